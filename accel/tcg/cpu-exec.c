@@ -400,6 +400,10 @@ static inline TranslationBlock *tb_find(CPUState *cpu,
     target_ulong cs_base, pc;
     uint32_t flags;
 
+    if (unlikely(cpu->hot_tb)) {
+        tb_hot_trace(cpu);
+    }
+
     tb = tb_lookup__cpu_state(cpu, &pc, &cs_base, &flags, cf_mask);
     if (tb == NULL) {
         mmap_lock();
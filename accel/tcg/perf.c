@@ -0,0 +1,268 @@
+/*
+ * Host profiler support for translated code
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Describes every TB to perf, so samples in the code buffer are attributed
+ * to the guest function the TB was translated from.
+ *
+ * map:     /tmp/perf-<pid>.map, read by perf report. perf has no way to
+ *          remove an entry, so after a tb_flush() reused code addresses
+ *          have several entries.
+ * jitdump: jit-<pid>.dump in the current directory, in the format of
+ *          tools/perf/Documentation/jitdump-specification.txt. Records hold
+ *          the code bytes and a timestamp, so perf annotate works and code
+ *          reused after a tb_flush() is attributed to the right TB. Use
+ *
+ *            perf record -k 1 qemu-system-... -perf jitdump
+ *            perf inject -j -i perf.data -o perf.jit.data
+ *            perf report -i perf.jit.data
+ *
+ * Invalidated TBs are not executed again and their code is only reused
+ * after a tb_flush(), so invalidation needs no record of its own.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu-common.h"
+
+#include "cpu.h"
+#include "exec/exec-all.h"
+#include "disas/disas.h"
+#include "elf.h"
+#include "translate-all.h"
+#include "qemu/error-report.h"
+#include "qemu/thread.h"
+
+#define JITDUMP_MAGIC       0x4A695444
+#define JITDUMP_VERSION     1
+
+enum {
+    JIT_CODE_LOAD = 0,
+    JIT_CODE_CLOSE = 3,
+};
+
+struct jitheader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+};
+
+struct jr_prefix {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+};
+
+struct jr_code_load {
+    struct jr_prefix p;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+};
+
+bool perf_enabled;
+
+static struct {
+    QemuMutex lock;
+    FILE *map;
+    FILE *jitdump;
+    void *marker;
+    uint64_t code_index;
+    bool flush_warned;
+} perf;
+
+/* perf matches jitdump records to samples with CLOCK_MONOTONIC */
+static uint64_t perf_timestamp(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t perf_elf_machine(void)
+{
+    Elf64_Ehdr ehdr;
+    uint32_t machine = EM_NONE;
+    FILE *f = fopen("/proc/self/exe", "rb");
+
+    if (f == NULL) {
+        return machine;
+    }
+    if (fread(&ehdr, sizeof(ehdr), 1, f) == 1 &&
+        !memcmp(ehdr.e_ident, ELFMAG, SELFMAG)) {
+        machine = ehdr.e_machine;
+    }
+    fclose(f);
+    return machine;
+}
+
+static bool perf_open_jitdump(void)
+{
+    struct jitheader hdr;
+    char *name;
+    int fd;
+
+    name = g_strdup_printf("jit-%d.dump", getpid());
+    fd = open(name, O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (fd < 0) {
+        warn_report("perf: can't create %s: %s", name, strerror(errno));
+        g_free(name);
+        return false;
+    }
+    g_free(name);
+
+    /* perf record finds the file through this executable mapping */
+    perf.marker = mmap(NULL, qemu_real_host_page_size, PROT_READ | PROT_EXEC,
+                       MAP_PRIVATE, fd, 0);
+    if (perf.marker == MAP_FAILED) {
+        warn_report("perf: can't map jitdump: %s", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    perf.jitdump = fdopen(fd, "wb");
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = JITDUMP_MAGIC;
+    hdr.version = JITDUMP_VERSION;
+    hdr.total_size = sizeof(hdr);
+    hdr.elf_mach = perf_elf_machine();
+    hdr.pid = getpid();
+    hdr.timestamp = perf_timestamp();
+    fwrite(&hdr, sizeof(hdr), 1, perf.jitdump);
+    return true;
+}
+
+static void perf_exit(void)
+{
+    struct jr_prefix close_rec;
+
+    qemu_mutex_lock(&perf.lock);
+
+    if (perf.map) {
+        fclose(perf.map);
+        perf.map = NULL;
+    }
+
+    if (perf.jitdump) {
+        close_rec.id = JIT_CODE_CLOSE;
+        close_rec.total_size = sizeof(close_rec);
+        close_rec.timestamp = perf_timestamp();
+        fwrite(&close_rec, sizeof(close_rec), 1, perf.jitdump);
+        fclose(perf.jitdump);
+        perf.jitdump = NULL;
+        munmap(perf.marker, qemu_real_host_page_size);
+    }
+
+    perf_enabled = false;
+    qemu_mutex_unlock(&perf.lock);
+}
+
+void perf_init(bool jitdump)
+{
+    char *name;
+
+    qemu_mutex_init(&perf.lock);
+
+    if (jitdump) {
+        if (!perf_open_jitdump()) {
+            return;
+        }
+    } else {
+        name = g_strdup_printf("/tmp/perf-%d.map", getpid());
+        perf.map = fopen(name, "w");
+        if (perf.map == NULL) {
+            warn_report("perf: can't create %s: %s", name, strerror(errno));
+            g_free(name);
+            return;
+        }
+        g_free(name);
+    }
+
+    perf_enabled = true;
+    atexit(perf_exit);
+}
+
+static void perf_tb_name(const TranslationBlock *tb, char *name, size_t size)
+{
+    const char *sym = lookup_symbol(tb->pc);
+
+    if (sym[0]) {
+        snprintf(name, size, "%s [0x" TARGET_FMT_lx "]", sym, tb->pc);
+    } else {
+        snprintf(name, size, "guest 0x" TARGET_FMT_lx, tb->pc);
+    }
+}
+
+/* Called by tb_gen_code() once @tb is linked and its code final */
+void perf_report_code(const TranslationBlock *tb)
+{
+    struct jr_code_load rec;
+    char name[256];
+    size_t len;
+
+    perf_tb_name(tb, name, sizeof(name));
+    len = strlen(name) + 1;
+
+    qemu_mutex_lock(&perf.lock);
+
+    if (perf.map) {
+        fprintf(perf.map, "%" PRIxPTR " %zx %s\n",
+                (uintptr_t)tb->tc.ptr, tb->tc.size, name);
+    }
+
+    if (perf.jitdump) {
+        rec.p.id = JIT_CODE_LOAD;
+        rec.p.total_size = sizeof(rec) + len + tb->tc.size;
+        rec.p.timestamp = perf_timestamp();
+        rec.pid = getpid();
+        rec.tid = qemu_get_thread_id();
+        rec.vma = (uintptr_t)tb->tc.ptr;
+        rec.code_addr = (uintptr_t)tb->tc.ptr;
+        rec.code_size = tb->tc.size;
+        rec.code_index = perf.code_index++;
+        fwrite(&rec, sizeof(rec), 1, perf.jitdump);
+        fwrite(name, len, 1, perf.jitdump);
+        fwrite(tb->tc.ptr, tb->tc.size, 1, perf.jitdump);
+    }
+
+    qemu_mutex_unlock(&perf.lock);
+}
+
+/* Called by do_tb_flush(), the code buffer is about to be reused */
+void perf_tb_flush(void)
+{
+    qemu_mutex_lock(&perf.lock);
+
+    if (perf.map && !perf.flush_warned) {
+        warn_report("perf: TBs were flushed, perf map entries may overlap, "
+                    "use -perf jitdump");
+        perf.flush_warned = true;
+    }
+
+    /* make everything before the flush visible to a running perf */
+    if (perf.map) {
+        fflush(perf.map);
+    }
+    if (perf.jitdump) {
+        fflush(perf.jitdump);
+    }
+
+    qemu_mutex_unlock(&perf.lock);
+}
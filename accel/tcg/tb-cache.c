@@ -0,0 +1,483 @@
+/*
+ * Persistent translation block cache
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+/*
+ * Translated code is saved to the file given with -tb-cache when QEMU
+ * exits and reused by later runs of the same QEMU binary on a host with
+ * the same instruction set extensions. A TB is keyed by
+ * pc, cs_base, flags, cflags, the CPU model and the hot trace settings,
+ * and is only reused if the guest code bytes it was translated from are
+ * unchanged.
+ *
+ * The backend reports the host addresses it embeds in generated code (see
+ * tcg_tb_cache_reloc()). Code is copied into the code buffer as is and the
+ * addresses into the QEMU image, the prologue and the TB itself are
+ * patched. TBs that embed any other host address are never saved.
+ *
+ * Breakpoints and single stepping are handled by invalidating TBs and
+ * translating them again with the debug state in effect. Code translated
+ * while they are in use is neither saved nor installed.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu-common.h"
+
+#define NO_CPU_IO_DEFS
+#include "cpu.h"
+#include "exec/exec-all.h"
+#include "tcg.h"
+#include "translate-all.h"
+#include "qemu/error-report.h"
+#include "qemu/qemu-print.h"
+#include "qemu/stats64.h"
+#include "qemu/thread.h"
+#include "qemu/xxhash.h"
+
+#define TB_CACHE_MAGIC      "QEMUTBC"
+#define TB_CACHE_VERSION    1
+
+typedef struct TBCacheKey {
+    uint64_t pc;
+    uint64_t cs_base;
+    uint32_t flags;
+    uint32_t cflags;
+    uint64_t cpu_key;
+} TBCacheKey;
+
+/* on disk, followed by guest bytes, code and search data, relocations */
+typedef struct TBCacheRecord {
+    TBCacheKey key;
+    uint32_t size;
+    uint32_t icount;
+    uint32_t code_size;
+    uint32_t search_size;
+    uint32_t jmp_insn_offset[2];
+    uint16_t jmp_reset_offset[2];
+    uint32_t nb_relocs;
+} TBCacheRecord;
+
+typedef struct TBCacheEntry {
+    TBCacheRecord rec;
+    const uint8_t *guest;
+    const uint8_t *code;
+    const TCGTBCacheReloc *relocs;
+} TBCacheEntry;
+
+typedef struct TBCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t nb_records;
+    char build[256];
+} TBCacheHeader;
+
+static struct {
+    char *path;
+    char build[256];
+    QemuMutex lock;
+    GHashTable *entries;
+    gchar *file;            /* loaded entries point into it */
+    size_t loaded;
+
+    Stat64 lookups;
+    Stat64 hits;
+    Stat64 stale;
+    Stat64 rejected;
+    Stat64 uncacheable;
+    Stat64 added;
+    Stat64 bytes_saved;
+} tb_cache;
+
+static guint tb_cache_hash(gconstpointer p)
+{
+    const TBCacheKey *k = p;
+
+    return qemu_xxhash6(k->pc, k->cs_base, k->flags, k->cflags ^ k->cpu_key);
+}
+
+static gboolean tb_cache_equal(gconstpointer a, gconstpointer b)
+{
+    return !memcmp(a, b, sizeof(TBCacheKey));
+}
+
+static void tb_cache_key(CPUState *cpu, const TranslationBlock *tb,
+                         TBCacheKey *key)
+{
+    CPUClass *cc = CPU_GET_CLASS(cpu);
+    uint64_t hook = cc->tb_cache_key ? cc->tb_cache_key(cpu) : 0;
+
+    memset(key, 0, sizeof(*key));
+    key->pc = tb->pc;
+    key->cs_base = tb->cs_base;
+    key->flags = tb->flags;
+    key->cflags = tb->cflags;
+    /* hot trace counting is compiled into the code with its threshold */
+    key->cpu_key = (uint64_t)qemu_xxhash6(hook, 0, tb_hot_trace_threshold,
+                                          tb_hot_trace_jumps) << 32 |
+        g_str_hash(object_class_get_name(OBJECT_CLASS(cc)));
+}
+
+/* TBs are specific to a QEMU binary, target and host CPU features */
+static bool tb_cache_build_id(void)
+{
+    struct stat st;
+
+    if (stat("/proc/self/exe", &st) < 0) {
+        return false;
+    }
+    snprintf(tb_cache.build, sizeof(tb_cache.build),
+             "%s %s %" PRIu64 " %" PRIu64 " %" PRId64 " %u %zu %x",
+             TARGET_NAME, QEMU_VERSION, (uint64_t)st.st_size,
+             (uint64_t)st.st_ino, (int64_t)st.st_mtime,
+             qemu_icache_linesize, sizeof(TranslationBlock),
+             tcg_tb_cache_host_features());
+    return true;
+}
+
+static size_t tb_cache_record_size(const TBCacheRecord *rec)
+{
+    return sizeof(*rec) + rec->size + rec->code_size + rec->search_size +
+        rec->nb_relocs * sizeof(TCGTBCacheReloc);
+}
+
+/* relocations and jumps must patch fields within the code of the TB */
+static bool tb_cache_entry_valid(const TBCacheEntry *e)
+{
+    uint32_t i;
+
+    /* tcg_gen_code() limits TBs to 64k of code */
+    if (e->rec.code_size > UINT16_MAX) {
+        return false;
+    }
+    for (i = 0; i < 2; i++) {
+        if (e->rec.jmp_reset_offset[i] != TB_JMP_RESET_OFFSET_INVALID &&
+            (e->rec.code_size < 4 ||
+             e->rec.jmp_reset_offset[i] >= e->rec.code_size ||
+             e->rec.jmp_insn_offset[i] > e->rec.code_size - 4)) {
+            return false;
+        }
+    }
+    for (i = 0; i < e->rec.nb_relocs; i++) {
+        if (!tcg_tb_cache_reloc_valid(&e->relocs[i], e->rec.code_size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void tb_cache_load(void)
+{
+    const TBCacheHeader *hdr;
+    const TBCacheRecord *rec;
+    TBCacheEntry *e;
+    size_t size, offset;
+    uint32_t i, invalid = 0;
+
+    if (!g_file_get_contents(tb_cache.path, &tb_cache.file, &size, NULL)) {
+        return;
+    }
+
+    hdr = (const TBCacheHeader *)tb_cache.file;
+    if (size < sizeof(*hdr) || memcmp(hdr->magic, TB_CACHE_MAGIC, 8) ||
+        hdr->version != TB_CACHE_VERSION ||
+        strncmp(hdr->build, tb_cache.build, sizeof(hdr->build))) {
+        info_report("tb-cache: %s is from another build, ignoring it",
+                    tb_cache.path);
+        return;
+    }
+
+    offset = sizeof(*hdr);
+    for (i = 0; i < hdr->nb_records; i++) {
+        rec = (const TBCacheRecord *)(tb_cache.file + offset);
+        if (size - offset < sizeof(*rec) ||
+            rec->nb_relocs > TCG_MAX_TB_CACHE_RELOCS ||
+            size - offset < tb_cache_record_size(rec)) {
+            warn_report("tb-cache: %s is truncated", tb_cache.path);
+            break;
+        }
+
+        e = g_new(TBCacheEntry, 1);
+        e->rec = *rec;
+        e->guest = (const uint8_t *)(rec + 1);
+        e->code = e->guest + rec->size;
+        e->relocs = (const TCGTBCacheReloc *)(e->code + rec->code_size +
+                                              rec->search_size);
+        offset += tb_cache_record_size(rec);
+
+        if (!tb_cache_entry_valid(e)) {
+            g_free(e);
+            invalid++;
+            continue;
+        }
+        g_hash_table_replace(tb_cache.entries, &e->rec.key, e);
+    }
+
+    if (invalid) {
+        warn_report("tb-cache: %s: ignoring %u corrupt records",
+                    tb_cache.path, invalid);
+    }
+
+    tb_cache.loaded = g_hash_table_size(tb_cache.entries);
+}
+
+static void tb_cache_save(void)
+{
+    TBCacheHeader hdr;
+    GHashTableIter iter;
+    TBCacheEntry *e;
+    char *tmp;
+    FILE *f;
+    bool ok;
+
+    qemu_mutex_lock(&tb_cache.lock);
+
+    if (!stat64_get(&tb_cache.added)) {
+        goto out;
+    }
+
+    /* write a new file and rename it, other runs may be reading the old */
+    tmp = g_strdup_printf("%s.%d", tb_cache.path, getpid());
+    f = fopen(tmp, "wb");
+    if (f == NULL) {
+        warn_report("tb-cache: can't create %s: %s", tmp, strerror(errno));
+        g_free(tmp);
+        goto out;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, TB_CACHE_MAGIC, sizeof(TB_CACHE_MAGIC));
+    hdr.version = TB_CACHE_VERSION;
+    hdr.nb_records = g_hash_table_size(tb_cache.entries);
+    memcpy(hdr.build, tb_cache.build, sizeof(hdr.build));
+    ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1;
+
+    g_hash_table_iter_init(&iter, tb_cache.entries);
+    while (ok && g_hash_table_iter_next(&iter, NULL, (gpointer *)&e)) {
+        ok = fwrite(&e->rec, sizeof(e->rec), 1, f) == 1 &&
+            fwrite(e->guest, e->rec.size, 1, f) == 1 &&
+            fwrite(e->code, e->rec.code_size + e->rec.search_size, 1, f) == 1;
+        if (ok && e->rec.nb_relocs) {
+            ok = fwrite(e->relocs, sizeof(*e->relocs), e->rec.nb_relocs,
+                        f) == e->rec.nb_relocs;
+        }
+    }
+
+    if (fclose(f) || !ok || rename(tmp, tb_cache.path)) {
+        warn_report("tb-cache: can't write %s: %s", tb_cache.path,
+                    strerror(errno));
+        unlink(tmp);
+    }
+    g_free(tmp);
+
+out:
+    qemu_mutex_unlock(&tb_cache.lock);
+}
+
+static void tb_cache_exit(void)
+{
+    uint64_t lookups = stat64_get(&tb_cache.lookups);
+    uint64_t hits = stat64_get(&tb_cache.hits);
+
+    tb_cache_save();
+
+    info_report("tb-cache: %" PRIu64 "/%" PRIu64 " hits (%.1f%%), "
+                "%" PRIu64 " bytes of code reused, %" PRIu64 " TBs added",
+                hits, lookups, lookups ? hits * 100.0 / lookups : 0.0,
+                stat64_get(&tb_cache.bytes_saved),
+                stat64_get(&tb_cache.added));
+}
+
+void tb_cache_init(const char *path)
+{
+    const char *err;
+
+    if (!tb_cache_build_id()) {
+        warn_report("tb-cache: disabled, can't identify the QEMU binary: %s",
+                    strerror(errno));
+        return;
+    }
+
+    err = tcg_tb_cache_enable();
+    if (err) {
+        warn_report("tb-cache: disabled, %s", err);
+        return;
+    }
+
+    tb_cache.path = g_strdup(path);
+    qemu_mutex_init(&tb_cache.lock);
+    tb_cache.entries = g_hash_table_new(tb_cache_hash, tb_cache_equal);
+    tb_cache_load();
+
+    atexit(tb_cache_exit);
+}
+
+/* true if @tb depends on debug state that the key does not capture */
+static bool tb_cache_debug(CPUState *cpu, const TranslationBlock *tb)
+{
+    CPUClass *cc = CPU_GET_CLASS(cpu);
+
+    return singlestep || cpu->singlestep_enabled ||
+        !QTAILQ_EMPTY(&cpu->breakpoints) ||
+        (cc->tb_cache_skip && cc->tb_cache_skip(cpu, tb));
+}
+
+static bool tb_cache_guest_equal(CPUState *cpu, const TranslationBlock *tb,
+                                 const uint8_t *guest, uint32_t size)
+{
+    uint8_t *buf = g_malloc(size);
+    bool equal;
+
+    equal = cpu_memory_rw_debug(cpu, tb->pc, buf, size, false) == 0 &&
+        !memcmp(buf, guest, size);
+    g_free(buf);
+    return equal;
+}
+
+/*
+ * Called by tb_gen_code() on a TB lookup miss, before translating. Copies
+ * the cached code for @tb to tb->tc.ptr and returns true on a hit.
+ */
+bool tb_cache_install(CPUState *cpu, TranslationBlock *tb,
+                      int *code_size, int *search_size)
+{
+    TBCacheKey key;
+    TBCacheEntry *e;
+    void *code = tb->tc.ptr;
+
+    if (tb_cache_debug(cpu, tb)) {
+        return false;
+    }
+
+    stat64_add(&tb_cache.lookups, 1);
+    tb_cache_key(cpu, tb, &key);
+
+    qemu_mutex_lock(&tb_cache.lock);
+    e = g_hash_table_lookup(tb_cache.entries, &key);
+    qemu_mutex_unlock(&tb_cache.lock);
+
+    if (e == NULL) {
+        return false;
+    }
+
+    /* guest code was modified or paged out */
+    if (!tb_cache_guest_equal(cpu, tb, e->guest, e->rec.size)) {
+        stat64_add(&tb_cache.stale, 1);
+        return false;
+    }
+
+    /* let translation deal with a full buffer */
+    if (code + e->rec.code_size + e->rec.search_size >
+        tcg_ctx->code_gen_highwater) {
+        return false;
+    }
+
+    memcpy(code, e->code, e->rec.code_size + e->rec.search_size);
+    if (!tcg_tb_cache_apply(tcg_ctx, code, e->rec.code_size,
+                            e->relocs, e->rec.nb_relocs)) {
+        stat64_add(&tb_cache.rejected, 1);
+        return false;
+    }
+
+    tb->size = e->rec.size;
+    tb->icount = e->rec.icount;
+    tb->tc.size = e->rec.code_size;
+    tb->jmp_reset_offset[0] = e->rec.jmp_reset_offset[0];
+    tb->jmp_reset_offset[1] = e->rec.jmp_reset_offset[1];
+    tb->jmp_target_arg[0] = e->rec.jmp_insn_offset[0];
+    tb->jmp_target_arg[1] = e->rec.jmp_insn_offset[1];
+
+    *code_size = e->rec.code_size;
+    *search_size = e->rec.search_size;
+
+    stat64_add(&tb_cache.hits, 1);
+    stat64_add(&tb_cache.bytes_saved, e->rec.code_size);
+    return true;
+}
+
+/* Called by tb_gen_code() with the code of a newly translated TB */
+void tb_cache_add(CPUState *cpu, TranslationBlock *tb,
+                  int code_size, int search_size)
+{
+    TCGContext *s = tcg_ctx;
+    TBCacheEntry *e;
+    uint8_t *guest, *code;
+    size_t relocs_size = s->nb_tb_cache_relocs * sizeof(TCGTBCacheReloc);
+
+    /* relocation is only done for direct jumps */
+    if (s->tb_cache_skip || (tb->cflags & CF_NOCACHE) ||
+        !TCG_TARGET_HAS_direct_jump || tb_cache_debug(cpu, tb)) {
+        stat64_add(&tb_cache.uncacheable, 1);
+        return;
+    }
+
+    e = g_malloc(sizeof(*e) + tb->size + code_size + search_size +
+                 relocs_size);
+    guest = (uint8_t *)(e + 1);
+    code = guest + tb->size;
+
+    if (cpu_memory_rw_debug(cpu, tb->pc, guest, tb->size, false)) {
+        g_free(e);
+        stat64_add(&tb_cache.uncacheable, 1);
+        return;
+    }
+
+    tb_cache_key(cpu, tb, &e->rec.key);
+    e->rec.size = tb->size;
+    e->rec.icount = tb->icount;
+    e->rec.code_size = code_size;
+    e->rec.search_size = search_size;
+    e->rec.jmp_reset_offset[0] = tb->jmp_reset_offset[0];
+    e->rec.jmp_reset_offset[1] = tb->jmp_reset_offset[1];
+    e->rec.jmp_insn_offset[0] = tb->jmp_target_arg[0];
+    e->rec.jmp_insn_offset[1] = tb->jmp_target_arg[1];
+    e->rec.nb_relocs = s->nb_tb_cache_relocs;
+
+    /* saved before tb_reset_jump() or chaining patch the jumps */
+    memcpy(code, tb->tc.ptr, code_size + search_size);
+    memcpy(code + code_size + search_size, s->tb_cache_relocs, relocs_size);
+    e->guest = guest;
+    e->code = code;
+    e->relocs = (const TCGTBCacheReloc *)(code + code_size + search_size);
+
+    /*
+     * A replaced entry may still be in use by another vCPU thread, it is
+     * not freed. Replacement only happens when guest code changes.
+     */
+    qemu_mutex_lock(&tb_cache.lock);
+    g_hash_table_replace(tb_cache.entries, &e->rec.key, e);
+    qemu_mutex_unlock(&tb_cache.lock);
+
+    stat64_add(&tb_cache.added, 1);
+}
+
+void tb_cache_dump_info(void)
+{
+    uint64_t lookups = stat64_get(&tb_cache.lookups);
+    uint64_t hits = stat64_get(&tb_cache.hits);
+
+    if (!tcg_tb_cache_enabled) {
+        return;
+    }
+
+    qemu_printf("\nTB cache %s:\n", tb_cache.path);
+    qemu_printf("TB cache entries    %u (%zu loaded)\n",
+                g_hash_table_size(tb_cache.entries), tb_cache.loaded);
+    qemu_printf("TB cache hits       %" PRIu64 "/%" PRIu64 " (%0.1f%%)\n",
+                hits, lookups, lookups ? hits * 100.0 / lookups : 0.0);
+    qemu_printf("TB cache stale      %" PRIu64 "\n",
+                stat64_get(&tb_cache.stale));
+    qemu_printf("TB cache rejected   %" PRIu64 "\n",
+                stat64_get(&tb_cache.rejected));
+    qemu_printf("TB cache added      %" PRIu64 " (%" PRIu64 " uncacheable)\n",
+                stat64_get(&tb_cache.added),
+                stat64_get(&tb_cache.uncacheable));
+    qemu_printf("TB cache code reuse %" PRIu64 " bytes\n",
+                stat64_get(&tb_cache.bytes_saved));
+}
@@ -30,8 +30,14 @@
 #include "cpu.h"
 #include "sysemu/cpus.h"
 #include "qemu/main-loop.h"
+#include "qemu/error-report.h"
+#include "hw/loader.h"
+#include "translate-all.h"
 
 unsigned long tcg_tb_size;
+const char *tcg_tb_cache_path;
+const char *tcg_perf_mode;
+const char *tcg_perf_elf;
 
 /* mask must never be zero, except for A20 change call */
 static void tcg_handle_interrupt(CPUState *cpu, int mask)
@@ -61,6 +67,15 @@ static void tcg_handle_interrupt(CPUState *cpu, int mask)
 static int tcg_init(MachineState *ms)
 {
     tcg_exec_init(tcg_tb_size * 1024 * 1024);
+    if (tcg_tb_cache_path) {
+        tb_cache_init(tcg_tb_cache_path);
+    }
+    if (tcg_perf_mode) {
+        if (tcg_perf_elf && load_elf_symbols(tcg_perf_elf) < 0) {
+            warn_report("perf: no symbols in %s", tcg_perf_elf);
+        }
+        perf_init(!strcmp(tcg_perf_mode, "jitdump"));
+    }
     cpu_interrupt_handler = tcg_handle_interrupt;
     return 0;
 }
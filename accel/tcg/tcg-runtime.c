@@ -163,6 +163,11 @@ void *HELPER(lookup_tb_ptr)(CPUArchState *env)
     return tb->tc.ptr;
 }
 
+void HELPER(tb_hot)(CPUArchState *env, void *tb)
+{
+    tb_hot_trace_request(env_cpu(env), tb);
+}
+
 void HELPER(exit_atomic)(CPUArchState *env)
 {
     cpu_loop_exit_atomic(env_cpu(env), GETPC());
@@ -1241,6 +1241,10 @@ static void do_tb_flush(CPUState *cpu, run_on_cpu_data tb_flush_count)
     qht_reset_size(&tb_ctx.htable, CODE_GEN_HTABLE_SIZE);
     page_flush_tb();
 
+    if (perf_enabled) {
+        perf_tb_flush();
+    }
+
     tcg_region_reset_all();
     /* XXX: flush processor icache at this point if cache flush is
        expensive */
@@ -1267,6 +1271,110 @@ void tb_flush(CPUState *cpu)
     }
 }
 
+/*
+ * Eviction: with -accel tcg,tb-evict=on a full code buffer only frees its
+ * least recently allocated region, see tcg_region_evict(). Code that is
+ * still in use is retranslated into the newest region and survives the
+ * following evictions, so guests that keep generating code (JITs) do not
+ * lose all their translations each time the buffer fills up.
+ *
+ * Evicted TBs are remembered in a bitmap indexed by their hash, so that
+ * retranslations can be counted. Collisions make the count approximate.
+ */
+#define TB_EVICT_MAP_BITS   20
+#define TB_EVICT_MAP_SIZE   (1 << TB_EVICT_MAP_BITS)
+
+bool tb_evict_enabled;
+
+static struct {
+    unsigned long *map;
+    size_t regions;
+    size_t tbs;
+    size_t translated;
+    size_t retranslated;
+} evict;
+
+static uint32_t tb_evict_hash(const TranslationBlock *tb)
+{
+    tb_page_addr_t phys_pc = tb->page_addr[0] + (tb->pc & ~TARGET_PAGE_MASK);
+
+    return tb_hash_func(phys_pc, tb->pc, tb->flags,
+                        tb_cflags(tb) & CF_HASH_MASK, tb->trace_vcpu_dstate) &
+           (TB_EVICT_MAP_SIZE - 1);
+}
+
+static gboolean tb_evict_iter(gpointer key, gpointer value, gpointer data)
+{
+    TranslationBlock *tb = value;
+    bool *evicted = data;
+    CPUState *cpu;
+
+    /* the TB struct is reused along with the code */
+    CPU_FOREACH(cpu) {
+        if (cpu->hot_tb == tb) {
+            cpu->hot_tb = NULL;
+        }
+    }
+
+    if (!(tb_cflags(tb) & (CF_INVALID | CF_NOCACHE))) {
+        set_bit(tb_evict_hash(tb), evict.map);
+        tb_phys_invalidate(tb, -1);
+        evict.tbs++;
+    }
+    *evicted = true;
+    return false;
+}
+
+/* Called by tb_gen_code() for each new TB while eviction is enabled */
+static void tb_evict_note(const TranslationBlock *tb)
+{
+    unsigned long *map = atomic_read(&evict.map);
+    uint32_t h;
+
+    atomic_inc(&evict.translated);
+    if (map) {
+        h = tb_evict_hash(tb);
+        if (atomic_fetch_and(&map[BIT_WORD(h)], ~BIT_MASK(h)) & BIT_MASK(h)) {
+            atomic_inc(&evict.retranslated);
+        }
+    }
+}
+
+static void do_tb_evict(CPUState *cpu, run_on_cpu_data data)
+{
+    bool evicted = false;
+
+    mmap_lock();
+    if (evict.map == NULL) {
+        atomic_set(&evict.map, bitmap_new(TB_EVICT_MAP_SIZE));
+    }
+    if (!tcg_region_evict(tb_evict_iter, &evicted)) {
+        /* every region is in use, or there is only one */
+        mmap_unlock();
+        do_tb_flush(cpu, RUN_ON_CPU_HOST_INT(tb_ctx.tb_flush_count));
+        return;
+    }
+    if (evicted) {
+        evict.regions++;
+        if (perf_enabled) {
+            perf_tb_flush();
+        }
+    }
+    mmap_unlock();
+}
+
+/* Make room in the code buffer, flushing it if eviction is disabled */
+static void tb_evict(CPUState *cpu)
+{
+    if (!tb_evict_enabled) {
+        tb_flush(cpu);
+    } else if (cpu_in_exclusive_context(cpu)) {
+        do_tb_evict(cpu, RUN_ON_CPU_NULL);
+    } else {
+        async_safe_run_on_cpu(cpu, do_tb_evict, RUN_ON_CPU_NULL);
+    }
+}
+
 /*
  * Formerly ifdef DEBUG_TB_CHECK. These debug functions are user-mode-only,
  * so in order to prevent bit rot we compile them unconditionally in user-mode,
@@ -1703,8 +1811,8 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
  buffer_overflow:
     tb = tcg_tb_alloc(tcg_ctx);
     if (unlikely(!tb)) {
-        /* flush must be done */
-        tb_flush(cpu);
+        /* flush or eviction must be done */
+        tb_evict(cpu);
         mmap_unlock();
         /* Make the execution loop process the flush as soon as possible.  */
         cpu->exception_index = EXCP_INTERRUPT;
@@ -1719,7 +1827,14 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     tb->cflags = cflags;
     tb->orig_tb = NULL;
     tb->trace_vcpu_dstate = *cpu->trace_dstate;
+    tb->hot_count = 0;
     tcg_ctx->tb_cflags = cflags;
+
+    if (tcg_tb_cache_enabled && !(cflags & CF_NOCACHE) &&
+        tb_cache_install(cpu, tb, &gen_code_size, &search_size)) {
+        goto cached;
+    }
+
  tb_overflow:
 
 #ifdef CONFIG_PROFILER
@@ -1794,6 +1909,10 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     }
     tb->tc.size = gen_code_size;
 
+    if (tcg_tb_cache_enabled) {
+        tb_cache_add(cpu, tb, gen_code_size, search_size);
+    }
+
 #ifdef CONFIG_PROFILER
     atomic_set(&prof->code_time, prof->code_time + profile_getclock() - ti);
     atomic_set(&prof->code_in_len, prof->code_in_len + tb->size);
@@ -1833,6 +1952,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     }
 #endif
 
+ cached:
     atomic_set(&tcg_ctx->code_gen_ptr, (void *)
         ROUND_UP((uintptr_t)gen_code_buf + gen_code_size + search_size,
                  CODE_GEN_ALIGN));
@@ -1873,9 +1993,85 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
         return existing_tb;
     }
     tcg_tb_insert(tb);
+
+    if (tb_evict_enabled) {
+        tb_evict_note(tb);
+    }
+    if (perf_enabled) {
+        perf_report_code(tb);
+    }
     return tb;
 }
 
+/*
+ * Hot traces: with -accel tcg,hot-trace=N a TB that is entered N times is
+ * retranslated with CF_HOT_TRACE. The target may then continue translation
+ * across direct jumps, so the blocks of a hot path become one TB with side
+ * exits and the optimizer and register allocator work across them.
+ */
+unsigned int tb_hot_trace_threshold;
+unsigned int tb_hot_trace_jumps = 8;
+
+static struct {
+    size_t hot;
+    size_t dropped;
+    size_t formed;
+    size_t spanning;
+    size_t jumps;
+} hot_trace;
+
+/* Called by the TB that reached the threshold, from generated code */
+void tb_hot_trace_request(CPUState *cpu, TranslationBlock *tb)
+{
+    unsigned int flush_count = atomic_read(&tb_ctx.tb_flush_count);
+
+    atomic_inc(&hot_trace.hot);
+
+    /* let a request that was not handled yet count again */
+    if (cpu->hot_tb && cpu->hot_tb_flush_count == flush_count) {
+        atomic_set(&cpu->hot_tb->hot_count, 0);
+    }
+    cpu->hot_tb = tb;
+    cpu->hot_tb_flush_count = flush_count;
+}
+
+/* Called by tb_find() to replace cpu->hot_tb with a hot trace */
+void tb_hot_trace(CPUState *cpu)
+{
+    TranslationBlock *tb = cpu->hot_tb;
+    uint32_t cflags;
+
+    cpu->hot_tb = NULL;
+
+    mmap_lock();
+    /* the TB was freed by a flush, or invalidated meanwhile */
+    if (cpu->hot_tb_flush_count != atomic_read(&tb_ctx.tb_flush_count) ||
+        (tb_cflags(tb) & CF_INVALID)) {
+        mmap_unlock();
+        atomic_inc(&hot_trace.dropped);
+        return;
+    }
+
+    /*
+     * CF_HOT_TRACE is not part of the hash, lookups find the new TB in
+     * place of the old one. Jumps into the old TB are unlinked.
+     */
+    cflags = tb_cflags(tb) | CF_HOT_TRACE;
+    tb_phys_invalidate(tb, -1);
+    tb_gen_code(cpu, tb->pc, tb->cs_base, tb->flags, cflags);
+    mmap_unlock();
+}
+
+/* Called by translator_loop() for CF_HOT_TRACE TBs */
+void tb_hot_trace_formed(TranslationBlock *tb, int jumps)
+{
+    atomic_inc(&hot_trace.formed);
+    if (jumps) {
+        atomic_inc(&hot_trace.spanning);
+        atomic_add(&hot_trace.jumps, jumps);
+    }
+}
+
 /*
  * @p must be non-NULL.
  * user-mode: call with mmap_lock held.
@@ -2358,11 +2554,34 @@ void dump_exec_info(void)
                 atomic_read(&tb_ctx.tb_flush_count));
     qemu_printf("TB invalidate count %zu\n",
                 tcg_tb_phys_invalidate_count());
+    if (tb_evict_enabled) {
+        size_t translated = atomic_read(&evict.translated);
+        size_t retranslated = atomic_read(&evict.retranslated);
+
+        qemu_printf("TB evicted regions  %zu (%zu TBs)\n",
+                    atomic_read(&evict.regions), atomic_read(&evict.tbs));
+        qemu_printf("TB retranslated     %zu (%zu%% of translations)\n",
+                    retranslated,
+                    translated ? (retranslated * 100) / translated : 0);
+    }
 
     tlb_flush_counts(&flush_full, &flush_part, &flush_elide);
     qemu_printf("TLB full flushes    %zu\n", flush_full);
     qemu_printf("TLB partial flushes %zu\n", flush_part);
     qemu_printf("TLB elided flushes  %zu\n", flush_elide);
+    if (tb_hot_trace_threshold) {
+        qemu_printf("\nHot traces (threshold %u, up to %u jumps):\n",
+                    tb_hot_trace_threshold, tb_hot_trace_jumps);
+        qemu_printf("hot TBs             %zu\n",
+                    atomic_read(&hot_trace.hot));
+        qemu_printf("retranslated        %zu (%zu dropped)\n",
+                    atomic_read(&hot_trace.formed),
+                    atomic_read(&hot_trace.dropped));
+        qemu_printf("spanning jumps      %zu (%zu jumps followed)\n",
+                    atomic_read(&hot_trace.spanning),
+                    atomic_read(&hot_trace.jumps));
+    }
+    tb_cache_dump_info();
     tcg_dump_info();
 }
 
@@ -32,6 +32,20 @@ void tb_invalidate_phys_page_fast(struct page_collection *pages,
 void tb_invalidate_phys_page_range(tb_page_addr_t start, tb_page_addr_t end);
 void tb_check_watchpoint(CPUState *cpu, uintptr_t retaddr);
 
+/* tb-cache.c */
+void tb_cache_init(const char *path);
+bool tb_cache_install(CPUState *cpu, TranslationBlock *tb,
+                      int *code_size, int *search_size);
+void tb_cache_add(CPUState *cpu, TranslationBlock *tb,
+                  int code_size, int search_size);
+void tb_cache_dump_info(void);
+
+/* perf.c */
+extern bool perf_enabled;
+void perf_init(bool jitdump);
+void perf_report_code(const TranslationBlock *tb);
+void perf_tb_flush(void);
+
 #ifdef CONFIG_USER_ONLY
 int page_unprotect(target_ulong address, uintptr_t pc);
 #endif
@@ -31,6 +31,29 @@ void translator_loop_temp_check(DisasContextBase *db)
     }
 }
 
+/*
+ * Count executions of the TB, including those entered through a chained
+ * jump, and ask for a hot trace once the threshold is reached. Every TB
+ * that has not become hot pays a load, add, store and compare on each
+ * entry, and with MTTCG vCPUs running the same TB share the counter.
+ */
+static void gen_tb_hot_count(TranslationBlock *tb)
+{
+    TCGv_ptr ptr = tcg_const_ptr(tb);
+    TCGv_i32 count = tcg_temp_new_i32();
+    TCGLabel *label = gen_new_label();
+
+    tcg_gen_ld_i32(count, ptr, offsetof(TranslationBlock, hot_count));
+    tcg_gen_addi_i32(count, count, 1);
+    tcg_gen_st_i32(count, ptr, offsetof(TranslationBlock, hot_count));
+    tcg_gen_brcondi_i32(TCG_COND_NE, count, tb_hot_trace_threshold, label);
+    gen_helper_tb_hot(cpu_env, ptr);
+    gen_set_label(label);
+
+    tcg_temp_free_i32(count);
+    tcg_temp_free_ptr(ptr);
+}
+
 void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
                      CPUState *cpu, TranslationBlock *tb, int max_insns)
 {
@@ -45,6 +68,7 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
     db->num_insns = 0;
     db->max_insns = max_insns;
     db->singlestep_enabled = cpu->singlestep_enabled;
+    db->trace_jumps = 0;
 
     ops->init_disas_context(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
@@ -54,6 +78,10 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
 
     /* Start translating.  */
     gen_tb_start(db->tb);
+    if (tb_hot_trace_threshold &&
+        !(tb_cflags(tb) & (CF_HOT_TRACE | CF_NOCACHE))) {
+        gen_tb_hot_count(tb);
+    }
     ops->tb_start(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
 
@@ -135,6 +163,10 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
     db->tb->size = db->pc_next - db->pc_first;
     db->tb->icount = db->num_insns;
 
+    if (tb_cflags(tb) & CF_HOT_TRACE) {
+        tb_hot_trace_formed(tb, db->trace_jumps);
+    }
+
 #ifdef DEBUG_DISAS
     if (qemu_loglevel_mask(CPU_LOG_TB_IN_ASM)
         && qemu_log_in_addr_range(db->pc_first)) {
@@ -0,0 +1,125 @@
+/*
+ * QEMU IO Bridge instance object
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * -object io-bridge,id=br0,ns=<namespace>
+ *
+ * Gives an IO bridge instance its own namespace so parent and child pairs
+ * started with different namespaces do not collide on SHM, ring or queue
+ * names. The first io-bridge object becomes the default instance used by
+ * the adsp machines.
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qemu/module.h"
+#include "qemu/io-bridge.h"
+#include "qom/object_interfaces.h"
+
+#define TYPE_IO_BRIDGE "io-bridge"
+#define IO_BRIDGE(obj) OBJECT_CHECK(IOBridgeObject, (obj), TYPE_IO_BRIDGE)
+
+typedef struct IOBridgeObject {
+    Object parent;
+
+    char *ns;
+    struct io_bridge *io;
+} IOBridgeObject;
+
+static bool have_default;
+
+static char *io_bridge_get_ns(Object *obj, Error **errp)
+{
+    IOBridgeObject *s = IO_BRIDGE(obj);
+
+    return g_strdup(s->ns);
+}
+
+static void io_bridge_set_ns(Object *obj, const char *value, Error **errp)
+{
+    IOBridgeObject *s = IO_BRIDGE(obj);
+
+    if (s->io) {
+        error_setg(errp, "io-bridge: namespace cannot change once created");
+        return;
+    }
+
+    g_free(s->ns);
+    s->ns = g_strdup(value);
+}
+
+static void io_bridge_complete(UserCreatable *uc, Error **errp)
+{
+    IOBridgeObject *s = IO_BRIDGE(uc);
+
+    /* namespace ends up in SHM and mqueue names */
+    if (s->ns && strchr(s->ns, '/')) {
+        error_setg(errp, "io-bridge: namespace '%s' must not contain '/'",
+                   s->ns);
+        return;
+    }
+
+    s->io = qemu_io_bridge_new(s->ns);
+    if (s->io == NULL) {
+        error_setg(errp, "io-bridge: namespace '%s' is too long", s->ns);
+        return;
+    }
+
+    if (!have_default) {
+        qemu_io_bridge_set_default(s->io);
+        have_default = true;
+    }
+}
+
+static void io_bridge_finalize(Object *obj)
+{
+    IOBridgeObject *s = IO_BRIDGE(obj);
+
+    if (s->io) {
+        /* don't leave the qemu_io_*() API with a dangling instance */
+        if (qemu_io_bridge_is_default(s->io)) {
+            qemu_io_bridge_set_default(NULL);
+            have_default = false;
+        }
+        qemu_io_bridge_free(s->io);
+        g_free(s->io);
+    }
+    g_free(s->ns);
+}
+
+static void io_bridge_class_init(ObjectClass *oc, void *data)
+{
+    UserCreatableClass *ucc = USER_CREATABLE_CLASS(oc);
+
+    ucc->complete = io_bridge_complete;
+
+    object_class_property_add_str(oc, "ns",
+        io_bridge_get_ns, io_bridge_set_ns, &error_abort);
+    object_class_property_set_description(oc, "ns",
+        "Namespace for bridge SHM, ring and queue names", &error_abort);
+}
+
+static const TypeInfo io_bridge_info = {
+    .name = TYPE_IO_BRIDGE,
+    .parent = TYPE_OBJECT,
+    .instance_size = sizeof(IOBridgeObject),
+    .instance_finalize = io_bridge_finalize,
+    .class_init = io_bridge_class_init,
+    .interfaces = (InterfaceInfo[]) {
+        { TYPE_USER_CREATABLE },
+        { }
+    }
+};
+
+static void register_types(void)
+{
+    type_register_static(&io_bridge_info);
+}
+
+type_init(register_types);
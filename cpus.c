@@ -129,6 +129,10 @@ static bool all_cpu_threads_idle(void)
 /* Protected by TimersState seqlock */
 
 static bool icount_sleep = true;
+
+/* time warp - jump the virtual clock over idle periods without icount */
+static bool time_warp;
+static bool (*time_warp_busy)(void);
 /* Arbitrarily pick 1MIPS as the minimum allowable speed.  */
 #define MAX_ICOUNT_SHIFT 10
 
@@ -237,6 +241,11 @@ void qemu_tcg_configure(QemuOpts *opts, Error **errp)
     } else {
         mttcg_enabled = default_mttcg_enabled();
     }
+
+    tb_hot_trace_threshold = qemu_opt_get_number(opts, "hot-trace", 0);
+    tb_hot_trace_jumps = qemu_opt_get_number(opts, "hot-trace-jumps",
+                                             tb_hot_trace_jumps);
+    tb_evict_enabled = qemu_opt_get_bool(opts, "tb-evict", false);
 }
 
 /* The current number of executed instructions is based on what we
@@ -577,12 +586,53 @@ void qtest_clock_warp(int64_t dest)
     qemu_clock_notify(QEMU_CLOCK_VIRTUAL);
 }
 
+void cpu_enable_time_warp(bool (*busy)(void))
+{
+    time_warp_busy = busy;
+    time_warp = true;
+}
+
+/*
+ * When every vCPU is halted and nothing external is in flight, move
+ * QEMU_CLOCK_VIRTUAL straight to the next deadline instead of waiting
+ * for it in real time. Only the clock offset moves, so guest time
+ * sources derived from the virtual clock stay consistent.
+ */
+static void cpu_time_warp(void)
+{
+    int64_t deadline;
+
+    if (!runstate_is_running() || !all_cpu_threads_idle()) {
+        return;
+    }
+
+    if (time_warp_busy && time_warp_busy()) {
+        return;
+    }
+
+    deadline = qemu_clock_deadline_ns_all(QEMU_CLOCK_VIRTUAL,
+                                          ~QEMU_TIMER_ATTR_EXTERNAL);
+    if (deadline <= 0) {
+        return;
+    }
+
+    seqlock_write_lock(&timers_state.vm_clock_seqlock,
+                       &timers_state.vm_clock_lock);
+    timers_state.cpu_clock_offset += deadline;
+    seqlock_write_unlock(&timers_state.vm_clock_seqlock,
+                         &timers_state.vm_clock_lock);
+    qemu_clock_notify(QEMU_CLOCK_VIRTUAL);
+}
+
 void qemu_start_warp_timer(void)
 {
     int64_t clock;
     int64_t deadline;
 
     if (!use_icount) {
+        if (time_warp) {
+            cpu_time_warp();
+        }
         return;
     }
 
@@ -1603,7 +1653,7 @@ static void *qemu_tcg_rr_cpu_thread_fn(void *arg)
             atomic_mb_set(&cpu->exit_request, 0);
         }
 
-        if (use_icount && all_cpu_threads_idle()) {
+        if ((use_icount || time_warp) && all_cpu_threads_idle()) {
             /*
              * When all cpus are sleeping (e.g in WFI), to avoid a deadlock
              * in the main_loop, wake it up in order to start the warp timer.
@@ -1805,6 +1855,12 @@ static void *qemu_tcg_cpu_thread_fn(void *arg)
         }
 
         atomic_mb_set(&cpu->exit_request, 0);
+
+        /* last vCPU to go idle wakes the main loop to warp the clock */
+        if (time_warp && all_cpu_threads_idle()) {
+            qemu_notify_event();
+        }
+
         qemu_wait_io_event(cpu);
     } while (!cpu->unplug || cpu_can_run(cpu));
 
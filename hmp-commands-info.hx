@@ -249,6 +249,22 @@ STEXI
 Show virtual to physical memory mappings.
 ETEXI
 
+#if defined(TARGET_XTENSA)
+    {
+        .name       = "decode-cache",
+        .args_type  = "",
+        .params     = "",
+        .help       = "show decoded instruction cache statistics",
+        .cmd        = hmp_info_decode_cache,
+    },
+#endif
+
+STEXI
+@item info decode-cache
+@findex info decode-cache
+Show Xtensa decoded instruction cache size, hits and misses.
+ETEXI
+
 #if defined(TARGET_I386) || defined(TARGET_RISCV)
     {
         .name       = "mem",
@@ -379,4 +379,7 @@ void adsp_hda_init(IntelHDAState *d, int version, const char *name)
 
     /* initialise bridge to x86 host driver */
     qemu_io_register_parent(name, &adsp_bridge_cb, (void*)d);
+
+    /* let DSP access guest RAM directly for host DMA */
+    adsp_host_share_ram();
 }
@@ -28,6 +28,12 @@
 #include "exec/memory.h"
 #include "exec/address-spaces.h"
 #include "migration/vmstate.h"
+#include "qemu/log.h"
+#include "qemu/notify.h"
+#include "qemu/bitmap.h"
+#include "qemu/error-report.h"
+#include "qemu/option.h"
+#include "qemu/main-loop.h"
 
 #include "qemu/io-bridge.h"
 #include "hw/audio/adsp-dev.h"
@@ -37,6 +43,20 @@
 #include "dsp/common.h"
 
 
+/*
+ * Map space as RAM over its SHM region. Only used for spaces without
+ * registers that have side effects, guest accesses never exit to QEMU.
+ */
+static void create_shadow_io(MemoryRegion *parent, struct adsp_io_info *info)
+{
+    struct adsp_reg_space *space = info->space;
+
+    memory_region_init_ram_ptr(&info->io, NULL, space->name,
+                               space->desc.size, space->desc.ptr);
+    vmstate_register_ram_global(&info->io);
+    memory_region_add_subregion(parent, space->desc.base, &info->io);
+}
+
 static int create_io_devices(const struct adsp_desc *board,
                               MemoryRegion *parent, void *adsp, int idx,
                               const MemoryRegionOps *ops)
@@ -67,6 +87,11 @@ static int create_io_devices(const struct adsp_desc *board,
         if (space->init)
             space->init(adsp, parent, info);
 
+        if (space->shadow) {
+            create_shadow_io(parent, info);
+            continue;
+        }
+
         memory_region_init_io(&info->io, NULL,
                               space->ops ? space->ops : ops, info,
                               board->io_dev[i].name, space->desc.size);
@@ -96,6 +121,7 @@ static int create_memory_regions(const struct adsp_desc *board,
         if (err < 0)
             fprintf(stderr, "error: cant alloc %s:%d SHM %d\n", shm_name,
                     idx,err);
+        desc->shm = idx;
 
         region = g_malloc(sizeof(*region));
         memory_region_init_ram_ptr(region, NULL, desc->name,
@@ -125,12 +151,24 @@ void adsp_create_io_devices(struct adsp_dev *adsp, const MemoryRegionOps *ops)
     adsp->shm_idx = create_io_devices(board, parent, adsp, adsp->shm_idx, ops);
 }
 
+static void mem_resident_exit(Notifier *n, void *data);
+
+static struct adsp_dev *mem_adsp;
+static Notifier mem_exit = { .notify = mem_resident_exit };
+
 void adsp_create_memory_regions(struct adsp_dev *adsp)
 {
     const struct adsp_desc *board = adsp->desc;
     MemoryRegion *parent = adsp->system_memory;
 
     adsp->shm_idx = create_memory_regions(board, parent, adsp, adsp->shm_idx);
+
+    /* report resident memory for this instance at exit */
+    if (!qemu_opt_get_bool(adsp->machine_opts, "mem-stats", false))
+        return;
+    if (mem_adsp == NULL)
+        qemu_add_exit_notifier(&mem_exit);
+    mem_adsp = adsp;
 }
 
 void adsp_create_host_io_devices(struct adsp_host *adsp,
@@ -142,6 +180,32 @@ void adsp_create_host_io_devices(struct adsp_host *adsp,
     adsp->shm_idx = create_io_devices(board, parent, adsp, adsp->shm_idx, ops);
 }
 
+static void host_msg_bh(void *opaque)
+{
+    struct adsp_host *adsp = opaque;
+    struct qemu_io_msg *msg;
+
+    while ((msg = g_queue_pop_head(&adsp->msg_queue))) {
+        qemu_io_send_msg(msg);
+        g_free(msg);
+    }
+}
+
+/*
+ * Queue a message to the DSP and return to the guest, the message is sent
+ * from the main loop. Called from register writes with the BQL held.
+ */
+void adsp_host_post_msg(struct adsp_host *adsp, struct qemu_io_msg *msg)
+{
+    if (adsp->msg_bh == NULL) {
+        g_queue_init(&adsp->msg_queue);
+        adsp->msg_bh = qemu_bh_new(host_msg_bh, adsp);
+    }
+
+    g_queue_push_tail(&adsp->msg_queue, g_memdup(msg, msg->size));
+    qemu_bh_schedule(adsp->msg_bh);
+}
+
 void adsp_create_host_memory_regions(struct adsp_host *adsp)
 {
     const struct adsp_desc *board = adsp->desc;
@@ -192,3 +256,203 @@ struct adsp_reg_space *adsp_get_io_space(struct adsp_dev *adsp, hwaddr addr)
 
     return NULL;
 }
+
+/*
+ * SRAM bank power gating. SHM regions are created sparse so only pages the
+ * DSP touches use host memory. Banks gated by firmware are punched out of
+ * the SHM file and trapped until they are powered again, so a gated bank
+ * reads back as zero like on HW and costs nothing on the host.
+ *
+ * Banks start powered regardless of the PGISTS reset value as ROM and
+ * firmware are loaded into them before the DSP runs. The gated bitmap is
+ * migrated and the traps are rebuilt from it on load.
+ */
+struct adsp_mem_gate {
+    struct adsp_mem_desc *desc;
+    uint32_t bank_size;
+    int32_t num_banks;
+    unsigned long *gated;
+    MemoryRegion *trap;         /* per bank, [bank] and [num_banks + bank] */
+};
+
+static uint64_t mem_gate_read(void *opaque, hwaddr addr, unsigned size)
+{
+    struct adsp_mem_gate *gate = opaque;
+
+    qemu_log_mask(LOG_GUEST_ERROR, "mem: %s read at 0x%" HWADDR_PRIx
+        " in power gated bank\n", gate->desc->name, addr);
+    return 0;
+}
+
+static void mem_gate_write(void *opaque, hwaddr addr, uint64_t val,
+    unsigned size)
+{
+    struct adsp_mem_gate *gate = opaque;
+
+    qemu_log_mask(LOG_GUEST_ERROR, "mem: %s write at 0x%" HWADDR_PRIx
+        " in power gated bank\n", gate->desc->name, addr);
+}
+
+static const MemoryRegionOps mem_gate_ops = {
+    .read = mem_gate_read,
+    .write = mem_gate_write,
+    .endianness = DEVICE_NATIVE_ENDIAN,
+};
+
+/* zero a range of DSP memory, releasing its host pages */
+void adsp_mem_discard(struct adsp_mem_desc *desc, size_t offset, size_t size)
+{
+    if (qemu_io_discard_shm(desc->shm, offset, size) < 0)
+        fprintf(stderr, "mem: cant release %s 0x%zx size 0x%zx\n",
+            desc->name, offset, size);
+}
+
+static void mem_gate_bank(struct adsp_mem_gate *gate, int bank, bool off)
+{
+    struct adsp_mem_desc *desc = gate->desc;
+
+    if (off)
+        adsp_mem_discard(desc, (size_t)bank * gate->bank_size,
+            gate->bank_size);
+
+    memory_region_set_enabled(&gate->trap[bank], off);
+    if (desc->alias)
+        memory_region_set_enabled(&gate->trap[gate->num_banks + bank], off);
+}
+
+static int mem_gate_post_load(void *opaque, int version_id)
+{
+    struct adsp_mem_gate *gate = opaque;
+    int bank;
+
+    for (bank = 0; bank < gate->num_banks; bank++)
+        mem_gate_bank(gate, bank, test_bit(bank, gate->gated));
+    return 0;
+}
+
+static const VMStateDescription vmstate_mem_gate = {
+    .name = "adsp-mem-gate",
+    .version_id = 1,
+    .minimum_version_id = 1,
+    .post_load = mem_gate_post_load,
+    .fields = (VMStateField[]) {
+        VMSTATE_INT32_EQUAL(num_banks, struct adsp_mem_gate, NULL),
+        VMSTATE_BITMAP(gated, struct adsp_mem_gate, 1, num_banks),
+        VMSTATE_END_OF_LIST()
+    }
+};
+
+static struct adsp_mem_desc *mem_find(struct adsp_dev *adsp,
+    const char *name)
+{
+    const struct adsp_desc *board = adsp->desc;
+    int i;
+
+    for (i = 0; i < board->num_mem; i++) {
+        if (!strcmp(board->mem_region[i].name, name))
+            return &board->mem_region[i];
+    }
+    return NULL;
+}
+
+/* make the banks of region name power gateable */
+void adsp_mem_gate_init(struct adsp_dev *adsp, const char *name,
+    uint32_t bank_size)
+{
+    struct adsp_mem_desc *desc = mem_find(adsp, name);
+    struct adsp_mem_gate *gate;
+    char trap_name[32];
+    int i;
+
+    if (desc == NULL || desc->gate != NULL)
+        return;
+
+    gate = g_new0(struct adsp_mem_gate, 1);
+    gate->desc = desc;
+    gate->bank_size = bank_size;
+    gate->num_banks = desc->size / bank_size;
+    gate->gated = bitmap_new(gate->num_banks);
+    gate->trap = g_new0(MemoryRegion, gate->num_banks * 2);
+
+    /* traps overlay the RAM and stay disabled while the bank is powered */
+    for (i = 0; i < gate->num_banks; i++) {
+        snprintf(trap_name, sizeof(trap_name), "%s-gate%d", desc->name, i);
+        memory_region_init_io(&gate->trap[i], NULL, &mem_gate_ops, gate,
+            trap_name, bank_size);
+        memory_region_set_enabled(&gate->trap[i], false);
+        memory_region_add_subregion_overlap(adsp->system_memory,
+            desc->base + i * bank_size, &gate->trap[i], 1);
+
+        if (!desc->alias)
+            continue;
+
+        memory_region_init_io(&gate->trap[gate->num_banks + i], NULL,
+            &mem_gate_ops, gate, trap_name, bank_size);
+        memory_region_set_enabled(&gate->trap[gate->num_banks + i], false);
+        memory_region_add_subregion_overlap(adsp->system_memory,
+            desc->alias + i * bank_size, &gate->trap[gate->num_banks + i], 1);
+    }
+
+    desc->gate = gate;
+    vmstate_register(NULL, desc->shm, &vmstate_mem_gate, gate);
+}
+
+/* apply the 32 PGCTL bits for banks first_bank.. of region name, 1 is gated */
+void adsp_mem_power_gate(struct adsp_dev *adsp, const char *name,
+    int first_bank, uint32_t gated)
+{
+    struct adsp_mem_desc *desc = mem_find(adsp, name);
+    struct adsp_mem_gate *gate;
+    bool off;
+    int bank;
+
+    if (desc == NULL || desc->gate == NULL)
+        return;
+    gate = desc->gate;
+
+    /* banks past the end of the region are ignored */
+    for (bank = first_bank;
+         bank < first_bank + 32 && bank < gate->num_banks; bank++) {
+
+        off = gated & (1U << (bank - first_bank));
+        if (off == test_bit(bank, gate->gated))
+            continue;
+
+        mem_gate_bank(gate, bank, off);
+        if (off)
+            set_bit(bank, gate->gated);
+        else
+            clear_bit(bank, gate->gated);
+    }
+}
+
+/* host memory used by all DSP memory regions in bytes */
+size_t adsp_mem_resident(struct adsp_dev *adsp)
+{
+    const struct adsp_desc *board = adsp->desc;
+    ssize_t bytes;
+    size_t total = 0;
+    int i;
+
+    for (i = 0; i < board->num_mem; i++) {
+        bytes = qemu_io_shm_resident(board->mem_region[i].shm);
+        if (bytes > 0)
+            total += bytes;
+    }
+
+    return total;
+}
+
+/* mem-stats machine option, resident memory of the instance at exit */
+static void mem_resident_exit(Notifier *n, void *data)
+{
+    const struct adsp_desc *board = mem_adsp->desc;
+    size_t size = 0;
+    int i;
+
+    for (i = 0; i < board->num_mem; i++)
+        size += board->mem_region[i].size;
+
+    info_report("mem: resident %zu KiB of %zu KiB",
+        adsp_mem_resident(mem_adsp) >> 10, size >> 10);
+}
@@ -0,0 +1,555 @@
+/*
+ * Audio DAI endpoint support for the audio DSP.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include <poll.h>
+#include "qemu-common.h"
+#include "qemu/bswap.h"
+#include "qemu/thread.h"
+#include "audio/audio.h"
+#include "hw/adsp/dai.h"
+
+#define WAV_HDR_SIZE    44
+
+/*
+ * File backends - called from the endpoint I/O thread only.
+ */
+
+static int dai_file_write(struct dai_endpoint *ep, void *data, uint32_t bytes)
+{
+    uint8_t *buf = data;
+    ssize_t ret;
+
+    /* backend failed to open, discard */
+    if (ep->fd < 0)
+        return 0;
+
+    while (bytes) {
+        ret = write(ep->fd, buf, bytes);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            /* pipe reader is slow or gone, drop rather than stall */
+            if (errno == EAGAIN)
+                return 0;
+            fprintf(stderr, "dai: %s write failed %d\n", ep->path, -errno);
+            return -errno;
+        }
+
+        buf += ret;
+        bytes -= ret;
+        ep->file_bytes += ret;
+    }
+
+    return 0;
+}
+
+/* read capture data, looping back to the first sample at end of file */
+static int dai_file_read(struct dai_endpoint *ep, void *data, uint32_t bytes)
+{
+    ssize_t ret;
+
+    ret = read(ep->fd, data, bytes);
+    if (ret == 0) {
+        if (lseek(ep->fd, ep->data_start, SEEK_SET) < 0)
+            return -errno;
+        ret = read(ep->fd, data, bytes);
+        if (ret == 0)
+            return -ENODATA;
+    }
+
+    if (ret < 0)
+        return errno == EINTR ? 0 : -errno;
+
+    ep->file_bytes += ret;
+    return ret;
+}
+
+static int dai_file_xfer(struct dai_endpoint *ep, void *data, uint32_t bytes)
+{
+    if (ep->dir == DAI_DIR_PLAYBACK)
+        return dai_file_write(ep, data, bytes);
+    else
+        return dai_file_read(ep, data, bytes);
+}
+
+static int dai_raw_open(struct dai_endpoint *ep)
+{
+    if (ep->dir == DAI_DIR_PLAYBACK)
+        ep->fd = open(ep->path, O_WRONLY | O_CREAT | O_TRUNC,
+            S_IRUSR | S_IWUSR);
+    else
+        ep->fd = open(ep->path, O_RDONLY);
+
+    if (ep->fd < 0)
+        return -errno;
+
+    ep->data_start = 0;
+    return 0;
+}
+
+static void dai_file_close(struct dai_endpoint *ep)
+{
+    if (ep->fd >= 0)
+        close(ep->fd);
+    ep->fd = -1;
+}
+
+static void dai_wav_header(struct dai_endpoint *ep, uint8_t *hdr)
+{
+    uint32_t frame_bytes = ep->fmt.channels * ep->fmt.sample_bytes;
+    uint32_t data_bytes = MIN(ep->file_bytes, UINT32_MAX - WAV_HDR_SIZE);
+
+    memcpy(hdr, "RIFF", 4);
+    stl_le_p(hdr + 4, data_bytes + WAV_HDR_SIZE - 8);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    stl_le_p(hdr + 16, 16);
+    stw_le_p(hdr + 20, 1);                   /* PCM */
+    stw_le_p(hdr + 22, ep->fmt.channels);
+    stl_le_p(hdr + 24, ep->fmt.rate);
+    stl_le_p(hdr + 28, ep->fmt.rate * frame_bytes);
+    stw_le_p(hdr + 32, frame_bytes);
+    stw_le_p(hdr + 34, ep->fmt.sample_bytes * 8);
+    memcpy(hdr + 36, "data", 4);
+    stl_le_p(hdr + 40, data_bytes);
+}
+
+/* find the start of the data chunk in a capture source file */
+static int dai_wav_parse(struct dai_endpoint *ep)
+{
+    uint8_t chunk[12];
+    off_t pos;
+
+    if (read(ep->fd, chunk, 12) != 12 ||
+        memcmp(chunk, "RIFF", 4) || memcmp(chunk + 8, "WAVE", 4)) {
+        /* not a WAV file, treat it as raw PCM */
+        ep->data_start = 0;
+        return lseek(ep->fd, 0, SEEK_SET) < 0 ? -errno : 0;
+    }
+
+    pos = 12;
+    while (read(ep->fd, chunk, 8) == 8) {
+        pos += 8;
+        if (!memcmp(chunk, "data", 4)) {
+            ep->data_start = pos;
+            return 0;
+        }
+
+        pos += ldl_le_p(chunk + 4);
+        if (lseek(ep->fd, pos, SEEK_SET) < 0)
+            return -errno;
+    }
+
+    return -EINVAL;
+}
+
+static int dai_wav_open(struct dai_endpoint *ep)
+{
+    uint8_t hdr[WAV_HDR_SIZE];
+    int ret;
+
+    ret = dai_raw_open(ep);
+    if (ret < 0)
+        return ret;
+
+    if (ep->dir == DAI_DIR_CAPTURE)
+        return dai_wav_parse(ep);
+
+    /* sizes are filled in on close */
+    dai_wav_header(ep, hdr);
+    if (write(ep->fd, hdr, sizeof(hdr)) != sizeof(hdr))
+        return -EIO;
+
+    ep->data_start = WAV_HDR_SIZE;
+    return 0;
+}
+
+static void dai_wav_close(struct dai_endpoint *ep)
+{
+    uint8_t hdr[WAV_HDR_SIZE];
+
+    if (ep->fd >= 0 && ep->dir == DAI_DIR_PLAYBACK) {
+        dai_wav_header(ep, hdr);
+        if (pwrite(ep->fd, hdr, sizeof(hdr), 0) != sizeof(hdr))
+            fprintf(stderr, "dai: %s header update failed %d\n",
+                ep->path, -errno);
+    }
+
+    dai_file_close(ep);
+}
+
+static int dai_pipe_open(struct dai_endpoint *ep)
+{
+    struct stat st;
+
+    if (stat(ep->path, &st) < 0 && mkfifo(ep->path, S_IRUSR | S_IWUSR) < 0)
+        return -errno;
+
+    /* O_RDWR so open does not wait for the other end */
+    ep->fd = open(ep->path, O_RDWR | O_NONBLOCK);
+    if (ep->fd < 0)
+        return -errno;
+
+    ep->data_start = 0;
+    return 0;
+}
+
+static int dai_pipe_xfer(struct dai_endpoint *ep, void *data, uint32_t bytes)
+{
+    struct pollfd pfd[2];
+    ssize_t ret;
+
+    if (ep->dir == DAI_DIR_PLAYBACK)
+        return dai_file_write(ep, data, bytes);
+
+    /* sleep until the writer has data or the endpoint is closed */
+    pfd[0].fd = ep->fd;
+    pfd[0].events = POLLIN;
+    pfd[1].fd = ep->wake_fd[0];
+    pfd[1].events = POLLIN;
+    ret = poll(pfd, 2, -1);
+    if (ret < 0)
+        return errno == EINTR ? 0 : -errno;
+    if (pfd[1].revents)
+        return 0;
+
+    ret = read(ep->fd, data, bytes);
+    if (ret < 0)
+        return errno == EAGAIN || errno == EINTR ? 0 : -errno;
+
+    ep->file_bytes += ret;
+    return ret;
+}
+
+/*
+ * QEMU audio backend - callback runs in the main loop.
+ */
+
+static void dai_audio_out(void *opaque, int avail)
+{
+    struct dai_endpoint *ep = opaque;
+    uint32_t off, n;
+    size_t done;
+
+    qemu_mutex_lock(&ep->mutex);
+
+    while (avail > 0 && ep->head != ep->tail) {
+        off = ep->tail % DAI_RING_SIZE;
+        n = MIN(ep->head - ep->tail, DAI_RING_SIZE - off);
+        n = MIN(n, avail);
+
+        done = AUD_write(ep->voice, ep->ring + off, n);
+        if (done == 0)
+            break;
+
+        ep->tail += done;
+        avail -= done;
+    }
+
+    qemu_mutex_unlock(&ep->mutex);
+}
+
+static int dai_audio_open(struct dai_endpoint *ep)
+{
+    struct audsettings as;
+
+    if (ep->dir == DAI_DIR_CAPTURE)
+        return -ENOTSUP;
+
+    as.freq = ep->fmt.rate;
+    as.nchannels = ep->fmt.channels;
+    as.fmt = ep->fmt.sample_bytes == 2 ? AUDIO_FORMAT_S16 : AUDIO_FORMAT_S32;
+    as.endianness = AUDIO_HOST_ENDIANNESS;
+
+    AUD_register_card("adsp-dai", &ep->card);
+    ep->voice = AUD_open_out(&ep->card, NULL, ep->name, ep, dai_audio_out,
+        &as);
+    if (ep->voice == NULL) {
+        AUD_remove_card(&ep->card);
+        return -ENODEV;
+    }
+
+    AUD_set_active_out(ep->voice, 1);
+    return 0;
+}
+
+static void dai_audio_close(struct dai_endpoint *ep)
+{
+    AUD_set_active_out(ep->voice, 0);
+    AUD_close_out(&ep->card, ep->voice);
+    AUD_remove_card(&ep->card);
+    ep->voice = NULL;
+}
+
+static const struct dai_backend_ops dai_backends[] = {
+    [DAI_BACKEND_NONE] = {.name = "none"},
+    [DAI_BACKEND_WAV] = {.name = "wav", .ext = ".wav",
+        .open = dai_wav_open, .xfer = dai_file_xfer,
+        .close = dai_wav_close},
+    [DAI_BACKEND_RAW] = {.name = "raw", .ext = ".raw",
+        .open = dai_raw_open, .xfer = dai_file_xfer,
+        .close = dai_file_close},
+    [DAI_BACKEND_PIPE] = {.name = "pipe", .ext = "",
+        .open = dai_pipe_open, .xfer = dai_pipe_xfer,
+        .close = dai_file_close},
+    [DAI_BACKEND_AUDIO] = {.name = "audio",
+        .open = dai_audio_open, .close = dai_audio_close},
+};
+
+static int dai_get_backend(void)
+{
+    const char *name = getenv("ADSP_DAI_BACKEND");
+    int i;
+
+    if (name == NULL)
+        return DAI_BACKEND_WAV;
+
+    for (i = 0; i < ARRAY_SIZE(dai_backends); i++) {
+        if (!strcmp(name, dai_backends[i].name))
+            return i;
+    }
+
+    fprintf(stderr, "dai: unknown backend %s, using wav\n", name);
+    return DAI_BACKEND_WAV;
+}
+
+/*
+ * I/O thread - moves data between the ring and a file backend.
+ */
+
+static void dai_playback_drain(struct dai_endpoint *ep)
+{
+    uint32_t off, n;
+
+    for (;;) {
+        qemu_mutex_lock(&ep->mutex);
+        while (ep->running && ep->head == ep->tail)
+            qemu_cond_wait(&ep->cond, &ep->mutex);
+
+        /* drain anything left before exiting */
+        if (ep->head == ep->tail) {
+            qemu_mutex_unlock(&ep->mutex);
+            return;
+        }
+
+        off = ep->tail % DAI_RING_SIZE;
+        n = MIN(ep->head - ep->tail, DAI_RING_SIZE - off);
+        qemu_mutex_unlock(&ep->mutex);
+
+        /* producer never writes into [tail, head) so no lock needed */
+        ep->ops->xfer(ep, ep->ring + off, n);
+
+        qemu_mutex_lock(&ep->mutex);
+        ep->tail += n;
+        qemu_mutex_unlock(&ep->mutex);
+    }
+}
+
+static void dai_capture_fill(struct dai_endpoint *ep)
+{
+    uint32_t off, n;
+    int ret;
+
+    for (;;) {
+        qemu_mutex_lock(&ep->mutex);
+        while (ep->running && ep->head - ep->tail == DAI_RING_SIZE)
+            qemu_cond_wait(&ep->cond, &ep->mutex);
+
+        if (!ep->running) {
+            qemu_mutex_unlock(&ep->mutex);
+            return;
+        }
+
+        off = ep->head % DAI_RING_SIZE;
+        n = MIN(DAI_RING_SIZE - (ep->head - ep->tail), DAI_RING_SIZE - off);
+        qemu_mutex_unlock(&ep->mutex);
+
+        ret = ep->ops->xfer(ep, ep->ring + off, n);
+        if (ret < 0) {
+            fprintf(stderr, "dai: %s read failed %d\n", ep->path, ret);
+            return;
+        }
+
+        qemu_mutex_lock(&ep->mutex);
+        ep->head += ret;
+        qemu_mutex_unlock(&ep->mutex);
+    }
+}
+
+static void *dai_thread(void *data)
+{
+    struct dai_endpoint *ep = data;
+    int ret;
+
+    /* open here as a pipe or slow filesystem may block */
+    ret = ep->ops->open(ep);
+    if (ret < 0) {
+        fprintf(stderr, "dai: can't open %s %d\n", ep->path, ret);
+        dai_file_close(ep);
+
+        /* capture reads silence, playback keeps draining to nowhere */
+        if (ep->dir == DAI_DIR_CAPTURE)
+            return NULL;
+    }
+
+    if (ep->dir == DAI_DIR_PLAYBACK)
+        dai_playback_drain(ep);
+    else
+        dai_capture_fill(ep);
+
+    ep->ops->close(ep);
+    return NULL;
+}
+
+struct dai_endpoint *dai_endpoint_open(const char *name, int dir,
+    int backend, const struct dai_format *fmt)
+{
+    struct dai_endpoint *ep;
+    const char *dirname = getenv("ADSP_DAI_DIR");
+    const char *source = getenv("ADSP_DAI_CAPTURE");
+
+    if (backend == DAI_BACKEND_DEFAULT)
+        backend = dai_get_backend();
+
+    ep = g_malloc0(sizeof(*ep));
+    ep->dir = dir;
+    ep->fmt = *fmt;
+    ep->fd = -1;
+    ep->wake_fd[0] = ep->wake_fd[1] = -1;
+    ep->ops = &dai_backends[backend];
+    snprintf(ep->name, sizeof(ep->name), "%s", name);
+
+    if (dirname == NULL)
+        dirname = "/tmp";
+    if (dir == DAI_DIR_CAPTURE && source && backend != DAI_BACKEND_PIPE)
+        snprintf(ep->path, sizeof(ep->path), "%s", source);
+    else
+        snprintf(ep->path, sizeof(ep->path), "%s/%s%s", dirname, name,
+            ep->ops->ext ? ep->ops->ext : "");
+
+    qemu_mutex_init(&ep->mutex);
+    qemu_cond_init(&ep->cond);
+    ep->ring = g_malloc0(DAI_RING_SIZE);
+    ep->running = 1;
+
+    /* pipe capture blocks in poll(), close wakes it through this pipe */
+    if (backend == DAI_BACKEND_PIPE && dir == DAI_DIR_CAPTURE &&
+        qemu_pipe(ep->wake_fd) < 0) {
+        fprintf(stderr, "dai: %s can't create wake pipe %d\n", ep->name,
+            -errno);
+        ep->ops = &dai_backends[DAI_BACKEND_NONE];
+    }
+
+    if (ep->ops->xfer) {
+        qemu_thread_create(&ep->thread, ep->name, dai_thread, ep,
+            QEMU_THREAD_JOINABLE);
+    } else if (ep->ops->open && ep->ops->open(ep) < 0) {
+        fprintf(stderr, "dai: %s can't use %s backend\n", ep->name,
+            ep->ops->name);
+        ep->ops = &dai_backends[DAI_BACKEND_NONE];
+    }
+
+    return ep;
+}
+
+void dai_endpoint_close(struct dai_endpoint *ep)
+{
+    if (ep == NULL)
+        return;
+
+    qemu_mutex_lock(&ep->mutex);
+    ep->running = 0;
+    qemu_cond_signal(&ep->cond);
+    qemu_mutex_unlock(&ep->mutex);
+
+    if (ep->wake_fd[1] >= 0 && write(ep->wake_fd[1], "", 1) != 1)
+        fprintf(stderr, "dai: %s wake failed %d\n", ep->name, -errno);
+
+    if (ep->ops->xfer)
+        qemu_thread_join(&ep->thread);
+    else if (ep->ops->close)
+        ep->ops->close(ep);
+
+    if (ep->wake_fd[0] >= 0) {
+        close(ep->wake_fd[0]);
+        close(ep->wake_fd[1]);
+    }
+
+    if (ep->xruns)
+        fprintf(stderr, "dai: %s had %d xruns\n", ep->name, ep->xruns);
+
+    qemu_cond_destroy(&ep->cond);
+    qemu_mutex_destroy(&ep->mutex);
+    g_free(ep->ring);
+    g_free(ep);
+}
+
+/* copy playback data into the ring, drops data if the backend is behind */
+uint32_t dai_endpoint_write(struct dai_endpoint *ep, const void *data,
+    uint32_t bytes)
+{
+    uint32_t off, n, count;
+
+    if (ep == NULL || ep->ops == &dai_backends[DAI_BACKEND_NONE])
+        return bytes;
+
+    qemu_mutex_lock(&ep->mutex);
+
+    count = MIN(bytes, DAI_RING_SIZE - (ep->head - ep->tail));
+    if (count < bytes)
+        ep->xruns++;
+
+    off = ep->head % DAI_RING_SIZE;
+    n = MIN(count, DAI_RING_SIZE - off);
+    memcpy(ep->ring + off, data, n);
+    memcpy(ep->ring, (const uint8_t *)data + n, count - n);
+
+    /* thread only sleeps on an empty ring */
+    if (ep->head == ep->tail)
+        qemu_cond_signal(&ep->cond);
+    ep->head += count;
+
+    qemu_mutex_unlock(&ep->mutex);
+    return count;
+}
+
+/* copy capture data out of the ring, pads with silence on underrun */
+uint32_t dai_endpoint_read(struct dai_endpoint *ep, void *data,
+    uint32_t bytes)
+{
+    uint8_t *buf = data;
+    uint32_t off, n, count;
+
+    if (ep == NULL || ep->ops == &dai_backends[DAI_BACKEND_NONE]) {
+        memset(data, 0, bytes);
+        return 0;
+    }
+
+    qemu_mutex_lock(&ep->mutex);
+
+    count = MIN(bytes, ep->head - ep->tail);
+    if (count < bytes)
+        ep->xruns++;
+
+    off = ep->tail % DAI_RING_SIZE;
+    n = MIN(count, DAI_RING_SIZE - off);
+    memcpy(buf, ep->ring + off, n);
+    memcpy(buf + n, ep->ring, count - n);
+    memset(buf + count, 0, bytes - count);
+
+    /* thread only sleeps on a full ring */
+    if (ep->head - ep->tail == DAI_RING_SIZE)
+        qemu_cond_signal(&ep->cond);
+    ep->tail += count;
+
+    qemu_mutex_unlock(&ep->mutex);
+    return count;
+}
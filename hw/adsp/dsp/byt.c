@@ -120,6 +120,8 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     //adsp->cpu_model = machine->cpu_model;
     adsp->kernel_filename = qemu_opt_get(adsp->machine_opts, "kernel");
     adsp->ops = &byt_ops;
+    adsp->clk_kHz = 19200;    /* SSP master clock */
+    adsp_time_warp_init(machine);
 
     /* initialise CPU */
     if (!adsp->cpu_model) {
@@ -148,7 +150,9 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     }
 
     adsp_create_memory_regions(adsp);
+    adsp_profile_init(adsp);
     adsp_create_io_devices(adsp, NULL);
+    adsp_trace_init(adsp);
 
     /* reset all devices to init state */
     qemu_devices_reset();
@@ -363,7 +367,7 @@ static void xtensa_byt_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_byt", xtensa_byt_machine_init)
+DEFINE_ADSP_MACHINE("adsp_byt", xtensa_byt_machine_init)
 
 static void xtensa_cht_machine_init(MachineClass *mc)
 {
@@ -374,4 +378,4 @@ static void xtensa_cht_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_cht", xtensa_cht_machine_init)
+DEFINE_ADSP_MACHINE("adsp_cht", xtensa_cht_machine_init)
@@ -158,10 +158,38 @@ struct cavs_irq_map irq_map[] = {
     {5, IRQ_NUM_EXT_LEVEL5},
 };
 
+/*
+ * The raw status is shared by all cores, each core has its own mask and
+ * status registers. Recompute the per core status for a level and route
+ * the level 1 IRQ to every core that has the source unmasked.
+ */
+static void cavs_irq_update(struct adsp_io_info *info, int level, int raise)
+{
+    struct adsp_dev *adsp = info->adsp;
+    uint32_t raw = info->region[ILRSD(level) >> 2];
+    uint32_t status, old;
+    int core;
+
+    for (core = 0; core < adsp->num_cores; core++) {
+        old = info->region[ILSCC(level, core) >> 2];
+        status = raw & ~info->region[ILMCC(level, core) >> 2];
+        info->region[ILSCC(level, core) >> 2] = status;
+
+        if (!status)
+            adsp_set_core_lvl1_irq(adsp, core, irq_map[level - 2].irq, 0);
+        else if (raise || (status & ~old))
+            adsp_set_core_lvl1_irq(adsp, core, irq_map[level - 2].irq, 1);
+    }
+}
+
 /* mask values copied as is */
 static void cavs_do_set_irq(struct adsp_io_info *info,
     const struct cavs_irq_desc *irq_desc, uint32_t mask)
 {
+    /* status lives in the IRQ controller, not the requesting device */
+    if (info->adsp->irq)
+        info = info->adsp->irq;
+
     if (irq_desc->shift) {
         info->region[ILRSD(irq_desc->level) >> 2] &= ~irq_desc->mask;
         info->region[ILRSD(irq_desc->level) >> 2] |= (mask << irq_desc->shift);
@@ -169,29 +197,24 @@ static void cavs_do_set_irq(struct adsp_io_info *info,
         info->region[ILRSD(irq_desc->level) >> 2] |= irq_desc->mask;
     }
 
-    info->region[ILSC(irq_desc->level) >> 2] =
-        info->region[ILRSD(irq_desc->level) >> 2] &
-        (~info->region[ILMC(irq_desc->level) >> 2]);
-
-    adsp_set_lvl1_irq(info->adsp, irq_map[irq_desc->level - 2].irq, 1);
+    cavs_irq_update(info, irq_desc->level, 1);
 }
 
 /* mask values copied as is */
 static void cavs_do_clear_irq(struct adsp_io_info *info,
     const struct cavs_irq_desc *irq_desc, uint32_t mask)
 {
+    if (info->adsp->irq)
+        info = info->adsp->irq;
+
     if (irq_desc->shift) {
        info->region[ILRSD(irq_desc->level) >> 2] &= ~irq_desc->mask;
        info->region[ILRSD(irq_desc->level) >> 2] |= (mask << irq_desc->shift);
     } else {
         info->region[ILRSD(irq_desc->level) >> 2] &= ~irq_desc->mask;
     }
-     info->region[ILSC(irq_desc->level) >> 2] =
-        info->region[ILRSD(irq_desc->level) >> 2] &
-        (~info->region[ILMC(irq_desc->level) >> 2]);
 
-    if (!info->region[ILSC(irq_desc->level) >> 2])
-        adsp_set_lvl1_irq(info->adsp, irq_map[irq_desc->level - 2].irq, 0);
+    cavs_irq_update(info, irq_desc->level, 0);
 }
 
 static void cavs_irq_1_5_set(struct adsp_io_info *info, int irq, uint32_t mask)
@@ -263,10 +286,24 @@ static void adsp_pm_msg(struct adsp_dev *adsp, struct qemu_io_msg *msg)
 void adsp_cavs_irq_msg(struct adsp_dev *adsp, struct qemu_io_msg *msg)
 {
     qemu_mutex_lock_iothread();
-    adsp_set_lvl1_irq(adsp, IRQ_IPC, 1);
+    cavs_irq_set(adsp->irq, IRQ_IPC, 0);
     qemu_mutex_unlock_iothread();
 }
 
+/* IPC source is level, drop it once both busy and done are acked */
+static void cavs_ipc_ack(struct adsp_io_info *info, uint32_t busy_reg,
+    uint32_t done_reg)
+{
+    struct adsp_dev *adsp = info->adsp;
+
+    if (info->region[busy_reg >> 2] & IPC_DIPCT_DSPLRST)
+        return;
+    if (info->region[done_reg >> 2] & IPC_DIPCIE_DONE)
+        return;
+
+    cavs_irq_clear(adsp->irq, IRQ_IPC, 0);
+}
+
 static int bridge_cb(void *data, struct qemu_io_msg *msg)
 {
     struct adsp_dev *adsp = (struct adsp_dev *)data;
@@ -368,8 +405,11 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     void *man_ptr, *desc_ptr;
     int n, skip, size;
     void *rom;
+    uint32_t params[3];
+    const char *trace_regs;
+    char *snap;
 
-    adsp = g_malloc(sizeof(*adsp));
+    adsp = g_malloc0(sizeof(*adsp));
     adsp->desc = board;
     adsp->shm_idx = 0;
     adsp->system_memory = get_system_memory();
@@ -377,9 +417,13 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
   //  adsp->cpu_model = machine->cpu_model;
     adsp->kernel_filename = qemu_opt_get(adsp->machine_opts, "kernel");
     adsp->rom_filename = qemu_opt_get(adsp->machine_opts, "rom");
-    adsp->log = log_init(NULL, qemu_opt_get(adsp->machine_opts, "trace_regs"));
+    trace_regs = qemu_opt_get(adsp->machine_opts, "trace_regs");
+    if (trace_regs == NULL)
+        trace_regs = qemu_opt_get(adsp->machine_opts, "trace-regs");
+    adsp->log = log_init(NULL, trace_regs);
     adsp->ops = board->ops;
     adsp->clk_kHz = clk_kHz;
+    adsp_time_warp_init(machine);
 
     /* initialise CPU */
     if (!adsp->cpu_model) {
@@ -407,9 +451,12 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
         */
         cpu_reset(CPU(adsp->xtensa[n]->cpu));
     }
+    adsp->num_cores = machine->smp.cpus;
 
     adsp_create_memory_regions(adsp);
+    adsp_profile_init(adsp);
     adsp_create_io_devices(adsp, &cavs_io_ops);
+    adsp_trace_init(adsp);
 
     /* reset all devices to init state */
     qemu_devices_reset();
@@ -427,6 +474,16 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     printf("now loading:\n kernel %s\n ROM %s\n",
         adsp->kernel_filename, adsp->rom_filename);
 
+    /* skip ROM and manifest parsing if this image was loaded before */
+    params[0] = copy_modules;
+    params[1] = exec_addr;
+    params[2] = imr_addr;
+    snap = adsp_snapshot_path(adsp, name, params, sizeof(params));
+    if (snap && adsp_snapshot_load(adsp, snap) == 0) {
+        g_free(snap);
+        return adsp;
+    }
+
     if (adsp->rom_filename != NULL) {
 
         /* get ROM */
@@ -489,14 +546,27 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     }
 
 out:
+    if (snap) {
+        adsp_snapshot_save(adsp, snap);
+        g_free(snap);
+    }
     return adsp;
 }
 
 static void cavs_irq_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info)
 {
+    int core, level;
+
     adsp->timer[0].info = info;
     adsp->timer[1].info = info;
+    adsp->irq = info;
+
+    /* secondary cores start with all sources masked */
+    for (core = 1; core < ADSP_MAX_CORES; core++) {
+        for (level = 2; level <= 5; level++)
+            info->region[ILMCC(level, core) >> 2] = 0xffffffff;
+    }
 }
 
 static uint64_t cavs_irq_read(void *opaque, hwaddr addr,
@@ -518,115 +588,27 @@ static void cavs_irq_write(void *opaque, hwaddr addr,
     struct adsp_io_info *info = opaque;
     struct adsp_dev *adsp = info->adsp;
     struct adsp_reg_space *space = info->space;
-
-    switch (addr) {
-    case ILMSD(2):
-        /* mask set - level 2 */
-        if (!(info->region[ILMC(2) >> 2] & val)) {
-            info->region[ILMC(2) >> 2] |= val;
-
-            info->region[ILSC(2) >> 2] =
-                (~info->region[ILMC(2) >> 2]) & info->region[ILRSD(2) >> 2];
-
-            /* clear IRQ if no other IRQ left */
-            if (!info->region[ILSC(2) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL2, 0);
-        }
-        break;
-    case ILMSD(3):
-         /* mask set - level 3 */
-        if (!(info->region[ILMC(3) >> 2] & val)) {
-            info->region[ILMC(3) >> 2] |= val;
-
-            info->region[ILSC(3) >> 2] =
-                (~info->region[ILMC(3) >> 2]) & info->region[ILRSD(3) >> 2];
-
-            /* clear IRQ if no other IRQ left */
-            if (!info->region[ILSC(3) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL3, 0);
+    int core, level;
+
+    /* per core blocks below the shared raw status */
+    if (addr < ILRSD(2)) {
+        core = addr / IL_CORE_SIZE;
+        level = (addr % IL_CORE_SIZE) / 0x10 + 2;
+
+        switch (addr - IL_CORE_SIZE * core - ILMSD(level)) {
+        case 0:
+            /* mask set - clear IRQ if no other IRQ left */
+            info->region[ILMCC(level, core) >> 2] |= val;
+            cavs_irq_update(info, level, 0);
+            break;
+        case 4:
+            /* mask clear - generate an IRQ if it was masked */
+            info->region[ILMCC(level, core) >> 2] &= ~val;
+            cavs_irq_update(info, level, 0);
+            break;
+        default:
+            break;
         }
-        break;
-    case ILMSD(4):
-        /* mask set - level 4 */
-        if (!(info->region[ILMC(4) >> 2] & val)) {
-            info->region[ILMC(4) >> 2] |= val;
-
-            info->region[ILSC(4) >> 2] =
-                (~info->region[ILMC(4) >> 2]) & info->region[ILRSD(4) >> 2];
-
-            /* clear IRQ if no other IRQ left */
-            if (!info->region[ILSC(4) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL4, 0);
-        }
-        break;
-    case ILMSD(5):
-        /* mask set - level 5 */
-        if (!(info->region[ILMC(5) >> 2] & val)) {
-            info->region[ILMC(5) >> 2] |= val;
-
-            info->region[ILSC(5) >> 2] =
-                (~info->region[ILMC(5) >> 2]) & info->region[ILRSD(5) >> 2];
-
-            /* clear IRQ if no other IRQ left */
-            if (!info->region[ILSC(5) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL5, 0);
-        }
-        break;
-    case ILMCD(2):
-         /* mask clear - level 2 */
-         if (info->region[ILMC(2) >> 2] & val) {
-             info->region[ILMC(2) >> 2] &= ~val;
-
-            info->region[ILSC(2) >> 2] =
-                (~info->region[ILMC(2) >> 2]) & info->region[ILRSD(2) >> 2];
-
-            /* generate an IRQ if it was masked */
-            if (info->region[ILSC(2) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL2, 1);
-        }
-        break;
-     case ILMCD(3):
-         /* mask clear - level 3 */
-         if (info->region[ILMC(3) >> 2] & val) {
-             info->region[ILMC(3) >> 2] &= ~val;
-
-            info->region[ILSC(3) >> 2] =
-                (~info->region[ILMC(3) >> 2]) & info->region[ILRSD(3) >> 2];
-
-            /* generate an IRQ if it was masked */
-            if (info->region[ILSC(3) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL3, 1);
-        }
-        break;
-     case ILMCD(4):
-         /* mask clear - level 4 */
-         if (info->region[ILMC(4) >> 2] & val) {
-             info->region[ILMC(4) >> 2] &= ~val;
-
-            info->region[ILSC(4) >> 2] =
-                (~info->region[ILMC(4) >> 2]) & info->region[ILRSD(4) >> 2];
-
-            /* generate an IRQ if it was masked */
-            if (info->region[ILSC(4) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL4, 1);
-        }
-        break;
-
-     case ILMCD(5):
-         /* mask clear - level 5 */
-         if (info->region[ILMC(5) >> 2] & val) {
-             info->region[ILMC(5) >> 2] &= ~val;
-
-            info->region[ILSC(5) >> 2] =
-                (~info->region[ILMC(5) >> 2]) & info->region[ILRSD(5) >> 2];
-
-            /* generate an IRQ if it was masked */
-            if (info->region[ILSC(5) >> 2])
-                 adsp_set_lvl1_irq(adsp, IRQ_NUM_EXT_LEVEL5, 1);
-        }
-        break;
-    default:
-    break;
     }
 
     log_write(adsp->log, space, addr, val, size,
@@ -675,6 +657,7 @@ static void cavs_ipc_1_5_write(void *opaque, hwaddr addr,
         /* host to DSP */
         if (val & IPC_DIPCT_DSPLRST)
             info->region[addr >> 2] &= ~IPC_DIPCT_DSPLRST;
+        cavs_ipc_ack(info, IPC_DIPCT, IPC_DIPCIE);
     break;
     case IPC_DIPCI:
         /* DSP to host */
@@ -697,6 +680,7 @@ static void cavs_ipc_1_5_write(void *opaque, hwaddr addr,
             info->region[addr >> 2] = val & ~(0x1 << 31);
             if (val & IPC_DIPCIE_DONE)
                 info->region[addr >> 2] &= ~IPC_DIPCIE_DONE;
+            cavs_ipc_ack(info, IPC_DIPCT, IPC_DIPCIE);
         break;
         case IPC_DIPCCTL5:
              /* assume interrupts are not masked atm */
@@ -852,6 +836,14 @@ static void sue_ctrl_init(struct adsp_dev *adsp, MemoryRegion *parent,
 #define HSRMCTL1		0x24
 #define HSPGISTS1		0x28
 
+#define HSPGCTL2		0x30
+#define HSRMCTL2		0x34
+#define HSPGISTS2		0x38
+
+#define HSPGCTL3		0x40
+#define HSRMCTL3		0x44
+#define HSPGISTS3		0x48
+
 #define LSPGCTL			0x50
 #define LSRMCTL			0x54
 #define LSPGISTS		0x58
@@ -861,6 +853,9 @@ static void cavs1_8_l2m_init(struct adsp_dev *adsp, MemoryRegion *parent,
 {
     info->region[HSPGISTS0 >> 2] = 0x00ffffff;
     info->region[HSPGISTS1 >> 2] = 0x00ffffff;
+
+    adsp_mem_gate_init(adsp, "hp-sram", ADSP_CAVS_1_8_DSP_SRAM_BANK_SIZE);
+    adsp_mem_gate_init(adsp, "lp-sram", ADSP_CAVS_1_8_DSP_SRAM_BANK_SIZE);
 }
 
 static uint64_t cavs1_8_l2m_read(void *opaque, hwaddr addr,
@@ -885,10 +880,16 @@ static void cavs1_8_l2m_write(void *opaque, hwaddr addr,
 
     switch (addr) {
     case HSPGCTL0:
-         info->region[HSPGISTS0 >> 2] = val;
-         break;
     case HSPGCTL1:
-         info->region[HSPGISTS1 >> 2] = val;
+    case HSPGCTL2:
+    case HSPGCTL3:
+         /* 32 banks per register, HSPGISTSn follows HSPGCTLn */
+         info->region[(addr + 8) >> 2] = val;
+         adsp_mem_power_gate(adsp, "hp-sram", (addr - HSPGCTL0) * 2, val);
+         break;
+    case LSPGCTL:
+         info->region[LSPGISTS >> 2] = val;
+         adsp_mem_power_gate(adsp, "lp-sram", 0, val);
          break;
     default:
 	break;
@@ -942,6 +943,7 @@ static void cavs_ipc_1_8_write(void *opaque, hwaddr addr,
         /* host to DSP */
         if (val & IPC_DIPCT_DSPLRST)
             info->region[addr >> 2] &= ~IPC_DIPCT_DSPLRST;
+        cavs_ipc_ack(info, IPC_DIPCTDR, IPC_DIPCIDA);
         break;
     case IPC_DIPCTDA:
         /* DSP to host */
@@ -986,6 +988,7 @@ static void cavs_ipc_1_8_write(void *opaque, hwaddr addr,
             info->region[addr >> 2] = val & ~(0x1 << 31);
             if (val & IPC_DIPCIE_DONE)
                 info->region[addr >> 2] &= ~IPC_DIPCIE_DONE;
+            cavs_ipc_ack(info, IPC_DIPCTDR, IPC_DIPCIDA);
         break;
     case IPC_DIPCCTL8:
              /* assume interrupts are not masked atm */
@@ -1307,7 +1310,7 @@ static void xtensa_bxt_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_bxt", xtensa_bxt_machine_init)
+DEFINE_ADSP_MACHINE("adsp_bxt", xtensa_bxt_machine_init)
 
 static void skl_adsp_init(MachineState *machine)
 {
@@ -1324,7 +1327,7 @@ static void xtensa_skl_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_skl", xtensa_skl_machine_init)
+DEFINE_ADSP_MACHINE("adsp_skl", xtensa_skl_machine_init)
 
 static void kbl_adsp_init(MachineState *machine)
 {
@@ -1341,7 +1344,7 @@ static void xtensa_kbl_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_kbl", xtensa_kbl_machine_init)
+DEFINE_ADSP_MACHINE("adsp_kbl", xtensa_kbl_machine_init)
 
 static void sue_adsp_init(MachineState *machine)
 {
@@ -1359,7 +1362,7 @@ static void xtensa_sue_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_sue", xtensa_sue_machine_init)
+DEFINE_ADSP_MACHINE("adsp_sue", xtensa_sue_machine_init)
 
 static void cnl_adsp_init(MachineState *machine)
 {
@@ -1376,7 +1379,7 @@ static void xtensa_cnl_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_cnl", xtensa_cnl_machine_init)
+DEFINE_ADSP_MACHINE("adsp_cnl", xtensa_cnl_machine_init)
 
 static void icl_adsp_init(MachineState *machine)
 {
@@ -1393,7 +1396,7 @@ static void xtensa_icl_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_icl", xtensa_icl_machine_init)
+DEFINE_ADSP_MACHINE("adsp_icl", xtensa_icl_machine_init)
 
 static void tgl_adsp_init(MachineState *machine)
 {
@@ -1410,4 +1413,4 @@ static void xtensa_tgl_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_tgl", xtensa_tgl_machine_init)
+DEFINE_ADSP_MACHINE("adsp_tgl", xtensa_tgl_machine_init)
@@ -20,8 +20,10 @@
 
 #include "qemu/osdep.h"
 #include "qapi/error.h"
+#include "qapi/visitor.h"
 #include "qemu-common.h"
 #include "sysemu/sysemu.h"
+#include "sysemu/cpus.h"
 #include "hw/boards.h"
 #include "hw/loader.h"
 #include "elf.h"
@@ -38,21 +40,296 @@
 /* In ASCII `XMan` */
 #define SND_SOF_EXT_MAN_MAGIC_NUMBER	0x6e614d58
 
-void adsp_set_lvl1_irq(struct adsp_dev *adsp, int irq, int active)
+/*
+ * Must be called with the iothread lock held. With MTTCG the target core
+ * runs in its own thread so INTSET is updated atomically as pic_cpu.c does.
+ */
+static void adsp_set_env_irq(CPUXtensaState *env, int irq, int active)
 {
-    /* TODO: allow interrupts other cores than core 0 */
-    CPUXtensaState *env = adsp->xtensa[0]->env;
     uint32_t irq_bit = 1 << irq;
 
     if (active) {
-        env->sregs[INTSET] |= irq_bit;
+        atomic_or(&env->sregs[INTSET], irq_bit);
     } else if (env->config->interrupt[irq].inttype == INTTYPE_LEVEL) {
-        env->sregs[INTSET] &= ~irq_bit;
+        atomic_and(&env->sregs[INTSET], ~irq_bit);
     }
 
     check_interrupts(env);
 }
 
+void adsp_set_core_lvl1_irq(struct adsp_dev *adsp, int core, int irq,
+    int active)
+{
+    if (core < 0 || core >= adsp->num_cores)
+        return;
+
+    adsp_set_env_irq(adsp->xtensa[core]->env, irq, active);
+}
+
+void adsp_set_lvl1_irq(struct adsp_dev *adsp, int irq, int active)
+{
+    adsp_set_env_irq(adsp->xtensa[0]->env, irq, active);
+}
+
+/* bridge messages can wake the DSP, so dont warp while any are in flight */
+static bool adsp_time_warp_busy(void)
+{
+    return qemu_io_pending();
+}
+
+void adsp_time_warp_init(MachineState *machine)
+{
+    if (!ADSP_MACHINE(machine)->time_warp)
+        return;
+
+    cpu_enable_time_warp(adsp_time_warp_busy);
+    printf(" ** time warp enabled, idle periods skip virtual time\n");
+}
+
+static bool adsp_machine_get_time_warp(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return ams->time_warp;
+}
+
+static void adsp_machine_set_time_warp(Object *obj, bool value, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    ams->time_warp = value;
+}
+
+static char *adsp_machine_get_profile(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return g_strdup(ams->profile);
+}
+
+static void adsp_machine_set_profile(Object *obj, const char *value,
+                                     Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->profile);
+    ams->profile = g_strdup(value);
+}
+
+static char *adsp_machine_get_profile_elf(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return g_strdup(ams->profile_elf);
+}
+
+static void adsp_machine_set_profile_elf(Object *obj, const char *value,
+                                         Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->profile_elf);
+    ams->profile_elf = g_strdup(value);
+}
+
+static void adsp_machine_finalize(Object *obj)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->profile);
+    g_free(ams->profile_elf);
+    g_free(ams->trace);
+    g_free(ams->trace_ldc);
+    g_free(ams->trace_area);
+    g_free(ams->trace_regs);
+}
+
+static bool adsp_machine_get_mem_stats(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return ams->mem_stats;
+}
+
+static void adsp_machine_set_mem_stats(Object *obj, bool value, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    ams->mem_stats = value;
+}
+
+static char *adsp_machine_get_trace(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return g_strdup(ams->trace);
+}
+
+static void adsp_machine_set_trace(Object *obj, const char *value,
+                                   Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->trace);
+    ams->trace = g_strdup(value);
+}
+
+static char *adsp_machine_get_trace_ldc(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return g_strdup(ams->trace_ldc);
+}
+
+static void adsp_machine_set_trace_ldc(Object *obj, const char *value,
+                                       Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->trace_ldc);
+    ams->trace_ldc = g_strdup(value);
+}
+
+static char *adsp_machine_get_trace_area(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return g_strdup(ams->trace_area);
+}
+
+static void adsp_machine_set_trace_area(Object *obj, const char *value,
+                                        Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->trace_area);
+    ams->trace_area = g_strdup(value);
+}
+
+static void adsp_machine_get_trace_us(Object *obj, Visitor *v,
+                                      const char *name, void *opaque,
+                                      Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    visit_type_uint32(v, name, &ams->trace_us, errp);
+}
+
+static void adsp_machine_set_trace_us(Object *obj, Visitor *v,
+                                      const char *name, void *opaque,
+                                      Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    visit_type_uint32(v, name, &ams->trace_us, errp);
+}
+
+static void adsp_machine_get_trace_clk(Object *obj, Visitor *v,
+                                       const char *name, void *opaque,
+                                       Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    visit_type_uint32(v, name, &ams->trace_clk_khz, errp);
+}
+
+static void adsp_machine_set_trace_clk(Object *obj, Visitor *v,
+                                       const char *name, void *opaque,
+                                       Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    visit_type_uint32(v, name, &ams->trace_clk_khz, errp);
+}
+
+static char *adsp_machine_get_trace_regs(Object *obj, Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    return g_strdup(ams->trace_regs);
+}
+
+static void adsp_machine_set_trace_regs(Object *obj, const char *value,
+                                        Error **errp)
+{
+    AdspMachineState *ams = ADSP_MACHINE(obj);
+
+    g_free(ams->trace_regs);
+    ams->trace_regs = g_strdup(value);
+}
+
+static void adsp_machine_class_init(ObjectClass *oc, void *data)
+{
+    object_class_property_add_str(oc, "trace-regs",
+        adsp_machine_get_trace_regs, adsp_machine_set_trace_regs, &error_abort);
+    object_class_property_set_description(oc, "trace-regs",
+        "Audio DSP register trace, text, bin or bin:<file>", &error_abort);
+
+    object_class_property_add_str(oc, "trace",
+        adsp_machine_get_trace, adsp_machine_set_trace, &error_abort);
+    object_class_property_set_description(oc, "trace",
+        "Audio DSP firmware trace output file, - for stdout", &error_abort);
+
+    object_class_property_add_str(oc, "trace-ldc",
+        adsp_machine_get_trace_ldc, adsp_machine_set_trace_ldc, &error_abort);
+    object_class_property_set_description(oc, "trace-ldc",
+        "Audio DSP firmware trace dictionary (.ldc)", &error_abort);
+
+    object_class_property_add_str(oc, "trace-area",
+        adsp_machine_get_trace_area, adsp_machine_set_trace_area, &error_abort);
+    object_class_property_set_description(oc, "trace-area",
+        "Audio DSP trace areas, addr:size[;addr:size]", &error_abort);
+
+    object_class_property_add(oc, "trace-us", "uint32",
+        adsp_machine_get_trace_us, adsp_machine_set_trace_us,
+        NULL, NULL, &error_abort);
+    object_class_property_set_description(oc, "trace-us",
+        "Audio DSP trace snapshot period in us of guest time", &error_abort);
+
+    object_class_property_add(oc, "trace-clk-khz", "uint32",
+        adsp_machine_get_trace_clk, adsp_machine_set_trace_clk,
+        NULL, NULL, &error_abort);
+    object_class_property_set_description(oc, "trace-clk-khz",
+        "Audio DSP trace timestamp clock in kHz", &error_abort);
+
+    object_class_property_add_bool(oc, "mem-stats",
+        adsp_machine_get_mem_stats, adsp_machine_set_mem_stats, &error_abort);
+    object_class_property_set_description(oc, "mem-stats",
+        "Report host memory used by the DSP at exit", &error_abort);
+
+    object_class_property_add_str(oc, "profile",
+        adsp_machine_get_profile, adsp_machine_set_profile, &error_abort);
+    object_class_property_set_description(oc, "profile",
+        "Xtensa firmware profile report file", &error_abort);
+
+    object_class_property_add_str(oc, "profile-elf",
+        adsp_machine_get_profile_elf, adsp_machine_set_profile_elf,
+        &error_abort);
+    object_class_property_set_description(oc, "profile-elf",
+        "Xtensa firmware ELF for profile symbols", &error_abort);
+
+    object_class_property_add_bool(oc, "time-warp",
+        adsp_machine_get_time_warp, adsp_machine_set_time_warp, &error_abort);
+    object_class_property_set_description(oc, "time-warp",
+        "Advance virtual time over idle periods", &error_abort);
+}
+
+static const TypeInfo adsp_machine_info = {
+    .name = TYPE_ADSP_MACHINE,
+    .parent = TYPE_MACHINE,
+    .abstract = true,
+    .instance_size = sizeof(AdspMachineState),
+    .instance_finalize = adsp_machine_finalize,
+    .class_init = adsp_machine_class_init,
+};
+
+static void adsp_machine_register_types(void)
+{
+    type_register_static(&adsp_machine_info);
+}
+
+type_init(adsp_machine_register_types)
+
 #define SST_FW_SIG_SIZE		4
 #define SST_HSW_FW_SIGN		"$SST"
 #define SST_HSW_IRAM	1
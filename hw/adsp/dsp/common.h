@@ -25,10 +25,48 @@
 #include "qapi/error.h"
 #include "qemu-common.h"
 #include "target/xtensa/cpu.h"
+#include "hw/boards.h"
 
 struct adsp_xtensa {
     XtensaCPU *cpu;
     CPUXtensaState *env;
 };
 
+/* DSP machines, holds the -machine options only the DSP boards use */
+#define TYPE_ADSP_MACHINE MACHINE_TYPE_NAME("adsp")
+#define ADSP_MACHINE(obj) \
+    OBJECT_CHECK(AdspMachineState, (obj), TYPE_ADSP_MACHINE)
+
+typedef struct AdspMachineState {
+    MachineState parent_obj;
+
+    char *profile;
+    char *profile_elf;
+    char *trace;
+    char *trace_ldc;
+    char *trace_area;
+    char *trace_regs;
+    uint32_t trace_us;
+    uint32_t trace_clk_khz;
+    bool mem_stats;
+    bool time_warp;
+} AdspMachineState;
+
+#define DEFINE_ADSP_MACHINE(namestr, machine_initfn) \
+    static void machine_initfn##_class_init(ObjectClass *oc, void *data) \
+    { \
+        MachineClass *mc = MACHINE_CLASS(oc); \
+        machine_initfn(mc); \
+    } \
+    static const TypeInfo machine_initfn##_typeinfo = { \
+        .name       = MACHINE_TYPE_NAME(namestr), \
+        .parent     = TYPE_ADSP_MACHINE, \
+        .class_init = machine_initfn##_class_init, \
+    }; \
+    static void machine_initfn##_register_types(void) \
+    { \
+        type_register_static(&machine_initfn##_typeinfo); \
+    } \
+    type_init(machine_initfn##_register_types)
+
 #endif
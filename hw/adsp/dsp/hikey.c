@@ -252,7 +252,9 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     }
 
     adsp_create_memory_regions(adsp);
+    adsp_profile_init(adsp);
     adsp_create_io_devices(adsp, &hikey_io_ops);
+    adsp_trace_init(adsp);
 
     /* reset all devices to init state */
     qemu_devices_reset();
@@ -428,4 +430,4 @@ static void xtensa_hikey960_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_hikey", xtensa_hikey960_machine_init)
+DEFINE_ADSP_MACHINE("adsp_hikey", xtensa_hikey960_machine_init)
@@ -115,6 +115,8 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
    // adsp->cpu_model = machine->cpu_model;
     adsp->kernel_filename = qemu_opt_get(adsp->machine_opts, "kernel");
     adsp->ops = &hsw_ops;
+    adsp->clk_kHz = 24000;    /* SSP master clock */
+    adsp_time_warp_init(machine);
 
     /* initialise CPU */
     if (!adsp->cpu_model) {
@@ -142,7 +144,9 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     }
 
     adsp_create_memory_regions(adsp);
+    adsp_profile_init(adsp);
     adsp_create_io_devices(adsp, NULL);
+    adsp_trace_init(adsp);
 
 
     /* reset all devices to init state */
@@ -298,7 +302,7 @@ static void xtensa_bdw_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_bdw", xtensa_bdw_machine_init)
+DEFINE_ADSP_MACHINE("adsp_bdw", xtensa_bdw_machine_init)
 
 static void xtensa_hsw_machine_init(MachineClass *mc)
 {
@@ -309,4 +313,4 @@ static void xtensa_hsw_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_hsw", xtensa_hsw_machine_init)
+DEFINE_ADSP_MACHINE("adsp_hsw", xtensa_hsw_machine_init)
@@ -71,6 +71,21 @@ static int bridge_cb(void *data, struct qemu_io_msg *msg)
     return 0;
 }
 
+static void imx8_irq_set(struct adsp_io_info *info, int irq, uint32_t mask)
+{
+     adsp_imx8_irqstr_set(info->adsp, irq, 1);
+}
+
+static void imx8_irq_clear(struct adsp_io_info *info, int irq, uint32_t mask)
+{
+     adsp_imx8_irqstr_set(info->adsp, irq, 0);
+}
+
+struct adsp_dev_ops imx8_ops = {
+    .irq_set = imx8_irq_set,
+    .irq_clear = imx8_irq_clear,
+};
+
 static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     MachineState *machine, const char *name)
 {
@@ -86,6 +101,8 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     adsp->system_memory = get_system_memory();
     adsp->machine_opts = qemu_get_machine_opts();
     adsp->kernel_filename = qemu_opt_get(adsp->machine_opts, "kernel");
+    adsp->ops = &imx8_ops;
+    adsp->irq = NULL;
 
     /* initialise CPU */
     if (!adsp->cpu_model) {
@@ -114,7 +131,9 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     }
 
     adsp_create_memory_regions(adsp);
+    adsp_profile_init(adsp);
     adsp_create_io_devices(adsp, NULL);
+    adsp_trace_init(adsp);
 
     /* reset all devices to init state */
     qemu_devices_reset();
@@ -329,7 +348,7 @@ static void xtensa_imx8x_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_imx8x", xtensa_imx8x_machine_init)
+DEFINE_ADSP_MACHINE("adsp_imx8x", xtensa_imx8x_machine_init)
 
 static void xtensa_imx8_machine_init(MachineClass *mc)
 {
@@ -340,4 +359,4 @@ static void xtensa_imx8_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_imx8", xtensa_imx8_machine_init)
+DEFINE_ADSP_MACHINE("adsp_imx8", xtensa_imx8_machine_init)
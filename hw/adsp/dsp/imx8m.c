@@ -69,6 +69,21 @@ static int bridge_cb(void *data, struct qemu_io_msg *msg)
     return 0;
 }
 
+static void imx8m_irq_set(struct adsp_io_info *info, int irq, uint32_t mask)
+{
+     adsp_imx8_irqstr_set(info->adsp, irq, 1);
+}
+
+static void imx8m_irq_clear(struct adsp_io_info *info, int irq, uint32_t mask)
+{
+     adsp_imx8_irqstr_set(info->adsp, irq, 0);
+}
+
+struct adsp_dev_ops imx8m_ops = {
+    .irq_set = imx8m_irq_set,
+    .irq_clear = imx8m_irq_clear,
+};
+
 static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     MachineState *machine, const char *name)
 {
@@ -84,6 +99,8 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     adsp->system_memory = get_system_memory();
     adsp->machine_opts = qemu_get_machine_opts();
     adsp->kernel_filename = qemu_opt_get(adsp->machine_opts, "kernel");
+    adsp->ops = &imx8m_ops;
+    adsp->irq = NULL;
 
     /* initialise CPU */
     if (!adsp->cpu_model) {
@@ -112,7 +129,9 @@ static struct adsp_dev *adsp_init(const struct adsp_desc *board,
     }
 
     adsp_create_memory_regions(adsp);
+    adsp_profile_init(adsp);
     adsp_create_io_devices(adsp, NULL);
+    adsp_trace_init(adsp);
 
     /* reset all devices to init state */
     qemu_devices_reset();
@@ -207,7 +226,7 @@ static struct adsp_reg_space imx8m_io[] = {
         .desc = {.base = ADSP_IMX8M_DSP_IRQSTR_BASE,
         .size = ADSP_IMX8M_DSP_IRQSTR_SIZE},},
     { .name = "sdma", .reg_count = ARRAY_SIZE(adsp_sdma_map),
-        .reg = adsp_sdma_map,
+        .reg = adsp_sdma_map, .irq = SDMA3_IRQ,
         .init = &sdma_init_dev, .ops = &sdma_ops,
         .desc = {.base = ADSP_IMX8M_DSP_SDMA_BASE,
         .size = ADSP_IMX8M_DSP_SDMA_SIZE},},
@@ -261,4 +280,4 @@ static void xtensa_imx8m_machine_init(MachineClass *mc)
     mc->default_cpu_type = XTENSA_DEFAULT_CPU_TYPE;
 }
 
-DEFINE_MACHINE("adsp_imx8m", xtensa_imx8m_machine_init)
+DEFINE_ADSP_MACHINE("adsp_imx8m", xtensa_imx8m_machine_init)
@@ -58,18 +58,57 @@ static uint64_t irqstr_read(void *opaque, hwaddr addr,
     return info->region[addr >> 2];
 }
 
+/* a DSP line is asserted while any of its unmasked inputs is pending */
+static void irqstr_line_update(struct adsp_io_info *info, int line)
+{
+    uint32_t pending = 0;
+    int n;
+
+    for (n = line * 2; n < line * 2 + 2; n++)
+        pending |= info->region[IRQSTR_CH_STATUS(n) >> 2] &
+            info->region[IRQSTR_CH_MASK(n) >> 2];
+
+    adsp_set_lvl1_irq(info->adsp, IRQ_NUM_IRQSTR_DSP0 + line, pending != 0);
+}
+
 static void irqstr_write(void *opaque, hwaddr addr,
         uint64_t val, unsigned size)
 {
     struct adsp_io_info *info = opaque;
     struct adsp_dev *adsp = info->adsp;
     struct adsp_reg_space *space = info->space;
+    int line;
 
     log_write(adsp->log, space, addr, val, size,
         info->region[addr >> 2]);
 
     /* set value via SHM */
     info->region[addr >> 2] = val;
+
+    /* unmasking may assert a line with inputs already pending */
+    if (addr >= ADSP_IRQSTR_MASK_OFFSET && addr < ADSP_IRQSTR_SET_OFFSET) {
+        for (line = 0; line < IRQSTR_IRQS_NUM / IRQSTR_IRQS_PER_LINE; line++)
+            irqstr_line_update(info, line);
+    }
+}
+
+/* peripheral input to the IRQ steer, irq is the SoC shared IRQ number */
+void adsp_imx8_irqstr_set(struct adsp_dev *adsp, int irq, int active)
+{
+    struct adsp_io_info *info = adsp->irq;
+    uint32_t *status;
+    int in = irq - IRQSTR_RESERVED_IRQS;
+
+    if (info == NULL || in < 0 || in >= IRQSTR_IRQS_NUM)
+        return;
+
+    status = &info->region[IRQSTR_CH_STATUS(in / 32) >> 2];
+    if (active)
+        *status |= 1 << (in % 32);
+    else
+        *status &= ~(1 << (in % 32));
+
+    irqstr_line_update(info, in / IRQSTR_IRQS_PER_LINE);
 }
 
 const MemoryRegionOps irqstr_io_ops = {
@@ -82,4 +121,5 @@ void adsp_imx8_irqstr_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info)
 {
     irqstr_reset(info);
+    adsp->irq = info;
 }
@@ -13,9 +13,22 @@
 #define ADSP_IRQSTR_MASTER_DISABLE_OFFSET   0xC4
 #define ADSP_IRQSTR_MASTER_STATUS_OFFSET    0xC8
 
+/* inputs are numbered after the reserved shared peripheral IRQs */
+#define IRQSTR_RESERVED_IRQS        32
+#define IRQSTR_IRQS_NUM             512
+#define IRQSTR_IRQS_PER_LINE        64
+#define IRQSTR_REGS_NUM             (IRQSTR_IRQS_NUM / 32)
+
+/* per 32 input registers are in reverse order */
+#define IRQSTR_CH_MASK(n)   (ADSP_IRQSTR_MASK_OFFSET + \
+                                4 * (IRQSTR_REGS_NUM - 1 - (n)))
+#define IRQSTR_CH_STATUS(n) (ADSP_IRQSTR_STATUS_OFFSET + \
+                                4 * (IRQSTR_REGS_NUM - 1 - (n)))
+
 #define IMX8_IRQSTR_REGS    6
 extern const struct adsp_reg_desc adsp_imx8_irqstr_map[IMX8_IRQSTR_REGS];
 
 void adsp_imx8_irqstr_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info);
+void adsp_imx8_irqstr_set(struct adsp_dev *adsp, int irq, int active);
 extern const MemoryRegionOps irqstr_io_ops;
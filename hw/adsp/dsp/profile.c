@@ -0,0 +1,222 @@
+/*
+ * Firmware cycle accounting profiler for audio DSP.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/notify.h"
+#include "qemu/option.h"
+#include "sysemu/sysemu.h"
+#include "elf.h"
+#include "target/xtensa/cpu.h"
+
+#include "hw/audio/adsp-dev.h"
+#include "hw/adsp/hw.h"
+
+/*
+ * Profiling is enabled by the profile machine option, e.g.
+ *
+ *  -machine bxt,profile=fw.prof,profile-elf=sof-apl.elf
+ *
+ * The report is written when QEMU exits. Function names come from the
+ * symbol table of the profile-elf file, or of the kernel image if that is
+ * an ELF. Use scripts/adsp-profile-diff.py to compare two reports.
+ */
+
+struct profile_sym {
+    uint32_t addr;
+    uint32_t size;
+    const char *name;
+};
+
+struct adsp_profile {
+    struct adsp_dev *adsp;
+    char *filename;
+    struct profile_sym *sym;
+    int num_sym;
+    gchar *strtab;
+    Notifier exit;
+};
+
+static int sym_cmp(const void *a, const void *b)
+{
+    const struct profile_sym *sa = a, *sb = b;
+
+    if (sa->addr != sb->addr)
+        return sa->addr < sb->addr ? -1 : 1;
+    return 0;
+}
+
+static uint32_t elf_word(const uint8_t *p, bool be)
+{
+    return be ? ldl_be_p(p) : ldl_le_p(p);
+}
+
+static uint16_t elf_half(const uint8_t *p, bool be)
+{
+    return be ? lduw_be_p(p) : lduw_le_p(p);
+}
+
+/* read FUNC symbols from ELF32 symtab, sorted by address */
+static int profile_load_symbols(struct adsp_profile *prof, const char *file)
+{
+    const Elf32_Ehdr *ehdr;
+    const uint8_t *shdr, *sh, *symtab, *strtab;
+    uint32_t shoff, sym_off, sym_size, str_off, str_size, name;
+    gchar *data;
+    gsize size;
+    bool be;
+    int i, shnum, shentsize, n;
+
+    if (!g_file_get_contents(file, &data, &size, NULL))
+        return -ENOENT;
+
+    ehdr = (const Elf32_Ehdr *)data;
+    if (size < sizeof(*ehdr) || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) ||
+        ehdr->e_ident[EI_CLASS] != ELFCLASS32)
+        goto err;
+
+    be = ehdr->e_ident[EI_DATA] == ELFDATA2MSB;
+    shoff = elf_word((const uint8_t *)&ehdr->e_shoff, be);
+    shnum = elf_half((const uint8_t *)&ehdr->e_shnum, be);
+    shentsize = elf_half((const uint8_t *)&ehdr->e_shentsize, be);
+    if (shentsize < sizeof(Elf32_Shdr) ||
+        shoff > size || (uint64_t)shnum * shentsize > size - shoff)
+        goto err;
+    shdr = (const uint8_t *)data + shoff;
+
+    for (i = 0; i < shnum; i++) {
+        sh = shdr + i * shentsize;
+        if (elf_word(sh + offsetof(Elf32_Shdr, sh_type), be) == SHT_SYMTAB)
+            break;
+    }
+    if (i == shnum)
+        goto err;
+
+    sym_off = elf_word(sh + offsetof(Elf32_Shdr, sh_offset), be);
+    sym_size = elf_word(sh + offsetof(Elf32_Shdr, sh_size), be);
+    i = elf_word(sh + offsetof(Elf32_Shdr, sh_link), be);
+    if (i >= shnum)
+        goto err;
+    sh = shdr + i * shentsize;
+    str_off = elf_word(sh + offsetof(Elf32_Shdr, sh_offset), be);
+    str_size = elf_word(sh + offsetof(Elf32_Shdr, sh_size), be);
+    if (sym_off > size || sym_size > size - sym_off ||
+        str_off > size || str_size > size - str_off || str_size == 0)
+        goto err;
+
+    symtab = (const uint8_t *)data + sym_off;
+    strtab = (const uint8_t *)data + str_off;
+    n = sym_size / sizeof(Elf32_Sym);
+    prof->sym = g_new0(struct profile_sym, n);
+
+    for (i = 0; i < n; i++) {
+        const uint8_t *s = symtab + i * sizeof(Elf32_Sym);
+        struct profile_sym *ps = &prof->sym[prof->num_sym];
+
+        if (ELF32_ST_TYPE(s[offsetof(Elf32_Sym, st_info)]) != STT_FUNC)
+            continue;
+        name = elf_word(s + offsetof(Elf32_Sym, st_name), be);
+        if (name >= str_size)
+            continue;
+
+        ps->addr = elf_word(s + offsetof(Elf32_Sym, st_value), be);
+        ps->size = elf_word(s + offsetof(Elf32_Sym, st_size), be);
+        ps->name = (const char *)strtab + name;
+        prof->num_sym++;
+    }
+
+    qsort(prof->sym, prof->num_sym, sizeof(*prof->sym), sym_cmp);
+
+    /* symbol names point into the file data, keep it */
+    prof->strtab = data;
+    return prof->num_sym;
+
+err:
+    g_free(data);
+    return -EINVAL;
+}
+
+static const char *profile_symbol(uint32_t addr, void *opaque)
+{
+    struct adsp_profile *prof = opaque;
+    int lo = 0, hi = prof->num_sym - 1, mid;
+    struct profile_sym *sym;
+
+    /* find last symbol at or below addr */
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (prof->sym[mid].addr <= addr)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+    if (hi < 0)
+        return NULL;
+
+    sym = &prof->sym[hi];
+    if (sym->size && addr - sym->addr >= sym->size)
+        return NULL;
+    return sym->name;
+}
+
+static void profile_exit(Notifier *n, void *data)
+{
+    struct adsp_profile *prof = container_of(n, struct adsp_profile, exit);
+    FILE *f;
+
+    f = fopen(prof->filename, "w");
+    if (f == NULL) {
+        fprintf(stderr, "profile: cant create %s: %d\n",
+            prof->filename, -errno);
+        return;
+    }
+
+    xtensa_profile_report(f, profile_symbol, prof);
+    fclose(f);
+    printf("profile: written to %s\n", prof->filename);
+}
+
+void adsp_profile_init(struct adsp_dev *adsp)
+{
+    const struct adsp_desc *board = adsp->desc;
+    const char *filename = qemu_opt_get(adsp->machine_opts, "profile");
+    const char *elf = qemu_opt_get(adsp->machine_opts, "profile-elf");
+    struct adsp_profile *prof;
+    struct adsp_mem_desc *mem;
+    char *name;
+    int i;
+
+    if (filename == NULL)
+        return;
+
+    prof = g_new0(struct adsp_profile, 1);
+    prof->adsp = adsp;
+    prof->filename = g_strdup(filename);
+
+    if (elf == NULL)
+        elf = adsp->kernel_filename;
+    if (elf && profile_load_symbols(prof, elf) < 0)
+        fprintf(stderr, "profile: no symbols in %s, using addresses\n", elf);
+
+    xtensa_profile_enable();
+
+    for (i = 0; i < board->num_mem; i++) {
+        mem = &board->mem_region[i];
+        xtensa_profile_add_region(mem->name, mem->base, mem->size);
+        if (mem->alias) {
+            name = g_strdup_printf("%s (alias)", mem->name);
+            xtensa_profile_add_region(name, mem->alias, mem->size);
+            g_free(name);
+        }
+    }
+
+    prof->exit.notify = profile_exit;
+    qemu_add_exit_notifier(&prof->exit);
+}
@@ -0,0 +1,268 @@
+/*
+ * Boot snapshot cache for audio DSP.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include <sys/mman.h>
+#include "qemu/cutils.h"
+
+#include "hw/audio/adsp-dev.h"
+#include "hw/adsp/hw.h"
+
+/*
+ * The snapshot holds the DSP memory contents after ROM and firmware have
+ * been loaded, it replaces reading and parsing the images but the ROM
+ * still boots the firmware on every launch. CPU and device state are not
+ * saved. It is keyed by a SHA256 over the machine name, the load
+ * parameters and the identity of the kernel and ROM image files, so a
+ * hit only costs a stat() of each image.
+ *
+ * Only non zero pages are stored, as extents of :-
+ *
+ *  struct adsp_snapshot_extent
+ *  uint8_t data[extent.size]
+ *
+ * Snapshots are enabled by setting ADSP_BOOT_CACHE to a cache directory.
+ */
+
+#define SNAPSHOT_MAGIC      "ADSPSNAP"
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_PAGE       4096
+
+struct adsp_snapshot_hdr {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_mem;
+    uint32_t num_extents;
+    uint32_t reserved;
+};
+
+struct adsp_snapshot_extent {
+    uint32_t mem;       /* index into board mem_region[] */
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+/* rewriting or replacing an image changes its size, mtime or inode */
+static int snapshot_hash_file(GChecksum *sum, const char *filename)
+{
+    uint64_t id[5];
+    struct stat st;
+
+    if (filename == NULL)
+        return 0;
+
+    if (stat(filename, &st) < 0)
+        return -errno;
+
+    id[0] = st.st_dev;
+    id[1] = st.st_ino;
+    id[2] = st.st_size;
+    id[3] = st.st_mtim.tv_sec;
+    id[4] = st.st_mtim.tv_nsec;
+    g_checksum_update(sum, (const guchar *)filename, strlen(filename) + 1);
+    g_checksum_update(sum, (const guchar *)id, sizeof(id));
+    return 0;
+}
+
+/* get cache file for this firmware or NULL if caching is disabled */
+char *adsp_snapshot_path(struct adsp_dev *adsp, const char *name,
+    const void *params, size_t params_size)
+{
+    const char *dir = getenv("ADSP_BOOT_CACHE");
+    GChecksum *sum;
+    char *path = NULL;
+
+    if (dir == NULL || adsp->kernel_filename == NULL)
+        return NULL;
+
+    sum = g_checksum_new(G_CHECKSUM_SHA256);
+    g_checksum_update(sum, (const guchar *)name, strlen(name) + 1);
+    g_checksum_update(sum, params, params_size);
+
+    if (snapshot_hash_file(sum, adsp->kernel_filename) < 0 ||
+        snapshot_hash_file(sum, adsp->rom_filename) < 0)
+        goto out;
+
+    if (g_mkdir_with_parents(dir, 0755) < 0) {
+        fprintf(stderr, "snapshot: cant create cache dir %s: %d\n",
+            dir, -errno);
+        goto out;
+    }
+
+    path = g_strdup_printf("%s/%s-%s.snap", dir, name,
+        g_checksum_get_string(sum));
+
+out:
+    g_checksum_free(sum);
+    return path;
+}
+
+/* restore memory from snapshot, returns 0 on hit */
+int adsp_snapshot_load(struct adsp_dev *adsp, const char *path)
+{
+    const struct adsp_desc *board = adsp->desc;
+    const struct adsp_snapshot_hdr *hdr;
+    const struct adsp_snapshot_extent *ext;
+    struct adsp_mem_desc *mem;
+    struct stat st;
+    uint8_t *map, *pos, *end;
+    int fd, i, ret = -EINVAL;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+
+    if (fstat(fd, &st) < 0 || st.st_size < sizeof(*hdr)) {
+        close(fd);
+        return -EINVAL;
+    }
+
+    /* private read only mapping, data is copied into the shared regions */
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return -errno;
+
+    hdr = (const struct adsp_snapshot_hdr *)map;
+    if (memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(hdr->magic)) ||
+        hdr->version != SNAPSHOT_VERSION || hdr->num_mem != board->num_mem)
+        goto out;
+
+    pos = map + sizeof(*hdr);
+    end = map + st.st_size;
+
+    /* validate every extent before touching DSP memory */
+    for (i = 0; i < hdr->num_extents; i++) {
+        ext = (const struct adsp_snapshot_extent *)pos;
+        if (pos + sizeof(*ext) > end || ext->mem >= board->num_mem ||
+            ext->offset + ext->size > board->mem_region[ext->mem].size ||
+            ext->size > end - pos - sizeof(*ext))
+            goto out;
+        pos += sizeof(*ext) + ext->size;
+    }
+
+    /* discard rather than memset so untouched pages stay unallocated */
+    for (i = 0; i < board->num_mem; i++)
+        adsp_mem_discard(&board->mem_region[i], 0, board->mem_region[i].size);
+
+    pos = map + sizeof(*hdr);
+    for (i = 0; i < hdr->num_extents; i++) {
+        ext = (const struct adsp_snapshot_extent *)pos;
+        mem = &board->mem_region[ext->mem];
+        memcpy(mem->ptr + ext->offset, pos + sizeof(*ext), ext->size);
+        pos += sizeof(*ext) + ext->size;
+    }
+
+    printf("snapshot: restored %d extents from %s\n", hdr->num_extents, path);
+    ret = 0;
+
+out:
+    if (ret < 0)
+        fprintf(stderr, "snapshot: ignoring invalid %s\n", path);
+    munmap(map, st.st_size);
+    return ret;
+}
+
+static int snapshot_write(int fd, const void *data, size_t size)
+{
+    const uint8_t *buf = data;
+    ssize_t ret;
+
+    while (size) {
+        ret = write(fd, buf, size);
+        if (ret < 0) {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+        buf += ret;
+        size -= ret;
+    }
+
+    return 0;
+}
+
+/* save memory to snapshot, written to a temp file and renamed into place */
+void adsp_snapshot_save(struct adsp_dev *adsp, const char *path)
+{
+    const struct adsp_desc *board = adsp->desc;
+    struct adsp_snapshot_hdr hdr;
+    struct adsp_snapshot_extent ext;
+    struct adsp_mem_desc *mem;
+    size_t offset, page, start;
+    char *tmp;
+    int fd, i, err = 0;
+
+    tmp = g_strdup_printf("%s.%d", path, getpid());
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "snapshot: cant create %s: %d\n", tmp, -errno);
+        g_free(tmp);
+        return;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, SNAPSHOT_MAGIC, sizeof(hdr.magic));
+    hdr.version = SNAPSHOT_VERSION;
+    hdr.num_mem = board->num_mem;
+
+    /* header is rewritten once the extent count is known */
+    err = snapshot_write(fd, &hdr, sizeof(hdr));
+
+    for (i = 0; i < board->num_mem && !err; i++) {
+        mem = &board->mem_region[i];
+
+        for (offset = 0; offset < mem->size && !err; ) {
+            page = MIN(SNAPSHOT_PAGE, mem->size - offset);
+            if (buffer_is_zero(mem->ptr + offset, page)) {
+                offset += page;
+                continue;
+            }
+
+            /* coalesce adjacent used pages into one extent */
+            start = offset;
+            while (offset < mem->size) {
+                page = MIN(SNAPSHOT_PAGE, mem->size - offset);
+                if (buffer_is_zero(mem->ptr + offset, page))
+                    break;
+                offset += page;
+            }
+
+            memset(&ext, 0, sizeof(ext));
+            ext.mem = i;
+            ext.offset = start;
+            ext.size = offset - start;
+
+            err = snapshot_write(fd, &ext, sizeof(ext));
+            if (!err)
+                err = snapshot_write(fd, mem->ptr + start, ext.size);
+            hdr.num_extents++;
+        }
+    }
+
+    if (!err && pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr))
+        err = -errno;
+
+    close(fd);
+
+    if (!err && rename(tmp, path) < 0)
+        err = -errno;
+
+    if (err < 0) {
+        fprintf(stderr, "snapshot: failed to save %s: %d\n", path, err);
+        unlink(tmp);
+    } else {
+        printf("snapshot: saved %d extents to %s\n", hdr.num_extents, path);
+    }
+
+    g_free(tmp);
+}
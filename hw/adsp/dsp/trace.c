@@ -0,0 +1,636 @@
+/*
+ * Bulk firmware trace decoder for audio DSP.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/error-report.h"
+#include "qemu/option.h"
+#include "qemu/notify.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "qemu/atomic.h"
+#include "sysemu/sysemu.h"
+
+#include "hw/audio/adsp-dev.h"
+#include "hw/adsp/hw.h"
+#include "hw/adsp/log.h"
+
+/*
+ * Firmware trace is decoded in bulk instead of on every mailbox store, e.g.
+ *
+ *  -machine imx8,trace=fw.trace,trace-ldc=sof-imx8.ldc
+ *
+ * A timer snapshots the trace areas every trace-us (default 1000us of guest
+ * time) and queues changed snapshots to a decoder thread, so the vCPU never
+ * formats trace. The mailbox "trace" area is watched by default,
+ * trace-area=<addr>:<size>[;<addr>:<size>] watches other areas such as the
+ * local DMA trace buffer instead.
+ *
+ * Without trace-ldc entries are the legacy 16 byte class events. With it
+ * entries are SOF dictionary entries and the format strings come from the
+ * rimage .ldc file. Timestamps are converted to us with trace-clk-khz, or
+ * the board clock, and printed as raw ticks if neither is known. Status
+ * goes to stderr so trace=- keeps stdout for the trace alone.
+ */
+
+#define TRACE_PERIOD_US     1000
+#define TRACE_SNAPS         64      /* queued snapshots */
+#define TRACE_AREAS         4
+#define TRACE_MAX_PARAMS    16
+
+/* rimage .ldc dictionary */
+#define LDC_SIG             "Logs"
+
+struct ldc_header {
+    char sig[4];
+    uint32_t base_address;
+    uint32_t data_length;
+    uint32_t data_offset;
+};
+
+struct ldc_entry_header {
+    uint32_t level;
+    uint32_t component_class;
+    uint32_t params_num;
+    uint32_t line_idx;
+    uint32_t file_name_len;
+    uint32_t text_len;
+};
+
+/* firmware dictionary log entry, followed by params_num params */
+#define LOG_ENTRY_SIZE      20
+#define LOG_ENTRY_TS        8
+#define LOG_ENTRY_ADDR      16
+
+/* legacy class event, 64 bit timestamp then event and value */
+#define EVENT_SIZE          16
+
+struct trace_area {
+    char name[32];
+    const uint8_t *ptr;
+    uint32_t size;
+    uint8_t *last;          /* last queued snapshot, timer side */
+
+    /* newest decoded entry, decoder side */
+    bool decoded;
+    uint64_t last_ts;
+    uint32_t last_offset;
+};
+
+struct trace_snap {
+    int area;
+    uint8_t *data;
+};
+
+struct trace_entry {
+    uint64_t ts;
+    uint32_t offset;
+};
+
+struct adsp_trace {
+    struct adsp_dev *adsp;
+    FILE *file;
+    QEMUTimer *timer;
+    int64_t period_ns;
+    uint32_t clk_kHz;
+
+    struct trace_area area[TRACE_AREAS];
+    int num_areas;
+
+    /* snapshot ring, timer produces and decoder consumes */
+    struct trace_snap snap[TRACE_SNAPS];
+    uint32_t head;
+    uint32_t tail;
+    QemuThread thread;
+    int running;
+
+    /* dictionary */
+    gchar *ldc;
+    gsize ldc_size;
+    uint32_t ldc_base;
+    uint32_t ldc_length;
+    uint32_t ldc_offset;
+
+    /* stats */
+    uint64_t snapshots;
+    uint64_t bytes;
+    uint64_t entries;
+    uint64_t dropped;
+    int64_t start;
+
+    Notifier exit;
+};
+
+static const char * const trace_level[] = {
+    "", "ERROR", "WARN", "INFO", "DEBUG", "VERBOSE",
+};
+
+static int trace_load_ldc(struct adsp_trace *t, const char *file)
+{
+    const struct ldc_header *hdr;
+
+    if (!g_file_get_contents(file, &t->ldc, &t->ldc_size, NULL))
+        return -ENOENT;
+
+    hdr = (const struct ldc_header *)t->ldc;
+    if (t->ldc_size < sizeof(*hdr) || memcmp(hdr->sig, LDC_SIG, 4))
+        goto err;
+
+    t->ldc_base = hdr->base_address;
+    t->ldc_length = hdr->data_length;
+    t->ldc_offset = hdr->data_offset;
+    if (t->ldc_offset > t->ldc_size ||
+        t->ldc_length > t->ldc_size - t->ldc_offset ||
+        t->ldc_length < sizeof(struct ldc_entry_header))
+        goto err;
+
+    return 0;
+
+err:
+    g_free(t->ldc);
+    t->ldc = NULL;
+    return -EINVAL;
+}
+
+/* dictionary entry for a firmware log entry address */
+static const struct ldc_entry_header *trace_ldc_entry(struct adsp_trace *t,
+    uint32_t addr)
+{
+    const struct ldc_entry_header *e;
+    uint32_t offset = addr - t->ldc_base;
+
+    if (addr < t->ldc_base || offset > t->ldc_length - sizeof(*e))
+        return NULL;
+
+    e = (const struct ldc_entry_header *)(t->ldc + t->ldc_offset + offset);
+    if (e->params_num > TRACE_MAX_PARAMS ||
+        e->file_name_len > t->ldc_length - offset - sizeof(*e) ||
+        e->text_len > t->ldc_length - offset - sizeof(*e) - e->file_name_len)
+        return NULL;
+
+    return e;
+}
+
+static void trace_time(struct adsp_trace *t, GString *s, uint64_t ts)
+{
+    if (t->clk_kHz)
+        g_string_append_printf(s, "[%16.3f] ", ts * 1000.0 / t->clk_kHz);
+    else
+        g_string_append_printf(s, "[%16" PRIu64 "] ", ts);
+}
+
+/* printf the dictionary text with the integer params of the entry */
+static void trace_format(GString *s, const char *text, uint32_t len,
+    const uint8_t *param, uint32_t num)
+{
+    char spec[16];
+    uint32_t i, j, n, p = 0, val;
+    char c;
+
+    for (i = 0; i < len && text[i]; i++) {
+
+        if (text[i] != '%') {
+            g_string_append_c(s, text[i]);
+            continue;
+        }
+
+        /* flags and width are kept, length modifiers dropped */
+        spec[0] = '%';
+        n = 1;
+        for (j = i + 1; j < len && text[j] &&
+             strchr("-+ #0123456789.", text[j]) && n < sizeof(spec) - 2; j++)
+            spec[n++] = text[j];
+        while (j < len && text[j] && strchr("hlLqjzt", text[j]))
+            j++;
+        if (j == len || !text[j])
+            break;
+
+        c = text[j];
+        i = j;
+
+        if (c == '%') {
+            g_string_append_c(s, '%');
+            continue;
+        }
+
+        val = p < num ? ldl_le_p(param + 4 * p) : 0;
+        p++;
+
+        switch (c) {
+        case 'd':
+        case 'i':
+            spec[n++] = 'd';
+            spec[n] = 0;
+            g_string_append_printf(s, spec, (int32_t)val);
+            break;
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            spec[n++] = c;
+            spec[n] = 0;
+            g_string_append_printf(s, spec, val);
+            break;
+        case 'p':
+            g_string_append_printf(s, "0x%8.8x", val);
+            break;
+        default:
+            /* strings are not in the entry */
+            g_string_append_printf(s, "<0x%x>", val);
+            break;
+        }
+    }
+}
+
+static int entry_cmp(const void *a, const void *b)
+{
+    const struct trace_entry *ea = a, *eb = b;
+
+    if (ea->ts != eb->ts)
+        return ea->ts < eb->ts ? -1 : 1;
+    return ea->offset < eb->offset ? -1 : ea->offset > eb->offset;
+}
+
+/* size of the entry at offset, 0 if there is none */
+static uint32_t trace_entry_size(struct adsp_trace *t, struct trace_area *area,
+    const uint8_t *data, uint32_t offset, uint64_t *ts)
+{
+    const struct ldc_entry_header *e;
+    uint32_t size;
+
+    if (!t->ldc) {
+        *ts = ldq_le_p(data + offset);
+        if (*ts == 0 && ldl_le_p(data + offset + 8) == 0)
+            return 0;
+        return EVENT_SIZE;
+    }
+
+    e = trace_ldc_entry(t, ldl_le_p(data + offset + LOG_ENTRY_ADDR));
+    if (e == NULL)
+        return 0;
+
+    size = LOG_ENTRY_SIZE + e->params_num * 4;
+    if (offset + size > area->size)
+        return 0;
+
+    *ts = ldq_le_p(data + offset + LOG_ENTRY_TS);
+    return size;
+}
+
+/* entries are ordered by timestamp, then by offset for equal timestamps */
+static bool trace_entry_new(struct trace_area *area, uint64_t ts,
+    uint32_t offset)
+{
+    if (!area->decoded)
+        return true;
+    return ts > area->last_ts ||
+        (ts == area->last_ts && offset > area->last_offset);
+}
+
+/* find entries newer than the last decoded one, oldest first */
+static int trace_find_entries(struct adsp_trace *t, struct trace_area *area,
+    const uint8_t *data, struct trace_entry *entry)
+{
+    uint32_t offset = 0, size, min = t->ldc ? LOG_ENTRY_SIZE : EVENT_SIZE;
+    uint64_t ts, newest = 0;
+    int n = 0;
+
+    while (offset + min <= area->size) {
+
+        /* class events are slots, dictionary entries resync on garbage */
+        size = trace_entry_size(t, area, data, offset, &ts);
+        if (size == 0) {
+            offset += t->ldc ? 4 : EVENT_SIZE;
+            continue;
+        }
+
+        newest = MAX(newest, ts);
+        if (trace_entry_new(area, ts, offset)) {
+            entry[n].ts = ts;
+            entry[n].offset = offset;
+            n++;
+        }
+        offset += size;
+    }
+
+    /* firmware was reloaded, start again */
+    if (area->decoded && newest && newest < area->last_ts) {
+        area->decoded = false;
+        return trace_find_entries(t, area, data, entry);
+    }
+
+    qsort(entry, n, sizeof(*entry), entry_cmp);
+    if (n) {
+        area->decoded = true;
+        area->last_ts = entry[n - 1].ts;
+        area->last_offset = entry[n - 1].offset;
+    }
+    return n;
+}
+
+static void trace_decode(struct adsp_trace *t, struct trace_snap *snap,
+    struct trace_entry *entry, GString *s)
+{
+    struct trace_area *area = &t->area[snap->area];
+    const struct ldc_entry_header *e;
+    const uint8_t *p;
+    const char *trace, *file;
+    uint32_t event;
+    int i, n;
+
+    n = trace_find_entries(t, area, snap->data, entry);
+
+    for (i = 0; i < n; i++) {
+
+        p = snap->data + entry[i].offset;
+        g_string_truncate(s, 0);
+        trace_time(t, s, entry[i].ts);
+
+        if (!t->ldc) {
+            event = ldl_le_p(p + 8);
+            trace = log_trace_class(event);
+            if (trace)
+                g_string_append_printf(s, "%s %c%c%c\n", trace,
+                    (char)(event >> 16), (char)(event >> 8), (char)event);
+            else
+                g_string_append_printf(s, "0x%8.8x 0x%8.8x\n", event,
+                    ldl_le_p(p + 12));
+            fputs(s->str, t->file);
+            continue;
+        }
+
+        e = trace_ldc_entry(t, ldl_le_p(p + LOG_ENTRY_ADDR));
+        file = (const char *)(e + 1);
+
+        g_string_append_printf(s, "%-7s %.*s:%u  ",
+            e->level < ARRAY_SIZE(trace_level) ? trace_level[e->level] : "",
+            (int)e->file_name_len, file, e->line_idx);
+        trace_format(s, file + e->file_name_len, e->text_len,
+            p + LOG_ENTRY_SIZE, e->params_num);
+        g_string_append_c(s, '\n');
+        fputs(s->str, t->file);
+    }
+
+    t->entries += n;
+}
+
+/* returns the number of snapshots decoded */
+static uint32_t trace_flush(struct adsp_trace *t, struct trace_entry *entry,
+    GString *s)
+{
+    uint32_t head = atomic_load_acquire(&t->head);
+    uint32_t tail = t->tail, count = head - tail;
+
+    while (tail != head) {
+        trace_decode(t, &t->snap[tail % TRACE_SNAPS], entry, s);
+        tail++;
+        atomic_store_release(&t->tail, tail);
+    }
+
+    if (count)
+        fflush(t->file);
+    return count;
+}
+
+static void *trace_thread(void *data)
+{
+    struct adsp_trace *t = data;
+    struct trace_entry *entry;
+    uint32_t max = 0;
+    GString *s = g_string_new(NULL);
+    int i;
+
+    for (i = 0; i < t->num_areas; i++)
+        max = MAX(max, t->area[i].size / 4);
+    entry = g_new(struct trace_entry, max);
+
+    while (atomic_read(&t->running)) {
+        if (!trace_flush(t, entry, s))
+            g_usleep(TRACE_PERIOD_US);
+    }
+
+    /* anything queued before exit */
+    trace_flush(t, entry, s);
+
+    g_string_free(s, TRUE);
+    g_free(entry);
+    return NULL;
+}
+
+/* copy changed areas in bulk, runs in the main loop */
+static void trace_timer(void *opaque)
+{
+    struct adsp_trace *t = opaque;
+    struct trace_area *area;
+    struct trace_snap *snap;
+    uint32_t head = t->head;
+    int i;
+
+    for (i = 0; i < t->num_areas; i++) {
+        area = &t->area[i];
+
+        if (!memcmp(area->ptr, area->last, area->size))
+            continue;
+
+        /* never wait for the decoder, try again next period */
+        if (head - atomic_load_acquire(&t->tail) == TRACE_SNAPS) {
+            t->dropped++;
+            continue;
+        }
+
+        snap = &t->snap[head % TRACE_SNAPS];
+        memcpy(snap->data, area->ptr, area->size);
+        memcpy(area->last, snap->data, area->size);
+        snap->area = i;
+        head++;
+
+        t->snapshots++;
+        t->bytes += area->size;
+    }
+
+    atomic_store_release(&t->head, head);
+    timer_mod(t->timer, qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) + t->period_ns);
+}
+
+static void trace_exit(Notifier *n, void *data)
+{
+    struct adsp_trace *t = container_of(n, struct adsp_trace, exit);
+    double secs = (get_clock() - t->start) / 1e9;
+
+    /* pick up the last writes */
+    timer_del(t->timer);
+    trace_timer(t);
+    timer_del(t->timer);
+
+    atomic_set(&t->running, 0);
+    qemu_thread_join(&t->thread);
+
+    if (t->file != stdout)
+        fclose(t->file);
+
+    info_report("trace: %" PRIu64 " entries from %" PRIu64 " snapshots"
+        " (%" PRIu64 " bytes) %.0f entries/s, %" PRIu64 " dropped",
+        t->entries, t->snapshots, t->bytes,
+        secs > 0 ? t->entries / secs : 0.0, t->dropped);
+}
+
+static int trace_add_area(struct adsp_trace *t, const char *name,
+    const uint8_t *ptr, uint32_t size)
+{
+    struct trace_area *area;
+
+    if (t->num_areas == TRACE_AREAS || ptr == NULL || size < EVENT_SIZE)
+        return -EINVAL;
+
+    area = &t->area[t->num_areas++];
+    snprintf(area->name, sizeof(area->name), "%s", name);
+    area->ptr = ptr;
+    area->size = size;
+    area->last = g_malloc0(size);
+
+    info_report("trace: watching %s %u bytes", area->name, size);
+    return 0;
+}
+
+/* area at a DSP address, either in memory or in an IO space */
+static int trace_add_addr(struct adsp_trace *t, hwaddr addr, uint32_t size)
+{
+    struct adsp_log *log = t->adsp->log;
+    struct adsp_mem_desc *mem;
+    struct adsp_reg_space *space;
+    hwaddr base;
+    char name[32];
+
+    snprintf(name, sizeof(name), "0x%8.8" HWADDR_PRIx, addr);
+
+    mem = adsp_get_mem_space(t->adsp, addr);
+    if (mem) {
+        base = addr >= mem->base && addr < mem->base + mem->size ?
+            mem->base : mem->alias;
+        if (addr - base + size > mem->size)
+            return -EINVAL;
+        return trace_add_area(t, name, (uint8_t *)mem->ptr + addr - base,
+            size);
+    }
+
+    space = adsp_get_io_space(t->adsp, addr);
+    if (space == NULL || addr - space->desc.base + size > space->desc.size)
+        return -EINVAL;
+
+    /* the vCPU stops formatting stores to the watched area */
+    if (log && log->trace_space == NULL) {
+        log->trace_space = space;
+        log->trace_offset = addr - space->desc.base;
+        log->trace_size = size;
+    }
+
+    return trace_add_area(t, name,
+        (uint8_t *)space->desc.ptr + addr - space->desc.base, size);
+}
+
+/* default to the trace area of the mailbox */
+static void trace_add_mbox(struct adsp_trace *t)
+{
+    const struct adsp_desc *board = t->adsp->desc;
+    struct adsp_reg_space *space;
+    int i, j;
+
+    for (i = 0; i < board->num_io; i++) {
+        space = &board->io_dev[i];
+        if (strcmp(space->name, "mbox"))
+            continue;
+
+        for (j = 0; j < space->reg_count; j++) {
+            if (!strcmp(space->reg[j].name, "trace") &&
+                trace_add_addr(t, space->desc.base + space->reg[j].offset,
+                    space->reg[j].size) == 0)
+                return;
+        }
+    }
+
+    fprintf(stderr, "trace: no mailbox trace area, use trace-area\n");
+}
+
+void adsp_trace_init(struct adsp_dev *adsp)
+{
+    QemuOpts *opts = adsp->machine_opts;
+    const char *filename = qemu_opt_get(opts, "trace");
+    const char *ldc = qemu_opt_get(opts, "trace-ldc");
+    const char *areas = qemu_opt_get(opts, "trace-area");
+    struct adsp_trace *t;
+    uint32_t max = 0;
+    char **area;
+    uint64_t addr, size;
+    char *end;
+    int i;
+
+    if (filename == NULL)
+        return;
+
+    t = g_new0(struct adsp_trace, 1);
+    t->adsp = adsp;
+    t->period_ns = qemu_opt_get_number(opts, "trace-us", 0) * SCALE_US;
+    if (t->period_ns <= 0)
+        t->period_ns = TRACE_PERIOD_US * SCALE_US;
+    t->clk_kHz = qemu_opt_get_number(opts, "trace-clk-khz", adsp->clk_kHz);
+
+    if (!strcmp(filename, "-"))
+        t->file = stdout;
+    else
+        t->file = fopen(filename, "w");
+    if (t->file == NULL) {
+        fprintf(stderr, "trace: cant create %s: %d\n", filename, -errno);
+        g_free(t);
+        return;
+    }
+
+    if (ldc && trace_load_ldc(t, ldc) < 0)
+        fprintf(stderr, "trace: invalid dictionary %s, using class events\n",
+            ldc);
+
+    if (areas == NULL) {
+        trace_add_mbox(t);
+    } else {
+        /* a comma has to be doubled in -machine, accept ; too */
+        area = g_strsplit_set(areas, ",;", 0);
+        for (i = 0; area[i]; i++) {
+            addr = g_ascii_strtoull(area[i], &end, 0);
+            size = *end == ':' ? g_ascii_strtoull(end + 1, NULL, 0) : 0;
+            if (size > UINT32_MAX || trace_add_addr(t, addr, size) < 0)
+                fprintf(stderr, "trace: invalid area %s\n", area[i]);
+        }
+        g_strfreev(area);
+    }
+
+    if (t->num_areas == 0) {
+        if (t->file != stdout)
+            fclose(t->file);
+        g_free(t->ldc);
+        g_free(t);
+        return;
+    }
+
+    for (i = 0; i < t->num_areas; i++)
+        max = MAX(max, t->area[i].size);
+    for (i = 0; i < TRACE_SNAPS; i++)
+        t->snap[i].data = g_malloc(max);
+
+    t->start = get_clock();
+    t->running = 1;
+    qemu_thread_create(&t->thread, "adsp-trace", trace_thread, t,
+        QEMU_THREAD_JOINABLE);
+
+    t->timer = timer_new_ns(QEMU_CLOCK_VIRTUAL, trace_timer, t);
+    timer_mod(t->timer, qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) + t->period_ns);
+
+    t->exit.notify = trace_exit;
+    qemu_add_exit_notifier(&t->exit);
+}
@@ -22,8 +22,12 @@
 #include "hw/audio/adsp-host.h"
 #include "hw/adsp/shim.h"
 #include "hw/adsp/log.h"
+#include "exec/ram_addr.h"
 #include <sys/mman.h>
 
+/* DSP DMA addresses are 32 bit so only low guest RAM is shared */
+#define ADSP_HOST_RAM_LIMIT     0x100000000ULL
+
 static void dma_M2M_create_read_shm(struct adsp_host *adsp, struct qemu_io_msg *msg)
 {
     struct qemu_io_msg_dma32 *dma_msg = (struct qemu_io_msg_dma32 *)msg;
@@ -152,3 +156,41 @@ void adsp_host_do_dma(struct adsp_host *adsp, struct qemu_io_msg *msg)
         break;
     }
 }
+
+/*
+ * Share guest RAM with the DSP so host DMA can be done without SHM bounce
+ * buffers. Only RAM backed by a shared fd (memory-backend-memfd,share=on) can
+ * be shared, otherwise the DSP falls back to QEMU_IO_DMA_REQ_NEW.
+ */
+void adsp_host_share_ram(void)
+{
+    MemoryRegionSection section;
+    hwaddr gpa = 0, size;
+    int fd;
+
+    while (gpa < ADSP_HOST_RAM_LIMIT) {
+
+        section = memory_region_find(get_system_memory(), gpa,
+            ADSP_HOST_RAM_LIMIT - gpa);
+        if (!section.mr)
+            break;
+
+        size = int128_get64(section.size);
+        fd = memory_region_get_fd(section.mr);
+
+        if (memory_region_is_ram(section.mr) && fd >= 0 &&
+            qemu_ram_is_shared(section.mr->ram_block)) {
+
+            fprintf(stdout, "host-dma: sharing %s gpa 0x%" HWADDR_PRIx
+                " size 0x%" HWADDR_PRIx " with DSP\n",
+                memory_region_name(section.mr),
+                section.offset_within_address_space, size);
+
+            qemu_io_register_host_ram(section.offset_within_address_space,
+                size, fd, section.offset_within_region);
+        }
+
+        gpa = section.offset_within_address_space + size;
+        memory_region_unref(section.mr);
+    }
+}
@@ -52,6 +52,7 @@ static struct adsp_reg_space byt_io[] = {
         .desc = {.base = ADSP_BYT_HOST_MAILBOX_BASE, .size = ADSP_MAILBOX_SIZE},
         .init = (void*)adsp_host_init_mbox,
         .ops = &adsp_host_mbox_ops,
+        .shadow = true,
     }
 };
 
@@ -126,6 +127,9 @@ void adsp_byt_host_init(struct adsp_host *adsp, const char *name)
 
     /* initialise bridge to x86 host driver */
     qemu_io_register_parent(name, &byt_bridge_cb, (void*)adsp);
+
+    /* let DSP access guest RAM directly for host DMA */
+    adsp_host_share_ram();
 }
 
 static void byt_reset(DeviceState *dev)
@@ -84,7 +84,7 @@ static void adsp_shim_write(void *opaque, hwaddr addr,
             irq.hdr.size = sizeof(irq);
             irq.irq = 0;
 
-            qemu_io_send_msg(&irq.hdr);
+            adsp_host_post_msg(adsp, &irq.hdr);
         }
         break;
     case SHIM_IPCD:
@@ -108,7 +108,7 @@ static void adsp_shim_write(void *opaque, hwaddr addr,
             irq.hdr.size = sizeof(irq);
             irq.irq = 0;
 
-            qemu_io_send_msg(&irq.hdr);
+            adsp_host_post_msg(adsp, &irq.hdr);
         }
         break;
     case SHIM_IMRX:
@@ -134,7 +134,7 @@ static void adsp_shim_write(void *opaque, hwaddr addr,
         reg32.hdr.size = sizeof(reg32);
         reg32.reg = addr;
         reg32.val = val;
-        qemu_io_send_msg(&reg32.hdr);
+        adsp_host_post_msg(adsp, &reg32.hdr);
         break;
     default:
         break;
@@ -23,6 +23,9 @@
 #include "hw/audio/adsp-host.h"
 #include "hw/adsp/hsw.h"
 
+extern const MemoryRegionOps adsp_hsw_shim_ops;
+extern const MemoryRegionOps adsp_host_mbox_ops;
+
 static struct adsp_mem_desc hsw_mem[] = {
     {.name = "iram", .base = ADSP_HSW_HOST_IRAM_BASE,
         .size = ADSP_HSW_IRAM_SIZE},
@@ -35,10 +38,17 @@ static struct adsp_reg_space hsw_io[] = {
         .desc = {.base = ADSP_HSW_PCI_BASE, .size = ADSP_PCI_SIZE},},
     { .name = "shim", .reg_count = ARRAY_SIZE(adsp_hsw_shim_map),
         .reg = adsp_hsw_shim_map,
-        .desc = {.base = ADSP_HSW_DSP_SHIM_BASE, .size = ADSP_HSW_SHIM_SIZE},},
+        .desc = {.base = ADSP_HSW_DSP_SHIM_BASE, .size = ADSP_HSW_SHIM_SIZE},
+        .init = (void*)adsp_hsw_init_shim,
+        .ops = &adsp_hsw_shim_ops,
+    },
     { .name = "mbox", .reg_count = ARRAY_SIZE(adsp_host_mbox_map),
         .reg = adsp_host_mbox_map,
-        .desc = {.base = ADSP_HSW_DSP_MAILBOX_BASE, .size = ADSP_MAILBOX_SIZE},},
+        .desc = {.base = ADSP_HSW_DSP_MAILBOX_BASE, .size = ADSP_MAILBOX_SIZE},
+        .init = (void*)adsp_host_init_mbox,
+        .ops = &adsp_host_mbox_ops,
+        .shadow = true,
+    },
 };
 
 static const struct adsp_desc hsw_board = {
@@ -61,10 +71,17 @@ static struct adsp_reg_space bdw_io[] = {
         .desc = {.base = ADSP_BDW_PCI_BASE, .size = ADSP_PCI_SIZE},},
     { .name = "shim", .reg_count = ARRAY_SIZE(adsp_hsw_shim_map),
         .reg = adsp_hsw_shim_map,
-        .desc = {.base = ADSP_BDW_DSP_SHIM_BASE, .size = ADSP_HSW_SHIM_SIZE},},
+        .desc = {.base = ADSP_BDW_DSP_SHIM_BASE, .size = ADSP_HSW_SHIM_SIZE},
+        .init = (void*)adsp_hsw_init_shim,
+        .ops = &adsp_hsw_shim_ops,
+    },
     { .name = "mbox", .reg_count = ARRAY_SIZE(adsp_host_mbox_map),
         .reg = adsp_host_mbox_map,
-        .desc = {.base = ADSP_BDW_DSP_MAILBOX_BASE, .size = ADSP_MAILBOX_SIZE},},
+        .desc = {.base = ADSP_BDW_DSP_MAILBOX_BASE, .size = ADSP_MAILBOX_SIZE},
+        .init = (void*)adsp_host_init_mbox,
+        .ops = &adsp_host_mbox_ops,
+        .shadow = true,
+    },
 };
 
 static const struct adsp_desc bdw_board = {
@@ -134,6 +151,9 @@ void adsp_hsw_host_init(struct adsp_host *adsp, const char *name)
 
     /* initialise bridge to x86 host driver */
     qemu_io_register_parent(name, &hsw_bridge_cb, (void*)adsp);
+
+    /* let DSP access guest RAM directly for host DMA */
+    adsp_host_share_ram();
 }
 
 void adsp_bdw_host_init(struct adsp_host *adsp, const char *name)
@@ -150,6 +170,9 @@ void adsp_bdw_host_init(struct adsp_host *adsp, const char *name)
 
     /* initialise bridge to x86 host driver */
     qemu_io_register_parent(name, &hsw_bridge_cb, (void*)adsp);
+
+    /* let DSP access guest RAM directly for host DMA */
+    adsp_host_share_ram();
 }
 
 static void hsw_reset(DeviceState *dev)
@@ -504,6 +504,52 @@ int load_elf_ram_sym(const char *filename,
     return ret;
 }
 
+int load_elf_symbols(const char *filename)
+{
+    int fd, data_order, must_swab, ret = -1;
+    uint8_t e_ident[EI_NIDENT];
+    struct elf32_hdr ehdr32;
+    struct elf64_hdr ehdr64;
+
+    fd = open(filename, O_RDONLY | O_BINARY);
+    if (fd < 0) {
+        return -1;
+    }
+    if (read(fd, e_ident, sizeof(e_ident)) != sizeof(e_ident) ||
+        memcmp(e_ident, ELFMAG, SELFMAG)) {
+        goto fail;
+    }
+#ifdef HOST_WORDS_BIGENDIAN
+    data_order = ELFDATA2MSB;
+#else
+    data_order = ELFDATA2LSB;
+#endif
+    must_swab = data_order != e_ident[EI_DATA];
+
+    lseek(fd, 0, SEEK_SET);
+    if (e_ident[EI_CLASS] == ELFCLASS64) {
+        if (read(fd, &ehdr64, sizeof(ehdr64)) != sizeof(ehdr64)) {
+            goto fail;
+        }
+        if (must_swab) {
+            bswap_ehdr64(&ehdr64);
+        }
+        ret = load_symbols64(&ehdr64, fd, must_swab, 0, NULL);
+    } else {
+        if (read(fd, &ehdr32, sizeof(ehdr32)) != sizeof(ehdr32)) {
+            goto fail;
+        }
+        if (must_swab) {
+            bswap_ehdr32(&ehdr32);
+        }
+        ret = load_symbols32(&ehdr32, fd, must_swab, 0, NULL);
+    }
+
+ fail:
+    close(fd);
+    return ret;
+}
+
 static void bswap_uboot_header(uboot_image_header_t *hdr)
 {
 #ifndef HOST_WORDS_BIGENDIAN
@@ -0,0 +1,79 @@
+/*
+ * Virtual clock pacing for audio DSP DMA channels.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * DMA channels are paced by virtual clock timers instead of a host thread
+ * per channel so many channels share the main loop, bursts stop when the
+ * guest is paused and follow any virtual time scaling.
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/timer.h"
+#include "qemu/host-utils.h"
+#include "hw/dma/dma-timer.h"
+
+static void dma_timer_cb(void *opaque)
+{
+    struct dma_timer *t = opaque;
+
+    if (!t->active)
+        return;
+
+    if (t->burst(t->chan)) {
+        /* rearm from last expiry so pacing does not drift */
+        t->expire += t->period_ns;
+        timer_mod(t->timer, t->expire);
+        return;
+    }
+
+    t->active = 0;
+    if (t->complete)
+        t->complete(t->chan);
+}
+
+void dma_timer_init(struct dma_timer *t)
+{
+    memset(t, 0, sizeof(*t));
+    t->timer = timer_new_ns(QEMU_CLOCK_VIRTUAL, dma_timer_cb, t);
+}
+
+void dma_timer_start(struct dma_timer *t, int64_t period_ns,
+    int (*burst)(void *chan), void (*complete)(void *chan), void *chan)
+{
+    /* channel restarted before the last burst ran, finish the old one */
+    if (t->active && t->complete)
+        t->complete(t->chan);
+
+    t->burst = burst;
+    t->complete = complete;
+    t->chan = chan;
+    t->period_ns = period_ns > 0 ? period_ns : DMA_TIMER_M2M_PERIOD;
+    t->expire = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) + t->period_ns;
+    t->active = 1;
+
+    timer_mod(t->timer, t->expire);
+}
+
+void dma_timer_stop(struct dma_timer *t)
+{
+    t->active = 0;
+    timer_del(t->timer);
+}
+
+/* time taken by the DAI to consume or produce burst_bytes */
+int64_t dma_timer_period_ns(uint32_t burst_bytes, uint32_t frame_bytes,
+    uint32_t rate)
+{
+    if (frame_bytes == 0 || rate == 0) {
+        frame_bytes = DMA_TIMER_DEFAULT_FRAME_BYTES;
+        rate = DMA_TIMER_DEFAULT_RATE;
+    }
+
+    return muldiv64(burst_bytes, NANOSECONDS_PER_SECOND, frame_bytes * rate);
+}
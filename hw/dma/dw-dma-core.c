@@ -28,6 +28,7 @@
 #include "exec/memory.h"
 #include "exec/address-spaces.h"
 #include "qemu/thread.h"
+#include "qemu/main-loop.h"
 #include "qemu/io-bridge.h"
 
 #include "hw/pci/pci.h"
@@ -44,17 +45,6 @@ const struct adsp_reg_desc adsp_gp_dma_map[] = {
         .offset = 0x00000000, .size = 0x4000},
 };
 
-static inline void dma_sleep(long nsec)
-{
-    struct timespec req;
-
-    req.tv_sec = 0;
-    req.tv_nsec = nsec;
-
-    if (nanosleep(&req, NULL) < 0)
-        fprintf(stderr, "failed to sleep %d\n", -errno);
-}
-
 static void dmac_reg_sync(struct adsp_gp_dmac *dmac, hwaddr addr)
 {
     uint32_t val = 0;
@@ -133,6 +123,33 @@ static void dma_host_req(struct adsp_gp_dmac *dmac, uint32_t chan,
     qemu_io_send_msg(&dma_msg->hdr);
 }
 
+/*
+ * Map host buffer directly when the host has shared its guest RAM. The host
+ * side of the transfer is the address without the DSP MSB set.
+ */
+static int dma_host_map(struct adsp_gp_dmac *dmac, uint32_t chan)
+{
+    struct dma_chan *dma_chan = &dmac->dma_chan[chan];
+    uint32_t sar, dar, size;
+    void *ptr;
+
+    sar = dmac->io[DW_SAR(chan) >> 2];
+    dar = dmac->io[DW_DAR(chan) >> 2];
+    size = dmac->io[DW_CTRL_HIGH(chan) >> 2] & DW_CTLH_BLOCK_TS_MASK;
+
+    ptr = qemu_io_host_ram(sar & 0x80000000 ? dar : sar, size);
+    dma_chan->zero_copy = ptr != NULL;
+    if (ptr == NULL)
+        return 0;
+
+    dma_chan->ptr = ptr;
+
+    log_text(dmac->log, LOG_DMA_M2M,
+        "DMA zero copy: src 0x%x dest 0x%x size 0x%x\n", sar, dar, size);
+
+    return 1;
+}
+
 static void dma_host_complete(struct adsp_gp_dmac *dmac, uint32_t chan)
 {
     struct dma_chan *dma_chan = &dmac->dma_chan[chan];
@@ -201,8 +218,9 @@ static int dma_llp_reloaded(struct dma_chan *dma_chan)
 
 #ifdef CONFIG_DW_DMA_DSP
 /* read from MEM and write to SSP - audio playback */
-static int dma_M2P_copy_burst(struct dma_chan *dma_chan)
+static int dma_M2P_copy_burst(void *data)
 {
+    struct dma_chan *dma_chan = data;
     struct adsp_gp_dmac *dmac = dma_chan->dmac;
     struct adsp_ssp *ssp = ssp_get_port(dma_chan->ssp);
     uint32_t chan = dma_chan->chan;
@@ -212,21 +230,15 @@ static int dma_M2P_copy_burst(struct dma_chan *dma_chan)
 
     sar = dmac->io[DW_SAR(chan) >> 2];
     size = dmac->io[DW_CTRL_HIGH(chan) >> 2] & DW_CTLH_BLOCK_TS_MASK;
-    burst_size = size / 2;
+    burst_size = MIN(size / 2, sizeof(buffer));
 
     /* copy burst from SAR to DAR */
     cpu_physical_memory_read(sar, buffer, burst_size);
 
-    /* copy buffer to files */
-    if (dma_chan->fd > 0) {
-        if (write(dma_chan->fd, buffer, burst_size) != burst_size)
-            fprintf(stderr, "error: writing to DMAC file %d\n", -errno);
-    }
+    /* copy buffer to endpoints */
+    dai_endpoint_write(dma_chan->trace, buffer, burst_size);
 
-    if (ssp->tx.fd > 0) {
-        if (write(ssp->tx.fd, buffer, burst_size) != burst_size)
-            fprintf(stderr, "error: writing to SSP%d file %d\n", dma_chan->ssp, -errno);
-    }
+    dai_endpoint_write(ssp->tx.ep, buffer, burst_size);
 
     /* update SAR, DAR and bytes copied */
     dmac->io[DW_SAR(chan) >> 2] += burst_size;
@@ -276,8 +288,9 @@ static int dma_M2P_copy_burst(struct dma_chan *dma_chan)
 }
 
 /* read from SSP and write to MEM - audio capture */
-static int dma_P2M_copy_burst(struct dma_chan *dma_chan)
+static int dma_P2M_copy_burst(void *data)
 {
+    struct dma_chan *dma_chan = data;
     struct adsp_gp_dmac *dmac = dma_chan->dmac;
     struct adsp_ssp *ssp = ssp_get_port(dma_chan->ssp);
     uint32_t chan = dma_chan->chan;
@@ -286,17 +299,14 @@ static int dma_P2M_copy_burst(struct dma_chan *dma_chan)
     uint32_t buffer[0x1000];
 
     size = dmac->io[DW_CTRL_HIGH(chan) >> 2] & DW_CTLH_BLOCK_TS_MASK;
-    burst_size = size / 2;
+    burst_size = MIN(size / 2, sizeof(buffer));
     dar = dmac->io[DW_DAR(chan) >> 2];
 
-    /* read in data from SSP file */
-    if (ssp->rx.fd > 0) {
-        if (write(ssp->rx.fd, buffer, burst_size) != burst_size)
-            fprintf(stderr, "error: reading from SSP%d file %d\n", dma_chan->ssp, -errno);
-    }
+    /* read in data from SSP endpoint, silence if none */
+    dai_endpoint_read(ssp->rx.ep, buffer, burst_size);
 
     /* copy burst from SAR to DAR */
-    cpu_physical_memory_read(dar, buffer, burst_size);
+    cpu_physical_memory_write(dar, buffer, burst_size);
 
     /* update SAR, DAR and bytes copied */
     dmac->io[DW_DAR(chan) >> 2] += burst_size;
@@ -347,8 +357,9 @@ static int dma_P2M_copy_burst(struct dma_chan *dma_chan)
 #endif
 
 /* read from host and write to DSP - audio playback */
-static int dma_M2M_read_host_burst(struct dma_chan *dma_chan)
+static int dma_M2M_read_host_burst(void *data)
 {
+    struct dma_chan *dma_chan = data;
     struct adsp_gp_dmac *dmac = dma_chan->dmac;
     uint32_t chan = dma_chan->chan;
     hwaddr burst_size = 32; // TODO read from DMAC
@@ -357,8 +368,13 @@ static int dma_M2M_read_host_burst(struct dma_chan *dma_chan)
     dar = dmac->io[DW_DAR(chan) >> 2];
     size = dmac->io[DW_CTRL_HIGH(chan) >> 2] & DW_CTLH_BLOCK_TS_MASK;
 
+    /* host buffer is only block size, last burst may be short */
+    if (dma_chan->bytes + burst_size > size)
+        burst_size = size > dma_chan->bytes ? size - dma_chan->bytes : 0;
+
     /* copy burst from SAR to DAR */
     cpu_physical_memory_write(dar, dma_chan->ptr, burst_size);
+    dai_endpoint_write(dma_chan->trace, dma_chan->ptr, burst_size);
 
     /* update SAR, DAR and bytes copied */
     dmac->io[DW_DAR(chan) >> 2] += burst_size;
@@ -368,10 +384,6 @@ static int dma_M2M_read_host_burst(struct dma_chan *dma_chan)
     dma_chan->bytes += burst_size;
     dma_chan->tbytes += burst_size;
 
-    if (dma_chan->fd > 0) {
-        if (write(dma_chan->fd, dma_chan->ptr, burst_size) != burst_size)
-            fprintf(stderr, "error: writing to DMAC file %d\n", -errno);
-    }
 
     /* block complete ? then send IRQ */
     if (dma_chan->bytes >= size || dma_chan->stop) {
@@ -380,15 +392,17 @@ static int dma_M2M_read_host_burst(struct dma_chan *dma_chan)
         dmac->io[DW_RAW_BLOCK >> 2] |= CHAN_RAW_ENABLE(chan);
         dmac_reg_sync(dmac, DW_STATUS_BLOCK);
 
-        /* tell host we are complete */
-        dma_host_complete(dmac, chan);
-
-        /* free SHM */
-        qemu_io_free_shm(ADSP_IO_SHM_DMA(dmac->id, chan)) ;
+        /* tell host we are complete and free SHM if not zero copy */
+        if (!dma_chan->zero_copy) {
+            dma_host_complete(dmac, chan);
+            qemu_io_free_shm(ADSP_IO_SHM_DMA(dmac->id, chan));
+        }
 
         /* reload LLP and re-arm the timer if LLP exists */
         if (dma_llp_reloaded(dma_chan) && !dma_chan->stop) {
-            dma_host_req(dmac, chan, QEMU_IO_DMA_DIR_READ);
+            dma_chan->bytes = 0;
+            if (!dma_host_map(dmac, chan))
+                dma_host_req(dmac, chan, QEMU_IO_DMA_DIR_READ);
 
             log_text(dmac->log, LOG_DMA_M2M,
                 "dma: %d:%d: completed SAR 0x%x DAR 0x%x size 0x%x total bytes 0x%x\n",
@@ -415,8 +429,9 @@ static int dma_M2M_read_host_burst(struct dma_chan *dma_chan)
 }
 
 /* read from DSP and write to host - audio capture */
-static int dma_M2M_write_host_burst(struct dma_chan *dma_chan)
+static int dma_M2M_write_host_burst(void *data)
 {
+    struct dma_chan *dma_chan = data;
     struct adsp_gp_dmac *dmac = dma_chan->dmac;
     uint32_t chan = dma_chan->chan;
     hwaddr burst_size = 32; // TODO read from DMAC
@@ -425,6 +440,10 @@ static int dma_M2M_write_host_burst(struct dma_chan *dma_chan)
     sar = dmac->io[DW_SAR(chan) >> 2];
     size = dmac->io[DW_CTRL_HIGH(chan) >> 2] & DW_CTLH_BLOCK_TS_MASK;
 
+    /* host buffer is only block size, last burst may be short */
+    if (dma_chan->bytes + burst_size > size)
+        burst_size = size > dma_chan->bytes ? size - dma_chan->bytes : 0;
+
     /* copy burst from SAR to DAR */
     cpu_physical_memory_read(sar, dma_chan->ptr, burst_size);
 
@@ -442,15 +461,17 @@ static int dma_M2M_write_host_burst(struct dma_chan *dma_chan)
         dmac->io[DW_RAW_BLOCK >> 2] |= CHAN_RAW_ENABLE(chan);
         dmac_reg_sync(dmac, DW_STATUS_BLOCK);
 
-        /* tell host we are complete */
-        dma_host_complete(dmac, chan);
-
-        /* free SHm */
-        qemu_io_free_shm(ADSP_IO_SHM_DMA(dmac->id, chan));
+        /* tell host we are complete and free SHM if not zero copy */
+        if (!dma_chan->zero_copy) {
+            dma_host_complete(dmac, chan);
+            qemu_io_free_shm(ADSP_IO_SHM_DMA(dmac->id, chan));
+        }
 
         /* reload LLP and re-arm the timer if LLP exists */
         if (dma_llp_reloaded(dma_chan) && !dma_chan->stop) {
-            dma_host_req(dmac, chan, QEMU_IO_DMA_DIR_WRITE);
+            dma_chan->bytes = 0;
+            if (!dma_host_map(dmac, chan))
+                dma_host_req(dmac, chan, QEMU_IO_DMA_DIR_WRITE);
 
             log_text(dmac->log, LOG_DMA_M2M,
                 "dma: %d:%d: completed SAR 0x%x DAR 0x%x size 0x%x total bytes 0x%x\n",
@@ -479,97 +500,31 @@ static int dma_M2M_write_host_burst(struct dma_chan *dma_chan)
 static void open_dmac_file(struct dma_chan *dma_chan)
 {
     struct adsp_gp_dmac *dmac = dma_chan->dmac;
+    struct dai_format fmt = {48000, 2, 2};
     char name[32];
 
-    /* create filename */
-    sprintf(name, "/tmp/dmac%d-%d-%d.wav", dmac->id, dma_chan->chan,
-        dma_chan->file_idx++);
-    unlink(name);
-
-    if (dma_chan->fd == 0)
-        dma_chan->fd = open(name, O_WRONLY | O_CREAT,
-            S_IRUSR | S_IWUSR | S_IXUSR);
-
-    if (dma_chan->fd < 0)
-        fprintf(stderr, "error: can't open file %s %d\n", name, -errno);
-}
-
-static void close_dmac_file(struct dma_chan *dma_chan)
-{
-    if (dma_chan->fd > 0) {
-        close(dma_chan->fd);
-        dma_chan->fd = 0;
-    }
-}
-
-/* TODO: make these configurable on rate etc */
-#define DMA_M2M_BURST_SLEEP    (200 * 1000)    /* 200us */
-#define DMA_M2P_BURST_SLEEP    (6667 * 1000)    /* 6.66ms */
-#define DMA_P2M_BURST_SLEEP    (6667 * 1000)    /* 6.66ms */
-
-/* dsp mem to host mem work for capture */
-static void * dma_channel_Mhost2Mdsp_work(void *data)
-{
-    struct dma_chan *dma_chan = data;
-
-    open_dmac_file(dma_chan);
-
-    do {
-        dma_sleep(DMA_M2M_BURST_SLEEP);
-    } while (dma_M2M_write_host_burst(dma_chan));
-
-    close_dmac_file(dma_chan);
-
-    return NULL;
-}
-
-/* dsp mem to host mem work for capture */
-static void * dma_channel_Mdsp2Mhost_work(void *data)
-{
-    struct dma_chan *dma_chan = data;
-
-    open_dmac_file(dma_chan);
-
-    do {
-        dma_sleep(DMA_M2M_BURST_SLEEP);
-    } while (dma_M2M_read_host_burst(dma_chan));
-
-    close_dmac_file(dma_chan);
+    /* one trace stream and writer per channel, kept across transfers */
+    if (dma_chan->trace)
+        return;
 
-    return NULL;
+    /* create stream name */
+    sprintf(name, "dmac%d-%d", dmac->id, dma_chan->chan);
+    dma_chan->trace = dai_endpoint_open(name, DAI_DIR_PLAYBACK,
+        DAI_BACKEND_RAW, &fmt);
 }
 
 #ifdef CONFIG_DW_DMA_DSP
-/* peripheral to mem channel work */
-static void * dma_channel_P2M_work(void *data)
-{
-    struct dma_chan *dma_chan = data;
-
-    open_dmac_file(dma_chan);
-
-    do {
-        dma_sleep(DMA_P2M_BURST_SLEEP);
-    } while (dma_P2M_copy_burst(dma_chan));
-
-    close_dmac_file(dma_chan);
-
-    return NULL;
-}
-
-/* mem to peripheral channel work */
-static void * dma_channel_M2P_work(void *data)
+/* burst period is the time the SSP takes to play or capture half a block */
+static int64_t dma_P_burst_period(struct dma_chan *dma_chan)
 {
-    struct dma_chan *dma_chan = data;
-
-    open_dmac_file(dma_chan);
-
-    do {
-        dma_sleep(DMA_M2P_BURST_SLEEP);
-    } while (dma_M2P_copy_burst(dma_chan));
+    struct adsp_gp_dmac *dmac = dma_chan->dmac;
+    struct adsp_ssp *ssp = ssp_get_port(dma_chan->ssp);
+    uint32_t size;
 
-    close_dmac_file(dma_chan);
+    size = dmac->io[DW_CTRL_HIGH(dma_chan->chan) >> 2] & DW_CTLH_BLOCK_TS_MASK;
 
-    return NULL;
+    return dma_timer_period_ns(size / 2, ssp_get_frame_bytes(ssp),
+        ssp_get_rate(ssp));
 }
 
 static void dma_P2M_start(struct adsp_gp_dmac *dmac, uint32_t chan, int ssp)
@@ -581,8 +536,9 @@ static void dma_P2M_start(struct adsp_gp_dmac *dmac, uint32_t chan, int ssp)
     dma_chan->ssp = ssp;
     dma_chan->tbytes = 0;
 
-    qemu_thread_create(&dma_chan->thread, dma_chan->thread_name,
-        dma_channel_P2M_work, dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(dma_chan);
+    dma_timer_start(&dma_chan->timer, dma_P_burst_period(dma_chan),
+        dma_P2M_copy_burst, NULL, dma_chan);
 }
 
 static void dma_M2P_start(struct adsp_gp_dmac *dmac, uint32_t chan, int ssp)
@@ -594,8 +550,9 @@ static void dma_M2P_start(struct adsp_gp_dmac *dmac, uint32_t chan, int ssp)
     dma_chan->ssp = ssp;
     dma_chan->tbytes = 0;
 
-    qemu_thread_create(&dma_chan->thread, dma_chan->thread_name,
-        dma_channel_M2P_work, dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(dma_chan);
+    dma_timer_start(&dma_chan->timer, dma_P_burst_period(dma_chan),
+        dma_M2P_copy_burst, NULL, dma_chan);
 }
 #endif
 
@@ -607,8 +564,9 @@ static void dma_Mdsp2Mhost_start(struct adsp_gp_dmac *dmac, uint32_t chan)
     dma_chan->bytes = 0;
     dma_chan->tbytes = 0;
 
-    qemu_thread_create(&dma_chan->thread, dma_chan->thread_name,
-        dma_channel_Mdsp2Mhost_work, dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(dma_chan);
+    dma_timer_start(&dma_chan->timer, DMA_TIMER_M2M_PERIOD,
+        dma_M2M_read_host_burst, NULL, dma_chan);
 }
 
 static void dma_Mhost2Mdsp_start(struct adsp_gp_dmac *dmac, uint32_t chan)
@@ -619,8 +577,9 @@ static void dma_Mhost2Mdsp_start(struct adsp_gp_dmac *dmac, uint32_t chan)
     dma_chan->bytes = 0;
     dma_chan->tbytes = 0;
 
-    qemu_thread_create(&dma_chan->thread, dma_chan->thread_name,
-        dma_channel_Mhost2Mdsp_work, dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(dma_chan);
+    dma_timer_start(&dma_chan->timer, DMA_TIMER_M2M_PERIOD,
+        dma_M2M_write_host_burst, NULL, dma_chan);
 }
 
 /* init new DMA mem to mem transfer after host is ready */
@@ -696,6 +655,15 @@ static void dma_start_transfer(struct adsp_gp_dmac *dmac, uint32_t chan)
 
     switch (ctl_lo) {
     case 0: /* DW_CTLL_FC_M2M */
+        /* host RAM shared with us ? then copy directly */
+        if (dma_host_map(dmac, chan)) {
+            if (sar & 0x80000000)
+                dma_Mhost2Mdsp_start(dmac, chan); /* DSP SAR to host DAR */
+            else
+                dma_Mdsp2Mhost_start(dmac, chan); /* host SAR to DSP DAR */
+            return;
+        }
+
         /* determine if we are to/from host - MSB == 1 then addr is DSP */
         if (sar & 0x80000000) {
             dma_host_req(dmac, chan, QEMU_IO_DMA_DIR_READ); /* capture */
@@ -891,12 +859,18 @@ static void dmac_write(void *opaque, hwaddr addr,
     }
 }
 
+/*
+ * Called from the bridge reader thread. The transfer arms the channel timer
+ * and updates channel state shared with the vCPUs so take the iothread lock.
+ */
 void dw_dma_msg(struct qemu_io_msg *msg)
 {
     struct qemu_io_msg_dma32 *dma_msg = (struct qemu_io_msg_dma32 *)msg;
     struct dma_chan *dma_chan = (struct dma_chan*)dma_msg->client_data;
     struct qemu_io_msg_dma32 *local_dma_msg = &dma_chan->dma_msg;
 
+    qemu_mutex_lock_iothread();
+
     /* get host buffer address */
     local_dma_msg->host_data = dma_msg->host_data;
 
@@ -906,6 +880,8 @@ void dw_dma_msg(struct qemu_io_msg *msg)
             (struct dma_chan*)dma_msg->client_data,
             dma_msg->chan_id, dma_msg->direction);
     }
+
+    qemu_mutex_unlock_iothread();
 }
 
 const MemoryRegionOps dw_dmac_ops = {
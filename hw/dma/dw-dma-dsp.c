@@ -72,9 +72,10 @@ void dw_dma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
     /* channels */
     for (j = 0; j < NUM_CHANNELS; j++) {
         dmac->dma_chan[j].dmac = dmac;
-        dmac->dma_chan[j].fd = 0;
+        dmac->dma_chan[j].trace = NULL;
         dmac->dma_chan[j].chan = j;
         dmac->dma_chan[j].file_idx = 0;
+        dma_timer_init(&dmac->dma_chan[j].timer);
         sprintf(dmac->dma_chan[j].thread_name, "dmac:%d.%d", info->io_dev, j);
     }
 
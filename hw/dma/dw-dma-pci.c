@@ -212,9 +212,10 @@ static void dw_dmac_init(struct dw_host *dw, int id)
     /* channels */
     for (j = 0; j < NUM_CHANNELS; j++) {
         dmac->dma_chan[j].dmac = dmac;
-        dmac->dma_chan[j].fd = 0;
+        dmac->dma_chan[j].trace = NULL;
         dmac->dma_chan[j].chan = j;
         dmac->dma_chan[j].file_idx = 0;
+        dma_timer_init(&dmac->dma_chan[j].timer);
         sprintf(dmac->dma_chan[j].thread_name, "dmac:%d.%d", id, j);
     }
 }
@@ -18,6 +18,8 @@
 #include "exec/memory.h"
 #include "exec/address-spaces.h"
 #include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "qemu/host-utils.h"
 #include "qemu/io-bridge.h"
 
 #include "hw/pci/pci.h"
@@ -25,26 +27,403 @@
 #include "hw/audio/adsp-host.h"
 #include "hw/adsp/shim.h"
 #include "hw/adsp/log.h"
-#include "hw/ssi/ssp.h"
+#include "hw/adsp/dai.h"
+#include "hw/ssi/sai.h"
+#include "hw/ssi/esai.h"
 #include "hw/dma/edma.h"
 
 
 const struct adsp_reg_desc adsp_edma_map[] = {
     {.name = "edma", .enable = LOG_DMA,
-        .offset = 0x00000000, .size = 0x10000},
+        .offset = 0x00000000, .size = NUM_CHANNELS * EDMA_CH_SIZE},
 };
 
-static inline void dma_sleep(long nsec)
+/* sub word access to the channel registers, TCD fields are 16 or 32 bit */
+static uint32_t edma_reg_read(struct adsp_edma *edma, hwaddr addr,
+        unsigned size)
+{
+    return extract32(edma->io[addr >> 2], (addr & 3) * 8, size * 8);
+}
+
+static void edma_reg_write(struct adsp_edma *edma, hwaddr addr,
+        uint32_t val, unsigned size)
+{
+    edma->io[addr >> 2] = deposit32(edma->io[addr >> 2], (addr & 3) * 8,
+        size * 8, val);
+}
+
+static uint32_t chan_reg(struct dma_chan *dma_chan, hwaddr reg, unsigned size)
+{
+    return edma_reg_read(dma_chan->edma, EDMA_CH_BASE(dma_chan->chan) + reg,
+        size);
+}
+
+static void chan_reg_write(struct dma_chan *dma_chan, hwaddr reg,
+        uint32_t val, unsigned size)
+{
+    edma_reg_write(dma_chan->edma, EDMA_CH_BASE(dma_chan->chan) + reg, val,
+        size);
+}
+
+/* per channel IRQSTR input, ESAI and SAI channel pairs share a line */
+int edma_chan_irq(int chan)
+{
+    switch (chan) {
+    case EDMA0_ESAI_CHAN_RX:
+        return EDMA0_ESAI_CHAN_RX_IRQ;
+    case EDMA0_ESAI_CHAN_TX:
+        return EDMA0_ESAI_CHAN_TX_IRQ;
+    case EDMA0_SAI_CHAN_RX:
+        return EDMA0_SAI_CHAN_RX_IRQ;
+    case EDMA0_SAI_CHAN_TX:
+        return EDMA0_SAI_CHAN_TX_IRQ;
+    default:
+        return -1;
+    }
+}
+
+/* raise or drop the channel IRQ, shared lines stay up while any is pending */
+static void edma_irq_sync(struct adsp_edma *edma, int chan)
+{
+    int irq = edma_chan_irq(chan);
+    int i, pending = 0;
+
+    if (irq < 0)
+        return;
+
+    for (i = 0; i < NUM_CHANNELS; i++) {
+        if (edma_chan_irq(i) == irq &&
+            (edma->io[(EDMA_CH_BASE(i) + EDMA_CH_INT) >> 2] & EDMA_CH_INT_INT))
+            pending = 1;
+    }
+
+    /* IRQSTR inputs are level, setting an asserted input again is harmless */
+    log_text(edma->log, LOG_DMA_IRQ, "IRQ: EDMA %d chan %d %s\n",
+        edma->id, chan, pending ? "set" : "clear");
+    edma->do_irq(edma, pending, chan);
+}
+
+static void edma_chan_irq_raise(struct dma_chan *dma_chan)
+{
+    chan_reg_write(dma_chan, EDMA_CH_INT, EDMA_CH_INT_INT, 4);
+    edma_irq_sync(dma_chan->edma, dma_chan->chan);
+}
+
+/* element size in bytes from TCD ATTR SSIZE or DSIZE */
+static uint32_t edma_elem_size(uint32_t code, uint32_t nbytes)
+{
+    uint32_t size = 1 << (code & 0x7);
+
+    /* reserved codes or sizes that don't divide the minor loop */
+    if (size > 64 || nbytes % size)
+        return 1;
+    return size;
+}
+
+/* gather elements from memory stepping off bytes after each one */
+static void edma_mem_read(hwaddr addr, int16_t off, uint32_t esize,
+        uint8_t *buf, uint32_t bytes)
+{
+    uint32_t i;
+
+    if (off == esize) {
+        cpu_physical_memory_read(addr, buf, bytes);
+        return;
+    }
+
+    for (i = 0; i < bytes; i += esize, addr += off)
+        cpu_physical_memory_read(addr, buf + i, esize);
+}
+
+/* scatter elements to memory stepping off bytes after each one */
+static void edma_mem_write(hwaddr addr, int16_t off, uint32_t esize,
+        const uint8_t *buf, uint32_t bytes)
+{
+    uint32_t i;
+
+    if (off == esize) {
+        cpu_physical_memory_write(addr, buf, bytes);
+        return;
+    }
+
+    for (i = 0; i < bytes; i += esize, addr += off)
+        cpu_physical_memory_write(addr, buf + i, esize);
+}
+
+/* find the DAI owning a FIFO address, sets sai or esai port and direction */
+static void edma_find_dai(struct dma_chan *dma_chan, uint32_t saddr,
+        uint32_t daddr)
+{
+    struct adsp_esai *esai;
+    struct adsp_sai *sai;
+    int i;
+
+    dma_chan->sai = -1;
+    dma_chan->esai = -1;
+
+    for (i = 0; (esai = esai_get_port(i)) != NULL; i++) {
+        if (daddr == esai->esai_dev->desc.base + REG_ESAI_ETDR) {
+            dma_chan->esai = i;
+            dma_chan->dir = DAI_DIR_PLAYBACK;
+            return;
+        }
+        if (saddr == esai->esai_dev->desc.base + REG_ESAI_ERDR) {
+            dma_chan->esai = i;
+            dma_chan->dir = DAI_DIR_CAPTURE;
+            return;
+        }
+    }
+
+    for (i = 0; (sai = sai_get_port(i)) != NULL; i++) {
+        if (daddr == sai->sai_dev->desc.base + REG_SAI_TDR0) {
+            dma_chan->sai = i;
+            dma_chan->dir = DAI_DIR_PLAYBACK;
+            return;
+        }
+        if (saddr == sai->sai_dev->desc.base + REG_SAI_RDR0) {
+            dma_chan->sai = i;
+            dma_chan->dir = DAI_DIR_CAPTURE;
+            return;
+        }
+    }
+}
+
+/* FIFO side of a burst, returns non zero when the DAI was short of data */
+static int edma_dai_write(struct dma_chan *dma_chan, const void *data,
+        uint32_t bytes)
+{
+    if (dma_chan->esai >= 0)
+        return esai_fifo_write(esai_get_port(dma_chan->esai), data,
+            bytes) < bytes;
+    return sai_fifo_write(sai_get_port(dma_chan->sai), data, bytes) < bytes;
+}
+
+static int edma_dai_read(struct dma_chan *dma_chan, void *data,
+        uint32_t bytes)
+{
+    if (dma_chan->esai >= 0)
+        return esai_fifo_read(esai_get_port(dma_chan->esai), data,
+            bytes) < bytes;
+    return sai_fifo_read(sai_get_port(dma_chan->sai), data, bytes) < bytes;
+}
+
+/* load the next TCD from memory for scatter gather */
+static void edma_tcd_load(struct dma_chan *dma_chan, uint32_t addr)
+{
+    struct adsp_edma *edma = dma_chan->edma;
+    uint32_t tcd[EDMA_TCD_SIZE / 4];
+    int i;
+
+    cpu_physical_memory_read(addr, tcd, sizeof(tcd));
+    for (i = 0; i < ARRAY_SIZE(tcd); i++)
+        chan_reg_write(dma_chan, EDMA_TCD_OFFSET + i * 4,
+            le32_to_cpu(tcd[i]), 4);
+
+    log_text(edma->log, LOG_DMA,
+        "edma: %d:%d: TCD load 0x%x SADDR 0x%x DADDR 0x%x\n", edma->id,
+        dma_chan->chan, addr, chan_reg(dma_chan, EDMA_TCD_SADDR, 4),
+        chan_reg(dma_chan, EDMA_TCD_DADDR, 4));
+}
+
+/* major loop done - apply last adjustments, reload and signal */
+static int edma_major_complete(struct dma_chan *dma_chan)
 {
-    struct timespec req;
+    uint32_t csr = chan_reg(dma_chan, EDMA_TCD_CSR, 2);
+    uint32_t biter = chan_reg(dma_chan, EDMA_TCD_BITER, 2);
+
+    chan_reg_write(dma_chan, EDMA_TCD_SADDR,
+        chan_reg(dma_chan, EDMA_TCD_SADDR, 4) +
+        chan_reg(dma_chan, EDMA_TCD_SLAST, 4), 4);
+    chan_reg_write(dma_chan, EDMA_TCD_CITER, biter, 2);
+    chan_reg_write(dma_chan, EDMA_CH_CSR,
+        chan_reg(dma_chan, EDMA_CH_CSR, 4) | EDMA_CH_CSR_DONE, 4);
+
+    if (csr & EDMA_TCD_CSR_ESG)
+        edma_tcd_load(dma_chan, chan_reg(dma_chan, EDMA_TCD_DLAST_SGA, 4));
+    else
+        chan_reg_write(dma_chan, EDMA_TCD_DADDR,
+            chan_reg(dma_chan, EDMA_TCD_DADDR, 4) +
+            chan_reg(dma_chan, EDMA_TCD_DLAST_SGA, 4), 4);
+
+    if (csr & EDMA_TCD_CSR_INTMAJOR)
+        edma_chan_irq_raise(dma_chan);
+
+    /* disable requests after this major loop */
+    if (csr & EDMA_TCD_CSR_DREQ) {
+        chan_reg_write(dma_chan, EDMA_CH_CSR,
+            chan_reg(dma_chan, EDMA_CH_CSR, 4) & ~EDMA_CH_CSR_ERQ, 4);
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Run the minor loops for one burst - half a major loop so the INTHALF and
+ * INTMAJOR points land on burst boundaries like the DW DMA half blocks.
+ */
+static int edma_chan_burst(void *data)
+{
+    struct dma_chan *dma_chan = data;
+    struct adsp_edma *edma = dma_chan->edma;
+    uint8_t buffer[0x4000];
+    uint32_t saddr, daddr, nbytes, attr, ssize, dsize, citer, biter;
+    uint32_t loops, chunk, bytes, start_citer;
+    int16_t soff, doff;
+    int dai;
+
+    if (dma_chan->stop)
+        return 0;
 
-    req.tv_sec = 0;
-    req.tv_nsec = nsec;
+    saddr = chan_reg(dma_chan, EDMA_TCD_SADDR, 4);
+    daddr = chan_reg(dma_chan, EDMA_TCD_DADDR, 4);
+    soff = chan_reg(dma_chan, EDMA_TCD_SOFF, 2);
+    doff = chan_reg(dma_chan, EDMA_TCD_DOFF, 2);
+    attr = chan_reg(dma_chan, EDMA_TCD_ATTR, 2);
+    nbytes = chan_reg(dma_chan, EDMA_TCD_NBYTES, 4) & EDMA_TCD_NBYTES_MASK;
+    citer = chan_reg(dma_chan, EDMA_TCD_CITER, 2) & EDMA_TCD_ITER_MASK;
+    biter = chan_reg(dma_chan, EDMA_TCD_BITER, 2) & EDMA_TCD_ITER_MASK;
 
-    if (nanosleep(&req, NULL) < 0) {
-        fprintf(stderr, "failed to sleep %d\n", -errno);
+    if (nbytes == 0 || nbytes > sizeof(buffer) || citer == 0) {
+        log_text(edma->log, LOG_DMA,
+            "edma: %d:%d: invalid TCD NBYTES 0x%x CITER %d\n",
+            edma->id, dma_chan->chan, nbytes, citer);
+        chan_reg_write(dma_chan, EDMA_CH_ES, EDMA_CH_ES_ERR, 4);
+        return 0;
     }
 
+    ssize = edma_elem_size(attr >> 8, nbytes);
+    dsize = edma_elem_size(attr, nbytes);
+    loops = MIN(citer, dma_chan->loops);
+    start_citer = citer;
+    dai = dma_chan->esai >= 0 || dma_chan->sai >= 0;
+
+    /* move the minor loops in chunks that fit the bounce buffer */
+    while (loops) {
+        chunk = MIN(loops, sizeof(buffer) / nbytes);
+        bytes = chunk * nbytes;
+
+        if (dai && dma_chan->dir == DAI_DIR_CAPTURE) {
+            /* capture - FIFO to memory */
+            dma_chan->xruns += edma_dai_read(dma_chan, buffer, bytes);
+            edma_mem_write(daddr, doff, dsize, buffer, bytes);
+        } else if (dai) {
+            /* playback - memory to FIFO */
+            edma_mem_read(saddr, soff, ssize, buffer, bytes);
+            dma_chan->xruns += edma_dai_write(dma_chan, buffer, bytes);
+        } else {
+            edma_mem_read(saddr, soff, ssize, buffer, bytes);
+            edma_mem_write(daddr, doff, dsize, buffer, bytes);
+        }
+
+        saddr += (bytes / ssize) * soff;
+        daddr += (bytes / dsize) * doff;
+        citer -= chunk;
+        loops -= chunk;
+        dma_chan->tbytes += bytes;
+    }
+
+    chan_reg_write(dma_chan, EDMA_TCD_SADDR, saddr, 4);
+    chan_reg_write(dma_chan, EDMA_TCD_DADDR, daddr, 4);
+    chan_reg_write(dma_chan, EDMA_TCD_CITER, citer, 2);
+
+    if (citer == 0)
+        return edma_major_complete(dma_chan);
+
+    if ((chan_reg(dma_chan, EDMA_TCD_CSR, 2) & EDMA_TCD_CSR_INTHALF) &&
+        citer <= biter / 2 && start_citer > biter / 2)
+        edma_chan_irq_raise(dma_chan);
+
+    return 1;
+}
+
+static void edma_chan_complete(void *data)
+{
+    struct dma_chan *dma_chan = data;
+    struct adsp_edma *edma = dma_chan->edma;
+    int64_t ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) - dma_chan->start_ns;
+
+    chan_reg_write(dma_chan, EDMA_CH_CSR,
+        chan_reg(dma_chan, EDMA_CH_CSR, 4) & ~EDMA_CH_CSR_ACTIVE, 4);
+
+    log_text(edma->log, LOG_DMA,
+        "edma: %d:%d: complete total bytes 0x%" PRIx64 " in %" PRId64
+        " us, %" PRIu64 " bytes/s, xruns %d\n", edma->id, dma_chan->chan,
+        dma_chan->tbytes, ns / 1000, ns > 0 ? muldiv64(dma_chan->tbytes,
+        NANOSECONDS_PER_SECOND, ns) : 0, dma_chan->xruns);
+}
+
+/* burst period is the time the DAI takes to play or capture one burst */
+static int64_t edma_burst_period(struct dma_chan *dma_chan)
+{
+    uint32_t nbytes = chan_reg(dma_chan, EDMA_TCD_NBYTES, 4) &
+        EDMA_TCD_NBYTES_MASK;
+    uint32_t bytes = dma_chan->loops * nbytes;
+    int dir = dma_chan->dir;
+
+    if (dma_chan->esai >= 0) {
+        struct adsp_esai *esai = esai_get_port(dma_chan->esai);
+
+        return dma_timer_period_ns(bytes, esai_get_frame_bytes(esai, dir),
+            esai_get_rate(esai, dir));
+    }
+
+    if (dma_chan->sai >= 0) {
+        struct adsp_sai *sai = sai_get_port(dma_chan->sai);
+
+        return dma_timer_period_ns(bytes, sai_get_frame_bytes(sai, dir),
+            sai_get_rate(sai, dir));
+    }
+
+    return DMA_TIMER_M2M_PERIOD;
+}
+
+static void edma_start_transfer(struct adsp_edma *edma, int chan)
+{
+    struct dma_chan *dma_chan = &edma->dma_chan[chan];
+    uint32_t saddr, daddr, biter;
+
+    saddr = chan_reg(dma_chan, EDMA_TCD_SADDR, 4);
+    daddr = chan_reg(dma_chan, EDMA_TCD_DADDR, 4);
+    biter = chan_reg(dma_chan, EDMA_TCD_BITER, 2) & EDMA_TCD_ITER_MASK;
+
+    if (chan_reg(dma_chan, EDMA_TCD_NBYTES, 4) & EDMA_TCD_NBYTES_MLOE)
+        log_text(edma->log, LOG_DMA,
+            "edma: %d:%d: minor loop offsets not supported\n",
+            edma->id, chan);
+
+    /* prepare timer context */
+    dma_chan->stop = 0;
+    dma_chan->tbytes = 0;
+    dma_chan->xruns = 0;
+    dma_chan->loops = MAX(biter / 2, 1);
+    dma_chan->start_ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    edma_find_dai(dma_chan, saddr, daddr);
+
+    chan_reg_write(dma_chan, EDMA_CH_CSR,
+        (chan_reg(dma_chan, EDMA_CH_CSR, 4) & ~EDMA_CH_CSR_DONE) |
+        EDMA_CH_CSR_ACTIVE, 4);
+
+    log_text(edma->log, LOG_DMA,
+        "edma: %d:%d: start SADDR 0x%x DADDR 0x%x NBYTES 0x%x BITER %d "
+        "esai %d sai %d\n", edma->id, chan, saddr, daddr,
+        chan_reg(dma_chan, EDMA_TCD_NBYTES, 4), biter, dma_chan->esai,
+        dma_chan->sai);
+
+    dma_timer_start(&dma_chan->timer, edma_burst_period(dma_chan),
+        edma_chan_burst, edma_chan_complete, dma_chan);
+}
+
+static void edma_stop_transfer(struct adsp_edma *edma, int chan)
+{
+    struct dma_chan *dma_chan = &edma->dma_chan[chan];
+
+    if (!dma_chan->timer.active)
+        return;
+
+    dma_chan->stop = 1;
+    dma_timer_stop(&dma_chan->timer);
+    edma_chan_complete(dma_chan);
 }
 
 void edma_reset(void *opaque)
@@ -52,6 +431,10 @@ void edma_reset(void *opaque)
     struct adsp_io_info *info = opaque;
     struct adsp_edma *edma = info->private;
     const struct adsp_reg_space *edma_dev = edma->desc;
+    int i;
+
+    for (i = 0; i < NUM_CHANNELS; i++)
+        dma_timer_stop(&edma->dma_chan[i].timer);
 
     memset(edma->io, 0, edma_dev->desc.size);
 }
@@ -67,7 +450,7 @@ static uint64_t edma_read(void *opaque, hwaddr addr,
     log_read(edma->log, edma_dev, addr, size,
             edma->io[addr >> 2]);
 
-    return edma->io[addr >> 2];
+    return edma_reg_read(edma, addr, size);
 }
 
 static void edma_write(void *opaque, hwaddr addr,
@@ -76,9 +459,54 @@ static void edma_write(void *opaque, hwaddr addr,
     struct adsp_io_info *info = opaque;
     struct adsp_edma *edma = info->private;
     const struct adsp_reg_space *edma_dev = edma->desc;
+    int chan = addr / EDMA_CH_SIZE;
+    hwaddr reg = addr % EDMA_CH_SIZE;
+    uint32_t old;
 
     log_write(edma->log, edma_dev, addr, val, size,
             edma->io[addr >> 2]);
+
+    if (chan >= NUM_CHANNELS)
+        return;
+
+    old = edma_reg_read(edma, addr, size);
+
+    switch (reg) {
+    case EDMA_CH_CSR:
+        /* DONE is write 1 to clear, ACTIVE is read only */
+        val = (val & ~(EDMA_CH_CSR_DONE | EDMA_CH_CSR_ACTIVE)) |
+            (old & EDMA_CH_CSR_ACTIVE) |
+            (old & EDMA_CH_CSR_DONE & ~val);
+        edma_reg_write(edma, addr, val, size);
+
+        /* hardware requests enabled or disabled */
+        if ((val & EDMA_CH_CSR_ERQ) && !(old & EDMA_CH_CSR_ERQ))
+            edma_start_transfer(edma, chan);
+        else if (!(val & EDMA_CH_CSR_ERQ) && (old & EDMA_CH_CSR_ERQ))
+            edma_stop_transfer(edma, chan);
+        break;
+    case EDMA_CH_ES:
+        /* error bits are write 1 to clear */
+        edma_reg_write(edma, addr, old & ~val, size);
+        break;
+    case EDMA_CH_INT:
+        /* write 1 to clear */
+        edma_reg_write(edma, addr, old & ~val, size);
+        edma_irq_sync(edma, chan);
+        break;
+    case EDMA_TCD_CSR:
+        edma_reg_write(edma, addr, val, size);
+
+        /* software start runs the TCD without a hardware request */
+        if (val & EDMA_TCD_CSR_START) {
+            edma_reg_write(edma, addr, val & ~EDMA_TCD_CSR_START, size);
+            edma_start_transfer(edma, chan);
+        }
+        break;
+    default:
+        edma_reg_write(edma, addr, val, size);
+        break;
+    }
 }
 
 const MemoryRegionOps edma_ops = {
@@ -25,14 +25,16 @@
 #include "hw/adsp/log.h"
 #include "hw/dma/edma.h"
 
+/* mask is the channel, each channel has its own IRQSTR input */
 static void dsp_do_irq(struct adsp_edma *edma, int enable, uint32_t mask)
 {
     struct adsp_io_info *info = edma->info;
+    int irq = edma_chan_irq(mask);
 
     if (enable) {
-        adsp_irq_set(edma->adsp, info, info->space->irq, mask);
+        adsp_irq_set(edma->adsp, info, irq, mask);
     } else {
-        adsp_irq_clear(edma->adsp, info, info->space->irq, mask);
+        adsp_irq_clear(edma->adsp, info, irq, mask);
     }
 }
 
@@ -43,7 +45,7 @@ void edma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
     char name[32];
     int j;
 
-    edma = g_malloc(sizeof(*edma));
+    edma = g_malloc0(sizeof(*edma));
     edma->adsp = adsp;
     edma->id = info->io_dev;
     edma->irq_assert = 0;
@@ -61,6 +63,9 @@ void edma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
         edma->dma_chan[j].fd = 0;
         edma->dma_chan[j].chan = j;
         edma->dma_chan[j].file_idx = 0;
+        edma->dma_chan[j].sai = -1;
+        edma->dma_chan[j].esai = -1;
+        dma_timer_init(&edma->dma_chan[j].timer);
         sprintf(edma->dma_chan[j].thread_name, "dmac:%d.%d", info->io_dev, j);
     }
 
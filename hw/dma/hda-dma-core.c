@@ -54,17 +54,6 @@
 #define DGCS_BNE    (0x1 << 8)
 #define DGCS_FIFORDY    (0x1 << 5)
 
-static inline void dma_sleep(long nsec)
-{
-    struct timespec req;
-
-    req.tv_sec = 0;
-    req.tv_nsec = nsec;
-
-    if (nanosleep(&req, NULL) < 0)
-        fprintf(stderr, "failed to sleep %d\n", -errno);
-}
-
 static void dma_host_req(struct adsp_hda_dmac *dmac, uint32_t chan,
     uint32_t direction)
 {
@@ -147,8 +136,9 @@ static void chan_reset(struct adsp_hda_dmac *dmac, int chan)
 }
 
 /* read from MEM and write to SSP - audio playback */
-static int dma_M2P_copy_burst(struct hda_dma_chan *hda_dma_chan)
+static int dma_M2P_copy_burst(void *data)
 {
+    struct hda_dma_chan *hda_dma_chan = data;
     struct adsp_hda_dmac *dmac = hda_dma_chan->dmac;
     uint32_t chan = hda_dma_chan->chan;
     hwaddr burst_size;
@@ -165,16 +155,13 @@ static int dma_M2P_copy_burst(struct hda_dma_chan *hda_dma_chan)
 
     sar = dmac->io[DGBRP(chan) >> 2];
     size = dmac->io[DGBFPI(chan) >> 2];
-    burst_size = size / 2;
+    burst_size = MIN(size / 2, sizeof(buffer));
 
     /* copy burst from SAR to DAR */
     cpu_physical_memory_read(sar, buffer, burst_size);
 
-    /* copy buffer to files */
-    if (hda_dma_chan->fd > 0) {
-        if (write(hda_dma_chan->fd, buffer, burst_size) != burst_size)
-            fprintf(stderr, "error: writing to DMAC file %d\n", -errno);
-    }
+    /* copy buffer to endpoints */
+    dai_endpoint_write(hda_dma_chan->trace, buffer, burst_size);
 
     /* update SAR, DAR and bytes copied */
     hda_dma_chan->ptr += burst_size;
@@ -192,8 +179,9 @@ static int dma_M2P_copy_burst(struct hda_dma_chan *hda_dma_chan)
 }
 
 /* read from SSP and write to MEM - audio capture */
-static int dma_P2M_copy_burst(struct hda_dma_chan *hda_dma_chan)
+static int dma_P2M_copy_burst(void *data)
 {
+    struct hda_dma_chan *hda_dma_chan = data;
     struct adsp_hda_dmac *dmac = hda_dma_chan->dmac;
     uint32_t chan = hda_dma_chan->chan;
     hwaddr burst_size;
@@ -210,16 +198,13 @@ static int dma_P2M_copy_burst(struct hda_dma_chan *hda_dma_chan)
 
     dar = dmac->io[DGBWP(chan) >> 2];
     size = dmac->io[DGBFPI(chan) >> 2];
-    burst_size = size / 2;
+    burst_size = MIN(size / 2, sizeof(buffer));
 
-    /* copy burst from SAR to DAR */
-    cpu_physical_memory_read(dar, buffer, burst_size);
+    /* link has no DAI endpoint so capture silence */
+    dai_endpoint_read(NULL, buffer, burst_size);
 
-    /* copy buffer to files */
-    if (hda_dma_chan->fd > 0) {
-        if (read(hda_dma_chan->fd, buffer, burst_size) != burst_size)
-            fprintf(stderr, "error: reading to DMAC file %d\n", -errno);
-    }
+    /* copy burst from SAR to DAR */
+    cpu_physical_memory_write(dar, buffer, burst_size);
 
     /* update SAR, DAR and bytes copied */
     hda_dma_chan->ptr += burst_size;
@@ -237,8 +222,9 @@ static int dma_P2M_copy_burst(struct hda_dma_chan *hda_dma_chan)
 }
 
 /* read from host and write to DSP - audio playback */
-static int dma_M2M_read_host_burst(struct hda_dma_chan *hda_dma_chan)
+static int dma_M2M_read_host_burst(void *data)
 {
+    struct hda_dma_chan *hda_dma_chan = data;
     struct adsp_hda_dmac *dmac = hda_dma_chan->dmac;
     uint32_t chan = hda_dma_chan->chan;
     hwaddr burst_size = 32; // TODO read from DMAC
@@ -262,16 +248,13 @@ static int dma_M2M_read_host_burst(struct hda_dma_chan *hda_dma_chan)
 
     /* copy burst from SAR to DAR */
     cpu_physical_memory_write(dar, hda_dma_chan->ptr, burst_size);
+    dai_endpoint_write(hda_dma_chan->trace, hda_dma_chan->ptr, burst_size);
 
     hda_dma_chan->ptr += burst_size;
     hda_dma_chan->bytes += burst_size;
     hda_dma_chan->tbytes += burst_size;
     chan_update_wptr(dmac, chan, burst_size);
 
-    if (hda_dma_chan->fd > 0) {
-        if (write(hda_dma_chan->fd, hda_dma_chan->ptr, burst_size) != burst_size)
-            fprintf(stderr, "error: writing to DMAC file %d\n", -errno);
-    }
 
     log_text(dmac->log, LOG_DMA_M2M,
         "dma: %d:%d: completed SAR 0x%x DAR 0x%x size 0x%x total bytes 0x%x\n",
@@ -283,8 +266,9 @@ static int dma_M2M_read_host_burst(struct hda_dma_chan *hda_dma_chan)
 }
 
 /* read from DSP and write to host - audio capture */
-static int dma_M2M_write_host_burst(struct hda_dma_chan *hda_dma_chan)
+static int dma_M2M_write_host_burst(void *data)
 {
+    struct hda_dma_chan *hda_dma_chan = data;
     struct adsp_hda_dmac *dmac = hda_dma_chan->dmac;
     uint32_t chan = hda_dma_chan->chan;
     hwaddr burst_size = 32; // TODO read from DMAC
@@ -326,96 +310,26 @@ static int dma_M2M_write_host_burst(struct hda_dma_chan *hda_dma_chan)
 static void open_dmac_file(struct hda_dma_chan *hda_dma_chan)
 {
     struct adsp_hda_dmac *dmac = hda_dma_chan->dmac;
+    struct dai_format fmt = {48000, 2, 2};
     char name[32];
 
-    /* create filename */
-    sprintf(name, "/tmp/hda-dmac%d-%d-%d.wav", dmac->id, hda_dma_chan->chan,
-        hda_dma_chan->file_idx++);
-    unlink(name);
-
-    if (hda_dma_chan->fd == 0)
-        hda_dma_chan->fd = open(name, O_WRONLY | O_CREAT,
-            S_IRUSR | S_IWUSR | S_IXUSR);
-
-    if (hda_dma_chan->fd < 0)
-        fprintf(stderr, "error: can't open file %s %d\n", name, -errno);
-}
-
-static void close_dmac_file(struct hda_dma_chan *hda_dma_chan)
-{
-    if (hda_dma_chan->fd > 0) {
-        close(hda_dma_chan->fd);
-        hda_dma_chan->fd = 0;
-    }
-}
-
-/* TODO: make these configurable on rate etc */
-#define DMA_M2M_BURST_SLEEP    (200 * 1000)    /* 200us */
-#define DMA_M2P_BURST_SLEEP    (6667 * 1000)    /* 6.66ms */
-#define DMA_P2M_BURST_SLEEP    (6667 * 1000)    /* 6.66ms */
-
-/* dsp mem to host mem work for capture */
-static void * hda_dma_channel_Mhost2Mdsp_work(void *data)
-{
-    struct hda_dma_chan *hda_dma_chan = data;
-
-    open_dmac_file(hda_dma_chan);
-
-    do {
-        dma_sleep(DMA_M2M_BURST_SLEEP);
-    } while (dma_M2M_write_host_burst(hda_dma_chan));
-
-    close_dmac_file(hda_dma_chan);
-
-    return NULL;
-}
-
-/* dsp mem to host mem work for capture */
-static void * hda_dma_channel_Mdsp2Mhost_work(void *data)
-{
-    struct hda_dma_chan *hda_dma_chan = data;
-
-    open_dmac_file(hda_dma_chan);
-
-    do {
-        dma_sleep(DMA_M2M_BURST_SLEEP);
-    } while (dma_M2M_read_host_burst(hda_dma_chan));
-
-    close_dmac_file(hda_dma_chan);
-
-    return NULL;
-}
-
-/* peripheral to mem channel work */
-static void * hda_dma_channel_P2M_work(void *data)
-{
-    struct hda_dma_chan *hda_dma_chan = data;
-
-    open_dmac_file(hda_dma_chan);
-
-    do {
-        dma_sleep(DMA_P2M_BURST_SLEEP);
-    } while (dma_P2M_copy_burst(hda_dma_chan));
-
-    close_dmac_file(hda_dma_chan);
+    /* one trace stream and writer per channel, kept across transfers */
+    if (hda_dma_chan->trace)
+        return;
 
-    return NULL;
+    /* create stream name */
+    sprintf(name, "hda-dmac%d-%d", dmac->id, hda_dma_chan->chan);
+    hda_dma_chan->trace = dai_endpoint_open(name, DAI_DIR_PLAYBACK,
+        DAI_BACKEND_RAW, &fmt);
 }
 
-/* mem to peripheral channel work */
-static void * hda_dma_channel_M2P_work(void *data)
+/* link DMA has no DAI format here, so pace at the default frame rate */
+static int64_t dma_P_burst_period(struct hda_dma_chan *hda_dma_chan)
 {
-    struct hda_dma_chan *hda_dma_chan = data;
-
-    open_dmac_file(hda_dma_chan);
-
-    do {
-        dma_sleep(DMA_M2P_BURST_SLEEP);
-    } while (dma_M2P_copy_burst(hda_dma_chan));
-
-    close_dmac_file(hda_dma_chan);
+    struct adsp_hda_dmac *dmac = hda_dma_chan->dmac;
+    uint32_t size = dmac->io[DGBFPI(hda_dma_chan->chan) >> 2];
 
-    return NULL;
+    return dma_timer_period_ns(size / 2, 0, 0);
 }
 
 static void dma_P2M_start(struct adsp_hda_dmac *dmac, uint32_t chan)
@@ -427,8 +341,9 @@ static void dma_P2M_start(struct adsp_hda_dmac *dmac, uint32_t chan)
     hda_dma_chan->tbytes = 0;
     chan_reset(dmac, chan);
 
-    qemu_thread_create(&hda_dma_chan->thread, hda_dma_chan->thread_name,
-        hda_dma_channel_P2M_work, hda_dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(hda_dma_chan);
+    dma_timer_start(&hda_dma_chan->timer, dma_P_burst_period(hda_dma_chan),
+        dma_P2M_copy_burst, NULL, hda_dma_chan);
 }
 
 static void dma_M2P_start(struct adsp_hda_dmac *dmac, uint32_t chan)
@@ -440,8 +355,9 @@ static void dma_M2P_start(struct adsp_hda_dmac *dmac, uint32_t chan)
     hda_dma_chan->tbytes = 0;
     chan_reset(dmac, chan);
 
-    qemu_thread_create(&hda_dma_chan->thread, hda_dma_chan->thread_name,
-        hda_dma_channel_M2P_work, hda_dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(hda_dma_chan);
+    dma_timer_start(&hda_dma_chan->timer, dma_P_burst_period(hda_dma_chan),
+        dma_M2P_copy_burst, NULL, hda_dma_chan);
 }
 
 static void dma_Mdsp2Mhost_start(struct adsp_hda_dmac *dmac, uint32_t chan)
@@ -453,8 +369,9 @@ static void dma_Mdsp2Mhost_start(struct adsp_hda_dmac *dmac, uint32_t chan)
     hda_dma_chan->tbytes = 0;
     chan_reset(dmac, chan);
 
-    qemu_thread_create(&hda_dma_chan->thread, hda_dma_chan->thread_name,
-        hda_dma_channel_Mdsp2Mhost_work, hda_dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(hda_dma_chan);
+    dma_timer_start(&hda_dma_chan->timer, DMA_TIMER_M2M_PERIOD,
+        dma_M2M_read_host_burst, NULL, hda_dma_chan);
 }
 
 static void dma_Mhost2Mdsp_start(struct adsp_hda_dmac *dmac, uint32_t chan)
@@ -466,8 +383,9 @@ static void dma_Mhost2Mdsp_start(struct adsp_hda_dmac *dmac, uint32_t chan)
     hda_dma_chan->tbytes = 0;
     chan_reset(dmac, chan);
 
-    qemu_thread_create(&hda_dma_chan->thread, hda_dma_chan->thread_name,
-        hda_dma_channel_Mhost2Mdsp_work, hda_dma_chan, QEMU_THREAD_DETACHED);
+    open_dmac_file(hda_dma_chan);
+    dma_timer_start(&hda_dma_chan->timer, DMA_TIMER_M2M_PERIOD,
+        dma_M2M_write_host_burst, NULL, hda_dma_chan);
 }
 
 /* init new DMA mem to mem transfer after host is ready */
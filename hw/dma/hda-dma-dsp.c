@@ -84,9 +84,10 @@ void hda_dma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
     /* channels */
     for (j = 0; j < HDA_NUM_CHANNELS; j++) {
         dmac->hda_dma_chan[j].dmac = dmac;
-        dmac->hda_dma_chan[j].fd = 0;
+        dmac->hda_dma_chan[j].trace = NULL;
         dmac->hda_dma_chan[j].chan = j;
         dmac->hda_dma_chan[j].file_idx = 0;
+        dma_timer_init(&dmac->hda_dma_chan[j].timer);
         sprintf(dmac->hda_dma_chan[j].thread_name, "hda-%s-dmac-%d-%d.io",
             info->space->name, info->io_dev, j);
     }
@@ -18,6 +18,8 @@
 #include "exec/memory.h"
 #include "exec/address-spaces.h"
 #include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "qemu/host-utils.h"
 #include "qemu/io-bridge.h"
 
 #include "hw/pci/pci.h"
@@ -25,7 +27,8 @@
 #include "hw/audio/adsp-host.h"
 #include "hw/adsp/shim.h"
 #include "hw/adsp/log.h"
-#include "hw/ssi/ssp.h"
+#include "hw/adsp/dai.h"
+#include "hw/ssi/sai.h"
 #include "hw/dma/sdma.h"
 
 
@@ -34,16 +37,254 @@ const struct adsp_reg_desc adsp_sdma_map[] = {
         .offset = 0x00000000, .size = 0x10000},
 };
 
-static inline void dma_sleep(long nsec)
+static void sdma_irq_sync(struct adsp_sdma *sdma)
 {
-    struct timespec req;
+    uint32_t intr = sdma->io[SDMA_H_INTR >> 2];
 
-    req.tv_sec = 0;
-    req.tv_nsec = nsec;
+    if (intr && !sdma->irq_assert) {
+        sdma->irq_assert = 1;
+        log_text(sdma->log, LOG_DMA_IRQ, "IRQ: SDMA %d set 0x%x\n",
+            sdma->id, intr);
+        sdma->do_irq(sdma, 1, intr);
+    } else if (intr == 0 && sdma->irq_assert) {
+        sdma->irq_assert = 0;
+        log_text(sdma->log, LOG_DMA_IRQ, "IRQ: SDMA %d clear\n", sdma->id);
+        sdma->do_irq(sdma, 0, intr);
+    }
+}
+
+static void sdma_chan_irq(struct dma_chan *dma_chan)
+{
+    struct adsp_sdma *sdma = dma_chan->sdma;
+
+    sdma->io[SDMA_H_INTR >> 2] |= 1 << dma_chan->chan;
+    sdma_irq_sync(sdma);
+}
+
+static uint32_t sdma_ccb_addr(struct dma_chan *dma_chan)
+{
+    struct adsp_sdma *sdma = dma_chan->sdma;
+
+    return sdma->io[SDMA_H_C0PTR >> 2] + dma_chan->chan * SDMA_CCB_SIZE;
+}
+
+/* the DAI is the one whose DMA request event is routed to this channel */
+static void sdma_find_dai(struct dma_chan *dma_chan)
+{
+    struct adsp_sdma *sdma = dma_chan->sdma;
+    uint32_t mask = 1 << dma_chan->chan;
+
+    dma_chan->sai = -1;
+
+    if (sdma->io[SDMA_CHNENBL(SDMA_SAI3_EVENT_TX) >> 2] & mask) {
+        dma_chan->sai = 0;
+        dma_chan->dir = DAI_DIR_PLAYBACK;
+    } else if (sdma->io[SDMA_CHNENBL(SDMA_SAI3_EVENT_RX) >> 2] & mask) {
+        dma_chan->sai = 0;
+        dma_chan->dir = DAI_DIR_CAPTURE;
+    }
+
+    if (dma_chan->sai >= 0 && sai_get_port(dma_chan->sai) == NULL)
+        dma_chan->sai = -1;
+}
+
+/* move one BD buffer, returns non zero when the DAI was short of data */
+static int sdma_bd_xfer(struct dma_chan *dma_chan, uint32_t mode,
+        uint32_t buf, uint32_t ext)
+{
+    struct adsp_sai *sai = sai_get_port(dma_chan->sai);
+    uint8_t buffer[0x4000];
+    uint32_t count = mode & SDMA_BD_COUNT_MASK;
+    uint32_t bytes;
+    int xrun = 0;
+
+    while (count) {
+        bytes = MIN(count, sizeof(buffer));
+
+        if (dma_chan->sai < 0) {
+            /* memory to memory */
+            cpu_physical_memory_read(buf, buffer, bytes);
+            cpu_physical_memory_write(ext, buffer, bytes);
+            ext += bytes;
+        } else if (dma_chan->dir == DAI_DIR_PLAYBACK) {
+            cpu_physical_memory_read(buf, buffer, bytes);
+            xrun |= sai_fifo_write(sai, buffer, bytes) < bytes;
+        } else {
+            xrun |= sai_fifo_read(sai, buffer, bytes) < bytes;
+            cpu_physical_memory_write(buf, buffer, bytes);
+        }
+
+        buf += bytes;
+        count -= bytes;
+        dma_chan->tbytes += bytes;
+    }
+
+    return xrun;
+}
+
+/* process the current BD, one BD per burst */
+static int sdma_chan_burst(void *data)
+{
+    struct dma_chan *dma_chan = data;
+    struct adsp_sdma *sdma = dma_chan->sdma;
+    uint32_t bd[SDMA_BD_SIZE / 4];
+    uint32_t mode, base;
+
+    if (dma_chan->stop)
+        return 0;
+
+    cpu_physical_memory_read(dma_chan->bd, bd, sizeof(bd));
+    mode = le32_to_cpu(bd[SDMA_BD_MODE / 4]);
+
+    /* BD still owned by the DSP */
+    if (!(mode & SDMA_BD_DONE)) {
+        if (dma_chan->sai < 0)
+            return 0;
+
+        /* DAI keeps clocking, count it and poll again next period */
+        dma_chan->xruns++;
+        return 1;
+    }
+
+    dma_chan->xruns += sdma_bd_xfer(dma_chan, mode,
+        le32_to_cpu(bd[SDMA_BD_BUFFER / 4]),
+        le32_to_cpu(bd[SDMA_BD_EXT_BUFFER / 4]));
+
+    /* hand BD back */
+    mode &= ~SDMA_BD_DONE;
+    bd[SDMA_BD_MODE / 4] = cpu_to_le32(mode);
+    cpu_physical_memory_write(dma_chan->bd, bd, 4);
+
+    if (mode & SDMA_BD_INTR)
+        sdma_chan_irq(dma_chan);
+
+    /* last BD of a non cyclic transfer */
+    if (!(mode & SDMA_BD_CONT) || (mode & SDMA_BD_LAST))
+        return 0;
+
+    if (mode & SDMA_BD_WRAP) {
+        cpu_physical_memory_read(sdma_ccb_addr(dma_chan) + SDMA_CCB_BASE_BD,
+            &base, 4);
+        dma_chan->bd = le32_to_cpu(base);
+    } else {
+        dma_chan->bd += SDMA_BD_SIZE;
+    }
+
+    log_text(sdma->log, LOG_DMA, "sdma: %d:%d: next BD 0x%x\n",
+        sdma->id, dma_chan->chan, dma_chan->bd);
+    return 1;
+}
+
+static void sdma_chan_complete(void *data)
+{
+    struct dma_chan *dma_chan = data;
+    struct adsp_sdma *sdma = dma_chan->sdma;
+    int64_t ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) - dma_chan->start_ns;
+
+    sdma->io[SDMA_H_STATSTOP >> 2] &= ~(1 << dma_chan->chan);
+
+    log_text(sdma->log, LOG_DMA,
+        "sdma: %d:%d: complete total bytes 0x%" PRIx64 " in %" PRId64
+        " us, %" PRIu64 " bytes/s, xruns %d\n", sdma->id, dma_chan->chan,
+        dma_chan->tbytes, ns / 1000, ns > 0 ? muldiv64(dma_chan->tbytes,
+        NANOSECONDS_PER_SECOND, ns) : 0, dma_chan->xruns);
+}
+
+/* burst period is the time the DAI takes to play or capture one BD */
+static int64_t sdma_burst_period(struct dma_chan *dma_chan)
+{
+    struct adsp_sai *sai;
+    uint32_t mode;
+
+    if (dma_chan->sai < 0)
+        return DMA_TIMER_M2M_PERIOD;
+
+    sai = sai_get_port(dma_chan->sai);
+    cpu_physical_memory_read(dma_chan->bd + SDMA_BD_MODE, &mode, 4);
+
+    return dma_timer_period_ns(le32_to_cpu(mode) & SDMA_BD_COUNT_MASK,
+        sai_get_frame_bytes(sai, dma_chan->dir),
+        sai_get_rate(sai, dma_chan->dir));
+}
+
+/*
+ * Channel 0 loads scripts and contexts on behalf of the host. Scripts are
+ * not executed so just complete its BDs straight away.
+ */
+static void sdma_chan0_run(struct adsp_sdma *sdma)
+{
+    struct dma_chan *dma_chan = &sdma->dma_chan[0];
+    uint32_t ccb = sdma_ccb_addr(dma_chan);
+    uint32_t bd, mode, le;
+    int i;
+
+    cpu_physical_memory_read(ccb + SDMA_CCB_CURRENT_BD, &bd, 4);
+    bd = le32_to_cpu(bd);
+
+    /* bounded in case the chain is not terminated */
+    for (i = 0; i < 64; i++) {
+        cpu_physical_memory_read(bd + SDMA_BD_MODE, &mode, 4);
+        mode = le32_to_cpu(mode);
+        if (!(mode & SDMA_BD_DONE))
+            break;
+
+        log_text(sdma->log, LOG_DMA,
+            "sdma: %d:0: command 0x%x count 0x%x ignored\n", sdma->id,
+            mode >> SDMA_BD_COMMAND_SHIFT, mode & SDMA_BD_COUNT_MASK);
+
+        mode &= ~SDMA_BD_DONE;
+        le = cpu_to_le32(mode);
+        cpu_physical_memory_write(bd + SDMA_BD_MODE, &le, 4);
 
-    if (nanosleep(&req, NULL) < 0) {
-        fprintf(stderr, "failed to sleep %d\n", -errno);
+        if (!(mode & SDMA_BD_CONT) || (mode & SDMA_BD_WRAP))
+            break;
+        bd += SDMA_BD_SIZE;
     }
+
+    sdma->io[SDMA_H_STATSTOP >> 2] &= ~1;
+    sdma_chan_irq(dma_chan);
+}
+
+static void sdma_start_transfer(struct adsp_sdma *sdma, int chan)
+{
+    struct dma_chan *dma_chan = &sdma->dma_chan[chan];
+    uint32_t bd;
+
+    if (chan == 0) {
+        sdma_chan0_run(sdma);
+        return;
+    }
+
+    cpu_physical_memory_read(sdma_ccb_addr(dma_chan) + SDMA_CCB_CURRENT_BD,
+        &bd, 4);
+
+    /* prepare timer context */
+    dma_chan->bd = le32_to_cpu(bd);
+    dma_chan->stop = 0;
+    dma_chan->tbytes = 0;
+    dma_chan->xruns = 0;
+    dma_chan->start_ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    sdma_find_dai(dma_chan);
+
+    sdma->io[SDMA_H_STATSTOP >> 2] |= 1 << chan;
+
+    log_text(sdma->log, LOG_DMA, "sdma: %d:%d: start BD 0x%x sai %d\n",
+        sdma->id, chan, dma_chan->bd, dma_chan->sai);
+
+    dma_timer_start(&dma_chan->timer, sdma_burst_period(dma_chan),
+        sdma_chan_burst, sdma_chan_complete, dma_chan);
+}
+
+static void sdma_stop_transfer(struct adsp_sdma *sdma, int chan)
+{
+    struct dma_chan *dma_chan = &sdma->dma_chan[chan];
+
+    if (!dma_chan->timer.active)
+        return;
+
+    dma_chan->stop = 1;
+    dma_timer_stop(&dma_chan->timer);
+    sdma_chan_complete(dma_chan);
 }
 
 void sdma_reset(void *opaque)
@@ -51,6 +292,10 @@ void sdma_reset(void *opaque)
     struct adsp_io_info *info = opaque;
     struct adsp_sdma *sdma = info->private;
     const struct adsp_reg_space *sdma_dev = sdma->desc;
+    int i;
+
+    for (i = 0; i < NUM_CHANNELS; i++)
+        dma_timer_stop(&sdma->dma_chan[i].timer);
 
     memset(sdma->io, 0, sdma_dev->desc.size);
 }
@@ -75,9 +320,35 @@ static void sdma_write(void *opaque, hwaddr addr,
     struct adsp_io_info *info = opaque;
     struct adsp_sdma *sdma = info->private;
     const struct adsp_reg_space *sdma_dev = sdma->desc;
+    int chan;
 
     log_write(sdma->log, sdma_dev, addr, val, size,
             sdma->io[addr >> 2]);
+
+    switch (addr) {
+    case SDMA_H_START:
+        for (chan = 0; chan < NUM_CHANNELS; chan++) {
+            if (val & (1 << chan))
+                sdma_start_transfer(sdma, chan);
+        }
+        break;
+    case SDMA_H_STATSTOP:
+        /* write 1 to stop */
+        for (chan = 0; chan < NUM_CHANNELS; chan++) {
+            if (val & (1 << chan))
+                sdma_stop_transfer(sdma, chan);
+        }
+        sdma->io[addr >> 2] &= ~val;
+        break;
+    case SDMA_H_INTR:
+        /* write 1 to clear */
+        sdma->io[addr >> 2] &= ~val;
+        sdma_irq_sync(sdma);
+        break;
+    default:
+        sdma->io[addr >> 2] = val;
+        break;
+    }
 }
 
 const MemoryRegionOps sdma_ops = {
@@ -43,7 +43,7 @@ void sdma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
     char name[32];
     int j;
 
-    sdma = g_malloc(sizeof(*sdma));
+    sdma = g_malloc0(sizeof(*sdma));
     sdma->adsp = adsp;
     sdma->id = info->io_dev;
     sdma->irq_assert = 0;
@@ -61,6 +61,8 @@ void sdma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
         sdma->dma_chan[j].fd = 0;
         sdma->dma_chan[j].chan = j;
         sdma->dma_chan[j].file_idx = 0;
+        sdma->dma_chan[j].sai = -1;
+        dma_timer_init(&sdma->dma_chan[j].timer);
         sprintf(sdma->dma_chan[j].thread_name, "dmac:%d.%d", info->io_dev, j);
     }
 
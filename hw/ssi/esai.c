@@ -15,6 +15,7 @@
 #include "qemu/io-bridge.h"
 #include "hw/adsp/shim.h"
 #include "hw/adsp/log.h"
+#include "hw/adsp/dai.h"
 #include "hw/ssi/esai.h"
 #include "hw/adsp/imx8.h"
 
@@ -23,6 +24,9 @@ const struct adsp_reg_desc adsp_esai_map[ADSP_ESAI_REGS] = {
         .offset = 0x00000000, .size = ADSP_IMX8_ESAI_SIZE},
 };
 
+static void esai_get_format(struct adsp_esai *esai, int dir,
+        struct dai_format *fmt);
+
 static void esai_reset(void *opaque)
 {
      struct adsp_io_info *info = opaque;
@@ -44,16 +48,77 @@ static uint64_t esai_read(void *opaque, hwaddr addr,
     return info->region[addr >> 2];
 }
 
+static void esai_fifo_open(struct adsp_esai *esai, struct esai_fifo *fifo,
+        int dir)
+{
+    struct dai_format fmt;
+
+    /* create stream name */
+    if (dir == DAI_DIR_PLAYBACK)
+        sprintf(fifo->file_name, "%s-play%d", esai->name, fifo->index++);
+    else
+        sprintf(fifo->file_name, "%s-capture", esai->name);
+
+    esai_get_format(esai, dir, &fmt);
+    fifo->ep = dai_endpoint_open(fifo->file_name, dir, DAI_BACKEND_DEFAULT,
+        &fmt);
+    printf("%s opened %s for %s at %dHz %d channels\n", esai->name,
+        fifo->ep->path, dir == DAI_DIR_PLAYBACK ? "playback" : "capture",
+        fmt.rate, fmt.channels);
+
+    fifo->total_frames = 0;
+    fifo->bytes = 0;
+    fifo->xruns = 0;
+}
+
+static void esai_fifo_close(struct adsp_esai *esai, struct esai_fifo *fifo,
+        int dir)
+{
+    printf("%s closed %s for %s at %d frames %" PRIu64 " bytes %d xruns\n",
+        esai->name, fifo->ep->path,
+        dir == DAI_DIR_PLAYBACK ? "playback" : "capture",
+        fifo->total_frames, fifo->bytes, fifo->xruns);
+    dai_endpoint_close(fifo->ep);
+    fifo->ep = NULL;
+}
+
 static void esai_write(void *opaque, hwaddr addr,
         uint64_t val, unsigned size)
 {
     struct adsp_io_info *info = opaque;
     struct adsp_reg_space *space = info->space;
     struct adsp_esai *esai = info->private;
+    uint32_t set, clear;
 
     log_write(esai->log, space, addr, val, size,
         info->region[addr >> 2]);
 
+    set = val & ~info->region[addr >> 2];
+    clear = ~val & info->region[addr >> 2];
+    info->region[addr >> 2] = val;
+
+    switch (addr) {
+    case REG_ESAI_TCR:
+        /* open endpoint when the first transmitter is enabled */
+        if ((set & ESAI_TCR_TE_MASK) && esai->tx.ep == NULL)
+            esai_fifo_open(esai, &esai->tx, DAI_DIR_PLAYBACK);
+
+        /* close endpoint when the last transmitter is disabled */
+        if ((clear & ESAI_TCR_TE_MASK) && !(val & ESAI_TCR_TE_MASK) &&
+            esai->tx.ep)
+            esai_fifo_close(esai, &esai->tx, DAI_DIR_PLAYBACK);
+        break;
+    case REG_ESAI_RCR:
+        if ((set & ESAI_RCR_RE_MASK) && esai->rx.ep == NULL)
+            esai_fifo_open(esai, &esai->rx, DAI_DIR_CAPTURE);
+
+        if ((clear & ESAI_RCR_RE_MASK) && !(val & ESAI_RCR_RE_MASK) &&
+            esai->rx.ep)
+            esai_fifo_close(esai, &esai->rx, DAI_DIR_CAPTURE);
+        break;
+    default:
+        break;
+    }
 }
 
 const MemoryRegionOps esai_ops = {
@@ -64,6 +129,7 @@ const MemoryRegionOps esai_ops = {
 
 #define MAX_ESAI     6
 struct adsp_esai *_esai[MAX_ESAI] = {NULL, NULL, NULL, NULL, NULL, NULL};
+static int num_esai;
 
 struct adsp_esai *esai_get_port(int port)
 {
@@ -75,19 +141,121 @@ struct adsp_esai *esai_get_port(int port)
     return NULL;
 }
 
+static uint32_t esai_ccr(struct adsp_esai *esai, int dir)
+{
+    return esai->io[(dir == DAI_DIR_PLAYBACK ?
+        REG_ESAI_TCCR : REG_ESAI_RCCR) >> 2];
+}
+
+/* network mode slots per frame */
+static uint32_t esai_get_slots(struct adsp_esai *esai, int dir)
+{
+    return ((esai_ccr(esai, dir) & ESAI_xCCR_xDC_MASK) >>
+        ESAI_xCCR_xDC_SHIFT) + 1;
+}
+
+/* frame rate from the programmed clock dividers or 0 */
+uint32_t esai_get_rate(struct adsp_esai *esai, int dir)
+{
+    uint32_t ccr = esai_ccr(esai, dir);
+    uint32_t psr = ccr & ESAI_xCCR_xPSR ? 1 : 8;
+    uint32_t pm = (ccr & ESAI_xCCR_xPM_MASK) + 1;
+    uint32_t fp = ((ccr & ESAI_xCCR_xFP_MASK) >> ESAI_xCCR_xFP_SHIFT) + 1;
+    uint32_t rate;
+
+    /* bit clock is HCK / 2 / prescalers */
+    rate = ESAI_HCK_HZ / 2 / psr / pm / fp /
+        (esai_get_slots(esai, dir) * ESAI_SLOT_BITS);
+
+    /* ignore rates that can't be audio - firmware not configured yet */
+    if (rate < 8000 || rate > 192000)
+        return 0;
+
+    return rate;
+}
+
+/* bytes per frame in DSP memory - one 32 bit FIFO word per slot */
+uint32_t esai_get_frame_bytes(struct adsp_esai *esai, int dir)
+{
+    return esai_get_slots(esai, dir) * 4;
+}
+
+/* endpoint format, defaults used until firmware has configured the port */
+static void esai_get_format(struct adsp_esai *esai, int dir,
+        struct dai_format *fmt)
+{
+    fmt->rate = esai_get_rate(esai, dir);
+    if (fmt->rate == 0) {
+        fmt->rate = 48000;
+        fmt->channels = 2;
+        fmt->sample_bytes = 4;
+        return;
+    }
+
+    fmt->channels = esai_get_slots(esai, dir);
+    fmt->sample_bytes = 4;
+}
+
+/* DMA burst into the transmit FIFO */
+uint32_t esai_fifo_write(struct adsp_esai *esai, const void *data,
+        uint32_t bytes)
+{
+    struct esai_fifo *fifo = &esai->tx;
+    uint32_t count;
+
+    /* transmitter not enabled yet, data goes nowhere */
+    if (fifo->ep == NULL)
+        return bytes;
+
+    count = dai_endpoint_write(fifo->ep, data, bytes);
+    if (count < bytes)
+        fifo->xruns++;
+
+    fifo->bytes += bytes;
+    fifo->total_frames += bytes / esai_get_frame_bytes(esai, DAI_DIR_PLAYBACK);
+    return count;
+}
+
+/* DMA burst from the receive FIFO, silence on underrun */
+uint32_t esai_fifo_read(struct adsp_esai *esai, void *data, uint32_t bytes)
+{
+    struct esai_fifo *fifo = &esai->rx;
+    uint32_t count;
+
+    count = dai_endpoint_read(fifo->ep, data, bytes);
+    if (fifo->ep == NULL)
+        return bytes;
+
+    if (count < bytes)
+        fifo->xruns++;
+
+    fifo->bytes += bytes;
+    fifo->total_frames += bytes / esai_get_frame_bytes(esai, DAI_DIR_CAPTURE);
+    return count;
+}
+
 void adsp_esai_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info)
 {
     struct adsp_esai *esai;
 
-    esai = g_malloc(sizeof(*esai));
+    if (num_esai == MAX_ESAI) {
+        fprintf(stderr, "cant add ESAI %s\n", info->space->name);
+        return;
+    }
+
+    esai = g_malloc0(sizeof(*esai));
 
     esai->tx.level = 0;
     esai->rx.level = 0;
+    esai->io = info->region;
+    esai->esai_dev = info->space;
     sprintf(esai->name, "%s.io", info->space->name);
 
     esai->log = log_init(NULL, NULL);
     info->private = esai;
     esai_reset(info);
-    _esai[info->io_dev] = esai;
+
+    /* ports are numbered in board order, not by IO table index */
+    _esai[num_esai++] = esai;
 }
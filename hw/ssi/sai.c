@@ -15,6 +15,7 @@
 #include "qemu/io-bridge.h"
 #include "hw/adsp/shim.h"
 #include "hw/adsp/log.h"
+#include "hw/adsp/dai.h"
 #include "hw/ssi/sai.h"
 #include "hw/adsp/imx8.h"
 
@@ -23,6 +24,9 @@ const struct adsp_reg_desc adsp_sai_map[ADSP_SAI_REGS] = {
         .offset = 0x00000000, .size = ADSP_IMX8_SAI_1_SIZE},
 };
 
+static void sai_get_format(struct adsp_sai *sai, int dir,
+        struct dai_format *fmt);
+
 static void sai_reset(void *opaque)
 {
      struct adsp_io_info *info = opaque;
@@ -44,16 +48,75 @@ static uint64_t sai_read(void *opaque, hwaddr addr,
     return info->region[addr >> 2];
 }
 
+static void sai_fifo_open(struct adsp_sai *sai, struct sai_fifo *fifo,
+        int dir)
+{
+    struct dai_format fmt;
+
+    /* create stream name */
+    if (dir == DAI_DIR_PLAYBACK)
+        sprintf(fifo->file_name, "%s-play%d", sai->name, fifo->index++);
+    else
+        sprintf(fifo->file_name, "%s-capture", sai->name);
+
+    sai_get_format(sai, dir, &fmt);
+    fifo->ep = dai_endpoint_open(fifo->file_name, dir, DAI_BACKEND_DEFAULT,
+        &fmt);
+    printf("%s opened %s for %s at %dHz %d channels\n", sai->name,
+        fifo->ep->path, dir == DAI_DIR_PLAYBACK ? "playback" : "capture",
+        fmt.rate, fmt.channels);
+
+    fifo->total_frames = 0;
+    fifo->bytes = 0;
+    fifo->xruns = 0;
+}
+
+static void sai_fifo_close(struct adsp_sai *sai, struct sai_fifo *fifo,
+        int dir)
+{
+    printf("%s closed %s for %s at %d frames %" PRIu64 " bytes %d xruns\n",
+        sai->name, fifo->ep->path,
+        dir == DAI_DIR_PLAYBACK ? "playback" : "capture",
+        fifo->total_frames, fifo->bytes, fifo->xruns);
+    dai_endpoint_close(fifo->ep);
+    fifo->ep = NULL;
+}
+
 static void sai_write(void *opaque, hwaddr addr,
         uint64_t val, unsigned size)
 {
     struct adsp_io_info *info = opaque;
     struct adsp_reg_space *space = info->space;
     struct adsp_sai *sai = info->private;
+    uint32_t set, clear;
 
     log_write(sai->log, space, addr, val, size,
         info->region[addr >> 2]);
 
+    set = val & ~info->region[addr >> 2];
+    clear = ~val & info->region[addr >> 2];
+    info->region[addr >> 2] = val;
+
+    switch (addr) {
+    case REG_SAI_TCSR:
+        /* open endpoint if playback has been enabled */
+        if ((set & SAI_xCSR_xE) && sai->tx.ep == NULL)
+            sai_fifo_open(sai, &sai->tx, DAI_DIR_PLAYBACK);
+
+        /* close endpoint if playback has finished */
+        if ((clear & SAI_xCSR_xE) && sai->tx.ep)
+            sai_fifo_close(sai, &sai->tx, DAI_DIR_PLAYBACK);
+        break;
+    case REG_SAI_RCSR:
+        if ((set & SAI_xCSR_xE) && sai->rx.ep == NULL)
+            sai_fifo_open(sai, &sai->rx, DAI_DIR_CAPTURE);
+
+        if ((clear & SAI_xCSR_xE) && sai->rx.ep)
+            sai_fifo_close(sai, &sai->rx, DAI_DIR_CAPTURE);
+        break;
+    default:
+        break;
+    }
 }
 
 const MemoryRegionOps sai_ops = {
@@ -64,6 +127,7 @@ const MemoryRegionOps sai_ops = {
 
 #define MAX_SAI     6
 struct adsp_sai *_sai[MAX_SAI] = {NULL, NULL, NULL, NULL, NULL, NULL};
+static int num_sai;
 
 struct adsp_sai *sai_get_port(int port)
 {
@@ -75,19 +139,126 @@ struct adsp_sai *sai_get_port(int port)
     return NULL;
 }
 
+static uint32_t sai_reg(struct adsp_sai *sai, int dir, uint32_t treg,
+        uint32_t rreg)
+{
+    return sai->io[(dir == DAI_DIR_PLAYBACK ? treg : rreg) >> 2];
+}
+
+/* words per frame */
+static uint32_t sai_get_slots(struct adsp_sai *sai, int dir)
+{
+    return ((sai_reg(sai, dir, REG_SAI_TCR4, REG_SAI_RCR4) &
+        SAI_xCR4_FRSZ_MASK) >> SAI_xCR4_FRSZ_SHIFT) + 1;
+}
+
+/* bits per word */
+static uint32_t sai_get_word_bits(struct adsp_sai *sai, int dir)
+{
+    return ((sai_reg(sai, dir, REG_SAI_TCR5, REG_SAI_RCR5) &
+        SAI_xCR5_WNW_MASK) >> SAI_xCR5_WNW_SHIFT) + 1;
+}
+
+/* frame rate from the programmed bit clock divider or 0 */
+uint32_t sai_get_rate(struct adsp_sai *sai, int dir)
+{
+    uint32_t div = (sai_reg(sai, dir, REG_SAI_TCR2, REG_SAI_RCR2) &
+        SAI_xCR2_DIV_MASK) + 1;
+    uint32_t rate;
+
+    rate = SAI_MCLK_HZ / (div * 2) /
+        (sai_get_slots(sai, dir) * sai_get_word_bits(sai, dir));
+
+    /* ignore rates that can't be audio - firmware not configured yet */
+    if (rate < 8000 || rate > 192000)
+        return 0;
+
+    return rate;
+}
+
+/* bytes per frame in DSP memory - samples are 16 or 32 bit containers */
+uint32_t sai_get_frame_bytes(struct adsp_sai *sai, int dir)
+{
+    return sai_get_slots(sai, dir) *
+        (sai_get_word_bits(sai, dir) > 16 ? 4 : 2);
+}
+
+/* endpoint format, defaults used until firmware has configured the port */
+static void sai_get_format(struct adsp_sai *sai, int dir,
+        struct dai_format *fmt)
+{
+    fmt->rate = sai_get_rate(sai, dir);
+    if (fmt->rate == 0) {
+        fmt->rate = 48000;
+        fmt->channels = 2;
+        fmt->sample_bytes = 4;
+        return;
+    }
+
+    fmt->channels = sai_get_slots(sai, dir);
+    fmt->sample_bytes = sai_get_word_bits(sai, dir) > 16 ? 4 : 2;
+}
+
+/* DMA burst into the transmit FIFO */
+uint32_t sai_fifo_write(struct adsp_sai *sai, const void *data,
+        uint32_t bytes)
+{
+    struct sai_fifo *fifo = &sai->tx;
+    uint32_t count;
+
+    /* transmitter not enabled yet, data goes nowhere */
+    if (fifo->ep == NULL)
+        return bytes;
+
+    count = dai_endpoint_write(fifo->ep, data, bytes);
+    if (count < bytes)
+        fifo->xruns++;
+
+    fifo->bytes += bytes;
+    fifo->total_frames += bytes / sai_get_frame_bytes(sai, DAI_DIR_PLAYBACK);
+    return count;
+}
+
+/* DMA burst from the receive FIFO, silence on underrun */
+uint32_t sai_fifo_read(struct adsp_sai *sai, void *data, uint32_t bytes)
+{
+    struct sai_fifo *fifo = &sai->rx;
+    uint32_t count;
+
+    count = dai_endpoint_read(fifo->ep, data, bytes);
+    if (fifo->ep == NULL)
+        return bytes;
+
+    if (count < bytes)
+        fifo->xruns++;
+
+    fifo->bytes += bytes;
+    fifo->total_frames += bytes / sai_get_frame_bytes(sai, DAI_DIR_CAPTURE);
+    return count;
+}
+
 void adsp_sai_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info)
 {
     struct adsp_sai *sai;
 
-    sai = g_malloc(sizeof(*sai));
+    if (num_sai == MAX_SAI) {
+        fprintf(stderr, "cant add SAI %s\n", info->space->name);
+        return;
+    }
+
+    sai = g_malloc0(sizeof(*sai));
 
     sai->tx.level = 0;
     sai->rx.level = 0;
+    sai->io = info->region;
+    sai->sai_dev = info->space;
     sprintf(sai->name, "%s.io", info->space->name);
 
     sai->log = log_init(NULL, NULL);
     info->private = sai;
     sai_reset(info);
-    _sai[info->io_dev] = sai;
+
+    /* ports are numbered in board order, not by IO table index */
+    _sai[num_sai++] = sai;
 }
@@ -26,8 +26,10 @@
 #include "hw/loader.h"
 
 #include "qemu/io-bridge.h"
+#include "hw/audio/adsp-dev.h"
 #include "hw/adsp/shim.h"
 #include "hw/adsp/log.h"
+#include "hw/adsp/dai.h"
 #include "hw/ssi/ssp.h"
 
 const struct adsp_reg_desc adsp_ssp_map[ADSP_SSP_REGS] = {
@@ -35,6 +37,8 @@ const struct adsp_reg_desc adsp_ssp_map[ADSP_SSP_REGS] = {
         .offset = 0x00000000, .size = 0x4000},
 };
 
+static void ssp_get_format(struct adsp_ssp *ssp, struct dai_format *fmt);
+
 static void ssp_reset(void *opaque)
 {
      struct adsp_io_info *info = opaque;
@@ -62,6 +66,7 @@ static void ssp_write(void *opaque, hwaddr addr,
     struct adsp_io_info *info = opaque;
     struct adsp_reg_space *space = info->space;
     struct adsp_ssp *ssp = info->private;
+    struct dai_format fmt;
     uint32_t set, clear;
 
     log_write(ssp->log, space, addr, val, size,
@@ -74,64 +79,52 @@ static void ssp_write(void *opaque, hwaddr addr,
 
         info->region[addr >> 2] = val;
 
-        /* open file if playback has been enabled */
+        /* open endpoint if playback has been enabled */
         if (set & SSCR1_TSRE) {
 
-            /* create filename */
-            sprintf(ssp->tx.file_name, "/tmp/%s-play%d.wav",
+            /* create stream name */
+            sprintf(ssp->tx.file_name, "%s-play%d",
                 ssp->name, ssp->tx.index++);
 
-            unlink(ssp->tx.file_name);
-            ssp->tx.fd = open(ssp->tx.file_name, O_WRONLY | O_CREAT,
-                S_IRUSR | S_IWUSR | S_IXUSR);
-
-            if (ssp->tx.fd < 0) {
-                fprintf(stderr, "cant open file %s %d\n",
-                    ssp->tx.file_name, -errno);
-                return;
-            } else
-                printf("%s opened %s for playback\n",
-                    ssp->name, ssp->tx.file_name);
+            ssp_get_format(ssp, &fmt);
+            ssp->tx.ep = dai_endpoint_open(ssp->tx.file_name,
+                DAI_DIR_PLAYBACK, DAI_BACKEND_DEFAULT, &fmt);
+            printf("%s opened %s for playback\n",
+                ssp->name, ssp->tx.ep->path);
 
             ssp->tx.total_frames = 0;
         }
 
-        /* close file if playback has finished */
-        if (clear & SSCR1_TSRE) {
+        /* close endpoint if playback has finished */
+        if ((clear & SSCR1_TSRE) && ssp->tx.ep) {
             printf("%s closed %s for playback at %d frames\n",
                 ssp->name,
-                ssp->tx.file_name, ssp->tx.total_frames);
-            close(ssp->tx.fd);
-            ssp->tx.fd = 0;
+                ssp->tx.ep->path, ssp->tx.total_frames);
+            dai_endpoint_close(ssp->tx.ep);
+            ssp->tx.ep = NULL;
         }
 
-        /* open file if capture has been enabled */
+        /* open endpoint if capture has been enabled */
         if (set & SSCR1_RSRE) {
 
-            /* create filename */
-            sprintf(ssp->rx.file_name, "/tmp/%s-capture.wav",
-                ssp->name);
+            /* create stream name */
+            sprintf(ssp->rx.file_name, "%s-capture", ssp->name);
 
-            ssp->rx.fd = open(ssp->tx.file_name, O_RDONLY,
-                S_IRUSR | S_IWUSR | S_IXUSR);
-
-            if (ssp->rx.fd < 0) {
-                fprintf(stderr, "cant open file %s %d\n",
-                    ssp->rx.file_name, -errno);
-                return;
-            } else
-                printf("%s opened %s for capture\n",
-                    ssp->name, ssp->rx.file_name);
+            ssp_get_format(ssp, &fmt);
+            ssp->rx.ep = dai_endpoint_open(ssp->rx.file_name,
+                DAI_DIR_CAPTURE, DAI_BACKEND_DEFAULT, &fmt);
+            printf("%s opened %s for capture\n",
+                ssp->name, ssp->rx.ep->path);
 
             ssp->rx.total_frames = 0;
         }
 
-        /* close file if capture has finished */
-        if (clear & SSCR1_RSRE) {
+        /* close endpoint if capture has finished */
+        if ((clear & SSCR1_RSRE) && ssp->rx.ep) {
             printf("%s closed %s for capture at %d frames\n", ssp->name,
-                ssp->rx.file_name, ssp->rx.total_frames);
-            close(ssp->rx.fd);
-            ssp->rx.fd = 0;
+                ssp->rx.ep->path, ssp->rx.total_frames);
+            dai_endpoint_close(ssp->rx.ep);
+            ssp->rx.ep = NULL;
         }
         break;
     case SSDR:
@@ -165,6 +158,61 @@ struct adsp_ssp *ssp_get_port(int port)
     return NULL;
 }
 
+/* valid sample bits, DSS is size - 1 and EDSS adds 16 */
+static uint32_t ssp_get_sample_bits(struct adsp_ssp *ssp)
+{
+    uint32_t sscr0 = ssp->io[SSCR0 >> 2];
+
+    return (sscr0 & SSCR0_DSS_MASK) + 1 + (sscr0 & SSCR0_EDSS ? 16 : 0);
+}
+
+/* network mode slots per frame */
+static uint32_t ssp_get_slots(struct adsp_ssp *ssp)
+{
+    return ((ssp->io[SSCR0 >> 2] & SSCR0_FRDC) >> 24) + 1;
+}
+
+/* frame rate from the programmed clock divider and frame format or 0 */
+uint32_t ssp_get_rate(struct adsp_ssp *ssp)
+{
+    uint32_t sscr0 = ssp->io[SSCR0 >> 2];
+    uint32_t scr = ((sscr0 >> 8) & 0xfff) + 1;
+    uint32_t frame_bits = ssp_get_slots(ssp) * ssp_get_sample_bits(ssp);
+    uint32_t rate;
+
+    if (ssp->clk_kHz == 0)
+        return 0;
+
+    rate = ssp->clk_kHz * 1000 / scr / frame_bits;
+
+    /* ignore rates that can't be audio - firmware not configured yet */
+    if (rate < 8000 || rate > 192000)
+        return 0;
+
+    return rate;
+}
+
+/* bytes per frame in DSP memory - samples are 16 or 32 bit containers */
+uint32_t ssp_get_frame_bytes(struct adsp_ssp *ssp)
+{
+    return ssp_get_slots(ssp) * (ssp_get_sample_bits(ssp) > 16 ? 4 : 2);
+}
+
+/* endpoint format, defaults used until firmware has configured the port */
+static void ssp_get_format(struct adsp_ssp *ssp, struct dai_format *fmt)
+{
+    fmt->rate = ssp_get_rate(ssp);
+    if (fmt->rate == 0) {
+        fmt->rate = 48000;
+        fmt->channels = 2;
+        fmt->sample_bytes = 2;
+        return;
+    }
+
+    fmt->channels = ssp_get_slots(ssp);
+    fmt->sample_bytes = ssp_get_sample_bits(ssp) > 16 ? 4 : 2;
+}
+
 void adsp_ssp_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info)
 {
@@ -174,6 +222,11 @@ void adsp_ssp_init(struct adsp_dev *adsp, MemoryRegion *parent,
 
     ssp->tx.level = 0;
     ssp->rx.level = 0;
+    ssp->tx.ep = NULL;
+    ssp->rx.ep = NULL;
+    ssp->tx.index = 0;
+    ssp->io = info->region;
+    ssp->clk_kHz = adsp->clk_kHz;
     sprintf(ssp->name, "%s.io", info->space->name);
 
     ssp->log = log_init(NULL, NULL);
@@ -377,6 +377,7 @@ struct TranslationBlock {
 #define CF_USE_ICOUNT  0x00020000
 #define CF_INVALID     0x00040000 /* TB is stale. Set with @jmp_lock held */
 #define CF_PARALLEL    0x00080000 /* Generate code for a parallel context */
+#define CF_HOT_TRACE   0x00100000 /* Hot path, may span direct jumps */
 #define CF_CLUSTER_MASK 0xff000000 /* Top 8 bits are cluster ID */
 #define CF_CLUSTER_SHIFT 24
 /* cflags' mask for hashing/comparison */
@@ -386,6 +387,9 @@ struct TranslationBlock {
     /* Per-vCPU dynamic tracing state used to generate this TB */
     uint32_t trace_vcpu_dstate;
 
+    /* executions counted until the TB is retranslated as a hot trace */
+    uint32_t hot_count;
+
     struct tb_tc tc;
 
     /* original tb when cflags has CF_NOCACHE */
@@ -461,6 +465,15 @@ TranslationBlock *tb_htable_lookup(CPUState *cpu, target_ulong pc,
                                    uint32_t cf_mask);
 void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr);
 
+/* Hot trace formation, see tb_hot_trace() */
+extern unsigned int tb_hot_trace_threshold;
+extern unsigned int tb_hot_trace_jumps;
+void tb_hot_trace_request(CPUState *cpu, TranslationBlock *tb);
+void tb_hot_trace(CPUState *cpu);
+void tb_hot_trace_formed(TranslationBlock *tb, int jumps);
+/* Free the oldest code region instead of flushing, see tcg_region_evict() */
+extern bool tb_evict_enabled;
+
 /* GETPC is the true target of the return instruction that we'll execute.  */
 #if defined(CONFIG_TCG_INTERPRETER)
 extern uintptr_t tci_tb_ptr;
@@ -63,6 +63,7 @@ typedef enum DisasJumpType {
  * @num_insns: Number of translated instructions (including current).
  * @max_insns: Maximum number of instructions to be translated in this TB.
  * @singlestep_enabled: "Hardware" single stepping enabled.
+ * @trace_jumps: Direct jumps followed by the target in a CF_HOT_TRACE TB.
  *
  * Architecture-agnostic disassembly context.
  */
@@ -74,6 +75,7 @@ typedef struct DisasContextBase {
     int num_insns;
     int max_insns;
     bool singlestep_enabled;
+    int trace_jumps;
 } DisasContextBase;
 
 /**
@@ -272,6 +272,9 @@
 #define ADSP_CAVS_1_8_DSP_LP_SRAM_BASE     0xBE800000
 #define ADSP_CAVS_1_8_DSP_LP_SRAM_SIZE         0x00020000
 
+/* SRAM power gating granularity */
+#define ADSP_CAVS_1_8_DSP_SRAM_BANK_SIZE       0x00010000
+
 /* Uncache */
 #define ADSP_CAVS_1_8_DSP_UNCACHE_BASE         (ADSP_CAVS_1_8_DSP_HP_SRAM_BASE - 0x20000000)
 #define ADSP_CAVS_1_8_DSP_UNCACHE_SIZE         ADSP_CAVS_1_8_DSP_SRAM_SIZE
@@ -0,0 +1,103 @@
+/*
+ * Audio DAI endpoint support for the audio DSP.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __HW_ADSP_DAI_H__
+#define __HW_ADSP_DAI_H__
+
+#include "qemu/osdep.h"
+#include "qemu/thread.h"
+#include "audio/audio.h"
+
+/*
+ * A DAI endpoint is the far side of a DSP audio port. DMA bursts are copied
+ * into (playback) or out of (capture) an in memory ring and never block, an
+ * I/O thread moves data between the ring and the backend.
+ *
+ * The backend is selected at runtime with ADSP_DAI_BACKEND :-
+ *
+ *  wav   - WAV file <dir>/<name>.wav (default)
+ *  raw   - headerless PCM file <dir>/<name>.raw
+ *  pipe  - named pipe <dir>/<name>, created if missing
+ *  audio - QEMU audio backend (playback only)
+ *  none  - discard playback and capture silence
+ *
+ * <dir> is ADSP_DAI_DIR or /tmp. Capture endpoints stream from the file
+ * named by ADSP_DAI_CAPTURE or <dir>/<name>.wav and loop at end of file.
+ */
+
+#define DAI_DIR_PLAYBACK    0
+#define DAI_DIR_CAPTURE     1
+
+#define DAI_BACKEND_DEFAULT -1
+#define DAI_BACKEND_NONE    0
+#define DAI_BACKEND_WAV     1
+#define DAI_BACKEND_RAW     2
+#define DAI_BACKEND_PIPE    3
+#define DAI_BACKEND_AUDIO   4
+
+/* ring size, about 340ms of 48kHz stereo 32 bit */
+#define DAI_RING_SIZE       (128 * 1024)
+
+struct dai_endpoint;
+
+struct dai_format {
+    uint32_t rate;
+    uint32_t channels;
+    uint32_t sample_bytes;
+};
+
+struct dai_backend_ops {
+    const char *name;
+    const char *ext;
+    int (*open)(struct dai_endpoint *ep);
+    int (*xfer)(struct dai_endpoint *ep, void *data, uint32_t bytes);
+    void (*close)(struct dai_endpoint *ep);
+};
+
+struct dai_endpoint {
+    char name[64];
+    char path[128];
+    int dir;
+    struct dai_format fmt;
+    const struct dai_backend_ops *ops;
+
+    /* ring - head and tail are free running byte counts */
+    uint8_t *ring;
+    uint64_t head;
+    uint64_t tail;
+    uint32_t xruns;
+
+    /* I/O thread */
+    QemuThread thread;
+    QemuMutex mutex;
+    QemuCond cond;
+    int running;
+    int wake_fd[2];     /* wakes pipe capture blocked in poll() */
+
+    /* file backends */
+    int fd;
+    off_t data_start;
+    uint64_t file_bytes;
+
+    /* audio backend */
+    QEMUSoundCard card;
+    SWVoiceOut *voice;
+};
+
+struct dai_endpoint *dai_endpoint_open(const char *name, int dir,
+    int backend, const struct dai_format *fmt);
+void dai_endpoint_close(struct dai_endpoint *ep);
+uint32_t dai_endpoint_write(struct dai_endpoint *ep, const void *data,
+    uint32_t bytes);
+uint32_t dai_endpoint_read(struct dai_endpoint *ep, void *data,
+    uint32_t bytes);
+
+#endif
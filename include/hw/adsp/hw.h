@@ -43,12 +43,18 @@ struct adsp_log;
 struct adsp_reg_space;
 struct adsp_io_info;
 
+struct adsp_mem_gate;
+
 struct adsp_mem_desc {
     const char *name;
 	hwaddr base;
 	size_t size;
 	hwaddr alias;
 	void *ptr;
+
+	/* runtime - SHM region and bank power gating */
+	int shm;
+	struct adsp_mem_gate *gate;
 };
 
 /* Register descriptor */
@@ -69,6 +75,13 @@ struct adsp_reg_space {
 	void (*init)(struct adsp_dev *adsp, MemoryRegion *parent,
 	    struct adsp_io_info *info);
 	const MemoryRegionOps *ops;
+
+	/*
+	 * Shadowed spaces are mapped as RAM over the SHM region and never
+	 * call ops, so accesses are not logged. Only for spaces whose
+	 * registers have no side effects.
+	 */
+	bool shadow;
 };
 
 struct adsp_io_info {
@@ -123,4 +136,24 @@ void adsp_create_host_io_devices(struct adsp_host *adsp, const MemoryRegionOps *
 struct adsp_reg_space *adsp_get_io_space(struct adsp_dev *adsp, hwaddr addr);
 struct adsp_mem_desc *adsp_get_mem_space(struct adsp_dev *adsp, hwaddr addr);
 
+/* SRAM bank power gating */
+void adsp_mem_gate_init(struct adsp_dev *adsp, const char *name,
+    uint32_t bank_size);
+void adsp_mem_power_gate(struct adsp_dev *adsp, const char *name,
+    int first_bank, uint32_t gated);
+void adsp_mem_discard(struct adsp_mem_desc *desc, size_t offset, size_t size);
+size_t adsp_mem_resident(struct adsp_dev *adsp);
+
+/* boot snapshot cache */
+char *adsp_snapshot_path(struct adsp_dev *adsp, const char *name,
+    const void *params, size_t params_size);
+int adsp_snapshot_load(struct adsp_dev *adsp, const char *path);
+void adsp_snapshot_save(struct adsp_dev *adsp, const char *path);
+
+/* firmware profiler */
+void adsp_profile_init(struct adsp_dev *adsp);
+
+/* bulk firmware trace decoder */
+void adsp_trace_init(struct adsp_dev *adsp);
+
 #endif
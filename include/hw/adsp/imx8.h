@@ -66,7 +66,7 @@
                                     + ADSP_SRAM_TRACE_SIZE)
 
 #define ADSP_IMX8_EDMA0_BASE         0x59200000
-#define ADSP_IMX8_EDMA0_SIZE         0x10000
+#define ADSP_IMX8_EDMA0_SIZE         0x200000    /* 32 channel pages */
 
 #define ADSP_IMX8_DSP_IRAM_BASE      0x596f8000
 #define ADSP_IMX8_DSP_DRAM_BASE      0x596e8000
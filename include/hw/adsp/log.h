@@ -30,6 +30,7 @@
 #include "hw/boards.h"
 #include "hw/loader.h"
 
+#include "qemu/atomic.h"
 #include "qemu/io-bridge.h"
 #include "hw/adsp/hw.h"
 #include "hw/adsp/shim.h"
@@ -132,14 +133,116 @@
 #define LOG_SAI 1
 #define LOG_ESAI 1
 
+/* log levels, set by the trace_regs machine option */
+#define LOG_LEVEL_OFF		0
+#define LOG_LEVEL_TEXT		1	/* trace_regs=text - formatted, slow */
+#define LOG_LEVEL_BIN		2	/* trace_regs=bin[:file] - binary ring */
+
+/*
+ * Binary trace records. Each thread doing MMIO gets its own lock free ring
+ * (i.e. one per vCPU under MTTCG) that a background thread flushes to the
+ * trace file. scripts/adsp-trace-decode.py turns the file back into the
+ * text output of LOG_LEVEL_TEXT.
+ */
+#define LOG_TRACE_MAGIC		"ADSPTRC"
+#define LOG_TRACE_VERSION	1
+
+#define LOG_TRACE_DEV		0	/* device name in value and old */
+#define LOG_TRACE_READ		1
+#define LOG_TRACE_WRITE		2
+#define LOG_TRACE_AREA_READ	3
+#define LOG_TRACE_AREA_WRITE	4
+#define LOG_TRACE_TYPE_MASK	0x0f
+#define LOG_TRACE_KNOWN		0x10	/* enabled register descriptor */
+#define LOG_TRACE_HAS_REGS	0x20	/* device has register descriptors */
+
+#define LOG_TRACE_DEV_UNMAPPED	0xffff	/* devices past LOG_SPACES */
+
+struct log_trace_rec {
+	uint64_t ns;		/* host monotonic time */
+	uint64_t value;
+	uint64_t old;
+	uint32_t offset;
+	uint16_t dev;
+	uint8_t type;
+	uint8_t size;
+};
+
+/* offset map flags, one byte per 32 bit word of the device */
+#define LOG_SPACE_REG		(1 << 0)	/* enabled register */
+#define LOG_SPACE_AREA		(1 << 1)	/* inside an enabled area */
+#define LOG_SPACE_SEEN		(1 << 2)	/* register found, maybe disabled */
+
+/* precomputed offset to descriptor lookup for a device */
+struct log_space {
+	const struct adsp_reg_space *space;
+	uint32_t words;
+	uint8_t *map;
+	uint16_t id;
+};
+
+#define LOG_SPACES		64	/* device hash slots per log */
+
 struct adsp_log {
 	GMutex mutex;
 	FILE *file;
 	time_t timestamp;	/* last trace timestamp */
 	time_t tv_sec_start;	/* start of tv_secs */
 	int level;
+
+	struct log_space *spaces[LOG_SPACES];
+
+	/* area decoded in bulk by the firmware trace watcher */
+	const struct adsp_reg_space *trace_space;
+	uint32_t trace_offset;
+	uint32_t trace_size;
 };
 
+struct log_space *log_add_space(struct adsp_log *log,
+	const struct adsp_reg_space *space);
+void log_trace(const struct log_space *ls, int type, hwaddr addr,
+	unsigned size, uint64_t value, uint64_t old);
+
+/* find the offset map for a device, lock free once it has been added */
+static inline const struct log_space *log_get_space(struct adsp_log *log,
+	const struct adsp_reg_space *space)
+{
+	unsigned int i, hash = ((uintptr_t)space >> 4) % LOG_SPACES;
+	struct log_space *ls;
+
+	for (i = 0; i < LOG_SPACES; i++) {
+		ls = atomic_load_acquire(&log->spaces[(hash + i) % LOG_SPACES]);
+		if (ls == NULL)
+			break;
+		if (ls->space == space)
+			return ls;
+	}
+
+	return log_add_space(log, space);
+}
+
+/* stores to the bulk trace area are decoded later, not per store */
+static inline int log_is_bulk_trace(struct adsp_log *log,
+	const struct adsp_reg_space *space, hwaddr addr)
+{
+	return space == log->trace_space &&
+		addr - log->trace_offset < log->trace_size;
+}
+
+static inline uint8_t log_space_flags(const struct log_space *ls, hwaddr addr)
+{
+	hwaddr word = addr >> 2;
+
+	if (word >= ls->words)
+		return 0;
+
+	/* registers only match on their exact offset */
+	if (addr & 3)
+		return ls->map[word] & LOG_SPACE_AREA;
+
+	return ls->map[word];
+}
+
 #define BYT_SHIM_REGS   25
 extern const struct adsp_reg_desc adsp_byt_shim_map[BYT_SHIM_REGS];
 #define HSW_SHIM_REGS   9
@@ -190,26 +293,25 @@ static inline void log_read(struct adsp_log *log,
 	const struct adsp_reg_space *space,
 	hwaddr addr, unsigned size, uint64_t value)
 {
-	const struct adsp_reg_desc *reg = space->reg;
-	int i;
+	const struct log_space *ls;
+	int known;
 
 	if (!log->level)
 		return;
 
-	/* TODO: have a faster direct array mapping to register to addr */
-	for (i = 0; i < space->reg_count; i++) {
+	ls = log_get_space(log, space);
+	known = log_space_flags(ls, addr) & LOG_SPACE_REG;
 
-		if (addr != reg[i].offset)
-			continue;
-
-		if (!reg[i].enable)
-			break;
+	if (log->level == LOG_LEVEL_BIN) {
+		log_trace(ls, LOG_TRACE_READ | (known ? LOG_TRACE_KNOWN : 0),
+			addr, size, value, 0);
+		return;
+	}
 
+	if (known) {
 		log_print(log, "%s.io: read at 0x%x val 0x%8.8lx\n", space->name,
 			(unsigned int)addr, value);
-
 		return;
-
 	}
 
 	/* fall through */
@@ -221,21 +323,22 @@ static inline void log_write(struct adsp_log *log,
 	const struct adsp_reg_space *space,
 	hwaddr addr, uint64_t val, unsigned size, uint64_t old_val)
 {
-	const struct adsp_reg_desc *reg = space->reg;
-	int i;
+	const struct log_space *ls;
+	int known;
 
-	if (!log->level)
+	if (!log->level || log_is_bulk_trace(log, space, addr))
 		return;
 
-	/* TODO: have a faster direct array mapping to register to addr */
-	for (i = 0; i < space->reg_count; i++) {
+	ls = log_get_space(log, space);
+	known = log_space_flags(ls, addr) & LOG_SPACE_REG;
 
-		if (addr != reg[i].offset)
-			continue;
-
-		if (!reg[i].enable)
-			break;
+	if (log->level == LOG_LEVEL_BIN) {
+		log_trace(ls, LOG_TRACE_WRITE | (known ? LOG_TRACE_KNOWN : 0),
+			addr, size, val, old_val);
+		return;
+	}
 
+	if (known) {
 		log_print(log, "%s.io: write 0x%x = \t0x%8.8lx (old 0x%lx) \t(%8.8ld) \t|%c%c%c%c|\n",
 			space->name, (unsigned int)addr, val,
 			old_val, val,
@@ -261,25 +364,48 @@ static inline void log_area_read(struct adsp_log *log,
 	const struct adsp_reg_space *space,
 	hwaddr addr, unsigned size, uint64_t value)
 {
-	const struct adsp_reg_desc *reg = space->reg;
-	int i;
+	const struct log_space *ls;
 
 	if (!log->level)
 		return;
 
-	/* TODO: have a faster direct array mapping to register to addr */
-	for (i = 0; i < space->reg_count; i++) {
+	ls = log_get_space(log, space);
+	if (!(log_space_flags(ls, addr) & LOG_SPACE_AREA))
+		return;
 
-		if (!reg[i].enable)
-			continue;
+	if (log->level == LOG_LEVEL_BIN) {
+		log_trace(ls, LOG_TRACE_AREA_READ | LOG_TRACE_KNOWN, addr, size,
+			value, 0);
+		return;
+	}
 
-		if (addr >= reg[i].offset &&
-			addr < reg[i].offset + reg[i].size) {
+	log_print(log, "%s.io: read at 0x%x val 0x%8.8x\n",
+		space->name, (unsigned int)addr, (uint32_t)value);
+}
 
-			log_print(log, "%s.io: read at 0x%x val 0x%8.8x\n",
-				space->name, (unsigned int)addr, value);
-			return;
-		}
+static inline const char *log_trace_class(uint64_t val)
+{
+	switch (val & 0xff000000) {
+	case TRACE_CLASS_IRQ:
+		return "irq";
+	case TRACE_CLASS_IPC:
+		return "ipc";
+	case TRACE_CLASS_PIPE:
+		return "pipe";
+	case TRACE_CLASS_HOST:
+		return "host";
+	case TRACE_CLASS_DAI:
+		return "dai";
+	case TRACE_CLASS_DMA:
+		return "dma";
+	case TRACE_CLASS_SSP:
+		return "ssp";
+	case TRACE_CLASS_COMP:
+		return "comp";
+	case TRACE_CLASS_WFI:
+		return "wfi";
+	default:
+		return NULL;
 	}
 }
 
@@ -287,76 +413,41 @@ static inline void log_area_write(struct adsp_log *log,
 	const struct adsp_reg_space *space,
 	hwaddr addr, uint64_t val, unsigned size, uint64_t old_val)
 {
-	const struct adsp_reg_desc *reg = space->reg;
-	uint32_t class;
 	const char *trace;
-	int i;
 
-	if (!log->level)
+	if (!log->level || log_is_bulk_trace(log, space, addr))
 		return;
 
 	/* ignore writes of 0 atm - used in mbox clear and init */
-	if (val == 0)// && addr >= 0xc00)
+	if (val == 0)
 	    return;
 
-	/* TODO: have a faster direct array mapping to register to addr */
-	for (i = 0; i < space->reg_count; i++) {
-
-		//if (!reg[i].enable)
-		//	continue;
-
-		/* TODO: get trace offset - do trace differently */
-		if (1) {
-
-			/* timestamp or value ? */
-			if ((addr % 16) == 0) {
-				//log_print(log, "trace.io: timestamp 0x%8.8x delta 0x%8.8x ",
-				//	(uint32_t)val, (uint32_t)val - log->timestamp);
-				log->timestamp = val;
-				//return;
-			}
-
-			class = val & 0xff000000;
-			if (class == TRACE_CLASS_IRQ)
-				trace = "irq";
-			else if (class == TRACE_CLASS_IPC)
-				trace = "ipc";
-			else if (class == TRACE_CLASS_PIPE)
-				trace = "pipe";
-			else if (class == TRACE_CLASS_HOST)
-				trace = "host";
-			else if (class == TRACE_CLASS_DAI)
-				trace = "dai";
-			else if (class == TRACE_CLASS_DMA)
-				trace = "dma";
-			else if (class == TRACE_CLASS_SSP)
-				trace = "ssp";
-			else if (class == TRACE_CLASS_COMP)
-				trace = "comp";
-			else if (class == TRACE_CLASS_WFI)
-				trace = "wfi";
-			else {
-				log_print(log, " 0x%x = \t0x%8.8lx \t(%8.8ld) \t|%c%c%c%c|\n",
-				(unsigned int)addr, val, val,
-				log_get_char(val, 3), log_get_char(val, 2),
-				log_get_char(val, 1), log_get_char(val, 0));
-				return;
-			}
+	/* timestamp or value ? */
+	if ((addr % 16) == 0)
+		log->timestamp = val;
 
-			log_print(log, "%s %c%c%c\n", trace,
-				(char)(val >> 16), (char)(val >> 8), (char)val);
-			return;
-		}
+	if (log->level == LOG_LEVEL_BIN) {
+		log_trace(log_get_space(log, space), LOG_TRACE_AREA_WRITE |
+			(space->reg_count ? LOG_TRACE_HAS_REGS : 0),
+			addr, size, val, old_val);
+		return;
+	}
 
-		if (addr >= reg[i].offset &&
-			addr < reg[i].offset + reg[i].size) {
+	/* TODO: get trace offset - do trace differently */
+	if (space->reg_count) {
 
-			log_print(log, "%s.io: write 0x%x = \t0x%8.8lx \t(%8.8ld) \t|%c%c%c%c|\n",
-				space->name, (unsigned int)addr, val, val,
-				log_get_char(val, 3), log_get_char(val, 2),
-				log_get_char(val, 1), log_get_char(val, 0));
+		trace = log_trace_class(val);
+		if (trace == NULL) {
+			log_print(log, " 0x%x = \t0x%8.8lx \t(%8.8ld) \t|%c%c%c%c|\n",
+			(unsigned int)addr, val, val,
+			log_get_char(val, 3), log_get_char(val, 2),
+			log_get_char(val, 1), log_get_char(val, 0));
 			return;
 		}
+
+		log_print(log, "%s %c%c%c\n", trace,
+			(char)(val >> 16), (char)(val >> 8), (char)val);
+		return;
 	}
 
 	/* fall through */
@@ -182,7 +182,13 @@
 #define ILMCD(x)   (0x4 + 0x10 * (x - 2)) /* mask clear - W1C */
 #define ILMC(x)   (0x8 + 0x10 * (x - 2))  /* mask status - ROV */
 #define ILSC(x)   (0xc + 0x10 * (x - 2))  /* IRQ status - ROV after mask */
-/* TODO: need to add macro for other cores. */
+
+/* IRQ registers for other cores, each core has a 0x40 block */
+#define IL_CORE_SIZE    0x40
+#define ILMSDC(x, c)    (ILMSD(x) + IL_CORE_SIZE * (c))
+#define ILMCDC(x, c)    (ILMCD(x) + IL_CORE_SIZE * (c))
+#define ILMCC(x, c)     (ILMC(x) + IL_CORE_SIZE * (c))
+#define ILSCC(x, c)     (ILSC(x) + IL_CORE_SIZE * (c))
 
 #define ILRSD(x)      (0x100 + 0x4 * (x - 2))   /* RAW status */
 
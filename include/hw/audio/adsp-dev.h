@@ -49,6 +49,7 @@ struct adsp_dev {
 
 	/* runtime CPU */
 	struct adsp_xtensa *xtensa[ADSP_MAX_CORES];
+	int num_cores;
 	bool cpu_stalled;
 	bool in_reset;
 	MemoryRegion *system_memory;
@@ -67,6 +68,9 @@ struct adsp_dev {
 	/* ext timer */
 	struct adsp_dev_timer timer[ADSP_MAX_EXT_TIMERS];
 
+	/* interrupt controller */
+	struct adsp_io_info *irq;
+
 	/* PMC */
 	QemuThread pmc_thread;
 	uint32_t pmc_cmd;
@@ -76,6 +80,9 @@ struct adsp_dev {
 };
 
 void adsp_set_lvl1_irq(struct adsp_dev *adsp, int irq, int active);
+void adsp_set_core_lvl1_irq(struct adsp_dev *adsp, int core, int irq,
+    int active);
+void adsp_time_warp_init(MachineState *machine);
 
 static inline void adsp_irq_set(struct adsp_dev *adsp,
     struct adsp_io_info *info, int irq, uint32_t mask)
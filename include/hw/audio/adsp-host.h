@@ -88,6 +88,10 @@ struct adsp_host {
     /* logging options */
     struct adsp_log *log;
 
+    /* messages to DSP posted from register writes */
+    QEMUBH *msg_bh;
+    GQueue msg_queue;
+
     /* machine init data */
     const struct adsp_desc *desc;
     const char *cpu_model;
@@ -102,6 +106,8 @@ extern const struct adsp_reg_desc adsp_host_mbox_map[ADSP_HOST_MBOX_COUNT];
 
 void adsp_host_init(struct adsp_host *adsp, const struct adsp_desc *board);
 void adsp_host_do_dma(struct adsp_host *adsp, struct qemu_io_msg *msg);
+void adsp_host_share_ram(void);
+void adsp_host_post_msg(struct adsp_host *adsp, struct qemu_io_msg *msg);
 void adsp_host_init_mbox(struct adsp_host *adsp, MemoryRegion *parent,
         struct adsp_io_info *info);
 
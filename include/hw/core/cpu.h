@@ -154,6 +154,11 @@ struct TranslationBlock;
  * @disas_set_info: Setup architecture specific components of disassembly info
  * @adjust_watchpoint_address: Perform a target-specific adjustment to an
  * address before attempting to match it against watchpoints.
+ * @tb_cache_key: Callback returning a key for CPU settings, other than the
+ * TB flags, that change the generated code. Used by the persistent TB cache.
+ * @tb_cache_skip: Callback returning true if the code of @tb depends on
+ * state that is not part of its key, e.g. debug registers checked at
+ * translation time. Such TBs bypass the persistent TB cache.
  *
  * Represents a CPU family or model.
  */
@@ -220,6 +225,8 @@ typedef struct CPUClass {
     void (*disas_set_info)(CPUState *cpu, disassemble_info *info);
     vaddr (*adjust_watchpoint_address)(CPUState *cpu, vaddr addr, int len);
     void (*tcg_initialize)(void);
+    uint64_t (*tb_cache_key)(CPUState *cpu);
+    bool (*tb_cache_skip)(CPUState *cpu, const struct TranslationBlock *tb);
 
     /* Keep non-pointer data at the end to minimize holes.  */
     int gdb_num_core_regs;
@@ -338,6 +345,8 @@ struct qemu_work_item;
  * @trace_dstate_delayed: Delayed changes to trace_dstate (includes all changes
  *                        to @trace_dstate).
  * @trace_dstate: Dynamic tracing state of events for this vCPU (bitmask).
+ * @hot_tb: TB that reached the hot trace threshold, to be retranslated.
+ * @hot_tb_flush_count: TB flush count when @hot_tb was set.
  * @plugin_mask: Plugin event bitmap. Modified only via async work.
  * @ignore_memory_transaction_failures: Cached copy of the MachineState
  *    flag of the same name: allows the board to suppress calling of the
@@ -391,6 +400,9 @@ struct CPUState {
     /* Accessed in parallel; all accesses must be atomic */
     struct TranslationBlock *tb_jmp_cache[TB_JMP_CACHE_SIZE];
 
+    struct TranslationBlock *hot_tb;
+    unsigned int hot_tb_flush_count;
+
     struct GDBRegisterState *gdb_regs;
     int gdb_num_regs;
     int gdb_num_g_regs;
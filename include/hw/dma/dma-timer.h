@@ -0,0 +1,48 @@
+/*
+ * Virtual clock pacing for audio DSP DMA channels.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef __HW_DMA_TIMER_H__
+#define __HW_DMA_TIMER_H__
+
+#include "qemu/osdep.h"
+#include "qemu/timer.h"
+
+/* default frame format used when the DAI rate is not known */
+#define DMA_TIMER_DEFAULT_RATE          48000
+#define DMA_TIMER_DEFAULT_FRAME_BYTES   4
+
+/* host memory to memory burst period - not paced by an audio clock */
+#define DMA_TIMER_M2M_PERIOD            (200 * 1000)    /* 200us */
+
+/*
+ * Channel burst timer on QEMU_CLOCK_VIRTUAL. The burst callback runs from the
+ * main loop with the iothread lock held and returns non zero to be called
+ * again one period later, or zero when the transfer is complete.
+ */
+struct dma_timer {
+    QEMUTimer *timer;
+    int64_t period_ns;
+    int64_t expire;
+    int active;
+
+    int (*burst)(void *chan);
+    void (*complete)(void *chan);
+    void *chan;
+};
+
+void dma_timer_init(struct dma_timer *t);
+void dma_timer_start(struct dma_timer *t, int64_t period_ns,
+    int (*burst)(void *chan), void (*complete)(void *chan), void *chan);
+void dma_timer_stop(struct dma_timer *t);
+int64_t dma_timer_period_ns(uint32_t burst_bytes, uint32_t frame_bytes,
+    uint32_t rate);
+
+#endif
@@ -35,6 +35,8 @@
 #include "qemu/thread.h"
 #include "qemu/io-bridge.h"
 #include "hw/adsp/hw.h"
+#include "hw/dma/dma-timer.h"
+#include "hw/adsp/dai.h"
 
 struct adsp_dev;
 struct adsp_host;
@@ -184,13 +186,14 @@ struct dma_chan {
     /* endpoint */
     struct qemu_io_msg_dma32 dma_msg;
     int ssp;
+    int zero_copy;  /* ptr is host guest RAM, no SHM bounce buffer */
 
-    /* file output/input */
-    int fd;
+    /* buffered trace output */
+    struct dai_endpoint *trace;
     int file_idx;
 
-    /* threading */
-    QemuThread thread;
+    /* burst pacing */
+    struct dma_timer timer;
     char thread_name[32];
     uint32_t stop;
 };
@@ -25,6 +25,7 @@
 #include "qemu/thread.h"
 #include "qemu/io-bridge.h"
 #include "hw/adsp/hw.h"
+#include "hw/dma/dma-timer.h"
 
 struct adsp_dev;
 struct adsp_host;
@@ -34,6 +35,10 @@ struct adsp_io_info;
 
 #define NUM_CHANNELS                    32
 
+/* each channel has its own register page */
+#define EDMA_CH_SIZE                    0x10000
+#define EDMA_CH_BASE(chan)              ((chan) * EDMA_CH_SIZE)
+
 #define EDMA_CH_CSR                     0x00
 #define EDMA_CH_ES                      0x04
 #define EDMA_CH_INT                     0x08
@@ -58,6 +63,36 @@ struct adsp_io_info;
 #define EDMA_INT                        0x08
 #define EDMA_HRS                        0x0C
 
+/* CH_CSR */
+#define EDMA_CH_CSR_ERQ                 0x00000001
+#define EDMA_CH_CSR_EEI                 0x00000002
+#define EDMA_CH_CSR_DONE                0x40000000
+#define EDMA_CH_CSR_ACTIVE              0x80000000
+
+/* CH_ES */
+#define EDMA_CH_ES_ERR                  0x80000000
+
+/* CH_INT */
+#define EDMA_CH_INT_INT                 0x00000001
+
+/* TCD_CSR */
+#define EDMA_TCD_CSR_START              0x0001
+#define EDMA_TCD_CSR_INTMAJOR           0x0002
+#define EDMA_TCD_CSR_INTHALF            0x0004
+#define EDMA_TCD_CSR_DREQ               0x0008
+#define EDMA_TCD_CSR_ESG                0x0010
+
+/* TCD NBYTES, minor loop offsets are not emulated */
+#define EDMA_TCD_NBYTES_MASK            0x3fffffff
+#define EDMA_TCD_NBYTES_MLOE            0xc0000000
+
+/* CITER and BITER without channel linking */
+#define EDMA_TCD_ITER_MASK              0x7fff
+
+/* TCD in memory for scatter gather */
+#define EDMA_TCD_OFFSET                 EDMA_TCD_SADDR
+#define EDMA_TCD_SIZE                   32
+
 #define EDMA_TCD_ATTR_SSIZE_8BIT        0x0000
 #define EDMA_TCD_ATTR_SSIZE_16BIT       0x0100
 #define EDMA_TCD_ATTR_SSIZE_32BIT       0x0200
@@ -98,13 +133,20 @@ struct dma_chan {
     uint32_t bytes;
     void *ptr;
     void *base;
-    uint32_t tbytes;
+    uint64_t tbytes;
 
-    /* endpoint */
+    /* endpoint - DAI port or -1 for memory */
     struct qemu_io_msg_dma32 dma_msg;
     int sai;
     int esai;
 
+    /* pacing and statistics */
+    struct dma_timer timer;
+    uint32_t loops;         /* minor loops per burst */
+    int dir;                /* DAI direction */
+    uint32_t xruns;
+    int64_t start_ns;
+
     /* file output/input */
     int fd;
     int file_idx;
@@ -153,5 +195,6 @@ void edma_init_dev(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info);
 void edma_msg(struct qemu_io_msg *msg);
 void edma_reset(void *opaque);
+int edma_chan_irq(int chan);
 
 #endif
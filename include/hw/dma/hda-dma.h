@@ -34,6 +34,8 @@
 #include "exec/address-spaces.h"
 #include "qemu/thread.h"
 #include "qemu/io-bridge.h"
+#include "hw/dma/dma-timer.h"
+#include "hw/adsp/dai.h"
 
 struct adsp_dev;
 struct adsp_host;
@@ -64,12 +66,12 @@ struct hda_dma_chan {
     /* endpoint */
     struct qemu_io_msg_dma32 dma_msg;
 
-    /* file output/input */
-    int fd;
+    /* buffered trace output */
+    struct dai_endpoint *trace;
     int file_idx;
 
-    /* threading */
-    QemuThread thread;
+    /* burst pacing */
+    struct dma_timer timer;
     char thread_name[32];
     uint32_t stop;
 };
@@ -8,8 +8,8 @@
  *
  */
 
-#ifndef __EDMA_H__
-#define __EDMA_H__
+#ifndef __SDMA_H__
+#define __SDMA_H__
 
 #include "qemu/osdep.h"
 #include "qapi/error.h"
@@ -25,6 +25,7 @@
 #include "qemu/thread.h"
 #include "qemu/io-bridge.h"
 #include "hw/adsp/hw.h"
+#include "hw/dma/dma-timer.h"
 
 struct adsp_dev;
 struct adsp_host;
@@ -34,6 +35,58 @@ struct adsp_io_info;
 
 #define NUM_CHANNELS                  32
 
+/* host side registers */
+#define SDMA_H_C0PTR                  0x000
+#define SDMA_H_INTR                   0x004
+#define SDMA_H_STATSTOP               0x008
+#define SDMA_H_START                  0x00c
+#define SDMA_H_EVTOVR                 0x010
+#define SDMA_H_DSPOVR                 0x014
+#define SDMA_H_HOSTOVR                0x018
+#define SDMA_H_EVTPEND                0x01c
+#define SDMA_H_DSPENBL                0x020
+#define SDMA_H_RESET                  0x024
+#define SDMA_H_EVTERR                 0x028
+#define SDMA_H_INTRMSK                0x02c
+#define SDMA_H_PSW                    0x030
+#define SDMA_H_EVTERRDBG              0x034
+#define SDMA_H_CONFIG                 0x038
+#define SDMA_CHNPRI(chan)             (0x100 + 4 * (chan))
+#define SDMA_CHNENBL(event)           (0x200 + 4 * (event))
+
+#define SDMA_NUM_EVENTS               48
+
+/* SAI3 DMA request events */
+#define SDMA_SAI3_EVENT_RX            4
+#define SDMA_SAI3_EVENT_TX            5
+
+/* SDMA3 IRQSTR input */
+#define SDMA3_IRQ                     34
+
+/*
+ * Channel control blocks and buffer descriptors live in DSP memory. The
+ * context script itself is not executed, channels move the BD buffers
+ * to or from the DAI their request event is routed to.
+ */
+#define SDMA_CCB_SIZE                 16
+#define SDMA_CCB_CURRENT_BD           0x0
+#define SDMA_CCB_BASE_BD              0x4
+
+#define SDMA_BD_SIZE                  12
+#define SDMA_BD_MODE                  0x0
+#define SDMA_BD_BUFFER                0x4
+#define SDMA_BD_EXT_BUFFER            0x8
+
+#define SDMA_BD_COUNT_MASK            0xffff
+#define SDMA_BD_DONE                  (1 << 16)
+#define SDMA_BD_WRAP                  (1 << 17)
+#define SDMA_BD_CONT                  (1 << 18)
+#define SDMA_BD_INTR                  (1 << 19)
+#define SDMA_BD_ERROR                 (1 << 20)
+#define SDMA_BD_LAST                  (1 << 21)
+#define SDMA_BD_EXTD                  (1 << 23)
+#define SDMA_BD_COMMAND_SHIFT         24
+
 /* context pointer used by timer callbacks */
 struct dma_chan {
     struct adsp_sdma *sdma;
@@ -43,11 +96,18 @@ struct dma_chan {
     uint32_t bytes;
     void *ptr;
     void *base;
-    uint32_t tbytes;
+    uint64_t tbytes;
 
-    /* endpoint */
+    /* endpoint - DAI port or -1 for memory */
     struct qemu_io_msg_dma32 dma_msg;
     int sai;
+    int dir;
+
+    /* pacing and statistics */
+    struct dma_timer timer;
+    uint32_t bd;            /* current BD address */
+    uint32_t xruns;
+    int64_t start_ns;
 
     /* file output/input */
     int fd;
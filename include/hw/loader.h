@@ -168,6 +168,15 @@ int load_elf(const char *filename,
              uint64_t *highaddr, int big_endian, int elf_machine,
              int clear_lsb, int data_swab);
 
+/** load_elf_symbols:
+ * @filename: Path of ELF file
+ *
+ * Add the function symbols of an ELF file to the symbols used by the
+ * disassembler and lookup_symbol(), without loading the file.
+ * Returns 0 on success, -1 if the file has no symbol table.
+ */
+int load_elf_symbols(const char *filename);
+
 /** load_elf_hdr:
  * @filename: Path of ELF file
  * @hdr: Buffer to populate with header data. Header data will not be
@@ -10,6 +10,8 @@
 #ifndef __ADSP_ESAI_H__
 #define __ADSP_ESAI_H__
 
+#include "hw/adsp/dai.h"
+
 /* ESAI Register Map */
 #define REG_ESAI_ETDR           0x00
 #define REG_ESAI_ERDR           0x04
@@ -37,6 +39,24 @@
 #define REG_ESAI_RCR            0xDC
 #define REG_ESAI_RCCR           0xE0
 
+/* TCR/RCR transmitter and receiver enables */
+#define ESAI_TCR_TE_MASK        0x3f
+#define ESAI_RCR_RE_MASK        0x0f
+
+/* TCCR/RCCR clock control */
+#define ESAI_xCCR_xPM_MASK      0xff
+#define ESAI_xCCR_xPSR          (1 << 8)
+#define ESAI_xCCR_xDC_SHIFT     9
+#define ESAI_xCCR_xDC_MASK      (0x1f << ESAI_xCCR_xDC_SHIFT)
+#define ESAI_xCCR_xFP_SHIFT     14
+#define ESAI_xCCR_xFP_MASK      (0xf << ESAI_xCCR_xFP_SHIFT)
+
+/* HCKT/HCKR source clock, the audio PLL is not modelled */
+#define ESAI_HCK_HZ             24576000
+
+/* FIFO words and slots are 32 bit */
+#define ESAI_SLOT_BITS          32
+
 struct adsp_dev;
 struct adsp_gp_dmac;
 struct adsp_log;
@@ -45,10 +65,14 @@ struct adsp_reg_space;
 struct esai_fifo {
 	uint32_t total_frames;
 	uint32_t index;
-	int fd;
+	struct dai_endpoint *ep;
 	char file_name[64];
 	uint32_t data[16];
 	uint32_t level;
+
+	/* DMA traffic statistics */
+	uint64_t bytes;
+	uint32_t xruns;
 };
 
 struct adsp_esai {
@@ -66,6 +90,11 @@ struct adsp_esai {
 extern const struct adsp_reg_desc adsp_esai_map[ADSP_ESAI_REGS];
 
 struct adsp_esai *esai_get_port(int port);
+uint32_t esai_get_rate(struct adsp_esai *esai, int dir);
+uint32_t esai_get_frame_bytes(struct adsp_esai *esai, int dir);
+uint32_t esai_fifo_write(struct adsp_esai *esai, const void *data,
+        uint32_t bytes);
+uint32_t esai_fifo_read(struct adsp_esai *esai, void *data, uint32_t bytes);
 void adsp_esai_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info);
 extern const MemoryRegionOps esai_ops;
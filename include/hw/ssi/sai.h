@@ -8,6 +8,8 @@
 #ifndef __SAI_H__
 #define __SAI_H__
 
+#include "hw/adsp/dai.h"
+
 #ifdef CONFIG_IMX8M
 #define SAI_OFS         8
 #else
@@ -73,6 +75,23 @@
 #define REG_SAI_RFR7   0xdc /* SAI Receive FIFO */
 #define REG_SAI_RMR    0xe0 /* SAI Receive Mask */
 
+/* xCSR */
+#define SAI_xCSR_xE         (1 << 31)   /* transmitter/receiver enable */
+
+/* xCR2 */
+#define SAI_xCR2_DIV_MASK   0xff
+
+/* xCR4 */
+#define SAI_xCR4_FRSZ_SHIFT 16
+#define SAI_xCR4_FRSZ_MASK  (0x1f << SAI_xCR4_FRSZ_SHIFT)
+
+/* xCR5 */
+#define SAI_xCR5_WNW_SHIFT  24
+#define SAI_xCR5_WNW_MASK   (0x1f << SAI_xCR5_WNW_SHIFT)
+
+/* MCLK feeding the bit clock divider, the audio PLL is not modelled */
+#define SAI_MCLK_HZ         24576000
+
 struct adsp_dev;
 struct adsp_gp_dmac;
 struct adsp_log;
@@ -81,10 +100,14 @@ struct adsp_reg_space;
 struct sai_fifo {
 	uint32_t total_frames;
 	uint32_t index;
-	int fd;
+	struct dai_endpoint *ep;
 	char file_name[64];
 	uint32_t data[16];
 	uint32_t level;
+
+	/* DMA traffic statistics */
+	uint64_t bytes;
+	uint32_t xruns;
 };
 
 struct adsp_sai {
@@ -102,6 +125,11 @@ struct adsp_sai {
 extern const struct adsp_reg_desc adsp_sai_map[ADSP_SAI_REGS];
 
 extern struct adsp_sai *sai_get_port(int port);
+uint32_t sai_get_rate(struct adsp_sai *sai, int dir);
+uint32_t sai_get_frame_bytes(struct adsp_sai *sai, int dir);
+uint32_t sai_fifo_write(struct adsp_sai *sai, const void *data,
+        uint32_t bytes);
+uint32_t sai_fifo_read(struct adsp_sai *sai, void *data, uint32_t bytes);
 void adsp_sai_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info);
 extern const MemoryRegionOps sai_ops;
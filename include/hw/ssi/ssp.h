@@ -109,10 +109,12 @@ struct adsp_gp_dmac;
 struct adsp_log;
 struct adsp_reg_space;
 
+struct dai_endpoint;
+
 struct ssp_fifo {
 	uint32_t total_frames;
 	uint32_t index;
-	int fd;
+	struct dai_endpoint *ep;
 	char file_name[64];
 	uint32_t data[16];
 	uint32_t level;
@@ -121,6 +123,7 @@ struct ssp_fifo {
 struct adsp_ssp {
 	char name[32];
 	uint32_t *io;
+	uint32_t clk_kHz;	/* SSP master clock */
 
 	struct ssp_fifo tx;
 	struct ssp_fifo rx;
@@ -133,6 +136,8 @@ struct adsp_ssp {
 extern const struct adsp_reg_desc adsp_ssp_map[ADSP_SSP_REGS];
 
 struct adsp_ssp *ssp_get_port(int port);
+uint32_t ssp_get_rate(struct adsp_ssp *ssp);
+uint32_t ssp_get_frame_bytes(struct adsp_ssp *ssp);
 void adsp_ssp_init(struct adsp_dev *adsp, MemoryRegion *parent,
         struct adsp_io_info *info);
 extern const MemoryRegionOps ssp_ops;
@@ -35,6 +35,15 @@
 
 #define QEMU_IO_DEBUG           0
 
+/*
+ * Message transport. The shared memory ring is the default, the POSIX
+ * message queue transport is kept for comparison and can be selected at
+ * runtime with QEMU_IO_TRANSPORT=mq (both parent and child must agree).
+ */
+#define QEMU_IO_TRANSPORT_MQ    0
+#define QEMU_IO_TRANSPORT_RING  1
+#define QEMU_IO_TRANSPORT       QEMU_IO_TRANSPORT_RING
+
 /* IO type */
 #define QEMU_IO_TYPE_QEMU       0
 #define QEMU_IO_TYPE_REG        1
@@ -70,6 +79,9 @@
 #define QEMU_IO_GDB_CONT        129
 #define QEMU_IO_GDB_STALL_RPLY  130 /* stall after reply */
 
+/* Memory Messages */
+#define QEMU_IO_MEM_HOST_RAM    224
+
 /* PM Messages */
 #define QEMU_IO_PM_S0           192
 #define QEMU_IO_PM_S1           193
@@ -113,6 +125,16 @@ struct qemu_io_msg_irq {
     uint32_t irq;
 };
 
+/* Memory Messages - parent RAM fd that child can map for zero copy DMA */
+struct qemu_io_msg_mem {
+    struct qemu_io_msg hdr;
+    uint32_t pid;       /* parent pid owning fd */
+    int32_t fd;         /* parent RAM fd e.g. memory-backend-memfd */
+    uint64_t gpa;       /* guest physical base of region */
+    uint64_t size;
+    uint64_t offset;    /* offset of gpa in fd */
+};
+
 /* PM Messages */
 struct qemu_io_msg_pm_state {
     struct qemu_io_msg hdr;
@@ -145,6 +167,42 @@ struct qemu_io_msg_dma64 {
     uint64_t client_data;
 };
 
+/*
+ * Bridge instances. IPC object names carry the instance namespace so many
+ * parent/child pairs can share one host. The qemu_io_*() calls below act on
+ * the default instance, which is the first io-bridge object created or one
+ * using the QEMU_IO_NS namespace from the environment.
+ */
+struct io_bridge;
+
+struct io_bridge *qemu_io_bridge_new(const char *ns);
+void qemu_io_bridge_set_default(struct io_bridge *io);
+bool qemu_io_bridge_is_default(struct io_bridge *io);
+struct io_bridge *qemu_io_bridge_get_default(void);
+const char *qemu_io_bridge_ns(struct io_bridge *io);
+
+int qemu_io_bridge_register_parent(struct io_bridge *io, const char *name,
+    int (*cb)(void *, struct qemu_io_msg *msg), void *data);
+int qemu_io_bridge_register_child(struct io_bridge *io, const char *name,
+    int (*cb)(void *, struct qemu_io_msg *msg), void *data);
+int qemu_io_bridge_send_msg(struct io_bridge *io, struct qemu_io_msg *msg);
+int qemu_io_bridge_send_msg_reply(struct io_bridge *io,
+    struct qemu_io_msg *msg);
+int qemu_io_bridge_register_shm(struct io_bridge *io, const char *name,
+    int region, size_t size, void **addr);
+int qemu_io_bridge_sync(struct io_bridge *io, int region, unsigned int offset,
+    size_t length);
+int qemu_io_bridge_discard_shm(struct io_bridge *io, int region,
+    size_t offset, size_t length);
+ssize_t qemu_io_bridge_shm_resident(struct io_bridge *io, int region);
+int qemu_io_bridge_pending(struct io_bridge *io);
+void qemu_io_bridge_free(struct io_bridge *io);
+void qemu_io_bridge_free_shm(struct io_bridge *io, int region);
+int qemu_io_bridge_register_host_ram(struct io_bridge *io, uint64_t gpa,
+    uint64_t size, int fd, uint64_t offset);
+void *qemu_io_bridge_host_ram(struct io_bridge *io, uint64_t gpa,
+    uint64_t size);
+
 /* API calls for parent and child */
 int qemu_io_register_parent(const char *name,
     int (*cb)(void *, struct qemu_io_msg *msg), void *data);
@@ -157,8 +215,16 @@ int qemu_io_send_msg_reply(struct qemu_io_msg *msg);
 int qemu_io_register_shm(const char *name, int region, size_t size,
     void **addr);
 int qemu_io_sync(int region, unsigned int offset, size_t length);
+int qemu_io_discard_shm(int region, size_t offset, size_t length);
+ssize_t qemu_io_shm_resident(int region);
+int qemu_io_pending(void);
 
 void qemu_io_free(void);
 void qemu_io_free_shm(int region);
 
+/* zero copy access to parent guest RAM */
+int qemu_io_register_host_ram(uint64_t gpa, uint64_t size, int fd,
+    uint64_t offset);
+void *qemu_io_host_ram(uint64_t gpa, uint64_t size);
+
 #endif
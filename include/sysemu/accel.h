@@ -65,6 +65,9 @@ typedef struct AccelClass {
     OBJECT_GET_CLASS(AccelClass, (obj), TYPE_ACCEL)
 
 extern unsigned long tcg_tb_size;
+extern const char *tcg_tb_cache_path;
+extern const char *tcg_perf_mode;
+extern const char *tcg_perf_elf;
 
 void configure_accelerator(MachineState *ms, const char *progname);
 /* Called just before os_setup_post (ie just before drop OS privs) */
@@ -30,6 +30,7 @@ void cpu_synchronize_all_post_init(void);
 void cpu_synchronize_all_pre_loadvm(void);
 
 void qtest_clock_warp(int64_t dest);
+void cpu_enable_time_warp(bool (*busy)(void));
 
 #ifndef CONFIG_USER_ONLY
 /* vl.c */
@@ -118,9 +118,12 @@ Select CPU model (@code{-cpu help} for list and additional feature selection)
 ETEXI
 
 DEF("accel", HAS_ARG, QEMU_OPTION_accel,
-    "-accel [accel=]accelerator[,thread=single|multi]\n"
+    "-accel [accel=]accelerator[,thread=single|multi][,hot-trace=n[,hot-trace-jumps=n]]\n"
+    "                [,tb-evict=on|off]\n"
     "                select accelerator (kvm, xen, hax, hvf, whpx or tcg; use 'help' for a list)\n"
-    "                thread=single|multi (enable multi-threaded TCG)\n", QEMU_ARCH_ALL)
+    "                thread=single|multi (enable multi-threaded TCG)\n"
+    "                hot-trace=n (retranslate TCG blocks run n times as hot traces)\n"
+    "                tb-evict=on|off (free the oldest TCG code instead of all of it)\n", QEMU_ARCH_ALL)
 STEXI
 @item -accel @var{name}[,prop=@var{value}[,...]]
 @findex -accel
@@ -134,6 +137,19 @@ Controls number of TCG threads. When the TCG is multi-threaded there will be one
 thread per vCPU therefor taking advantage of additional host cores. The default
 is to enable multi-threading where both the back-end and front-ends support it and
 no incompatible TCG features have been enabled (e.g. icount/replay).
+@item hot-trace=@var{n}
+Count executions of each TCG translation block and retranslate a block that
+ran @var{n} times as a hot trace. Where the target supports it, translation
+of a hot trace continues across direct jumps, so the former blocks are
+optimized together. Statistics are shown by @code{info jit}. Disabled by
+default.
+@item hot-trace-jumps=@var{n}
+Maximum number of direct jumps followed in one hot trace (default 8).
+@item tb-evict=on|off
+When the TCG code buffer is full, free only its least recently allocated
+region instead of all translated code. The buffer is split into at least two
+regions per TCG thread for this. Eviction and retranslation counts are shown
+by @code{info jit}. Disabled by default.
 @end table
 ETEXI
 
@@ -4023,6 +4039,35 @@ STEXI
 Set TB size.
 ETEXI
 
+DEF("tb-cache", HAS_ARG, QEMU_OPTION_tb_cache, \
+    "-tb-cache file  reuse translated code saved in file\n", QEMU_ARCH_ALL)
+STEXI
+@item -tb-cache @var{file}
+@findex -tb-cache
+Load translated code from @var{file} and save newly translated code to it
+when QEMU exits. Cached code is only used by the same QEMU binary, target
+and CPU model, and only if the guest code it was translated from is
+unchanged. Hit rates are shown by @code{info jit}. Requires an x86_64
+Linux host and a position independent QEMU build.
+ETEXI
+
+DEF("perf", HAS_ARG, QEMU_OPTION_perf, \
+    "-perf map|jitdump[,elf=file]\n" \
+    "                describe translated code to the perf profiler\n", \
+    QEMU_ARCH_ALL)
+STEXI
+@item -perf map|jitdump[,elf=@var{file}]
+@findex -perf
+Describe every translated block to the Linux perf profiler, so samples in
+translated code are attributed to the guest function it came from.
+@option{map} writes @file{/tmp/perf-<pid>.map}, which @code{perf report}
+reads directly. @option{jitdump} writes @file{jit-<pid>.dump}, which also
+holds the generated code for @code{perf annotate} and stays correct after
+translated code is flushed; run @code{perf record -k 1} and merge it with
+@code{perf inject -j}. Guest symbols come from ELF images loaded by the
+machine and from the symbol table of @var{file}.
+ETEXI
+
 DEF("incoming", HAS_ARG, QEMU_OPTION_incoming, \
     "-incoming tcp:[host]:port[,to=maxport][,ipv4][,ipv6]\n" \
     "-incoming rdma:host:port[,ipv4][,ipv6]\n" \
@@ -0,0 +1,91 @@
+#!/usr/bin/env python
+#
+# Compare two audio DSP firmware profiles (-machine profile=<file>)
+#
+# Copyright (c) 2026 agent <agent@local>
+#
+# This work is licensed under the terms of the GNU GPL, version 2 or later.
+# See the COPYING file in the top-level directory.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Usage: adsp-profile-diff.py [--all] <old profile> <new profile>
+#
+# Prints the per function self cycle and MCPS deltas, largest change first,
+# then call count changes and memory region access deltas. Functions
+# without change are skipped unless --all is given.
+
+from __future__ import print_function
+import sys
+
+def read_profile(name):
+    '''returns (flat, callgraph, memory) dicts'''
+    sections = {'flat': {}, 'callgraph': {}, 'memory': {}}
+    cur = None
+
+    with open(name) as fobj:
+        for line in fobj:
+            line = line.rstrip('\n')
+            if not line or line.startswith('#'):
+                continue
+            if line in sections:
+                cur = sections[line]
+                continue
+            if cur is None:
+                continue
+
+            if cur is sections['flat']:
+                f = line.split(None, 6)
+                cur[f[6]] = (int(f[0]), float(f[2]))
+            elif cur is sections['callgraph']:
+                f = line.split(None, 2)
+                cur[f[2]] = (int(f[0]), int(f[1]))
+            else:
+                f = line.split(None, 1)
+                cur[f[1]] = int(f[0])
+
+    return sections['flat'], sections['callgraph'], sections['memory']
+
+def main():
+    args = sys.argv[1:]
+    show_all = '--all' in args
+    if show_all:
+        args.remove('--all')
+    if len(args) != 2:
+        sys.stderr.write('usage: %s [--all] <old profile> <new profile>\n' %
+                         sys.argv[0])
+        sys.exit(1)
+
+    old_flat, old_cg, old_mem = read_profile(args[0])
+    new_flat, new_cg, new_mem = read_profile(args[1])
+
+    print('flat')
+    print('#%15s %16s %16s %9s  %s' % ('old', 'new', 'delta', 'mcps',
+                                       'function'))
+    rows = []
+    for func in set(old_flat) | set(new_flat):
+        old, old_mcps = old_flat.get(func, (0, 0.0))
+        new, new_mcps = new_flat.get(func, (0, 0.0))
+        if old != new or show_all:
+            rows.append((new - old, new_mcps - old_mcps, old, new, func))
+    rows.sort(key=lambda r: (-abs(r[0]), r[4]))
+    for delta, mcps, old, new, func in rows:
+        print('%16d %16d %+16d %+9.3f  %s' % (old, new, delta, mcps, func))
+
+    print('\ncallgraph')
+    print('#%9s %10s %10s  %s' % ('old', 'new', 'delta', 'caller -> callee'))
+    for arc in sorted(set(old_cg) | set(new_cg)):
+        old = old_cg.get(arc, (0, 0))[0]
+        new = new_cg.get(arc, (0, 0))[0]
+        if old != new or show_all:
+            print('%10d %10d %+10d  %s' % (old, new, new - old, arc))
+
+    print('\nmemory')
+    print('#%15s %16s %16s  %s' % ('old', 'new', 'delta', 'region'))
+    for region in sorted(set(old_mem) | set(new_mem)):
+        old = old_mem.get(region, 0)
+        new = new_mem.get(region, 0)
+        print('%16d %16d %+16d  %s' % (old, new, new - old, region))
+
+if __name__ == '__main__':
+    main()
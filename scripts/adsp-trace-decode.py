@@ -0,0 +1,153 @@
+#!/usr/bin/env python
+#
+# Decode audio DSP binary register trace files (trace_regs=bin)
+#
+# Copyright (c) 2026 agent <agent@local>
+#
+# This work is licensed under the terms of the GNU GPL, version 2 or later.
+# See the COPYING file in the top-level directory.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Usage: adsp-trace-decode.py [--timestamps] <trace file>
+#
+# Output matches the trace_regs=text log format from include/hw/adsp/log.h
+
+from __future__ import print_function
+import struct
+import sys
+
+LOG_TRACE_MAGIC = b'ADSPTRC\0'
+LOG_TRACE_VERSION = 1
+
+LOG_TRACE_DEV = 0
+LOG_TRACE_READ = 1
+LOG_TRACE_WRITE = 2
+LOG_TRACE_AREA_READ = 3
+LOG_TRACE_AREA_WRITE = 4
+LOG_TRACE_TYPE_MASK = 0x0f
+LOG_TRACE_KNOWN = 0x10
+LOG_TRACE_HAS_REGS = 0x20
+
+LOG_TRACE_DEV_UNMAPPED = 0xffff
+
+# struct log_trace_rec
+rec_fmt = '=QQQIHBB'
+rec_size = struct.calcsize(rec_fmt)
+
+trace_class = {
+    1 << 24: 'irq',
+    2 << 24: 'ipc',
+    3 << 24: 'pipe',
+    4 << 24: 'host',
+    5 << 24: 'dai',
+    6 << 24: 'dma',
+    7 << 24: 'ssp',
+    8 << 24: 'comp',
+    9 << 24: 'wfi',
+}
+
+def get_char(val, idx):
+    '''log_get_char() - printable byte or .'''
+    c = (val >> (idx * 8)) & 0xff
+    if c < ord('0') or c > ord('z'):
+        return '.'
+    return chr(c)
+
+def chars(val):
+    return '|%s%s%s%s|' % (get_char(val, 3), get_char(val, 2),
+                           get_char(val, 1), get_char(val, 0))
+
+def signed(val):
+    '''%8.8ld of a 64 bit value'''
+    if val & (1 << 63):
+        val -= 1 << 64
+    if val < 0:
+        return '-%08d' % -val
+    return '%08d' % val
+
+def decode(name, rtype, offset, val, old):
+    kind = rtype & LOG_TRACE_TYPE_MASK
+    known = rtype & LOG_TRACE_KNOWN
+
+    if kind == LOG_TRACE_READ:
+        if known:
+            return '%s.io: read at 0x%x val 0x%08x' % (name, offset, val)
+        return '%s.io: *read* at %x val 0x%08x' % (name, offset, val)
+
+    if kind == LOG_TRACE_WRITE:
+        return '%s.io: %s 0x%x = \t0x%08x (old 0x%x) \t(%s) \t%s' % (
+            name, 'write' if known else '*write*', offset, val, old,
+            signed(val), chars(val))
+
+    if kind == LOG_TRACE_AREA_READ:
+        return '%s.io: read at 0x%x val 0x%08x' % (name, offset,
+                                                   val & 0xffffffff)
+
+    if kind == LOG_TRACE_AREA_WRITE:
+        if not rtype & LOG_TRACE_HAS_REGS:
+            return '%s.io: write 0x%x = \t0x%08x \t(%s) \t%s' % (
+                name, offset, val, signed(val), chars(val))
+
+        cls = trace_class.get(val & 0xff000000)
+        if cls is None:
+            return ' 0x%x = \t0x%08x \t(%s) \t%s' % (offset, val,
+                                                    signed(val), chars(val))
+        return '%s %s%s%s' % (cls, chr((val >> 16) & 0xff),
+                              chr((val >> 8) & 0xff), chr(val & 0xff))
+
+    return 'unknown record type %d' % kind
+
+def read_trace(fobj):
+    hdr = fobj.read(16)
+    if len(hdr) != 16 or hdr[:8] != LOG_TRACE_MAGIC:
+        raise ValueError('not an adsp trace file')
+
+    version, size = struct.unpack('=II', hdr[8:])
+    if version != LOG_TRACE_VERSION or size != rec_size:
+        raise ValueError('unsupported trace version %d record size %d' %
+                         (version, size))
+
+    recs = []
+    while True:
+        buf = fobj.read(rec_size)
+        if len(buf) < rec_size:
+            break
+        recs.append(struct.unpack(rec_fmt, buf))
+    return recs
+
+def main():
+    args = sys.argv[1:]
+    timestamps = '--timestamps' in args
+    if timestamps:
+        args.remove('--timestamps')
+    if len(args) != 1:
+        sys.stderr.write('usage: %s [--timestamps] <trace file>\n' %
+                         sys.argv[0])
+        sys.exit(1)
+
+    with open(args[0], 'rb') as fobj:
+        recs = read_trace(fobj)
+
+    # device names first, they can be in any thread ring
+    devs = {LOG_TRACE_DEV_UNMAPPED: 'unmapped'}
+    for ns, val, old, offset, dev, rtype, size in recs:
+        if rtype & LOG_TRACE_TYPE_MASK == LOG_TRACE_DEV:
+            name = struct.pack('=QQ', val, old).split(b'\0')[0]
+            devs[dev] = name.decode('ascii', 'replace')
+
+    # rings are flushed per thread, restore global order
+    recs.sort(key=lambda r: r[0])
+    start = recs[0][0] if recs else 0
+
+    for ns, val, old, offset, dev, rtype, size in recs:
+        if rtype & LOG_TRACE_TYPE_MASK == LOG_TRACE_DEV:
+            continue
+        line = decode(devs.get(dev, 'dev%d' % dev), rtype, offset, val, old)
+        if timestamps:
+            line = '%6.6d.%6.6d: %s' % ((ns - start) // 1000000000,
+                                        (ns - start) // 1000 % 1000000, line)
+        print(line)
+
+if __name__ == '__main__':
+    main()
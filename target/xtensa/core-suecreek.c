@@ -43,6 +43,11 @@ static XtensaConfig suecreek __attribute__((unused)) = {
         }
     },
     .isa_internal = &xtensa_modules,
+    .opcode_translators = (const XtensaOpcodeTranslators *[]){
+        &xtensa_core_opcodes,
+        &xtensa_hifi3_opcodes,
+        NULL,
+    },
     .clock_freq_khz = 5000,
     DEFAULT_SECTIONS
 };
@@ -32,6 +32,7 @@
 #include "qapi/error.h"
 #include "cpu.h"
 #include "qemu/module.h"
+#include "hw/qdev-properties.h"
 #include "migration/vmstate.h"
 
 
@@ -129,6 +130,30 @@ static void xtensa_cpu_disas_set_info(CPUState *cs, disassemble_info *info)
     info->print_insn = print_insn_xtensa;
 }
 
+/* cycle accounting and profiling change the generated code */
+static uint64_t xtensa_cpu_tb_cache_key(CPUState *cs)
+{
+    uint64_t key = xtensa_profile_enabled();
+#ifndef CONFIG_USER_ONLY
+    CPUXtensaState *env = &XTENSA_CPU(cs)->env;
+
+    key |= (uint64_t)env->ccount_cpi << 32 | env->ccount_deterministic << 1;
+#endif
+    return key;
+}
+
+/*
+ * With XTENSA_TBFLAG_DEBUG enabled IBREAKA are compared at translation
+ * time. Writing them invalidates the TB so it is translated again, it must
+ * not be reinstalled from the cache.
+ */
+static bool xtensa_cpu_tb_cache_skip(CPUState *cs, const TranslationBlock *tb)
+{
+    CPUXtensaState *env = &XTENSA_CPU(cs)->env;
+
+    return (tb->flags & XTENSA_TBFLAG_DEBUG) && env->sregs[IBREAKENABLE];
+}
+
 static void xtensa_cpu_realizefn(DeviceState *dev, Error **errp)
 {
     CPUState *cs = CPU(dev);
@@ -136,7 +161,13 @@ static void xtensa_cpu_realizefn(DeviceState *dev, Error **errp)
     Error *local_err = NULL;
 
 #ifndef CONFIG_USER_ONLY
-    xtensa_irq_init(&XTENSA_CPU(dev)->env);
+    CPUXtensaState *env = &XTENSA_CPU(dev)->env;
+
+    if (env->ccount_deterministic && env->ccount_cpi == 0) {
+        error_setg(errp, "ccount-deterministic requires non zero ccount-cpi");
+        return;
+    }
+    xtensa_irq_init(env);
 #endif
 
     cpu_exec_realizefn(cs, &local_err);
@@ -170,6 +201,15 @@ static void xtensa_cpu_initfn(Object *obj)
 #endif
 }
 
+static Property xtensa_cpu_properties[] = {
+#ifndef CONFIG_USER_ONLY
+    DEFINE_PROP_UINT32("ccount-cpi", XtensaCPU, env.ccount_cpi, 0),
+    DEFINE_PROP_BOOL("ccount-deterministic", XtensaCPU,
+                     env.ccount_deterministic, false),
+#endif
+    DEFINE_PROP_END_OF_LIST()
+};
+
 static const VMStateDescription vmstate_xtensa_cpu = {
     .name = "cpu",
     .unmigratable = 1,
@@ -205,7 +245,10 @@ static void xtensa_cpu_class_init(ObjectClass *oc, void *data)
     cc->debug_excp_handler = xtensa_breakpoint_handler;
     cc->disas_set_info = xtensa_cpu_disas_set_info;
     cc->tcg_initialize = xtensa_translate_init;
+    cc->tb_cache_key = xtensa_cpu_tb_cache_key;
+    cc->tb_cache_skip = xtensa_cpu_tb_cache_skip;
     dc->vmsd = &vmstate_xtensa_cpu;
+    dc->props = xtensa_cpu_properties;
 }
 
 static const TypeInfo xtensa_cpu_type_info = {
@@ -104,8 +104,18 @@ enum {
     THREADPTR = 231,
     FCR = 232,
     FSR = 233,
+    AE_OVF_SAR = 240,
+    AE_BITHEAD = 241,
+    AE_TS_FTS_BU_BP = 242,
+    AE_CW_SD_NO = 243,
+    AE_CBEGIN0 = 246,
+    AE_CEND0 = 247,
 };
 
+/* AE_OVF_SAR fields */
+#define AE_SAR_MASK         0x3f
+#define AE_OVERFLOW_SHIFT   6
+
 enum {
     LBEG = 0,
     LEND = 1,
@@ -357,6 +367,7 @@ typedef struct opcode_arg {
     uint32_t raw_imm;
     void *in;
     void *out;
+    unsigned num_bits;
 } OpcodeArg;
 
 typedef struct DisasContext DisasContext;
@@ -420,6 +431,7 @@ typedef struct XtensaOpcodeTranslators {
 
 extern const XtensaOpcodeTranslators xtensa_core_opcodes;
 extern const XtensaOpcodeTranslators xtensa_fpu2000_opcodes;
+extern const XtensaOpcodeTranslators xtensa_hifi3_opcodes;
 
 struct XtensaConfig {
     const char *name;
@@ -511,6 +523,9 @@ typedef struct CPUXtensaState {
         float64 f64;
     } fregs[16];
     float_status fp_status;
+    /* HiFi3 audio engine */
+    uint64_t aed[16];
+    uint64_t ae_valign[4];
     uint32_t windowbase_next;
     uint32_t exclusive_addr;
     uint32_t exclusive_val;
@@ -531,12 +546,21 @@ typedef struct CPUXtensaState {
     uint64_t time_base;
     uint64_t ccount_time;
     uint32_t ccount_base;
+    /* CCOUNT cycles per instruction, 0 reads CCOUNT from the virtual clock */
+    uint32_t ccount_cpi;
+    bool ccount_deterministic;
+    /* deterministic mode CCOMPARE tracking */
+    uint32_t ccount_last;
+    uint32_t ccount_next;
 #endif
 
     int exception_taken;
     int yield_needed;
     unsigned static_vectors;
 
+    /* cycle accounting profiler state, allocated on first use */
+    struct XtensaProfileCPU *profile;
+
     /* Watchpoints for DBREAK registers */
     struct CPUWatchpoint *cpu_watchpoint[MAX_NDBREAK];
 } CPUXtensaState;
@@ -598,11 +622,23 @@ void xtensa_cpu_do_unaligned_access(CPUState *cpu, vaddr addr,
 void xtensa_collect_sr_names(const XtensaConfig *config);
 void xtensa_translate_init(void);
 void **xtensa_get_regfile_by_name(const char *name);
+void xtensa_decode_cache_stats(uint64_t *hits, uint64_t *misses,
+                               unsigned *entries);
 void xtensa_breakpoint_handler(CPUState *cs);
 void xtensa_register_core(XtensaConfigList *node);
 void xtensa_sim_open_console(Chardev *chr);
 void check_interrupts(CPUXtensaState *s);
 void xtensa_irq_init(CPUXtensaState *env);
+bool xtensa_ccount_warp(CPUXtensaState *env);
+
+typedef const char *(*XtensaProfileSymbolFn)(uint32_t addr, void *opaque);
+void xtensa_profile_enable(void);
+bool xtensa_profile_enabled(void);
+void xtensa_profile_add_region(const char *name, uint32_t base, uint32_t size);
+unsigned xtensa_profile_opcode_cycles(const XtensaConfig *config,
+                                      xtensa_opcode opc, uint32_t op_flags);
+void *xtensa_profile_tb(uint32_t pc, uint32_t insns, uint32_t cycles);
+void xtensa_profile_report(FILE *f, XtensaProfileSymbolFn sym, void *opaque);
 qemu_irq *xtensa_get_extints(CPUXtensaState *env);
 qemu_irq xtensa_get_runstall(CPUXtensaState *env);
 int cpu_xtensa_signal_handler(int host_signum, void *pinfo, void *puc);
@@ -711,6 +747,8 @@ static inline int cpu_mmu_index(CPUXtensaState *env, bool ifetch)
 #define XTENSA_TBFLAG_CWOE 0x40000
 #define XTENSA_TBFLAG_CALLINC_MASK 0x180000
 #define XTENSA_TBFLAG_CALLINC_SHIFT 19
+#define XTENSA_TBFLAG_WINDOWBASE_MASK 0x1e00000
+#define XTENSA_TBFLAG_WINDOWBASE_SHIFT 21
 
 #define XTENSA_CSBASE_LEND_MASK 0x0000ffff
 #define XTENSA_CSBASE_LEND_SHIFT 0
@@ -787,6 +825,7 @@ static inline void cpu_get_tb_cpu_state(CPUXtensaState *env, target_ulong *pc,
         *flags |= (w << XTENSA_TBFLAG_WINDOW_SHIFT) | XTENSA_TBFLAG_CWOE;
         *flags |= extract32(env->sregs[PS], PS_CALLINC_SHIFT,
                             PS_CALLINC_LEN) << XTENSA_TBFLAG_CALLINC_SHIFT;
+        *flags |= env->sregs[WINDOW_BASE] << XTENSA_TBFLAG_WINDOWBASE_SHIFT;
     } else {
         *flags |= 3 << XTENSA_TBFLAG_WINDOW_SHIFT;
     }
@@ -110,6 +110,11 @@ void HELPER(waiti)(CPUXtensaState *env, uint32_t pc, uint32_t intlevel)
     check_interrupts(env);
     qemu_mutex_unlock_iothread();
 
+    /* deterministic CCOUNT does not advance while halted, skip ahead */
+    if (!env->pending_irq_level && env->ccount_deterministic) {
+        xtensa_ccount_warp(env);
+    }
+
     if (env->pending_irq_level) {
         cpu_loop_exit(cpu);
         return;
@@ -201,6 +206,7 @@ void xtensa_cpu_do_interrupt(CPUState *cs)
     CPUXtensaState *env = &cpu->env;
 
     if (cs->exception_index == EXC_IRQ) {
+        HELPER(update_ccount)(env);
         qemu_log_mask(CPU_LOG_INT,
                       "%s(EXC_IRQ) level = %d, cintlevel = %d, "
                       "pc = %08x, a0 = %08x, ps = %08x, "
@@ -4,10 +4,8 @@ DEF_HELPER_4(exception_cause_vaddr, noreturn, env, i32, i32, i32)
 DEF_HELPER_3(debug_exception, noreturn, env, i32, i32)
 
 DEF_HELPER_1(sync_windowbase, void, env)
-DEF_HELPER_4(entry, void, env, i32, i32, i32)
 DEF_HELPER_2(test_ill_retw, void, env, i32)
 DEF_HELPER_2(test_underflow_retw, void, env, i32)
-DEF_HELPER_2(retw, void, env, i32)
 DEF_HELPER_3(window_check, noreturn, env, i32, i32)
 DEF_HELPER_1(restore_owb, void, env)
 DEF_HELPER_2(movsp, void, env, i32)
@@ -20,6 +18,11 @@ DEF_HELPER_3(waiti, void, env, i32, i32)
 DEF_HELPER_1(update_ccount, void, env)
 DEF_HELPER_2(wsr_ccount, void, env, i32)
 DEF_HELPER_2(update_ccompare, void, env, i32)
+DEF_HELPER_1(ccount_event, void, env)
+DEF_HELPER_FLAGS_2(profile_tb, TCG_CALL_NO_RWG, void, env, ptr)
+DEF_HELPER_FLAGS_2(profile_mem, TCG_CALL_NO_RWG, void, env, i32)
+DEF_HELPER_FLAGS_3(profile_call, TCG_CALL_NO_RWG, void, env, i32, i32)
+DEF_HELPER_FLAGS_1(profile_ret, TCG_CALL_NO_RWG, void, env)
 DEF_HELPER_1(check_interrupts, void, env)
 DEF_HELPER_2(intset, void, env, i32)
 DEF_HELPER_2(intclear, void, env, i32)
@@ -67,5 +70,14 @@ DEF_HELPER_4(ult_s, void, env, i32, f32, f32)
 DEF_HELPER_4(ole_s, void, env, i32, f32, f32)
 DEF_HELPER_4(ule_s, void, env, i32, f32, f32)
 
+DEF_HELPER_4(ae_addsub16s, i64, env, i64, i64, i32)
+DEF_HELPER_4(ae_addsub32s, i64, env, i64, i64, i32)
+DEF_HELPER_4(ae_addsub64s, i64, env, i64, i64, i32)
+DEF_HELPER_FLAGS_2(ae_negabs32s, TCG_CALL_NO_RWG_SE, i64, i64, i32)
+DEF_HELPER_5(ae_mulf32s, i64, env, i64, i32, i32, i32)
+DEF_HELPER_5(ae_round32x2, i64, env, i64, i64, i32, i32)
+DEF_HELPER_5(ae_pack16x4, i64, env, i64, i64, i32, i32)
+DEF_HELPER_3(ae_sat64, i64, env, i64, i32)
+
 DEF_HELPER_2(rer, i32, env, i32)
 DEF_HELPER_3(wer, void, env, i32, i32)
@@ -0,0 +1,196 @@
+/*
+ * HiFi3 audio engine helpers.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "cpu.h"
+#include "exec/helper-proto.h"
+
+/*
+ * Only the saturating and rounding operations live here, they need to set
+ * AE_OVERFLOW. Wrapping lane arithmetic is generated inline by the
+ * translator.
+ */
+
+static void ae_overflow(CPUXtensaState *env)
+{
+    env->uregs[AE_OVF_SAR] |= 1u << AE_OVERFLOW_SHIFT;
+}
+
+static int64_t ae_sat(CPUXtensaState *env, int64_t v, unsigned bits)
+{
+    int64_t max = (1ll << (bits - 1)) - 1;
+    int64_t min = -max - 1;
+
+    if (v > max) {
+        if (env) {
+            ae_overflow(env);
+        }
+        return max;
+    }
+    if (v < min) {
+        if (env) {
+            ae_overflow(env);
+        }
+        return min;
+    }
+    return v;
+}
+
+static int64_t ae_sat64_add(CPUXtensaState *env, int64_t a, int64_t b)
+{
+    int64_t r = (uint64_t)a + b;
+
+    if (((a ^ r) & (b ^ r)) < 0) {
+        ae_overflow(env);
+        return a < 0 ? INT64_MIN : INT64_MAX;
+    }
+    return r;
+}
+
+static int64_t ae_sat64_sub(CPUXtensaState *env, int64_t a, int64_t b)
+{
+    int64_t r = (uint64_t)a - b;
+
+    if (((a ^ b) & (a ^ r)) < 0) {
+        ae_overflow(env);
+        return a < 0 ? INT64_MIN : INT64_MAX;
+    }
+    return r;
+}
+
+static int64_t ae_lane(uint64_t v, unsigned lane, unsigned bits)
+{
+    return sextract64(v, lane * bits, bits);
+}
+
+static uint64_t ae_addsub_lanes(CPUXtensaState *env, uint64_t a, uint64_t b,
+                                uint32_t sub, unsigned bits)
+{
+    uint64_t r = 0;
+    unsigned i;
+
+    for (i = 0; i < 64 / bits; ++i) {
+        int64_t x = ae_lane(a, i, bits);
+        int64_t y = ae_lane(b, i, bits);
+
+        r = deposit64(r, i * bits, bits,
+                      ae_sat(env, sub ? x - y : x + y, bits));
+    }
+    return r;
+}
+
+uint64_t HELPER(ae_addsub16s)(CPUXtensaState *env, uint64_t a, uint64_t b,
+                              uint32_t sub)
+{
+    return ae_addsub_lanes(env, a, b, sub, 16);
+}
+
+uint64_t HELPER(ae_addsub32s)(CPUXtensaState *env, uint64_t a, uint64_t b,
+                              uint32_t sub)
+{
+    return ae_addsub_lanes(env, a, b, sub, 32);
+}
+
+uint64_t HELPER(ae_addsub64s)(CPUXtensaState *env, uint64_t a, uint64_t b,
+                              uint32_t sub)
+{
+    return sub ? ae_sat64_sub(env, a, b) : ae_sat64_add(env, a, b);
+}
+
+/* AE_NEG32S and AE_ABS32S saturate but leave AE_OVERFLOW alone */
+uint64_t HELPER(ae_negabs32s)(uint64_t a, uint32_t abs)
+{
+    uint64_t r = 0;
+    unsigned i;
+
+    for (i = 0; i < 2; ++i) {
+        int64_t x = ae_lane(a, i, 32);
+
+        r = deposit64(r, i * 32, 32,
+                      ae_sat(NULL, abs && x >= 0 ? x : -x, 32));
+    }
+    return r;
+}
+
+/*
+ * 1.31 x 1.31 fractional multiply into 1.63, optionally accumulated.
+ * The product only overflows for 0x80000000 * 0x80000000.
+ */
+uint64_t HELPER(ae_mulf32s)(CPUXtensaState *env, uint64_t acc,
+                            uint32_t a, uint32_t b, uint32_t op)
+{
+    int64_t p;
+
+    if (a == 0x80000000 && b == 0x80000000) {
+        ae_overflow(env);
+        p = INT64_MAX;
+    } else {
+        p = (int64_t)(int32_t)a * (int32_t)b * 2;
+    }
+
+    switch (op) {
+    case 1:
+        return ae_sat64_add(env, acc, p);
+    case 2:
+        return ae_sat64_sub(env, acc, p);
+    default:
+        return p;
+    }
+}
+
+/* drop the low shift bits, rounding half up or half away from zero */
+static int64_t ae_round(int64_t v, unsigned shift, bool sym)
+{
+    if (sym && v < 0) {
+        return -(int64_t)((-(uint64_t)v + (1ull << (shift - 1))) >> shift);
+    }
+    return (v >> shift) + ((v >> (shift - 1)) & 1);
+}
+
+/*
+ * AE_ROUND32X2F48S* and AE_ROUND32X2F64S*: round the 17.47 or 1.63 values
+ * in d0 and d1 to 1.31 in the high and low lanes.
+ */
+uint64_t HELPER(ae_round32x2)(CPUXtensaState *env, uint64_t d0, uint64_t d1,
+                              uint32_t shift, uint32_t sym)
+{
+    uint64_t r;
+
+    r = deposit64(0, 0, 32, ae_sat(env, ae_round(d1, shift, sym), 32));
+    return deposit64(r, 32, 32, ae_sat(env, ae_round(d0, shift, sym), 32));
+}
+
+/*
+ * AE_ROUND16X4F32S* (shift 16) and AE_SAT16X4 (shift 0): narrow the 2x32
+ * lanes of d0 and d1 to 4x16, d0 in the high lanes.
+ */
+uint64_t HELPER(ae_pack16x4)(CPUXtensaState *env, uint64_t d0, uint64_t d1,
+                             uint32_t shift, uint32_t sym)
+{
+    uint64_t r = 0;
+    unsigned i;
+
+    for (i = 0; i < 4; ++i) {
+        int64_t x = ae_lane(i < 2 ? d1 : d0, i & 1, 32);
+
+        if (shift) {
+            x = ae_round(x, shift, sym);
+        }
+        r = deposit64(r, i * 16, 16, ae_sat(env, x, 16));
+    }
+    return r;
+}
+
+/* AE_SAT48S and AE_SATQ56S */
+uint64_t HELPER(ae_sat64)(CPUXtensaState *env, uint64_t v, uint32_t bits)
+{
+    return ae_sat(env, v, bits);
+}
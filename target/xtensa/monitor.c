@@ -37,3 +37,13 @@ void hmp_info_tlb(Monitor *mon, const QDict *qdict)
     }
     dump_mmu(env1);
 }
+
+void hmp_info_decode_cache(Monitor *mon, const QDict *qdict)
+{
+    uint64_t hits, misses;
+    unsigned entries;
+
+    xtensa_decode_cache_stats(&hits, &misses, &entries);
+    monitor_printf(mon, "entries %u hits %" PRIu64 " misses %" PRIu64 "\n",
+                   entries, hits, misses);
+}
@@ -33,18 +33,45 @@
 #include "exec/exec-all.h"
 #include "exec/cpu_ldst.h"
 #include "exec/address-spaces.h"
+#include "hw/irq.h"
 #include "qemu/timer.h"
 
 #ifndef CONFIG_USER_ONLY
 
+/*
+ * With ccount_cpi set CCOUNT is advanced inline by the translator, by
+ * ccount_cpi cycles per instruction at the start of every TB. It is only
+ * synchronised with the virtual clock here, on interrupts, on timer
+ * register accesses and when a TB exits to the main loop, and never goes
+ * backwards.
+ *
+ * In deterministic mode CCOUNT is never synchronised and CCOMPARE
+ * interrupts are raised from CCOUNT itself rather than virtual clock
+ * timers, so firmware timing does not depend on the host.
+ */
 void HELPER(update_ccount)(CPUXtensaState *env)
 {
-    uint64_t now = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    uint64_t now;
+    uint32_t ccount;
+    int32_t delta;
 
-    env->ccount_time = now;
-    env->sregs[CCOUNT] = env->ccount_base +
+    if (env->ccount_deterministic) {
+        return;
+    }
+
+    now = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    ccount = env->ccount_base +
         (uint32_t)((now - env->time_base) *
                    env->config->clock_freq_khz / 1000000);
+    env->ccount_time = now;
+
+    delta = ccount - env->sregs[CCOUNT];
+    if (delta >= 0) {
+        env->sregs[CCOUNT] = ccount;
+    } else {
+        /* inline count ran ahead of the clock, follow it */
+        env->ccount_base -= delta;
+    }
 }
 
 void HELPER(wsr_ccount)(CPUXtensaState *env, uint32_t v)
@@ -53,11 +80,28 @@ void HELPER(wsr_ccount)(CPUXtensaState *env, uint32_t v)
 
     HELPER(update_ccount)(env);
     env->ccount_base += v - env->sregs[CCOUNT];
+    env->sregs[CCOUNT] = v;
     for (i = 0; i < env->config->nccompare; ++i) {
         HELPER(update_ccompare)(env, i);
     }
 }
 
+/* deterministic mode: find CCOUNT value of the next CCOMPARE match */
+static void ccount_schedule(CPUXtensaState *env)
+{
+    uint32_t ccount = env->sregs[CCOUNT];
+    uint64_t next = INT32_MAX;
+    uint64_t dcc;
+    int i;
+
+    for (i = 0; i < env->config->nccompare; ++i) {
+        dcc = (uint64_t)(env->sregs[CCOMPARE + i] - ccount - 1) + 1;
+        next = MIN(next, dcc);
+    }
+    env->ccount_last = ccount;
+    env->ccount_next = ccount + next;
+}
+
 void HELPER(update_ccompare)(CPUXtensaState *env, uint32_t i)
 {
     uint64_t dcc;
@@ -65,12 +109,61 @@ void HELPER(update_ccompare)(CPUXtensaState *env, uint32_t i)
     atomic_and(&env->sregs[INTSET],
                ~(1u << env->config->timerint[i]));
     HELPER(update_ccount)(env);
-    dcc = (uint64_t)(env->sregs[CCOMPARE + i] - env->sregs[CCOUNT] - 1) + 1;
-    timer_mod(env->ccompare[i].timer,
-              env->ccount_time + (dcc * 1000000) / env->config->clock_freq_khz);
+    if (env->ccount_deterministic) {
+        ccount_schedule(env);
+    } else {
+        dcc = (uint64_t)(env->sregs[CCOMPARE + i] -
+                         env->sregs[CCOUNT] - 1) + 1;
+        timer_mod(env->ccompare[i].timer,
+                  env->ccount_time +
+                  (dcc * 1000000) / env->config->clock_freq_khz);
+    }
     env->yield_needed = 1;
 }
 
+/* deterministic mode: CCOUNT has reached ccount_next */
+void HELPER(ccount_event)(CPUXtensaState *env)
+{
+    uint32_t elapsed = env->sregs[CCOUNT] - env->ccount_last;
+    int i;
+
+    for (i = 0; i < env->config->nccompare; ++i) {
+        if (env->sregs[CCOMPARE + i] - env->ccount_last - 1 < elapsed) {
+            qemu_mutex_lock_iothread();
+            qemu_set_irq(env->irq_inputs[env->config->timerint[i]], 1);
+            qemu_mutex_unlock_iothread();
+        }
+    }
+    ccount_schedule(env);
+}
+
+/*
+ * Deterministic mode WAITI: nothing advances CCOUNT while the core is
+ * halted, so jump to the next CCOMPARE match with its interrupt enabled.
+ * Returns false if there is none.
+ */
+bool xtensa_ccount_warp(CPUXtensaState *env)
+{
+    uint32_t ccount = env->sregs[CCOUNT];
+    uint64_t next = UINT64_MAX;
+    uint64_t dcc;
+    int i;
+
+    for (i = 0; i < env->config->nccompare; ++i) {
+        if (env->sregs[INTENABLE] & (1u << env->config->timerint[i])) {
+            dcc = (uint64_t)(env->sregs[CCOMPARE + i] - ccount - 1) + 1;
+            next = MIN(next, dcc);
+        }
+    }
+    if (next == UINT64_MAX) {
+        return false;
+    }
+
+    env->sregs[CCOUNT] = ccount + next;
+    HELPER(ccount_event)(env);
+    return true;
+}
+
 /*!
  * Check vaddr accessibility/cache attributes and raise an exception if
  * specified by the ATOMCTL SR.
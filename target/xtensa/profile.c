@@ -0,0 +1,450 @@
+/*
+ * Xtensa firmware cycle accounting profiler.
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/error-report.h"
+#include "qemu/thread.h"
+#include "qemu/stats64.h"
+#include "qemu/timer.h"
+#include "cpu.h"
+#include "exec/helper-proto.h"
+
+/*
+ * Every TB gets a static cycle estimate when it is translated, the sum of
+ * its instruction estimates. An instruction costs :-
+ *
+ *  - the longest time it occupies one functional unit, from the libisa
+ *    funcUnit uses, at least 1 cycle. FLIX bundles cost their most
+ *    expensive slot.
+ *  - plus a fetch bubble of (pipe stages - 3) cycles for branches, jumps
+ *    and calls.
+ *  - plus XTENSA_PROFILE_LOAD_STALL cycles load use stall for loads.
+ *
+ * TB entry counts give the flat profile. Calls and returns are tracked on
+ * a per CPU shadow stack to count call graph edges and their inclusive
+ * cycles. Memory accesses are counted against the registered regions.
+ * MCPS is self cycles over virtual time since profiling was enabled.
+ */
+
+#define XTENSA_PROFILE_LOAD_STALL   1
+#define XTENSA_PROFILE_MAX_REGIONS  16
+#define XTENSA_PROFILE_STACK        256
+
+typedef struct XtensaProfileTB {
+    uint32_t pc;
+    uint32_t insns;
+    uint32_t cycles;
+    Stat64 count;
+} XtensaProfileTB;
+
+typedef struct XtensaProfileEdge {
+    uint32_t site;
+    uint32_t target;
+    uint64_t calls;
+    uint64_t cycles;
+} XtensaProfileEdge;
+
+typedef struct XtensaProfileFrame {
+    XtensaProfileEdge *edge;
+    uint64_t start;
+} XtensaProfileFrame;
+
+struct XtensaProfileCPU {
+    QemuSpin lock;      /* edges, against the report */
+    uint64_t cycles;
+    uint64_t mem[XTENSA_PROFILE_MAX_REGIONS + 1];
+    GHashTable *edges;
+    XtensaProfileFrame stack[XTENSA_PROFILE_STACK];
+    unsigned depth;
+};
+
+typedef struct XtensaProfileRegion {
+    char *name;
+    uint32_t base;
+    uint32_t size;
+} XtensaProfileRegion;
+
+static bool profile_enabled;
+static int64_t profile_start_ns;
+static QemuMutex profile_lock;
+static GHashTable *profile_tbs;
+static GPtrArray *profile_tb_list;
+static GPtrArray *profile_cpus;
+static XtensaProfileRegion profile_region[XTENSA_PROFILE_MAX_REGIONS];
+static unsigned profile_num_regions;
+
+void xtensa_profile_enable(void)
+{
+    qemu_mutex_init(&profile_lock);
+    profile_tbs = g_hash_table_new(g_int64_hash, g_int64_equal);
+    profile_tb_list = g_ptr_array_new();
+    profile_cpus = g_ptr_array_new();
+    profile_start_ns = qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL);
+    profile_enabled = true;
+}
+
+bool xtensa_profile_enabled(void)
+{
+    return profile_enabled;
+}
+
+void xtensa_profile_add_region(const char *name, uint32_t base, uint32_t size)
+{
+    XtensaProfileRegion *region;
+
+    if (profile_num_regions == XTENSA_PROFILE_MAX_REGIONS) {
+        warn_report("xtensa profile: too many regions, %s counted as other",
+                    name);
+        return;
+    }
+    region = profile_region + profile_num_regions++;
+    region->name = g_strdup(name);
+    region->base = base;
+    region->size = size;
+}
+
+static unsigned profile_branch_penalty(const XtensaConfig *config)
+{
+    static const XtensaConfig *last_config;
+    static unsigned penalty;
+    int stages;
+
+    /* xtensa_isa_num_pipe_stages walks all opcodes, cache it */
+    if (atomic_read(&last_config) != config) {
+        stages = xtensa_isa_num_pipe_stages(config->isa);
+        atomic_set(&penalty, stages > 3 ? stages - 3 : 0);
+        atomic_set(&last_config, config);
+    }
+    return atomic_read(&penalty);
+}
+
+unsigned xtensa_profile_opcode_cycles(const XtensaConfig *config,
+                                      xtensa_opcode opc, uint32_t op_flags)
+{
+    xtensa_isa isa = config->isa;
+    int n = xtensa_opcode_num_funcUnit_uses(isa, opc);
+    unsigned cycles = 1;
+    int i, j;
+
+    for (i = 0; i < n; ++i) {
+        xtensa_funcUnit_use *use = xtensa_opcode_funcUnit_use(isa, opc, i);
+        unsigned busy = 0;
+
+        for (j = 0; j < n; ++j) {
+            if (xtensa_opcode_funcUnit_use(isa, opc, j)->unit == use->unit) {
+                ++busy;
+            }
+        }
+        cycles = MAX(cycles, busy);
+    }
+
+    if (xtensa_opcode_is_branch(isa, opc) == 1 ||
+        xtensa_opcode_is_jump(isa, opc) == 1 ||
+        xtensa_opcode_is_call(isa, opc) == 1) {
+        cycles += profile_branch_penalty(config);
+    }
+    if (op_flags & XTENSA_OP_LOAD) {
+        cycles += XTENSA_PROFILE_LOAD_STALL;
+    }
+    return cycles;
+}
+
+/* TB descriptor for the translator, shared by all TBs of the same shape */
+void *xtensa_profile_tb(uint32_t pc, uint32_t insns, uint32_t cycles)
+{
+    uint64_t key = ((uint64_t)pc << 32) | (insns << 16) | (cycles & 0xffff);
+    XtensaProfileTB *tb;
+
+    qemu_mutex_lock(&profile_lock);
+    tb = g_hash_table_lookup(profile_tbs, &key);
+    if (tb == NULL || tb->cycles != cycles) {
+        tb = g_new0(XtensaProfileTB, 1);
+        tb->pc = pc;
+        tb->insns = insns;
+        tb->cycles = cycles;
+        stat64_init(&tb->count, 0);
+        g_hash_table_insert(profile_tbs, g_memdup(&key, sizeof(key)), tb);
+        g_ptr_array_add(profile_tb_list, tb);
+    }
+    qemu_mutex_unlock(&profile_lock);
+    return tb;
+}
+
+static struct XtensaProfileCPU *profile_cpu(CPUXtensaState *env)
+{
+    struct XtensaProfileCPU *prof = env->profile;
+
+    if (prof == NULL) {
+        prof = g_new0(struct XtensaProfileCPU, 1);
+        qemu_spin_init(&prof->lock);
+        prof->edges = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                            g_free, g_free);
+        qemu_mutex_lock(&profile_lock);
+        g_ptr_array_add(profile_cpus, prof);
+        qemu_mutex_unlock(&profile_lock);
+        env->profile = prof;
+    }
+    return prof;
+}
+
+void HELPER(profile_tb)(CPUXtensaState *env, void *p)
+{
+    XtensaProfileTB *tb = p;
+
+    stat64_add(&tb->count, 1);
+    profile_cpu(env)->cycles += tb->cycles;
+}
+
+void HELPER(profile_mem)(CPUXtensaState *env, uint32_t addr)
+{
+    struct XtensaProfileCPU *prof = profile_cpu(env);
+    unsigned i;
+
+    for (i = 0; i < profile_num_regions; ++i) {
+        if (addr - profile_region[i].base < profile_region[i].size) {
+            break;
+        }
+    }
+    prof->mem[i]++;
+}
+
+void HELPER(profile_call)(CPUXtensaState *env, uint32_t site, uint32_t target)
+{
+    struct XtensaProfileCPU *prof = profile_cpu(env);
+    uint64_t key = ((uint64_t)site << 32) | target;
+    XtensaProfileEdge *edge;
+
+    qemu_spin_lock(&prof->lock);
+    edge = g_hash_table_lookup(prof->edges, &key);
+    if (edge == NULL) {
+        edge = g_new0(XtensaProfileEdge, 1);
+        edge->site = site;
+        edge->target = target;
+        g_hash_table_insert(prof->edges, g_memdup(&key, sizeof(key)), edge);
+    }
+    edge->calls++;
+
+    /* frames deeper than the stack are counted but not timed */
+    if (prof->depth < XTENSA_PROFILE_STACK) {
+        prof->stack[prof->depth].edge = edge;
+        prof->stack[prof->depth].start = prof->cycles;
+    }
+    prof->depth++;
+    qemu_spin_unlock(&prof->lock);
+}
+
+void HELPER(profile_ret)(CPUXtensaState *env)
+{
+    struct XtensaProfileCPU *prof = profile_cpu(env);
+    XtensaProfileFrame *frame;
+
+    /* returns from code entered before profiling, or from a task switch */
+    if (prof->depth == 0) {
+        return;
+    }
+    prof->depth--;
+    if (prof->depth < XTENSA_PROFILE_STACK) {
+        frame = prof->stack + prof->depth;
+        qemu_spin_lock(&prof->lock);
+        frame->edge->cycles += prof->cycles - frame->start;
+        qemu_spin_unlock(&prof->lock);
+    }
+}
+
+typedef struct ProfileFunc {
+    const char *name;
+    uint64_t cycles;
+    uint64_t insns;
+    uint64_t calls;
+    uint64_t incl;
+} ProfileFunc;
+
+typedef struct ProfileArc {
+    char *name;
+    uint64_t calls;
+    uint64_t cycles;
+} ProfileArc;
+
+static const char *profile_symbol(XtensaProfileSymbolFn sym, void *opaque,
+                                  uint32_t addr, GStringChunk *names)
+{
+    const char *name = sym ? sym(addr, opaque) : NULL;
+    char buf[16];
+
+    if (name == NULL) {
+        snprintf(buf, sizeof(buf), "0x%08x", addr);
+        name = buf;
+    }
+    return g_string_chunk_insert_const(names, name);
+}
+
+static ProfileFunc *profile_func(GHashTable *funcs, const char *name)
+{
+    ProfileFunc *func = g_hash_table_lookup(funcs, name);
+
+    if (func == NULL) {
+        func = g_new0(ProfileFunc, 1);
+        func->name = name;
+        g_hash_table_insert(funcs, (gpointer)name, func);
+    }
+    return func;
+}
+
+static gint profile_func_cmp(gconstpointer a, gconstpointer b)
+{
+    const ProfileFunc *fa = *(ProfileFunc * const *)a;
+    const ProfileFunc *fb = *(ProfileFunc * const *)b;
+
+    if (fa->cycles != fb->cycles) {
+        return fa->cycles < fb->cycles ? 1 : -1;
+    }
+    return strcmp(fa->name, fb->name);
+}
+
+static gint profile_arc_cmp(gconstpointer a, gconstpointer b)
+{
+    const ProfileArc *pa = *(ProfileArc * const *)a;
+    const ProfileArc *pb = *(ProfileArc * const *)b;
+
+    return strcmp(pa->name, pb->name);
+}
+
+/*
+ * Write the profile. Functions are sorted by self cycles, call graph arcs
+ * by name so that two runs diff cleanly. This runs from an exit notifier,
+ * possibly while other vCPUs are still executing, so each CPU's edge table
+ * is walked under its lock. TB and memory counts may miss the last few
+ * increments.
+ */
+void xtensa_profile_report(FILE *f, XtensaProfileSymbolFn sym, void *opaque)
+{
+    GStringChunk *names = g_string_chunk_new(4096);
+    GHashTable *funcs = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                              NULL, g_free);
+    GHashTable *arcs = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                             NULL, g_free);
+    GPtrArray *sorted;
+    GHashTableIter iter;
+    gpointer value;
+    uint64_t total = 0, mem[XTENSA_PROFILE_MAX_REGIONS + 1] = {};
+    int64_t elapsed_us;
+    unsigned i, j;
+
+    if (!profile_enabled) {
+        return;
+    }
+    qemu_mutex_lock(&profile_lock);
+    elapsed_us = (qemu_clock_get_ns(QEMU_CLOCK_VIRTUAL) -
+                  profile_start_ns) / SCALE_US;
+
+    /* flat profile from TB counts */
+    for (i = 0; i < profile_tb_list->len; ++i) {
+        XtensaProfileTB *tb = g_ptr_array_index(profile_tb_list, i);
+        uint64_t count = stat64_get(&tb->count);
+        ProfileFunc *func;
+
+        if (count == 0) {
+            continue;
+        }
+        func = profile_func(funcs,
+                            profile_symbol(sym, opaque, tb->pc, names));
+        func->cycles += count * tb->cycles;
+        func->insns += count * tb->insns;
+        total += count * tb->cycles;
+    }
+
+    /* call graph, merged over CPUs and call sites */
+    for (i = 0; i < profile_cpus->len; ++i) {
+        struct XtensaProfileCPU *prof = g_ptr_array_index(profile_cpus, i);
+
+        for (j = 0; j <= profile_num_regions; ++j) {
+            mem[j] += atomic_read__nocheck(&prof->mem[j]);
+        }
+
+        qemu_spin_lock(&prof->lock);
+        g_hash_table_iter_init(&iter, prof->edges);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            XtensaProfileEdge *edge = value;
+            const char *caller = profile_symbol(sym, opaque, edge->site,
+                                                names);
+            const char *callee = profile_symbol(sym, opaque, edge->target,
+                                                names);
+            char *key = g_strdup_printf("%s -> %s", caller, callee);
+            ProfileArc *arc = g_hash_table_lookup(arcs, key);
+            ProfileFunc *func = profile_func(funcs, callee);
+
+            if (arc == NULL) {
+                arc = g_new0(ProfileArc, 1);
+                arc->name = key;
+                g_hash_table_insert(arcs, key, arc);
+            } else {
+                g_free(key);
+            }
+            arc->calls += edge->calls;
+            arc->cycles += edge->cycles;
+            func->calls += edge->calls;
+            func->incl += edge->cycles;
+        }
+        qemu_spin_unlock(&prof->lock);
+    }
+
+    fprintf(f, "# xtensa firmware profile, estimated cycles\n");
+    fprintf(f, "total %" PRIu64 "\n", total);
+    fprintf(f, "elapsed_us %" PRId64 "\n\n", elapsed_us);
+
+    fprintf(f, "flat\n");
+    fprintf(f, "#%15s %7s %9s %15s %10s %15s  %s\n", "self", "%", "mcps",
+            "insns", "calls", "inclusive", "function");
+    sorted = g_ptr_array_new();
+    g_hash_table_iter_init(&iter, funcs);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(sorted, value);
+    }
+    g_ptr_array_sort(sorted, profile_func_cmp);
+    for (i = 0; i < sorted->len; ++i) {
+        ProfileFunc *func = g_ptr_array_index(sorted, i);
+
+        fprintf(f, "%16" PRIu64 " %7.3f %9.3f %15" PRIu64 " %10" PRIu64
+                " %15" PRIu64 "  %s\n",
+                func->cycles, total ? 100.0 * func->cycles / total : 0.0,
+                elapsed_us > 0 ? (double)func->cycles / elapsed_us : 0.0,
+                func->insns, func->calls, func->incl, func->name);
+    }
+    g_ptr_array_free(sorted, true);
+
+    fprintf(f, "\ncallgraph\n");
+    fprintf(f, "#%9s %15s  %s\n", "calls", "inclusive", "caller -> callee");
+    sorted = g_ptr_array_new();
+    g_hash_table_iter_init(&iter, arcs);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        g_ptr_array_add(sorted, value);
+    }
+    g_ptr_array_sort(sorted, profile_arc_cmp);
+    for (i = 0; i < sorted->len; ++i) {
+        ProfileArc *arc = g_ptr_array_index(sorted, i);
+
+        fprintf(f, "%10" PRIu64 " %15" PRIu64 "  %s\n",
+                arc->calls, arc->cycles, arc->name);
+    }
+    g_ptr_array_free(sorted, true);
+
+    fprintf(f, "\nmemory\n");
+    fprintf(f, "#%15s  %s\n", "accesses", "region");
+    for (i = 0; i < profile_num_regions; ++i) {
+        fprintf(f, "%16" PRIu64 "  %s\n", mem[i], profile_region[i].name);
+    }
+    fprintf(f, "%16" PRIu64 "  %s\n", mem[i], "other");
+
+    qemu_mutex_unlock(&profile_lock);
+    g_hash_table_destroy(arcs);
+    g_hash_table_destroy(funcs);
+    g_string_chunk_free(names);
+}
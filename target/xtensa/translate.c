@@ -34,8 +34,12 @@
 #include "exec/exec-all.h"
 #include "disas/disas.h"
 #include "tcg-op.h"
+#include "tcg-op-gvec.h"
 #include "qemu/log.h"
 #include "qemu/qemu-print.h"
+#include "qemu/qht.h"
+#include "qemu/stats64.h"
+#include "qemu/xxhash.h"
 #include "exec/cpu_ldst.h"
 #include "hw/semihosting/semihost.h"
 #include "exec/translator.h"
@@ -62,6 +66,7 @@ struct DisasContext {
     TCGv_i32 sar_m32;
 
     unsigned window;
+    unsigned windowbase;
     unsigned callinc;
     bool cwoe;
 
@@ -69,6 +74,19 @@ struct DisasContext {
     bool icount;
     TCGv_i32 next_icount;
 
+    uint32_t ccount_cpi;
+    bool ccount_deterministic;
+    TCGOp *ccount_insn;
+
+    bool profile;
+    uint32_t profile_cycles;
+    TCGOp *profile_insn;
+
+    bool trace;
+    bool trace_jump;
+    uint32_t trace_dest;
+    TCGLabel *trace_loop;
+
     unsigned cpenable;
 
     uint32_t op_flags;
@@ -83,6 +101,8 @@ static TCGv_i32 cpu_MR[4];
 static TCGv_i32 cpu_BR[16];
 static TCGv_i32 cpu_BR4[4];
 static TCGv_i32 cpu_BR8[2];
+static TCGv_i64 cpu_AED[16];
+static TCGv_i64 cpu_AE_VALIGN[4];
 static TCGv_i32 cpu_SR[256];
 static TCGv_i32 cpu_UR[256];
 static TCGv_i32 cpu_windowbase_next;
@@ -96,6 +116,8 @@ static GHashTable *xtensa_regfile_table;
 static char *sr_name[256];
 static char *ur_name[256];
 
+static void decode_cache_init(void);
+
 void xtensa_collect_sr_names(const XtensaConfig *config)
 {
     xtensa_isa isa = config->isa;
@@ -151,6 +173,15 @@ void xtensa_translate_init(void)
         "b8", "b9", "b10", "b11",
         "b12", "b13", "b14", "b15",
     };
+    static const char * const aedregnames[] = {
+        "aed0", "aed1", "aed2", "aed3",
+        "aed4", "aed5", "aed6", "aed7",
+        "aed8", "aed9", "aed10", "aed11",
+        "aed12", "aed13", "aed14", "aed15",
+    };
+    static const char * const valignregnames[] = {
+        "u0", "u1", "u2", "u3",
+    };
     int i;
 
     cpu_pc = tcg_global_mem_new_i32(cpu_env,
@@ -195,6 +226,19 @@ void xtensa_translate_init(void)
         }
     }
 
+    for (i = 0; i < 16; i++) {
+        cpu_AED[i] = tcg_global_mem_new_i64(cpu_env,
+                                            offsetof(CPUXtensaState, aed[i]),
+                                            aedregnames[i]);
+    }
+
+    for (i = 0; i < 4; i++) {
+        cpu_AE_VALIGN[i] = tcg_global_mem_new_i64(cpu_env,
+                                                  offsetof(CPUXtensaState,
+                                                           ae_valign[i]),
+                                                  valignregnames[i]);
+    }
+
     for (i = 0; i < 256; ++i) {
         if (sr_name[i]) {
             cpu_SR[i] = tcg_global_mem_new_i32(cpu_env,
@@ -225,6 +269,8 @@ void xtensa_translate_init(void)
         tcg_global_mem_new_i32(cpu_env,
                                offsetof(CPUXtensaState, exclusive_val),
                                "exclusive_val");
+
+    decode_cache_init();
 }
 
 void **xtensa_get_regfile_by_name(const char *name)
@@ -243,6 +289,10 @@ void **xtensa_get_regfile_by_name(const char *name)
                             (void *)"BR4", (void *)cpu_BR4);
         g_hash_table_insert(xtensa_regfile_table,
                             (void *)"BR8", (void *)cpu_BR8);
+        g_hash_table_insert(xtensa_regfile_table,
+                            (void *)"AE_DR", (void *)cpu_AED);
+        g_hash_table_insert(xtensa_regfile_table,
+                            (void *)"AE_VALIGN", (void *)cpu_AE_VALIGN);
     }
     return (void **)g_hash_table_lookup(xtensa_regfile_table, (void *)name);
 }
@@ -374,6 +424,12 @@ static void gen_jump_slot(DisasContext *dc, TCGv dest, int slot)
             tcg_gen_goto_tb(slot);
             tcg_gen_exit_tb(dc->base.tb, slot);
         } else {
+#ifndef CONFIG_USER_ONLY
+            /* back to the main loop, catch up with the virtual clock */
+            if (dc->ccount_cpi && !dc->ccount_deterministic) {
+                gen_helper_update_ccount(cpu_env);
+            }
+#endif
             tcg_gen_exit_tb(NULL, 0);
         }
     }
@@ -394,18 +450,93 @@ static int adjust_jump_slot(DisasContext *dc, uint32_t dest, int slot)
     }
 }
 
+/*
+ * A hot trace jumping back to its own start loops inside the TB, without
+ * going through goto_tb and the TB prologue. It leaves through the usual
+ * jump when an exit is requested or the TB has been invalidated.
+ */
+static void gen_trace_loop(DisasContext *dc)
+{
+    TCGv_ptr tb = tcg_const_ptr(dc->base.tb);
+    TCGv_i32 tmp = tcg_temp_new_i32();
+    TCGLabel *label = gen_new_label();
+
+    tcg_gen_ld_i32(tmp, tb, offsetof(TranslationBlock, cflags));
+    tcg_gen_andi_i32(tmp, tmp, CF_INVALID);
+    tcg_gen_brcondi_i32(TCG_COND_NE, tmp, 0, label);
+    tcg_gen_ld_i32(tmp, cpu_env,
+                   offsetof(ArchCPU, neg.icount_decr.u32) -
+                   offsetof(ArchCPU, env));
+    tcg_gen_brcondi_i32(TCG_COND_GE, tmp, 0, dc->trace_loop);
+    gen_set_label(label);
+
+    tcg_temp_free(tmp);
+    tcg_temp_free_ptr(tb);
+}
+
 static void gen_jumpi(DisasContext *dc, uint32_t dest, int slot)
 {
-    TCGv_i32 tmp = tcg_const_i32(dest);
+    TCGv_i32 tmp;
+
+    if (dc->trace && dest == dc->base.pc_first && slot >= 0 &&
+        !(dc->op_flags & XTENSA_OP_POSTPROCESS)) {
+        gen_trace_loop(dc);
+    }
+
+    tmp = tcg_const_i32(dest);
     gen_jump_slot(dc, tmp, adjust_jump_slot(dc, dest, slot));
     tcg_temp_free(tmp);
 }
 
+/*
+ * In a hot trace continue translation at the target of a direct jump that
+ * follows in the same page, instead of ending the TB. The TB then still
+ * covers [pc_first, pc_next).
+ */
+static void gen_jumpi_trace(DisasContext *dc, uint32_t dest)
+{
+    if (dc->trace && !(dc->op_flags & XTENSA_OP_POSTPROCESS) &&
+        dest >= dc->base.pc_next &&
+        ((dc->base.pc_first ^ dest) & TARGET_PAGE_MASK) == 0 &&
+        dc->base.trace_jumps < tb_hot_trace_jumps) {
+        dc->trace_jump = true;
+        dc->trace_dest = dest;
+    } else {
+        gen_jumpi(dc, dest, 0);
+    }
+}
+
+static void gen_profile_call(DisasContext *dc, TCGv_i32 dest)
+{
+    if (dc->profile) {
+        TCGv_i32 site = tcg_const_i32(dc->pc);
+
+        gen_helper_profile_call(cpu_env, site, dest);
+        tcg_temp_free(site);
+    }
+}
+
+static void gen_profile_ret(DisasContext *dc)
+{
+    if (dc->profile) {
+        gen_helper_profile_ret(cpu_env);
+    }
+}
+
+static void gen_profile_mem(DisasContext *dc, TCGv_i32 addr)
+{
+    if (dc->profile) {
+        gen_helper_profile_mem(cpu_env, addr);
+    }
+}
+
 static void gen_callw_slot(DisasContext *dc, int callinc, TCGv_i32 dest,
         int slot)
 {
     TCGv_i32 tcallinc = tcg_const_i32(callinc);
 
+    gen_profile_call(dc, dest);
+
     tcg_gen_deposit_i32(cpu_SR[PS], cpu_SR[PS],
             tcallinc, PS_CALLINC_SHIFT, PS_CALLINC_LEN);
     tcg_temp_free(tcallinc);
@@ -527,6 +658,7 @@ static void gen_load_store_alignment(DisasContext *dc, int shift,
         gen_set_label(label);
         tcg_temp_free(tmp);
     }
+    gen_profile_mem(dc, addr);
 }
 
 #ifndef CONFIG_USER_ONLY
@@ -559,6 +691,83 @@ static bool gen_window_check(DisasContext *dc, uint32_t mask)
     return true;
 }
 
+/*
+ * Rotate the register window by delta windows. WINDOWBASE is known from
+ * the TB flags, so only the registers leaving the window are stored to
+ * phys_regs and only the ones entering it are loaded, the rest are moved
+ * between cpu_R.
+ */
+static void gen_rotate_window(DisasContext *dc, int delta)
+{
+    unsigned nareg = dc->config->nareg;
+    unsigned old = dc->windowbase * 4;
+    unsigned new = ((dc->windowbase + delta) & (nareg / 4 - 1)) * 4;
+    int n = abs(delta) * 4;
+    int i;
+
+    if (delta > 0) {
+        for (i = 0; i < n; ++i) {
+            tcg_gen_st_i32(cpu_R[i], cpu_env,
+                           offsetof(CPUXtensaState,
+                                    phys_regs[(old + i) % nareg]));
+        }
+        for (i = 0; i < 16 - n; ++i) {
+            tcg_gen_mov_i32(cpu_R[i], cpu_R[i + n]);
+        }
+        for (i = 16 - n; i < 16; ++i) {
+            tcg_gen_ld_i32(cpu_R[i], cpu_env,
+                           offsetof(CPUXtensaState,
+                                    phys_regs[(new + i) % nareg]));
+        }
+    } else if (delta < 0) {
+        for (i = 16 - n; i < 16; ++i) {
+            tcg_gen_st_i32(cpu_R[i], cpu_env,
+                           offsetof(CPUXtensaState,
+                                    phys_regs[(old + i) % nareg]));
+        }
+        for (i = 15; i >= n; --i) {
+            tcg_gen_mov_i32(cpu_R[i], cpu_R[i - n]);
+        }
+        for (i = 0; i < n; ++i) {
+            tcg_gen_ld_i32(cpu_R[i], cpu_env,
+                           offsetof(CPUXtensaState,
+                                    phys_regs[(new + i) % nareg]));
+        }
+    }
+    tcg_gen_movi_i32(cpu_SR[WINDOW_BASE], new / 4);
+}
+
+/*
+ * RETW is legal and does not underflow when the first WINDOWSTART bit
+ * below WINDOWBASE is the one of the caller window, a0[31:30] windows
+ * down. Only call the helpers, that raise the exceptions, otherwise.
+ */
+static void gen_retw_check(DisasContext *dc)
+{
+    unsigned nw = dc->config->nareg / 4;
+    TCGv_i32 ws = tcg_temp_new_i32();
+    TCGv_i32 n = tcg_temp_new_i32();
+    TCGLabel *label = gen_new_label();
+    TCGv_i32 pc;
+
+    /* WINDOWSTART bits windowbase - 3 .. windowbase - 1 */
+    tcg_gen_shli_i32(ws, cpu_SR[WINDOW_START], nw);
+    tcg_gen_or_i32(ws, ws, cpu_SR[WINDOW_START]);
+    tcg_gen_extract_i32(ws, ws, dc->windowbase + nw - 3, 3);
+    tcg_gen_extract_i32(n, cpu_R[0], 30, 2);
+    tcg_gen_subfi_i32(n, 3, n);
+    tcg_gen_shr_i32(ws, ws, n);
+    tcg_gen_brcondi_i32(TCG_COND_EQ, ws, 1, label);
+    tcg_temp_free(n);
+    tcg_temp_free(ws);
+
+    pc = tcg_const_i32(dc->pc);
+    gen_helper_test_ill_retw(cpu_env, pc);
+    gen_helper_test_underflow_retw(cpu_env, pc);
+    tcg_temp_free(pc);
+    gen_set_label(label);
+}
+
 static TCGv_i32 gen_mac16_m(TCGv_i32 v, bool hi, bool is_unsigned)
 {
     TCGv_i32 m = tcg_temp_new_i32();
@@ -622,6 +831,10 @@ struct opcode_arg_info {
 
 struct slot_prop {
     XtensaOpcodeOps *ops;
+    xtensa_opcode opc;
+    /* visible PC-relative operand, imm is relocated at translation time */
+    int pcrel_arg;
+    int pcrel_opnd;
     OpcodeArg arg[MAX_OPCODE_ARGS];
     struct opcode_arg_info in[MAX_OPCODE_ARGS];
     struct opcode_arg_info out[MAX_OPCODE_ARGS];
@@ -856,35 +1069,83 @@ static int arg_copy_compare(const void *a, const void *b)
         -1 : (pa->resource > pb->resource ? 1 : 0);
 }
 
-static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
+/*
+ * Decoded instruction cache.
+ *
+ * Firmware runs the same code over and over and retranslates it every time
+ * a TB is flushed or invalidated, so libisa decoding of the instruction
+ * bytes shows up high in translation profiles. Decoded instructions are
+ * cached keyed by the core config and the instruction bytes. Entries hold
+ * everything that does not depend on the PC or on DisasContext state, i.e.
+ * the per slot opcode, ops, operands and FLIX resources. PC-relative
+ * operands are relocated when the entry is used.
+ *
+ * Entries are never freed, the cache stops growing at
+ * XTENSA_DECODE_CACHE_MAX entries.
+ */
+#define XTENSA_DECODE_CACHE_MAX 16384
+
+typedef struct XtensaDecodedInsn {
+    const XtensaConfig *config;
+    unsigned len;
+    unsigned char b[MAX_INSN_LENGTH];
+    unsigned slots;
+    uint32_t windowed_register;
+    struct slot_prop slot_prop[];
+} XtensaDecodedInsn;
+
+static struct qht decode_cache;
+static unsigned decode_cache_entries;
+static Stat64 decode_cache_hits;
+static Stat64 decode_cache_misses;
+
+static uint32_t decode_cache_hash(const XtensaConfig *config,
+                                  const unsigned char *b, unsigned len)
+{
+    uint64_t w[2] = {0, 0};
+
+    memcpy(w, b, MIN(len, sizeof(w)));
+    return qemu_xxhash7(w[0], w[1], (uintptr_t)config, len,
+                        (uint64_t)(uintptr_t)config >> 32);
+}
+
+static bool decode_cache_cmp(const void *ap, const void *bp)
+{
+    const XtensaDecodedInsn *a = ap;
+    const XtensaDecodedInsn *b = bp;
+
+    return a->config == b->config &&
+        a->len == b->len &&
+        memcmp(a->b, b->b, a->len) == 0;
+}
+
+static void decode_cache_init(void)
+{
+    qht_init(&decode_cache, decode_cache_cmp, 1 << 12, QHT_MODE_AUTO_RESIZE);
+    stat64_init(&decode_cache_hits, 0);
+    stat64_init(&decode_cache_misses, 0);
+}
+
+void xtensa_decode_cache_stats(uint64_t *hits, uint64_t *misses,
+                               unsigned *entries)
+{
+    *hits = stat64_get(&decode_cache_hits);
+    *misses = stat64_get(&decode_cache_misses);
+    *entries = atomic_read(&decode_cache_entries);
+}
+
+/*
+ * Decode instruction bytes with libisa. Returns NULL and raises
+ * illegal instruction exception if the instruction cannot be decoded.
+ */
+static XtensaDecodedInsn *decode_insn(DisasContext *dc,
+                                      const unsigned char *b, unsigned len)
 {
     xtensa_isa isa = dc->config->isa;
-    unsigned char b[MAX_INSN_LENGTH] = {translator_ldub(env, dc->pc)};
-    unsigned len = xtensa_op0_insn_len(dc, b[0]);
+    XtensaDecodedInsn *insn;
     xtensa_format fmt;
     int slot, slots;
-    unsigned i;
-    uint32_t op_flags = 0;
-    struct slot_prop slot_prop[MAX_INSN_SLOTS];
-    struct slot_prop *ordered[MAX_INSN_SLOTS];
-    struct opcode_arg_copy arg_copy[MAX_INSN_SLOTS * MAX_OPCODE_ARGS];
-    unsigned n_arg_copy = 0;
-    uint32_t debug_cause = 0;
-    uint32_t windowed_register = 0;
-    uint32_t coprocessor = 0;
-
-    if (len == XTENSA_UNDEFINED) {
-        qemu_log_mask(LOG_GUEST_ERROR,
-                      "unknown instruction length (pc = %08x)\n",
-                      dc->pc);
-        gen_exception_cause(dc, ILLEGAL_INSTRUCTION_CAUSE);
-        return;
-    }
 
-    dc->base.pc_next = dc->pc + len;
-    for (i = 1; i < len; ++i) {
-        b[i] = translator_ldub(env, dc->pc + i);
-    }
     xtensa_insnbuf_from_chars(isa, dc->insnbuf, b, len);
     fmt = xtensa_format_decode(isa, dc->insnbuf);
     if (fmt == XTENSA_UNDEFINED) {
@@ -892,13 +1153,22 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
                       "unrecognized instruction format (pc = %08x)\n",
                       dc->pc);
         gen_exception_cause(dc, ILLEGAL_INSTRUCTION_CAUSE);
-        return;
+        return NULL;
     }
     slots = xtensa_format_num_slots(isa, fmt);
+
+    insn = g_malloc(sizeof(*insn) + slots * sizeof(insn->slot_prop[0]));
+    insn->config = dc->config;
+    insn->len = len;
+    memcpy(insn->b, b, len);
+    insn->slots = slots;
+    insn->windowed_register = 0;
+
     for (slot = 0; slot < slots; ++slot) {
+        struct slot_prop *prop = insn->slot_prop + slot;
         xtensa_opcode opc;
         int opnd, vopnd, opnds;
-        OpcodeArg *arg = slot_prop[slot].arg;
+        OpcodeArg *arg = prop->arg;
         XtensaOpcodeOps *ops;
 
         xtensa_format_get_slot(isa, fmt, slot, dc->insnbuf, dc->slotbuf);
@@ -908,17 +1178,23 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
                           "unrecognized opcode in slot %d (pc = %08x)\n",
                           slot, dc->pc);
             gen_exception_cause(dc, ILLEGAL_INSTRUCTION_CAUSE);
-            return;
+            g_free(insn);
+            return NULL;
         }
         opnds = xtensa_opcode_num_operands(isa, opc);
+        prop->opc = opc;
+        prop->pcrel_arg = -1;
+        prop->pcrel_opnd = -1;
 
         for (opnd = vopnd = 0; opnd < opnds; ++opnd) {
             void **register_file = NULL;
+            unsigned num_bits = 32;
 
             if (xtensa_operand_is_register(isa, opc, opnd)) {
                 xtensa_regfile rf = xtensa_operand_regfile(isa, opc, opnd);
 
                 register_file = dc->config->regfile[rf];
+                num_bits = xtensa_regfile_num_bits(isa, rf);
 
                 if (rf == dc->config->a_regfile) {
                     uint32_t v;
@@ -926,7 +1202,7 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
                     xtensa_operand_get_field(isa, opc, opnd, fmt, slot,
                                              dc->slotbuf, &v);
                     xtensa_operand_decode(isa, opc, opnd, &v);
-                    windowed_register |= 1u << v;
+                    insn->windowed_register |= 1u << v;
                 }
             }
             if (xtensa_operand_is_visible(isa, opc, opnd)) {
@@ -937,9 +1213,12 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
                 xtensa_operand_decode(isa, opc, opnd, &v);
                 arg[vopnd].raw_imm = v;
                 if (xtensa_operand_is_PCrelative(isa, opc, opnd)) {
-                    xtensa_operand_undo_reloc(isa, opc, opnd, &v, dc->pc);
+                    assert(prop->pcrel_arg < 0);
+                    prop->pcrel_arg = vopnd;
+                    prop->pcrel_opnd = opnd;
                 }
                 arg[vopnd].imm = v;
+                arg[vopnd].num_bits = num_bits;
                 if (register_file) {
                     arg[vopnd].in = register_file[v];
                     arg[vopnd].out = register_file[v];
@@ -948,35 +1227,12 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
             }
         }
         ops = dc->config->opcode_ops[opc];
-        slot_prop[slot].ops = ops;
-
-        if (ops) {
-            op_flags |= ops->op_flags;
-        } else {
-            qemu_log_mask(LOG_UNIMP,
-                          "unimplemented opcode '%s' in slot %d (pc = %08x)\n",
-                          xtensa_opcode_name(isa, opc), slot, dc->pc);
-            op_flags |= XTENSA_OP_ILL;
-        }
-        if ((op_flags & XTENSA_OP_ILL) ||
-            (ops && ops->test_ill && ops->test_ill(dc, arg, ops->par))) {
-            gen_exception_cause(dc, ILLEGAL_INSTRUCTION_CAUSE);
-            return;
-        }
-        if (ops->op_flags & XTENSA_OP_DEBUG_BREAK) {
-            debug_cause |= ops->par[0];
-        }
-        if (ops->test_overflow) {
-            windowed_register |= ops->test_overflow(dc, arg, ops->par);
-        }
-        coprocessor |= ops->coprocessor;
+        prop->ops = ops;
 
         if (slots > 1) {
-            slot_prop[slot].n_in = 0;
-            slot_prop[slot].n_out = 0;
-            slot_prop[slot].op_flags = ops->op_flags & XTENSA_OP_LOAD_STORE;
-
-            opnds = xtensa_opcode_num_operands(isa, opc);
+            prop->n_in = 0;
+            prop->n_out = 0;
+            prop->op_flags = ops ? ops->op_flags & XTENSA_OP_LOAD_STORE : 0;
 
             for (opnd = vopnd = 0; opnd < opnds; ++opnd) {
                 bool visible = xtensa_operand_is_visible(isa, opc, opnd);
@@ -988,7 +1244,7 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
                     xtensa_operand_get_field(isa, opc, opnd, fmt, slot,
                                              dc->slotbuf, &v);
                     xtensa_operand_decode(isa, opc, opnd, &v);
-                    opcode_add_resource(slot_prop + slot,
+                    opcode_add_resource(prop,
                                         encode_resource(RES_REGFILE, rf, v),
                                         xtensa_operand_inout(isa, opc, opnd),
                                         visible ? vopnd : -1);
@@ -1003,7 +1259,7 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
             for (opnd = 0; opnd < opnds; ++opnd) {
                 xtensa_state state = xtensa_stateOperand_state(isa, opc, opnd);
 
-                opcode_add_resource(slot_prop + slot,
+                opcode_add_resource(prop,
                                     encode_resource(RES_STATE, 0, state),
                                     xtensa_stateOperand_inout(isa, opc, opnd),
                                     -1);
@@ -1012,14 +1268,138 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
                 xtensa_opcode_is_jump(isa, opc) ||
                 xtensa_opcode_is_loop(isa, opc) ||
                 xtensa_opcode_is_call(isa, opc)) {
-                slot_prop[slot].op_flags |= XTENSA_OP_CONTROL_FLOW;
+                prop->op_flags |= XTENSA_OP_CONTROL_FLOW;
             }
 
-            qsort(slot_prop[slot].in, slot_prop[slot].n_in,
-                  sizeof(slot_prop[slot].in[0]), resource_compare);
-            qsort(slot_prop[slot].out, slot_prop[slot].n_out,
-                  sizeof(slot_prop[slot].out[0]), resource_compare);
+            qsort(prop->in, prop->n_in,
+                  sizeof(prop->in[0]), resource_compare);
+            qsort(prop->out, prop->n_out,
+                  sizeof(prop->out[0]), resource_compare);
+        }
+    }
+    return insn;
+}
+
+static void copy_decoded_insn(const XtensaDecodedInsn *insn,
+                              struct slot_prop *slot_prop,
+                              uint32_t *windowed_register)
+{
+    memcpy(slot_prop, insn->slot_prop, insn->slots * sizeof(slot_prop[0]));
+    *windowed_register = insn->windowed_register;
+}
+
+/*
+ * Look the instruction up in the decode cache, decode and insert it on
+ * miss. Fills slot_prop and returns the number of slots, or 0 if the
+ * instruction cannot be decoded.
+ */
+static int get_decoded_insn(DisasContext *dc,
+                            const unsigned char *b, unsigned len,
+                            struct slot_prop *slot_prop,
+                            uint32_t *windowed_register)
+{
+    XtensaDecodedInsn key, *insn;
+    void *existing = NULL;
+    uint32_t hash = decode_cache_hash(dc->config, b, len);
+    int slots;
+
+    key.config = dc->config;
+    key.len = len;
+    memcpy(key.b, b, len);
+
+    insn = qht_lookup(&decode_cache, &key, hash);
+    if (insn) {
+        stat64_add(&decode_cache_hits, 1);
+        copy_decoded_insn(insn, slot_prop, windowed_register);
+        return insn->slots;
+    }
+
+    stat64_add(&decode_cache_misses, 1);
+    insn = decode_insn(dc, b, len);
+    if (!insn) {
+        return 0;
+    }
+    copy_decoded_insn(insn, slot_prop, windowed_register);
+    slots = insn->slots;
+
+    /* another vCPU thread may have inserted it meanwhile */
+    if (atomic_read(&decode_cache_entries) < XTENSA_DECODE_CACHE_MAX &&
+        qht_insert(&decode_cache, insn, hash, &existing)) {
+        atomic_inc(&decode_cache_entries);
+    } else {
+        g_free(insn);
+    }
+    return slots;
+}
+
+static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
+{
+    xtensa_isa isa = dc->config->isa;
+    unsigned char b[MAX_INSN_LENGTH] = {translator_ldub(env, dc->pc)};
+    unsigned len = xtensa_op0_insn_len(dc, b[0]);
+    int slot, slots;
+    unsigned i;
+    uint32_t op_flags = 0;
+    struct slot_prop slot_prop[MAX_INSN_SLOTS];
+    struct slot_prop *ordered[MAX_INSN_SLOTS];
+    struct opcode_arg_copy arg_copy[MAX_INSN_SLOTS * MAX_OPCODE_ARGS];
+    unsigned n_arg_copy = 0;
+    uint32_t debug_cause = 0;
+    uint32_t windowed_register = 0;
+    uint32_t coprocessor = 0;
+
+    if (len == XTENSA_UNDEFINED) {
+        qemu_log_mask(LOG_GUEST_ERROR,
+                      "unknown instruction length (pc = %08x)\n",
+                      dc->pc);
+        gen_exception_cause(dc, ILLEGAL_INSTRUCTION_CAUSE);
+        return;
+    }
+
+    dc->base.pc_next = dc->pc + len;
+    for (i = 1; i < len; ++i) {
+        b[i] = translator_ldub(env, dc->pc + i);
+    }
+    slots = get_decoded_insn(dc, b, len, slot_prop, &windowed_register);
+    if (!slots) {
+        return;
+    }
+
+    for (slot = 0; slot < slots; ++slot) {
+        OpcodeArg *arg = slot_prop[slot].arg;
+        XtensaOpcodeOps *ops = slot_prop[slot].ops;
+        int pcrel_arg = slot_prop[slot].pcrel_arg;
+
+        if (pcrel_arg >= 0) {
+            uint32_t v = arg[pcrel_arg].imm;
+
+            xtensa_operand_undo_reloc(isa, slot_prop[slot].opc,
+                                      slot_prop[slot].pcrel_opnd,
+                                      &v, dc->pc);
+            arg[pcrel_arg].imm = v;
+        }
+
+        if (ops) {
+            op_flags |= ops->op_flags;
+        } else {
+            qemu_log_mask(LOG_UNIMP,
+                          "unimplemented opcode '%s' in slot %d (pc = %08x)\n",
+                          xtensa_opcode_name(isa, slot_prop[slot].opc),
+                          slot, dc->pc);
+            op_flags |= XTENSA_OP_ILL;
+        }
+        if ((op_flags & XTENSA_OP_ILL) ||
+            (ops && ops->test_ill && ops->test_ill(dc, arg, ops->par))) {
+            gen_exception_cause(dc, ILLEGAL_INSTRUCTION_CAUSE);
+            return;
+        }
+        if (ops->op_flags & XTENSA_OP_DEBUG_BREAK) {
+            debug_cause |= ops->par[0];
+        }
+        if (ops->test_overflow) {
+            windowed_register |= ops->test_overflow(dc, arg, ops->par);
         }
+        coprocessor |= ops->coprocessor;
     }
 
     if (slots > 1) {
@@ -1034,6 +1414,20 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
         ordered[0] = slot_prop + 0;
     }
 
+    if (dc->profile) {
+        uint32_t cycles = 0;
+
+        /* FLIX slots issue together, the bundle costs its slowest slot */
+        for (slot = 0; slot < slots; ++slot) {
+            struct slot_prop *prop = slot_prop + slot;
+
+            cycles = MAX(cycles,
+                         xtensa_profile_opcode_cycles(dc->config, prop->opc,
+                                                      prop->ops->op_flags));
+        }
+        dc->profile_cycles += cycles;
+    }
+
     if ((op_flags & XTENSA_OP_PRIVILEGED) &&
         !gen_check_privilege(dc)) {
         return;
@@ -1054,10 +1448,7 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
     }
 
     if (op_flags & XTENSA_OP_UNDERFLOW) {
-        TCGv_i32 tmp = tcg_const_i32(dc->pc);
-
-        gen_helper_test_underflow_retw(cpu_env, tmp);
-        tcg_temp_free(tmp);
+        gen_retw_check(dc);
     }
 
     if (op_flags & XTENSA_OP_ALLOCA) {
@@ -1080,8 +1471,13 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
         for (i = j = 0; i < n_arg_copy; ++i) {
             if (i == 0 || arg_copy[i].resource != resource) {
                 resource = arg_copy[i].resource;
-                temp = tcg_temp_local_new();
-                tcg_gen_mov_i32(temp, arg_copy[i].arg->in);
+                if (arg_copy[i].arg->num_bits <= 32) {
+                    temp = tcg_temp_local_new_i32();
+                    tcg_gen_mov_i32(temp, arg_copy[i].arg->in);
+                } else {
+                    temp = tcg_temp_local_new_i64();
+                    tcg_gen_mov_i64(temp, arg_copy[i].arg->in);
+                }
                 arg_copy[i].temp = temp;
 
                 if (i != j) {
@@ -1112,13 +1508,21 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
     }
 
     for (i = 0; i < n_arg_copy; ++i) {
-        tcg_temp_free(arg_copy[i].temp);
+        if (arg_copy[i].arg->num_bits <= 32) {
+            tcg_temp_free_i32(arg_copy[i].temp);
+        } else {
+            tcg_temp_free_i64(arg_copy[i].temp);
+        }
     }
 
     if (dc->base.is_jmp == DISAS_NEXT) {
         gen_postprocess(dc, 0);
         dc->op_flags = 0;
-        if (op_flags & XTENSA_OP_EXIT_TB_M1) {
+        if (dc->trace_jump) {
+            /* a taken jump does not end a zero overhead loop */
+            dc->base.pc_next = dc->trace_dest;
+            dc->base.trace_jumps++;
+        } else if (op_flags & XTENSA_OP_EXIT_TB_M1) {
             /* Change in mmu index, memory mapping or tb->flags; exit tb */
             gen_jumpi_check_loop_end(dc, -1);
         } else if (op_flags & XTENSA_OP_EXIT_TB_0) {
@@ -1127,6 +1531,7 @@ static void disas_xtensa_insn(CPUXtensaState *env, DisasContext *dc)
             gen_check_loop_end(dc, 0);
         }
     }
+    dc->trace_jump = false;
     dc->pc = dc->base.pc_next;
 }
 
@@ -1171,8 +1576,26 @@ static void xtensa_tr_init_disas_context(DisasContextBase *dcbase,
     dc->window = ((tb_flags & XTENSA_TBFLAG_WINDOW_MASK) >>
                  XTENSA_TBFLAG_WINDOW_SHIFT);
     dc->cwoe = tb_flags & XTENSA_TBFLAG_CWOE;
+    dc->windowbase = ((tb_flags & XTENSA_TBFLAG_WINDOWBASE_MASK) >>
+                      XTENSA_TBFLAG_WINDOWBASE_SHIFT);
     dc->callinc = ((tb_flags & XTENSA_TBFLAG_CALLINC_MASK) >>
                    XTENSA_TBFLAG_CALLINC_SHIFT);
+    dc->profile = xtensa_profile_enabled() && dc->config->isa;
+    dc->profile_cycles = 0;
+    /* the profiler accounts cycles of a TB to its first function */
+    dc->trace = (tb_cflags(dc->base.tb) & CF_HOT_TRACE) &&
+        !dc->profile && !dc->icount && !dc->debug &&
+        !dc->base.singlestep_enabled;
+
+#ifndef CONFIG_USER_ONLY
+    /* with icount the virtual clock is already instruction based */
+    if (xtensa_option_enabled(dc->config, XTENSA_OPTION_TIMER_INTERRUPT) &&
+        (env->ccount_deterministic ||
+         !(tb_cflags(dc->base.tb) & CF_USE_ICOUNT))) {
+        dc->ccount_cpi = env->ccount_cpi;
+        dc->ccount_deterministic = env->ccount_deterministic;
+    }
+#endif
 
     if (dc->config->isa) {
         dc->insnbuf = xtensa_insnbuf_alloc(dc->config->isa);
@@ -1181,6 +1604,32 @@ static void xtensa_tr_init_disas_context(DisasContextBase *dcbase,
     init_sar_tracker(dc);
 }
 
+/*
+ * Advance CCOUNT by the cycles of the whole TB on entry. The TB length is
+ * not known yet, it is patched into the movi by xtensa_tr_tb_stop.
+ */
+static void gen_ccount_start(DisasContext *dc)
+{
+    TCGv_i32 tmp = tcg_temp_new_i32();
+
+    tcg_gen_movi_i32(tmp, 0xdeadbeef);
+    dc->ccount_insn = tcg_last_op();
+    tcg_gen_add_i32(cpu_SR[CCOUNT], cpu_SR[CCOUNT], tmp);
+
+#ifndef CONFIG_USER_ONLY
+    if (dc->ccount_deterministic) {
+        TCGLabel *label = gen_new_label();
+
+        tcg_gen_ld_i32(tmp, cpu_env, offsetof(CPUXtensaState, ccount_next));
+        tcg_gen_sub_i32(tmp, cpu_SR[CCOUNT], tmp);
+        tcg_gen_brcondi_i32(TCG_COND_LT, tmp, 0, label);
+        gen_helper_ccount_event(cpu_env);
+        gen_set_label(label);
+    }
+#endif
+    tcg_temp_free(tmp);
+}
+
 static void xtensa_tr_tb_start(DisasContextBase *dcbase, CPUState *cpu)
 {
     DisasContext *dc = container_of(dcbase, DisasContext, base);
@@ -1188,7 +1637,23 @@ static void xtensa_tr_tb_start(DisasContextBase *dcbase, CPUState *cpu)
     if (dc->icount) {
         dc->next_icount = tcg_temp_local_new_i32();
     }
-}
+    if (dc->trace) {
+        /* loop back here, CCOUNT is advanced for every iteration */
+        dc->trace_loop = gen_new_label();
+        gen_set_label(dc->trace_loop);
+    }
+    if (dc->ccount_cpi) {
+        gen_ccount_start(dc);
+    }
+    if (dc->profile) {
+        /* TB descriptor is patched in by xtensa_tr_tb_stop */
+        TCGv_ptr tb = tcg_const_ptr(0);
+
+        dc->profile_insn = tcg_last_op();
+        gen_helper_profile_tb(cpu_env, tb);
+        tcg_temp_free_ptr(tb);
+    }
+}
 
 static void xtensa_tr_insn_start(DisasContextBase *dcbase, CPUState *cpu)
 {
@@ -1266,6 +1731,16 @@ static void xtensa_tr_tb_stop(DisasContextBase *dcbase, CPUState *cpu)
 {
     DisasContext *dc = container_of(dcbase, DisasContext, base);
 
+    if (dc->ccount_cpi) {
+        tcg_set_insn_param(dc->ccount_insn, 1,
+                           dc->base.num_insns * dc->ccount_cpi);
+    }
+    if (dc->profile) {
+        tcg_set_insn_param(dc->profile_insn, 1,
+                           (uintptr_t)xtensa_profile_tb(dc->base.pc_first,
+                                                        dc->base.num_insns,
+                                                        dc->profile_cycles));
+    }
     reset_sar_tracker(dc);
     if (dc->config->isa) {
         xtensa_insnbuf_free(dc->config->isa, dc->insnbuf);
@@ -1540,8 +2015,14 @@ static void translate_bp(DisasContext *dc, const OpcodeArg arg[],
 static void translate_call0(DisasContext *dc, const OpcodeArg arg[],
                             const uint32_t par[])
 {
+    if (dc->profile) {
+        TCGv_i32 tmp = tcg_const_i32(arg[0].imm);
+
+        gen_profile_call(dc, tmp);
+        tcg_temp_free(tmp);
+    }
     tcg_gen_movi_i32(cpu_R[0], dc->base.pc_next);
-    gen_jumpi(dc, arg[0].imm, 0);
+    gen_jumpi_trace(dc, arg[0].imm);
 }
 
 static void translate_callw(DisasContext *dc, const OpcodeArg arg[],
@@ -1557,6 +2038,7 @@ static void translate_callx0(DisasContext *dc, const OpcodeArg arg[],
 {
     TCGv_i32 tmp = tcg_temp_new_i32();
     tcg_gen_mov_i32(tmp, arg[0].in);
+    gen_profile_call(dc, tmp);
     tcg_gen_movi_i32(cpu_R[0], dc->base.pc_next);
     gen_jump(dc, tmp);
     tcg_temp_free(tmp);
@@ -1652,13 +2134,13 @@ static uint32_t test_overflow_entry(DisasContext *dc, const OpcodeArg arg[],
 static void translate_entry(DisasContext *dc, const OpcodeArg arg[],
                             const uint32_t par[])
 {
-    TCGv_i32 pc = tcg_const_i32(dc->pc);
-    TCGv_i32 s = tcg_const_i32(arg[0].imm);
-    TCGv_i32 imm = tcg_const_i32(arg[1].imm);
-    gen_helper_entry(cpu_env, pc, s, imm);
-    tcg_temp_free(imm);
-    tcg_temp_free(s);
-    tcg_temp_free(pc);
+    unsigned nw = dc->config->nareg / 4;
+
+    tcg_gen_subi_i32(cpu_R[(dc->callinc << 2) | (arg[0].imm & 3)],
+                     cpu_R[arg[0].imm], arg[1].imm);
+    tcg_gen_ori_i32(cpu_SR[WINDOW_START], cpu_SR[WINDOW_START],
+                    1u << ((dc->windowbase + dc->callinc) & (nw - 1)));
+    gen_rotate_window(dc, dc->callinc);
 }
 
 static void translate_extui(DisasContext *dc, const OpcodeArg arg[],
@@ -1710,7 +2192,7 @@ static void translate_itlb(DisasContext *dc, const OpcodeArg arg[],
 static void translate_j(DisasContext *dc, const OpcodeArg arg[],
                         const uint32_t par[])
 {
-    gen_jumpi(dc, arg[0].imm, 0);
+    gen_jumpi_trace(dc, arg[0].imm);
 }
 
 static void translate_jx(DisasContext *dc, const OpcodeArg arg[],
@@ -1796,6 +2278,7 @@ static void translate_l32r(DisasContext *dc, const OpcodeArg arg[],
     } else {
         tmp = tcg_const_i32(arg[1].imm);
     }
+    gen_profile_mem(dc, tmp);
     tcg_gen_qemu_ld32u(arg[0].out, tmp, dc->cring);
     tcg_temp_free(tmp);
 }
@@ -2109,6 +2592,7 @@ static void translate_rer(DisasContext *dc, const OpcodeArg arg[],
 static void translate_ret(DisasContext *dc, const OpcodeArg arg[],
                           const uint32_t par[])
 {
+    gen_profile_ret(dc);
     gen_jump(dc, cpu_R[0]);
 }
 
@@ -2120,10 +2604,6 @@ static bool test_ill_retw(DisasContext *dc, const OpcodeArg arg[],
                       "Illegal retw instruction(pc = %08x)\n", dc->pc);
         return true;
     } else {
-        TCGv_i32 tmp = tcg_const_i32(dc->pc);
-
-        gen_helper_test_ill_retw(cpu_env, tmp);
-        tcg_temp_free(tmp);
         return false;
     }
 }
@@ -2131,14 +2611,32 @@ static bool test_ill_retw(DisasContext *dc, const OpcodeArg arg[],
 static void translate_retw(DisasContext *dc, const OpcodeArg arg[],
                            const uint32_t par[])
 {
-    TCGv_i32 tmp = tcg_const_i32(1);
-    tcg_gen_shl_i32(tmp, tmp, cpu_SR[WINDOW_BASE]);
-    tcg_gen_andc_i32(cpu_SR[WINDOW_START],
-                     cpu_SR[WINDOW_START], tmp);
+    TCGv_i32 tmp = tcg_temp_local_new_i32();
+    TCGv_i32 n = tcg_temp_local_new_i32();
+    TCGLabel *done = gen_new_label();
+    int i;
+
+    gen_profile_ret(dc);
+    tcg_gen_andi_i32(cpu_SR[WINDOW_START], cpu_SR[WINDOW_START],
+                     ~(1u << dc->windowbase));
     tcg_gen_movi_i32(tmp, dc->pc);
     tcg_gen_deposit_i32(tmp, tmp, cpu_R[0], 0, 30);
-    gen_helper_retw(cpu_env, cpu_R[0]);
+
+    /* gen_retw_check has made sure a0[31:30] is 1, 2 or 3 */
+    tcg_gen_extract_i32(n, cpu_R[0], 30, 2);
+    for (i = 1; i < 3; ++i) {
+        TCGLabel *next = gen_new_label();
+
+        tcg_gen_brcondi_i32(TCG_COND_NE, n, i, next);
+        gen_rotate_window(dc, -i);
+        tcg_gen_br(done);
+        gen_set_label(next);
+    }
+    gen_rotate_window(dc, -3);
+    gen_set_label(done);
+
     gen_jump(dc, tmp);
+    tcg_temp_free(n);
     tcg_temp_free(tmp);
 }
 
@@ -2206,6 +2704,21 @@ static void translate_rsr(DisasContext *dc, const OpcodeArg arg[],
 static void translate_rsr_ccount(DisasContext *dc, const OpcodeArg arg[],
                                  const uint32_t par[])
 {
+#ifndef CONFIG_USER_ONLY
+    if (tb_cflags(dc->base.tb) & CF_USE_ICOUNT) {
+        gen_io_start();
+    }
+    /* inline CCOUNT is exact, the TB ends with this instruction */
+    if (!dc->ccount_cpi) {
+        gen_helper_update_ccount(cpu_env);
+    }
+    tcg_gen_mov_i32(arg[0].out, cpu_SR[par[0]]);
+#endif
+}
+
+static void translate_rsr_intset(DisasContext *dc, const OpcodeArg arg[],
+                                 const uint32_t par[])
+{
 #ifndef CONFIG_USER_ONLY
     if (tb_cflags(dc->base.tb) & CF_USE_ICOUNT) {
         gen_io_start();
@@ -2812,7 +3325,9 @@ static void translate_xsr_ccount(DisasContext *dc, const OpcodeArg arg[],
         gen_io_start();
     }
 
-    gen_helper_update_ccount(cpu_env);
+    if (!dc->ccount_cpi) {
+        gen_helper_update_ccount(cpu_env);
+    }
     tcg_gen_mov_i32(tmp, cpu_SR[par[0]]);
     gen_helper_wsr_ccount(cpu_env, arg[0].in);
     tcg_gen_mov_i32(arg[0].out, tmp);
@@ -3224,8 +3739,7 @@ static const XtensaOpcodeOps core_ops[] = {
         .translate = translate_entry,
         .test_ill = test_ill_entry,
         .test_overflow = test_overflow_entry,
-        .op_flags = XTENSA_OP_EXIT_TB_M1 |
-            XTENSA_OP_SYNC_REGISTER_WINDOW,
+        .op_flags = XTENSA_OP_EXIT_TB_M1,
     }, {
         .name = "esync",
         .translate = translate_nop,
@@ -4314,7 +4828,7 @@ static const XtensaOpcodeOps core_ops[] = {
         .op_flags = XTENSA_OP_PRIVILEGED,
     }, {
         .name = "rsr.interrupt",
-        .translate = translate_rsr_ccount,
+        .translate = translate_rsr_intset,
         .test_ill = test_ill_sr,
         .par = (const uint32_t[]){
             INTSET,
@@ -4323,7 +4837,7 @@ static const XtensaOpcodeOps core_ops[] = {
         .op_flags = XTENSA_OP_PRIVILEGED | XTENSA_OP_EXIT_TB_0,
     }, {
         .name = "rsr.intset",
-        .translate = translate_rsr_ccount,
+        .translate = translate_rsr_intset,
         .test_ill = test_ill_sr,
         .par = (const uint32_t[]){
             INTSET,
@@ -6643,3 +7157,1299 @@ const XtensaOpcodeTranslators xtensa_fpu2000_opcodes = {
     .num_opcodes = ARRAY_SIZE(fpu2000_ops),
     .opcode = fpu2000_ops,
 };
+
+/*
+ * HiFi3 audio engine.
+ *
+ * AE_DR registers hold 64 bit, 2x32 or 4x16 vectors. They are TCG globals,
+ * so the lane arithmetic uses the 64 bit SWAR expanders from tcg-op-gvec.c
+ * rather than gvec operations on env, which would bypass the globals.
+ * Vector memory order puts the lowest address in the highest lane.
+ */
+
+enum {
+    AE_MEM_64,
+    AE_MEM_32X2,
+    AE_MEM_16X4,
+    AE_MEM_32,
+    AE_MEM_16,
+};
+
+enum {
+    AE_ADDR_I,      /* ars + imm */
+    AE_ADDR_IP,     /* ars, then ars += imm */
+    AE_ADDR_X,      /* ars + art */
+    AE_ADDR_XP,     /* ars, then ars += art */
+    AE_ADDR_XC,     /* ars, then ars += art wrapped to AE_CBEGIN0..AE_CEND0 */
+};
+
+enum {
+    AE_MUL,
+    AE_MULA,
+    AE_MULS,
+};
+
+/* convert between vector lane order and a 64 bit memory access */
+static void gen_ae_swap_lanes(TCGv_i64 v, unsigned layout)
+{
+#ifndef TARGET_WORDS_BIGENDIAN
+    TCGv_i64 tmp;
+
+    switch (layout) {
+    case AE_MEM_32X2:
+        tcg_gen_rotli_i64(v, v, 32);
+        break;
+
+    case AE_MEM_16X4:
+        tmp = tcg_temp_new_i64();
+        tcg_gen_rotli_i64(v, v, 32);
+        tcg_gen_shri_i64(tmp, v, 16);
+        tcg_gen_andi_i64(tmp, tmp, 0x0000ffff0000ffffull);
+        tcg_gen_andi_i64(v, v, 0x0000ffff0000ffffull);
+        tcg_gen_shli_i64(v, v, 16);
+        tcg_gen_or_i64(v, v, tmp);
+        tcg_temp_free_i64(tmp);
+        break;
+    }
+#endif
+}
+
+static void gen_ae_circular_add(TCGv_i32 dst, TCGv_i32 base, TCGv_i32 inc)
+{
+    TCGv_i32 next = tcg_temp_new_i32();
+    TCGv_i32 size = tcg_temp_new_i32();
+    TCGv_i32 tmp = tcg_temp_new_i32();
+
+    tcg_gen_add_i32(next, base, inc);
+    tcg_gen_sub_i32(size, cpu_UR[AE_CEND0], cpu_UR[AE_CBEGIN0]);
+    tcg_gen_sub_i32(tmp, next, size);
+    tcg_gen_movcond_i32(TCG_COND_GEU, tmp, next, cpu_UR[AE_CEND0],
+                        tmp, next);
+    tcg_gen_add_i32(size, next, size);
+    tcg_gen_movcond_i32(TCG_COND_LTU, dst, next, cpu_UR[AE_CBEGIN0],
+                        size, tmp);
+    tcg_temp_free(next);
+    tcg_temp_free(size);
+    tcg_temp_free(tmp);
+}
+
+static void translate_ae_ldst(DisasContext *dc, const OpcodeArg arg[],
+                              const uint32_t par[])
+{
+    static const unsigned shift[] = {
+        [AE_MEM_64] = 3,
+        [AE_MEM_32X2] = 3,
+        [AE_MEM_16X4] = 3,
+        [AE_MEM_32] = 2,
+        [AE_MEM_16] = 1,
+    };
+    unsigned layout = par[0];
+    bool store = par[1];
+    unsigned mode = par[2];
+    TCGv_i32 addr = tcg_temp_new_i32();
+    TCGv_i32 inc = NULL;
+    TCGv_i64 v = tcg_temp_new_i64();
+    TCGv_i32 v32;
+
+    switch (mode) {
+    case AE_ADDR_I:
+        tcg_gen_addi_i32(addr, arg[1].in, arg[2].imm);
+        break;
+    case AE_ADDR_X:
+        tcg_gen_add_i32(addr, arg[1].in, arg[2].in);
+        break;
+    case AE_ADDR_IP:
+        inc = tcg_const_i32(arg[2].imm);
+        tcg_gen_mov_i32(addr, arg[1].in);
+        break;
+    default:
+        inc = arg[2].in;
+        tcg_gen_mov_i32(addr, arg[1].in);
+        break;
+    }
+    gen_load_store_alignment(dc, shift[layout], addr, false);
+
+    if (store) {
+        switch (layout) {
+        case AE_MEM_32:
+            v32 = tcg_temp_new_i32();
+            tcg_gen_extrl_i64_i32(v32, arg[0].in);
+            tcg_gen_qemu_st_i32(v32, addr, dc->cring, MO_TEUL);
+            tcg_temp_free(v32);
+            break;
+        case AE_MEM_16:
+            v32 = tcg_temp_new_i32();
+            tcg_gen_extrl_i64_i32(v32, arg[0].in);
+            tcg_gen_qemu_st_i32(v32, addr, dc->cring, MO_TEUW);
+            tcg_temp_free(v32);
+            break;
+        default:
+            tcg_gen_mov_i64(v, arg[0].in);
+            gen_ae_swap_lanes(v, layout);
+            tcg_gen_qemu_st_i64(v, addr, dc->cring, MO_TEQ);
+            break;
+        }
+    } else {
+        switch (layout) {
+        case AE_MEM_32:
+            tcg_gen_qemu_ld_i64(v, addr, dc->cring, MO_TEUL);
+            tcg_gen_muli_i64(arg[0].out, v, 0x0000000100000001ull);
+            break;
+        case AE_MEM_16:
+            tcg_gen_qemu_ld_i64(v, addr, dc->cring, MO_TEUW);
+            tcg_gen_muli_i64(arg[0].out, v, 0x0001000100010001ull);
+            break;
+        default:
+            tcg_gen_qemu_ld_i64(v, addr, dc->cring, MO_TEQ);
+            gen_ae_swap_lanes(v, layout);
+            tcg_gen_mov_i64(arg[0].out, v);
+            break;
+        }
+    }
+
+    switch (mode) {
+    case AE_ADDR_IP:
+        tcg_gen_add_i32(arg[1].out, arg[1].in, inc);
+        tcg_temp_free(inc);
+        break;
+    case AE_ADDR_XP:
+        tcg_gen_add_i32(arg[1].out, arg[1].in, inc);
+        break;
+    case AE_ADDR_XC:
+        gen_ae_circular_add(arg[1].out, arg[1].in, inc);
+        break;
+    }
+    tcg_temp_free_i64(v);
+    tcg_temp_free(addr);
+}
+
+static void translate_ae_la64_pp(DisasContext *dc, const OpcodeArg arg[],
+                                 const uint32_t par[])
+{
+    TCGv_i32 addr = tcg_temp_new_i32();
+
+    tcg_gen_andi_i32(addr, arg[1].in, ~7);
+    gen_profile_mem(dc, addr);
+    tcg_gen_qemu_ld_i64(arg[0].out, addr, dc->cring, MO_TEQ);
+    tcg_temp_free(addr);
+}
+
+/*
+ * Unaligned stream load. AE_VALIGN holds the aligned doubleword under ars
+ * (primed by AE_LA64.PP), the next one is loaded and the two are merged.
+ */
+static void translate_ae_la_ip(DisasContext *dc, const OpcodeArg arg[],
+                               const uint32_t par[])
+{
+    TCGv_i32 addr = tcg_temp_new_i32();
+    TCGv_i64 next = tcg_temp_new_i64();
+    TCGv_i64 sh = tcg_temp_new_i64();
+    TCGv_i64 lo = tcg_temp_new_i64();
+    TCGv_i64 hi = tcg_temp_new_i64();
+
+    tcg_gen_andi_i32(addr, arg[2].in, ~7);
+    tcg_gen_addi_i32(addr, addr, 8);
+    gen_profile_mem(dc, addr);
+    tcg_gen_qemu_ld_i64(next, addr, dc->cring, MO_TEQ);
+
+    /* sh = 8 * (ars & 7), the second shift is split to cope with sh == 0 */
+    tcg_gen_extu_i32_i64(sh, arg[2].in);
+    tcg_gen_andi_i64(sh, sh, 7);
+    tcg_gen_shli_i64(sh, sh, 3);
+#ifdef TARGET_WORDS_BIGENDIAN
+    tcg_gen_shl_i64(lo, arg[1].in, sh);
+    tcg_gen_subfi_i64(sh, 63, sh);
+    tcg_gen_shr_i64(hi, next, sh);
+    tcg_gen_shri_i64(hi, hi, 1);
+#else
+    tcg_gen_shr_i64(lo, arg[1].in, sh);
+    tcg_gen_subfi_i64(sh, 63, sh);
+    tcg_gen_shl_i64(hi, next, sh);
+    tcg_gen_shli_i64(hi, hi, 1);
+#endif
+    tcg_gen_or_i64(lo, lo, hi);
+    gen_ae_swap_lanes(lo, par[0]);
+
+    tcg_gen_mov_i64(arg[0].out, lo);
+    tcg_gen_mov_i64(arg[1].out, next);
+    tcg_gen_addi_i32(arg[2].out, arg[2].in, 8);
+
+    tcg_temp_free(addr);
+    tcg_temp_free_i64(next);
+    tcg_temp_free_i64(sh);
+    tcg_temp_free_i64(lo);
+    tcg_temp_free_i64(hi);
+}
+
+static void translate_ae_valign_ldst(DisasContext *dc, const OpcodeArg arg[],
+                                     const uint32_t par[])
+{
+    TCGv_i32 addr = tcg_temp_new_i32();
+
+    tcg_gen_addi_i32(addr, arg[1].in, arg[2].imm);
+    gen_load_store_alignment(dc, 3, addr, false);
+    if (par[0]) {
+        tcg_gen_qemu_st_i64(arg[0].in, addr, dc->cring, MO_TEQ);
+    } else {
+        tcg_gen_qemu_ld_i64(arg[0].out, addr, dc->cring, MO_TEQ);
+    }
+    tcg_temp_free(addr);
+}
+
+static void translate_ae_mov(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    tcg_gen_mov_i64(arg[0].out, arg[1].in);
+}
+
+static void translate_ae_zalign64(DisasContext *dc, const OpcodeArg arg[],
+                                  const uint32_t par[])
+{
+    tcg_gen_movi_i64(arg[0].out, 0);
+}
+
+static void translate_ae_movi(DisasContext *dc, const OpcodeArg arg[],
+                              const uint32_t par[])
+{
+    tcg_gen_movi_i64(arg[0].out, 0x0000000100000001ull * arg[1].imm);
+}
+
+static void translate_ae_movda32(DisasContext *dc, const OpcodeArg arg[],
+                                 const uint32_t par[])
+{
+    tcg_gen_concat_i32_i64(arg[0].out, par[0] ? arg[2].in : arg[1].in,
+                           arg[1].in);
+}
+
+static void translate_ae_movda16(DisasContext *dc, const OpcodeArg arg[],
+                                 const uint32_t par[])
+{
+    TCGv_i32 tmp = tcg_temp_new_i32();
+
+    if (par[0]) {
+        tcg_gen_deposit_i32(tmp, arg[2].in, arg[1].in, 16, 16);
+    } else {
+        tcg_gen_deposit_i32(tmp, arg[1].in, arg[1].in, 16, 16);
+    }
+    tcg_gen_concat_i32_i64(arg[0].out, tmp, tmp);
+    tcg_temp_free(tmp);
+}
+
+static void translate_ae_movad(DisasContext *dc, const OpcodeArg arg[],
+                               const uint32_t par[])
+{
+    TCGv_i64 tmp = tcg_temp_new_i64();
+
+    tcg_gen_sextract_i64(tmp, arg[1].in, par[0], par[1]);
+    tcg_gen_extrl_i64_i32(arg[0].out, tmp);
+    tcg_temp_free_i64(tmp);
+}
+
+static void translate_ae_add(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    switch (par[0]) {
+    case 16:
+        tcg_gen_vec_add16_i64(arg[0].out, arg[1].in, arg[2].in);
+        break;
+    case 32:
+        tcg_gen_vec_add32_i64(arg[0].out, arg[1].in, arg[2].in);
+        break;
+    default:
+        tcg_gen_add_i64(arg[0].out, arg[1].in, arg[2].in);
+        break;
+    }
+}
+
+static void translate_ae_sub(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    switch (par[0]) {
+    case 16:
+        tcg_gen_vec_sub16_i64(arg[0].out, arg[1].in, arg[2].in);
+        break;
+    case 32:
+        tcg_gen_vec_sub32_i64(arg[0].out, arg[1].in, arg[2].in);
+        break;
+    default:
+        tcg_gen_sub_i64(arg[0].out, arg[1].in, arg[2].in);
+        break;
+    }
+}
+
+static void translate_ae_neg(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    if (par[0] == 32) {
+        tcg_gen_vec_neg32_i64(arg[0].out, arg[1].in);
+    } else {
+        tcg_gen_neg_i64(arg[0].out, arg[1].in);
+    }
+}
+
+/* AE_ADDSUB32 adds the high lanes and subtracts the low, AE_SUBADD32 swaps */
+static void translate_ae_addsub32(DisasContext *dc, const OpcodeArg arg[],
+                                  const uint32_t par[])
+{
+    TCGv_i64 add = tcg_temp_new_i64();
+    TCGv_i64 sub = tcg_temp_new_i64();
+
+    tcg_gen_vec_add32_i64(add, arg[1].in, arg[2].in);
+    tcg_gen_vec_sub32_i64(sub, arg[1].in, arg[2].in);
+    if (par[0]) {
+        tcg_gen_deposit_i64(arg[0].out, sub, add, 0, 32);
+    } else {
+        tcg_gen_deposit_i64(arg[0].out, add, sub, 0, 32);
+    }
+    tcg_temp_free_i64(add);
+    tcg_temp_free_i64(sub);
+}
+
+static void translate_ae_and(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    tcg_gen_and_i64(arg[0].out, arg[1].in, arg[2].in);
+}
+
+static void translate_ae_nand(DisasContext *dc, const OpcodeArg arg[],
+                              const uint32_t par[])
+{
+    tcg_gen_nand_i64(arg[0].out, arg[1].in, arg[2].in);
+}
+
+static void translate_ae_or(DisasContext *dc, const OpcodeArg arg[],
+                            const uint32_t par[])
+{
+    tcg_gen_or_i64(arg[0].out, arg[1].in, arg[2].in);
+}
+
+static void translate_ae_xor(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    tcg_gen_xor_i64(arg[0].out, arg[1].in, arg[2].in);
+}
+
+static void translate_ae_abs64(DisasContext *dc, const OpcodeArg arg[],
+                               const uint32_t par[])
+{
+    tcg_gen_abs_i64(arg[0].out, arg[1].in);
+}
+
+/* per lane operations on 2x32 vectors that have no SWAR expander */
+enum {
+    AE_LANE_ABS,
+    AE_LANE_MAX,
+    AE_LANE_MIN,
+};
+
+static void translate_ae_lane32(DisasContext *dc, const OpcodeArg arg[],
+                                const uint32_t par[])
+{
+    TCGv_i32 a = tcg_temp_new_i32();
+    TCGv_i32 b = tcg_temp_new_i32();
+    TCGv_i32 r[2];
+    unsigned i;
+
+    for (i = 0; i < 2; ++i) {
+        r[i] = tcg_temp_new_i32();
+        if (i) {
+            tcg_gen_extrh_i64_i32(a, arg[1].in);
+        } else {
+            tcg_gen_extrl_i64_i32(a, arg[1].in);
+        }
+        if (par[0] == AE_LANE_ABS) {
+            tcg_gen_abs_i32(r[i], a);
+            continue;
+        }
+        if (i) {
+            tcg_gen_extrh_i64_i32(b, arg[2].in);
+        } else {
+            tcg_gen_extrl_i64_i32(b, arg[2].in);
+        }
+        if (par[0] == AE_LANE_MAX) {
+            tcg_gen_smax_i32(r[i], a, b);
+        } else {
+            tcg_gen_smin_i32(r[i], a, b);
+        }
+    }
+    tcg_gen_concat_i32_i64(arg[0].out, r[0], r[1]);
+    tcg_temp_free(a);
+    tcg_temp_free(b);
+    tcg_temp_free(r[0]);
+    tcg_temp_free(r[1]);
+}
+
+static void translate_ae_minmax64(DisasContext *dc, const OpcodeArg arg[],
+                                  const uint32_t par[])
+{
+    if (par[0] == AE_LANE_MAX) {
+        tcg_gen_smax_i64(arg[0].out, arg[1].in, arg[2].in);
+    } else {
+        tcg_gen_smin_i64(arg[0].out, arg[1].in, arg[2].in);
+    }
+}
+
+static void translate_ae_addsub_s(DisasContext *dc, const OpcodeArg arg[],
+                                  const uint32_t par[])
+{
+    TCGv_i32 sub = tcg_const_i32(par[1]);
+
+    switch (par[0]) {
+    case 16:
+        gen_helper_ae_addsub16s(arg[0].out, cpu_env,
+                                arg[1].in, arg[2].in, sub);
+        break;
+    case 32:
+        gen_helper_ae_addsub32s(arg[0].out, cpu_env,
+                                arg[1].in, arg[2].in, sub);
+        break;
+    default:
+        gen_helper_ae_addsub64s(arg[0].out, cpu_env,
+                                arg[1].in, arg[2].in, sub);
+        break;
+    }
+    tcg_temp_free(sub);
+}
+
+static void translate_ae_negabs32s(DisasContext *dc, const OpcodeArg arg[],
+                                   const uint32_t par[])
+{
+    TCGv_i32 abs = tcg_const_i32(par[0]);
+
+    gen_helper_ae_negabs32s(arg[0].out, arg[1].in, abs);
+    tcg_temp_free(abs);
+}
+
+enum {
+    AE_SHIFT_SRA,
+    AE_SHIFT_SRL,
+    AE_SHIFT_SLL,
+};
+
+static void translate_ae_shift_imm(DisasContext *dc, const OpcodeArg arg[],
+                                   const uint32_t par[])
+{
+    unsigned sh = arg[2].imm;
+    TCGv_i64 hi, lo;
+
+    switch (par[0]) {
+    case 16:
+        if (par[1] == AE_SHIFT_SRA) {
+            tcg_gen_vec_sar16i_i64(arg[0].out, arg[1].in, sh);
+        } else if (par[1] == AE_SHIFT_SRL) {
+            tcg_gen_vec_shr16i_i64(arg[0].out, arg[1].in, sh);
+        } else {
+            tcg_gen_vec_shl16i_i64(arg[0].out, arg[1].in, sh);
+        }
+        break;
+
+    case 32:
+        /* shift the whole register for the high lane, fix up the low one */
+        hi = tcg_temp_new_i64();
+        lo = tcg_temp_new_i64();
+        if (par[1] == AE_SHIFT_SRA) {
+            tcg_gen_sari_i64(hi, arg[1].in, sh);
+            tcg_gen_sextract_i64(lo, arg[1].in, 0, 32);
+            tcg_gen_sari_i64(lo, lo, sh);
+        } else if (par[1] == AE_SHIFT_SRL) {
+            tcg_gen_shri_i64(hi, arg[1].in, sh);
+            tcg_gen_extract_i64(lo, arg[1].in, 0, 32);
+            tcg_gen_shri_i64(lo, lo, sh);
+        } else {
+            tcg_gen_andi_i64(hi, arg[1].in, 0xffffffff00000000ull);
+            tcg_gen_shli_i64(hi, hi, sh);
+            tcg_gen_shli_i64(lo, arg[1].in, sh);
+        }
+        tcg_gen_deposit_i64(arg[0].out, hi, lo, 0, 32);
+        tcg_temp_free_i64(hi);
+        tcg_temp_free_i64(lo);
+        break;
+
+    default:
+        if (par[1] == AE_SHIFT_SRA) {
+            tcg_gen_sari_i64(arg[0].out, arg[1].in, sh);
+        } else if (par[1] == AE_SHIFT_SRL) {
+            tcg_gen_shri_i64(arg[0].out, arg[1].in, sh);
+        } else {
+            tcg_gen_shli_i64(arg[0].out, arg[1].in, sh);
+        }
+        break;
+    }
+}
+
+static void gen_ae_lane(TCGv_i64 dst, TCGv_i64 src, unsigned lane,
+                        unsigned bits, bool is_unsigned)
+{
+    if (is_unsigned) {
+        tcg_gen_extract_i64(dst, src, lane * bits, bits);
+    } else {
+        tcg_gen_sextract_i64(dst, src, lane * bits, bits);
+    }
+}
+
+static void gen_ae_accumulate(TCGv_i64 q, TCGv_i64 q_in, TCGv_i64 p,
+                              unsigned op)
+{
+    switch (op) {
+    case AE_MULA:
+        tcg_gen_add_i64(q, q_in, p);
+        break;
+    case AE_MULS:
+        tcg_gen_sub_i64(q, q_in, p);
+        break;
+    default:
+        tcg_gen_mov_i64(q, p);
+        break;
+    }
+}
+
+/*
+ * par[0], par[1]: lane and lane width of d0
+ * par[2], par[3]: lane and lane width of d1
+ * par[4]: AE_MUL, AE_MULA or AE_MULS
+ * par[5]: unsigned, par[6]: fractional (product shifted left by one)
+ */
+static void translate_ae_mul(DisasContext *dc, const OpcodeArg arg[],
+                             const uint32_t par[])
+{
+    TCGv_i64 a = tcg_temp_new_i64();
+    TCGv_i64 b = tcg_temp_new_i64();
+
+    gen_ae_lane(a, arg[1].in, par[0], par[1], par[5]);
+    gen_ae_lane(b, arg[2].in, par[2], par[3], par[5]);
+    tcg_gen_mul_i64(a, a, b);
+    if (par[6]) {
+        tcg_gen_shli_i64(a, a, 1);
+    }
+    gen_ae_accumulate(arg[0].out, arg[0].in, a, par[4]);
+    tcg_temp_free_i64(a);
+    tcg_temp_free_i64(b);
+}
+
+static void translate_ae_mulf32s(DisasContext *dc, const OpcodeArg arg[],
+                                 const uint32_t par[])
+{
+    TCGv_i32 a = tcg_temp_new_i32();
+    TCGv_i32 b = tcg_temp_new_i32();
+    TCGv_i32 op = tcg_const_i32(par[2]);
+    TCGv_i64 acc = par[2] == AE_MUL ? tcg_const_i64(0) : arg[0].in;
+
+    if (par[0]) {
+        tcg_gen_extrh_i64_i32(a, arg[1].in);
+    } else {
+        tcg_gen_extrl_i64_i32(a, arg[1].in);
+    }
+    if (par[1]) {
+        tcg_gen_extrh_i64_i32(b, arg[2].in);
+    } else {
+        tcg_gen_extrl_i64_i32(b, arg[2].in);
+    }
+    gen_helper_ae_mulf32s(arg[0].out, cpu_env, acc, a, b, op);
+    if (par[2] == AE_MUL) {
+        tcg_temp_free_i64(acc);
+    }
+    tcg_temp_free(a);
+    tcg_temp_free(b);
+    tcg_temp_free(op);
+}
+
+/*
+ * Dual 32x16 multiply: the high d0 lane by d1 lane par[0] plus the low d0
+ * lane by d1 lane par[1].
+ * par[2]: AE_MUL or AE_MULA, par[3], par[4]: negate the first, second
+ * product, par[5]: fractional
+ */
+static void translate_ae_mul2(DisasContext *dc, const OpcodeArg arg[],
+                              const uint32_t par[])
+{
+    TCGv_i64 a = tcg_temp_new_i64();
+    TCGv_i64 b = tcg_temp_new_i64();
+    TCGv_i64 p = tcg_temp_new_i64();
+
+    gen_ae_lane(a, arg[1].in, 1, 32, false);
+    gen_ae_lane(b, arg[2].in, par[0], 16, false);
+    tcg_gen_mul_i64(p, a, b);
+    if (par[3]) {
+        tcg_gen_neg_i64(p, p);
+    }
+    gen_ae_lane(a, arg[1].in, 0, 32, false);
+    gen_ae_lane(b, arg[2].in, par[1], 16, false);
+    tcg_gen_mul_i64(a, a, b);
+    if (par[4]) {
+        tcg_gen_sub_i64(p, p, a);
+    } else {
+        tcg_gen_add_i64(p, p, a);
+    }
+    if (par[5]) {
+        tcg_gen_shli_i64(p, p, 1);
+    }
+    gen_ae_accumulate(arg[0].out, arg[0].in, p, par[2]);
+    tcg_temp_free_i64(a);
+    tcg_temp_free_i64(b);
+    tcg_temp_free_i64(p);
+}
+
+/* par[0]: 32 or 64 bit source, par[1]: symmetric rounding */
+static void translate_ae_round32x2(DisasContext *dc, const OpcodeArg arg[],
+                                   const uint32_t par[])
+{
+    TCGv_i32 shift = tcg_const_i32(par[0] == 64 ? 32 : 16);
+    TCGv_i32 sym = tcg_const_i32(par[1]);
+
+    gen_helper_ae_round32x2(arg[0].out, cpu_env, arg[1].in, arg[2].in,
+                            shift, sym);
+    tcg_temp_free(shift);
+    tcg_temp_free(sym);
+}
+
+/* par[0]: round off 16 bits or only saturate, par[1]: symmetric rounding */
+static void translate_ae_pack16x4(DisasContext *dc, const OpcodeArg arg[],
+                                  const uint32_t par[])
+{
+    TCGv_i32 shift = tcg_const_i32(par[0] ? 16 : 0);
+    TCGv_i32 sym = tcg_const_i32(par[1]);
+
+    gen_helper_ae_pack16x4(arg[0].out, cpu_env, arg[1].in, arg[2].in,
+                           shift, sym);
+    tcg_temp_free(shift);
+    tcg_temp_free(sym);
+}
+
+static void translate_ae_sat64(DisasContext *dc, const OpcodeArg arg[],
+                               const uint32_t par[])
+{
+    TCGv_i32 bits = tcg_const_i32(par[0]);
+
+    gen_helper_ae_sat64(arg[0].out, cpu_env, arg[1].in, bits);
+    tcg_temp_free(bits);
+}
+
+/* AR 1.31 to a 64 bit fraction with par[0] integer bits */
+static void translate_ae_cvt_a32(DisasContext *dc, const OpcodeArg arg[],
+                                 const uint32_t par[])
+{
+    tcg_gen_ext_i32_i64(arg[0].out, arg[1].in);
+    tcg_gen_shli_i64(arg[0].out, arg[0].out, 32 - par[0]);
+}
+
+static void translate_ae_cvt64f32_h(DisasContext *dc, const OpcodeArg arg[],
+                                    const uint32_t par[])
+{
+    tcg_gen_andi_i64(arg[0].out, arg[1].in, 0xffffffff00000000ull);
+}
+
+/* 16 bit lanes par[0] and par[1] to the high and low 1.31 lanes */
+static void translate_ae_cvt32x2f16(DisasContext *dc, const OpcodeArg arg[],
+                                    const uint32_t par[])
+{
+    TCGv_i64 hi = tcg_temp_new_i64();
+    TCGv_i64 lo = tcg_temp_new_i64();
+
+    tcg_gen_extract_i64(hi, arg[1].in, par[0] * 16, 16);
+    tcg_gen_extract_i64(lo, arg[1].in, par[1] * 16, 16);
+    tcg_gen_shli_i64(hi, hi, 48);
+    tcg_gen_shli_i64(lo, lo, 16);
+    tcg_gen_or_i64(arg[0].out, hi, lo);
+    tcg_temp_free_i64(hi);
+    tcg_temp_free_i64(lo);
+}
+
+static void translate_ae_rur_field(DisasContext *dc, const OpcodeArg arg[],
+                                   const uint32_t par[])
+{
+    tcg_gen_extract_i32(arg[0].out, cpu_UR[par[0]], par[1], par[2]);
+}
+
+static void translate_ae_wur_field(DisasContext *dc, const OpcodeArg arg[],
+                                   const uint32_t par[])
+{
+    tcg_gen_deposit_i32(cpu_UR[par[0]], cpu_UR[par[0]], arg[0].in,
+                        par[1], par[2]);
+}
+
+#define AE_LDST(op, layout, store, mode, flags) { \
+        .name = op, \
+        .translate = translate_ae_ldst, \
+        .par = (const uint32_t[]){layout, store, mode}, \
+        .op_flags = flags, \
+        .coprocessor = 0x2, \
+    }
+
+#define AE_LOAD(op, layout, mode) \
+    AE_LDST(op, layout, false, mode, XTENSA_OP_LOAD)
+
+#define AE_STORE(op, layout, mode) \
+    AE_LDST(op, layout, true, mode, XTENSA_OP_STORE)
+
+/* lane, width of d0 then d1 */
+#define AE_MUL32_LANES(a, b)    a, 32, b, 32
+#define AE_MUL32X16_LANES(a, b) a, 32, b, 16
+
+#define AE_MUL_OP(op, lanes, kind, uns, frac) { \
+        .name = (const char * const[]) { op, op "_s2", NULL }, \
+        .translate = translate_ae_mul, \
+        .par = (const uint32_t[]){lanes, kind, uns, frac}, \
+        .op_flags = XTENSA_OP_NAME_ARRAY, \
+        .coprocessor = 0x2, \
+    }
+
+#define AE_MUL32X16(suffix, a, b) \
+    AE_MUL_OP("ae_mul32x16." suffix, AE_MUL32X16_LANES(a, b), \
+              AE_MUL, false, false), \
+    AE_MUL_OP("ae_mula32x16." suffix, AE_MUL32X16_LANES(a, b), \
+              AE_MULA, false, false), \
+    AE_MUL_OP("ae_muls32x16." suffix, AE_MUL32X16_LANES(a, b), \
+              AE_MULS, false, false), \
+    AE_MUL_OP("ae_mulf32x16." suffix, AE_MUL32X16_LANES(a, b), \
+              AE_MUL, false, true), \
+    AE_MUL_OP("ae_mulaf32x16." suffix, AE_MUL32X16_LANES(a, b), \
+              AE_MULA, false, true), \
+    AE_MUL_OP("ae_mulsf32x16." suffix, AE_MUL32X16_LANES(a, b), \
+              AE_MULS, false, true)
+
+#define AE_MUL2_OP(op, l0, l1, kind, neg0, neg1, frac) { \
+        .name = (const char * const[]) { op, op "_s2", NULL }, \
+        .translate = translate_ae_mul2, \
+        .par = (const uint32_t[]){l0, l1, kind, neg0, neg1, frac}, \
+        .op_flags = XTENSA_OP_NAME_ARRAY, \
+        .coprocessor = 0x2, \
+    }
+
+/* high d0 lane times d1 lane a, low d0 lane times d1 lane b */
+#define AE_MUL2_32X16(lanes, a, b) \
+    AE_MUL2_OP("ae_mulaafd32x16." lanes, a, b, AE_MULA, false, false, true), \
+    AE_MUL2_OP("ae_mulzaad32x16." lanes, a, b, AE_MUL, false, false, false), \
+    AE_MUL2_OP("ae_mulzaafd32x16." lanes, a, b, AE_MUL, false, false, true)
+
+/* only the odd pairs have the add/subtract forms */
+#define AE_MUL2_32X16_AS(lanes, a, b) \
+    AE_MUL2_OP("ae_mulasfd32x16." lanes, a, b, AE_MULA, false, true, true), \
+    AE_MUL2_OP("ae_mulsafd32x16." lanes, a, b, AE_MULA, true, false, true), \
+    AE_MUL2_OP("ae_mulssfd32x16." lanes, a, b, AE_MULA, true, true, true), \
+    AE_MUL2_OP("ae_mulzasfd32x16." lanes, a, b, AE_MUL, false, true, true), \
+    AE_MUL2_OP("ae_mulzsafd32x16." lanes, a, b, AE_MUL, true, false, true), \
+    AE_MUL2_OP("ae_mulzssfd32x16." lanes, a, b, AE_MUL, true, true, true)
+
+#define AE_MULF32S(op, a, b, kind) { \
+        .name = (const char * const[]) { op, op "_s2", NULL }, \
+        .translate = translate_ae_mulf32s, \
+        .par = (const uint32_t[]){a, b, kind}, \
+        .op_flags = XTENSA_OP_NAME_ARRAY, \
+        .coprocessor = 0x2, \
+    }
+
+static const XtensaOpcodeOps hifi3_ops[] = {
+    {
+        .name = "ae_abs32",
+        .translate = translate_ae_lane32,
+        .par = (const uint32_t[]){AE_LANE_ABS},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_abs32s",
+        .translate = translate_ae_negabs32s,
+        .par = (const uint32_t[]){true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_abs64",
+        .translate = translate_ae_abs64,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_add16",
+        .translate = translate_ae_add,
+        .par = (const uint32_t[]){16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_add16s",
+        .translate = translate_ae_addsub_s,
+        .par = (const uint32_t[]){16, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_add32",
+        .translate = translate_ae_add,
+        .par = (const uint32_t[]){32},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_add32s",
+        .translate = translate_ae_addsub_s,
+        .par = (const uint32_t[]){32, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_add64",
+        .translate = translate_ae_add,
+        .par = (const uint32_t[]){64},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_add64s",
+        .translate = translate_ae_addsub_s,
+        .par = (const uint32_t[]){64, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_addsub32",
+        .translate = translate_ae_addsub32,
+        .par = (const uint32_t[]){false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_and",
+        .translate = translate_ae_and,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_cvt32x2f16.10",
+        .translate = translate_ae_cvt32x2f16,
+        .par = (const uint32_t[]){1, 0},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_cvt32x2f16.32",
+        .translate = translate_ae_cvt32x2f16,
+        .par = (const uint32_t[]){3, 2},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_cvt48a32",
+        .translate = translate_ae_cvt_a32,
+        .par = (const uint32_t[]){16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_cvt64a32",
+        .translate = translate_ae_cvt_a32,
+        .par = (const uint32_t[]){0},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_cvt64f32.h",
+        .translate = translate_ae_cvt64f32_h,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_cvtq56a32s",
+        .translate = translate_ae_cvt_a32,
+        .par = (const uint32_t[]){16},
+        .coprocessor = 0x2,
+    },
+    AE_LOAD("ae_l16.i", AE_MEM_16, AE_ADDR_I),
+    AE_LOAD("ae_l16.ip", AE_MEM_16, AE_ADDR_IP),
+    AE_LOAD("ae_l16.x", AE_MEM_16, AE_ADDR_X),
+    AE_LOAD("ae_l16.xc", AE_MEM_16, AE_ADDR_XC),
+    AE_LOAD("ae_l16.xp", AE_MEM_16, AE_ADDR_XP),
+    AE_LOAD("ae_l16x4.i", AE_MEM_16X4, AE_ADDR_I),
+    AE_LOAD("ae_l16x4.ip", AE_MEM_16X4, AE_ADDR_IP),
+    AE_LOAD("ae_l16x4.x", AE_MEM_16X4, AE_ADDR_X),
+    AE_LOAD("ae_l16x4.xc", AE_MEM_16X4, AE_ADDR_XC),
+    AE_LOAD("ae_l16x4.xp", AE_MEM_16X4, AE_ADDR_XP),
+    AE_LOAD("ae_l32.i", AE_MEM_32, AE_ADDR_I),
+    AE_LOAD("ae_l32.ip", AE_MEM_32, AE_ADDR_IP),
+    AE_LOAD("ae_l32.x", AE_MEM_32, AE_ADDR_X),
+    AE_LOAD("ae_l32.xc", AE_MEM_32, AE_ADDR_XC),
+    AE_LOAD("ae_l32.xp", AE_MEM_32, AE_ADDR_XP),
+    AE_LOAD("ae_l32x2.i", AE_MEM_32X2, AE_ADDR_I),
+    AE_LOAD("ae_l32x2.ip", AE_MEM_32X2, AE_ADDR_IP),
+    AE_LOAD("ae_l32x2.x", AE_MEM_32X2, AE_ADDR_X),
+    AE_LOAD("ae_l32x2.xc", AE_MEM_32X2, AE_ADDR_XC),
+    AE_LOAD("ae_l32x2.xp", AE_MEM_32X2, AE_ADDR_XP),
+    AE_LOAD("ae_l64.i", AE_MEM_64, AE_ADDR_I),
+    AE_LOAD("ae_l64.ip", AE_MEM_64, AE_ADDR_IP),
+    AE_LOAD("ae_l64.x", AE_MEM_64, AE_ADDR_X),
+    AE_LOAD("ae_l64.xc", AE_MEM_64, AE_ADDR_XC),
+    AE_LOAD("ae_l64.xp", AE_MEM_64, AE_ADDR_XP),
+    {
+        .name = "ae_la16x4.ip",
+        .translate = translate_ae_la_ip,
+        .par = (const uint32_t[]){AE_MEM_16X4},
+        .op_flags = XTENSA_OP_LOAD,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_la32x2.ip",
+        .translate = translate_ae_la_ip,
+        .par = (const uint32_t[]){AE_MEM_32X2},
+        .op_flags = XTENSA_OP_LOAD,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_la64.pp",
+        .translate = translate_ae_la64_pp,
+        .op_flags = XTENSA_OP_LOAD,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_lalign64.i",
+        .translate = translate_ae_valign_ldst,
+        .par = (const uint32_t[]){false},
+        .op_flags = XTENSA_OP_LOAD,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_max32",
+        .translate = translate_ae_lane32,
+        .par = (const uint32_t[]){AE_LANE_MAX},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_max64",
+        .translate = translate_ae_minmax64,
+        .par = (const uint32_t[]){AE_LANE_MAX},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_min32",
+        .translate = translate_ae_lane32,
+        .par = (const uint32_t[]){AE_LANE_MIN},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_min64",
+        .translate = translate_ae_minmax64,
+        .par = (const uint32_t[]){AE_LANE_MIN},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_mov",
+        .translate = translate_ae_mov,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movad16.0",
+        .translate = translate_ae_movad,
+        .par = (const uint32_t[]){0, 16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movad16.1",
+        .translate = translate_ae_movad,
+        .par = (const uint32_t[]){16, 16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movad16.2",
+        .translate = translate_ae_movad,
+        .par = (const uint32_t[]){32, 16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movad16.3",
+        .translate = translate_ae_movad,
+        .par = (const uint32_t[]){48, 16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movad32.h",
+        .translate = translate_ae_movad,
+        .par = (const uint32_t[]){32, 32},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movad32.l",
+        .translate = translate_ae_movad,
+        .par = (const uint32_t[]){0, 32},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movalign",
+        .translate = translate_ae_mov,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movda16",
+        .translate = translate_ae_movda16,
+        .par = (const uint32_t[]){false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movda16x2",
+        .translate = translate_ae_movda16,
+        .par = (const uint32_t[]){true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movda32",
+        .translate = translate_ae_movda32,
+        .par = (const uint32_t[]){false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movda32x2",
+        .translate = translate_ae_movda32,
+        .par = (const uint32_t[]){true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_movi",
+        .translate = translate_ae_movi,
+        .coprocessor = 0x2,
+    },
+    AE_MUL2_32X16("h0.l1", 0, 1),
+    AE_MUL2_32X16("h1.l0", 1, 0),
+    AE_MUL2_32X16("h2.l3", 2, 3),
+    AE_MUL2_32X16("h3.l2", 3, 2),
+    AE_MUL2_32X16_AS("h1.l0", 1, 0),
+    AE_MUL2_32X16_AS("h3.l2", 3, 2),
+    AE_MUL_OP("ae_mul32.hh", AE_MUL32_LANES(1, 1), AE_MUL, false, false),
+    AE_MUL_OP("ae_mul32.lh", AE_MUL32_LANES(0, 1), AE_MUL, false, false),
+    AE_MUL_OP("ae_mul32.ll", AE_MUL32_LANES(0, 0), AE_MUL, false, false),
+    AE_MUL_OP("ae_mul32u.ll", AE_MUL32_LANES(0, 0), AE_MUL, true, false),
+    AE_MUL32X16("h0", 1, 0),
+    AE_MUL32X16("h1", 1, 1),
+    AE_MUL32X16("h2", 1, 2),
+    AE_MUL32X16("h3", 1, 3),
+    AE_MUL32X16("l0", 0, 0),
+    AE_MUL32X16("l1", 0, 1),
+    AE_MUL32X16("l2", 0, 2),
+    AE_MUL32X16("l3", 0, 3),
+    AE_MUL_OP("ae_mula32.hh", AE_MUL32_LANES(1, 1), AE_MULA, false, false),
+    AE_MUL_OP("ae_mula32.lh", AE_MUL32_LANES(0, 1), AE_MULA, false, false),
+    AE_MUL_OP("ae_mula32.ll", AE_MUL32_LANES(0, 0), AE_MULA, false, false),
+    AE_MUL_OP("ae_mula32u.ll", AE_MUL32_LANES(0, 0), AE_MULA, true, false),
+    AE_MULF32S("ae_mulaf32s.hh", 1, 1, AE_MULA),
+    AE_MULF32S("ae_mulaf32s.lh", 0, 1, AE_MULA),
+    AE_MULF32S("ae_mulaf32s.ll", 0, 0, AE_MULA),
+    AE_MULF32S("ae_mulf32s.hh", 1, 1, AE_MUL),
+    AE_MULF32S("ae_mulf32s.lh", 0, 1, AE_MUL),
+    AE_MULF32S("ae_mulf32s.ll", 0, 0, AE_MUL),
+    AE_MUL_OP("ae_muls32.hh", AE_MUL32_LANES(1, 1), AE_MULS, false, false),
+    AE_MUL_OP("ae_muls32.lh", AE_MUL32_LANES(0, 1), AE_MULS, false, false),
+    AE_MUL_OP("ae_muls32.ll", AE_MUL32_LANES(0, 0), AE_MULS, false, false),
+    AE_MUL_OP("ae_muls32u.ll", AE_MUL32_LANES(0, 0), AE_MULS, true, false),
+    AE_MULF32S("ae_mulsf32s.hh", 1, 1, AE_MULS),
+    AE_MULF32S("ae_mulsf32s.lh", 0, 1, AE_MULS),
+    AE_MULF32S("ae_mulsf32s.ll", 0, 0, AE_MULS),
+    {
+        .name = "ae_nand",
+        .translate = translate_ae_nand,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_neg32",
+        .translate = translate_ae_neg,
+        .par = (const uint32_t[]){32},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_neg32s",
+        .translate = translate_ae_negabs32s,
+        .par = (const uint32_t[]){false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_neg64",
+        .translate = translate_ae_neg,
+        .par = (const uint32_t[]){64},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_or",
+        .translate = translate_ae_or,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_round16x4f32sasym",
+        .translate = translate_ae_pack16x4,
+        .par = (const uint32_t[]){true, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_round16x4f32ssym",
+        .translate = translate_ae_pack16x4,
+        .par = (const uint32_t[]){true, true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_round32x2f48sasym",
+        .translate = translate_ae_round32x2,
+        .par = (const uint32_t[]){48, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_round32x2f48ssym",
+        .translate = translate_ae_round32x2,
+        .par = (const uint32_t[]){48, true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_round32x2f64sasym",
+        .translate = translate_ae_round32x2,
+        .par = (const uint32_t[]){64, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_round32x2f64ssym",
+        .translate = translate_ae_round32x2,
+        .par = (const uint32_t[]){64, true},
+        .coprocessor = 0x2,
+    },
+    AE_STORE("ae_s16.0.i", AE_MEM_16, AE_ADDR_I),
+    AE_STORE("ae_s16.0.ip", AE_MEM_16, AE_ADDR_IP),
+    AE_STORE("ae_s16.0.x", AE_MEM_16, AE_ADDR_X),
+    AE_STORE("ae_s16.0.xc", AE_MEM_16, AE_ADDR_XC),
+    AE_STORE("ae_s16.0.xp", AE_MEM_16, AE_ADDR_XP),
+    AE_STORE("ae_s16x4.i", AE_MEM_16X4, AE_ADDR_I),
+    AE_STORE("ae_s16x4.ip", AE_MEM_16X4, AE_ADDR_IP),
+    AE_STORE("ae_s16x4.x", AE_MEM_16X4, AE_ADDR_X),
+    AE_STORE("ae_s16x4.xc", AE_MEM_16X4, AE_ADDR_XC),
+    AE_STORE("ae_s16x4.xp", AE_MEM_16X4, AE_ADDR_XP),
+    AE_STORE("ae_s32.l.i", AE_MEM_32, AE_ADDR_I),
+    AE_STORE("ae_s32.l.ip", AE_MEM_32, AE_ADDR_IP),
+    AE_STORE("ae_s32.l.x", AE_MEM_32, AE_ADDR_X),
+    AE_STORE("ae_s32.l.xc", AE_MEM_32, AE_ADDR_XC),
+    AE_STORE("ae_s32.l.xp", AE_MEM_32, AE_ADDR_XP),
+    AE_STORE("ae_s32x2.i", AE_MEM_32X2, AE_ADDR_I),
+    AE_STORE("ae_s32x2.ip", AE_MEM_32X2, AE_ADDR_IP),
+    AE_STORE("ae_s32x2.x", AE_MEM_32X2, AE_ADDR_X),
+    AE_STORE("ae_s32x2.xc", AE_MEM_32X2, AE_ADDR_XC),
+    AE_STORE("ae_s32x2.xp", AE_MEM_32X2, AE_ADDR_XP),
+    AE_STORE("ae_s64.i", AE_MEM_64, AE_ADDR_I),
+    AE_STORE("ae_s64.ip", AE_MEM_64, AE_ADDR_IP),
+    AE_STORE("ae_s64.x", AE_MEM_64, AE_ADDR_X),
+    AE_STORE("ae_s64.xc", AE_MEM_64, AE_ADDR_XC),
+    AE_STORE("ae_s64.xp", AE_MEM_64, AE_ADDR_XP),
+    {
+        .name = "ae_salign64.i",
+        .translate = translate_ae_valign_ldst,
+        .par = (const uint32_t[]){true},
+        .op_flags = XTENSA_OP_STORE,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sat16x4",
+        .translate = translate_ae_pack16x4,
+        .par = (const uint32_t[]){false, false},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sat48s",
+        .translate = translate_ae_sat64,
+        .par = (const uint32_t[]){48},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_satq56s",
+        .translate = translate_ae_sat64,
+        .par = (const uint32_t[]){56},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_slai32",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){32, AE_SHIFT_SLL},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_slai64",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){64, AE_SHIFT_SLL},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_srai16",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){16, AE_SHIFT_SRA},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_srai32",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){32, AE_SHIFT_SRA},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_srai64",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){64, AE_SHIFT_SRA},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_srli32",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){32, AE_SHIFT_SRL},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_srli64",
+        .translate = translate_ae_shift_imm,
+        .par = (const uint32_t[]){64, AE_SHIFT_SRL},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sub16",
+        .translate = translate_ae_sub,
+        .par = (const uint32_t[]){16},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sub16s",
+        .translate = translate_ae_addsub_s,
+        .par = (const uint32_t[]){16, true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sub32",
+        .translate = translate_ae_sub,
+        .par = (const uint32_t[]){32},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sub32s",
+        .translate = translate_ae_addsub_s,
+        .par = (const uint32_t[]){32, true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sub64",
+        .translate = translate_ae_sub,
+        .par = (const uint32_t[]){64},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_sub64s",
+        .translate = translate_ae_addsub_s,
+        .par = (const uint32_t[]){64, true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_subadd32",
+        .translate = translate_ae_addsub32,
+        .par = (const uint32_t[]){true},
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_xor",
+        .translate = translate_ae_xor,
+        .coprocessor = 0x2,
+    }, {
+        .name = "ae_zalign64",
+        .translate = translate_ae_zalign64,
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_bithead",
+        .translate = translate_rur,
+        .par = (const uint32_t[]){AE_BITHEAD},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_cbegin0",
+        .translate = translate_rur,
+        .par = (const uint32_t[]){AE_CBEGIN0},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_cend0",
+        .translate = translate_rur,
+        .par = (const uint32_t[]){AE_CEND0},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_cw_sd_no",
+        .translate = translate_rur,
+        .par = (const uint32_t[]){AE_CW_SD_NO},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_overflow",
+        .translate = translate_ae_rur_field,
+        .par = (const uint32_t[]){AE_OVF_SAR, AE_OVERFLOW_SHIFT, 1},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_ovf_sar",
+        .translate = translate_rur,
+        .par = (const uint32_t[]){AE_OVF_SAR},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_sar",
+        .translate = translate_ae_rur_field,
+        .par = (const uint32_t[]){AE_OVF_SAR, 0, 6},
+        .coprocessor = 0x2,
+    }, {
+        .name = "rur.ae_ts_fts_bu_bp",
+        .translate = translate_rur,
+        .par = (const uint32_t[]){AE_TS_FTS_BU_BP},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_bithead",
+        .translate = translate_wur,
+        .par = (const uint32_t[]){AE_BITHEAD},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_cbegin0",
+        .translate = translate_wur,
+        .par = (const uint32_t[]){AE_CBEGIN0},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_cend0",
+        .translate = translate_wur,
+        .par = (const uint32_t[]){AE_CEND0},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_cw_sd_no",
+        .translate = translate_wur,
+        .par = (const uint32_t[]){AE_CW_SD_NO},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_overflow",
+        .translate = translate_ae_wur_field,
+        .par = (const uint32_t[]){AE_OVF_SAR, AE_OVERFLOW_SHIFT, 1},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_ovf_sar",
+        .translate = translate_ae_wur_field,
+        .par = (const uint32_t[]){AE_OVF_SAR, 0, AE_OVERFLOW_SHIFT + 1},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_sar",
+        .translate = translate_ae_wur_field,
+        .par = (const uint32_t[]){AE_OVF_SAR, 0, 6},
+        .coprocessor = 0x2,
+    }, {
+        .name = "wur.ae_ts_fts_bu_bp",
+        .translate = translate_wur,
+        .par = (const uint32_t[]){AE_TS_FTS_BU_BP},
+        .coprocessor = 0x2,
+    },
+};
+
+const XtensaOpcodeTranslators xtensa_hifi3_opcodes = {
+    .num_opcodes = ARRAY_SIZE(hifi3_ops),
+    .opcode = hifi3_ops,
+};
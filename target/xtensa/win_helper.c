@@ -101,15 +101,6 @@ void HELPER(sync_windowbase)(CPUXtensaState *env)
     xtensa_rotate_window_abs(env, env->windowbase_next);
 }
 
-void HELPER(entry)(CPUXtensaState *env, uint32_t pc, uint32_t s, uint32_t imm)
-{
-    int callinc = (env->sregs[PS] & PS_CALLINC) >> PS_CALLINC_SHIFT;
-
-    env->regs[(callinc << 2) | (s & 3)] = env->regs[s] - imm;
-    env->windowbase_next = env->sregs[WINDOW_BASE] + callinc;
-    env->sregs[WINDOW_START] |= windowstart_bit(env->windowbase_next, env);
-}
-
 void HELPER(window_check)(CPUXtensaState *env, uint32_t pc, uint32_t w)
 {
     uint32_t windowbase = windowbase_bound(env->sregs[WINDOW_BASE], env);
@@ -184,13 +175,6 @@ void HELPER(test_underflow_retw)(CPUXtensaState *env, uint32_t pc)
     }
 }
 
-void HELPER(retw)(CPUXtensaState *env, uint32_t a0)
-{
-    int n = (a0 >> 30) & 0x3;
-
-    xtensa_rotate_window(env, -n);
-}
-
 void xtensa_restore_owb(CPUXtensaState *env)
 {
     xtensa_rotate_window_abs(env, (env->sregs[PS] & PS_OWB) >> PS_OWB_SHIFT);
@@ -160,6 +160,8 @@ static int tcg_out_ldst_finalize(TCGContext *s);
 static TCGContext **tcg_ctxs;
 static unsigned int n_tcg_ctxs;
 TCGv_env cpu_env = 0;
+/* size of the prologue, cached TBs may call into it */
+static size_t tcg_prologue_size;
 
 struct tcg_region_tree {
     QemuMutex lock;
@@ -187,6 +189,9 @@ struct tcg_region_state {
     /* fields protected by the lock */
     size_t current; /* current region index */
     size_t agg_size_full; /* aggregate size of full regions */
+    /* with tb-evict only: allocation order of each region, 0 if free */
+    uint64_t *gen;
+    uint64_t last_gen;
 };
 
 static struct tcg_region_state region;
@@ -547,13 +552,38 @@ static void tcg_region_assign(TCGContext *s, size_t curr_region)
     s->code_gen_highwater = end - TCG_HIGHWATER;
 }
 
+/* Find a region freed by tcg_region_evict(), region.n if there is none */
+static size_t tcg_region_find_free__locked(void)
+{
+    size_t i;
+
+    if (region.gen == NULL) {
+        return region.n;
+    }
+    for (i = 0; i < region.n; i++) {
+        if (region.gen[i] == 0) {
+            break;
+        }
+    }
+    return i;
+}
+
 static bool tcg_region_alloc__locked(TCGContext *s)
 {
-    if (region.current == region.n) {
-        return true;
+    size_t curr_region = region.current;
+
+    if (curr_region == region.n) {
+        curr_region = tcg_region_find_free__locked();
+        if (curr_region == region.n) {
+            return true;
+        }
+    } else {
+        region.current++;
+    }
+    tcg_region_assign(s, curr_region);
+    if (region.gen) {
+        region.gen[curr_region] = ++region.last_gen;
     }
-    tcg_region_assign(s, region.current);
-    region.current++;
     return false;
 }
 
@@ -594,6 +624,9 @@ void tcg_region_reset_all(void)
     qemu_mutex_lock(&region.lock);
     region.current = 0;
     region.agg_size_full = 0;
+    if (region.gen) {
+        memset(region.gen, 0, region.n * sizeof(region.gen[0]));
+    }
 
     for (i = 0; i < n_ctxs; i++) {
         TCGContext *s = atomic_read(&tcg_ctxs[i]);
@@ -606,6 +639,77 @@ void tcg_region_reset_all(void)
     tcg_region_tree_reset_all();
 }
 
+/* Returns true if a TCG context is translating into region @curr_region */
+static bool tcg_region_busy__locked(size_t curr_region)
+{
+    unsigned int n_ctxs = atomic_read(&n_tcg_ctxs);
+    unsigned int i;
+    void *start, *end;
+
+    tcg_region_bounds(curr_region, &start, &end);
+    for (i = 0; i < n_ctxs; i++) {
+        const TCGContext *s = atomic_read(&tcg_ctxs[i]);
+
+        if (s && s->code_gen_buffer == start) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Make room for new code without flushing all regions: unless a region is
+ * free already, call @func on each TB of the least recently allocated
+ * region that no TCG context is translating into, then free that region.
+ * @func must unlink the TB, its code and the TB itself are reused.
+ *
+ * Call from a safe-work context.
+ * Returns false if no region can be freed, i.e. only a flush can help.
+ */
+bool tcg_region_evict(GTraverseFunc func, gpointer user_data)
+{
+    struct tcg_region_tree *rt;
+    size_t oldest = region.n;
+    size_t i;
+    void *start, *end;
+
+    if (region.gen == NULL) {
+        return false;
+    }
+
+    qemu_mutex_lock(&region.lock);
+    if (tcg_region_find_free__locked() != region.n) {
+        qemu_mutex_unlock(&region.lock);
+        return true;
+    }
+    for (i = 0; i < region.n; i++) {
+        if (tcg_region_busy__locked(i)) {
+            continue;
+        }
+        if (oldest == region.n || region.gen[i] < region.gen[oldest]) {
+            oldest = i;
+        }
+    }
+    if (oldest == region.n) {
+        qemu_mutex_unlock(&region.lock);
+        return false;
+    }
+    /* the region was accounted as full when its context moved on */
+    tcg_region_bounds(oldest, &start, &end);
+    region.agg_size_full -= end - start - TCG_HIGHWATER;
+    region.gen[oldest] = 0;
+    qemu_mutex_unlock(&region.lock);
+
+    rt = region_trees + oldest * tree_size;
+    qemu_mutex_lock(&rt->lock);
+    g_tree_foreach(rt->tree, func, user_data);
+    /* Increment the refcount first so that destroy acts as a reset */
+    g_tree_ref(rt->tree);
+    g_tree_destroy(rt->tree);
+    qemu_mutex_unlock(&rt->lock);
+    return true;
+}
+
 #ifdef CONFIG_USER_ONLY
 static size_t tcg_n_regions(void)
 {
@@ -620,31 +724,35 @@ static size_t tcg_n_regions(void)
  */
 static size_t tcg_n_regions(void)
 {
-    size_t i;
+    size_t i, n_threads;
+    /* eviction needs regions that no thread is translating into */
+    size_t min_per_thread = tb_evict_enabled ? 2 : 1;
 
-    /* Use a single region if all we have is one vCPU thread */
 #if !defined(CONFIG_USER_ONLY)
     MachineState *ms = MACHINE(qdev_get_machine());
     unsigned int max_cpus = ms->smp.max_cpus;
 #endif
-    if (max_cpus == 1 || !qemu_tcg_mttcg_enabled()) {
+    n_threads = qemu_tcg_mttcg_enabled() ? max_cpus : 1;
+
+    /* Use a single region if all we have is one vCPU thread */
+    if (n_threads == 1 && !tb_evict_enabled) {
         return 1;
     }
 
-    /* Try to have more regions than max_cpus, with each region being >= 2 MB */
-    for (i = 8; i > 0; i--) {
+    /* Try to have more regions than threads, with each region being >= 2 MB */
+    for (i = 8; i > min_per_thread; i--) {
         size_t regions_per_thread = i;
         size_t region_size;
 
         region_size = tcg_init_ctx.code_gen_buffer_size;
-        region_size /= max_cpus * regions_per_thread;
+        region_size /= n_threads * regions_per_thread;
 
         if (region_size >= 2 * 1024u * 1024) {
-            return max_cpus * regions_per_thread;
+            return n_threads * regions_per_thread;
         }
     }
     /* If we can't, then just allocate one region per vCPU thread */
-    return max_cpus;
+    return n_threads * min_per_thread;
 }
 #endif
 
@@ -659,7 +767,9 @@ static size_t tcg_n_regions(void)
  * code in parallel without synchronization.
  *
  * In softmmu the number of TCG threads is bounded by max_cpus, so we use at
- * least max_cpus regions in MTTCG. In !MTTCG we use a single region.
+ * least max_cpus regions in MTTCG. In !MTTCG we use a single region. With
+ * -accel tcg,tb-evict=on we use at least two regions per thread, so that
+ * tcg_region_evict() can free the oldest one instead of flushing them all.
  * Note that the TCG options from the command-line (i.e. -accel accel=tcg,[...])
  * must have been parsed before calling this function, since it calls
  * qemu_tcg_mttcg_enabled().
@@ -726,6 +836,10 @@ void tcg_region_init(void)
 
     tcg_region_trees_init();
 
+    if (tb_evict_enabled && region.n > 1) {
+        region.gen = g_new0(uint64_t, region.n);
+    }
+
     /* In user-mode we support only one ctx, so do the initial allocation now */
 #ifdef CONFIG_USER_ONLY
     {
@@ -1075,6 +1189,7 @@ void tcg_prologue_init(TCGContext *s)
 
     /* Deduct the prologue from the buffer.  */
     prologue_size = tcg_current_code_size(s);
+    tcg_prologue_size = prologue_size;
     s->code_gen_ptr = buf1;
     s->code_gen_buffer = buf1;
     s->code_buf = buf1;
@@ -1139,6 +1254,176 @@ void tcg_func_start(TCGContext *s)
     QTAILQ_INIT(&s->ops);
     QTAILQ_INIT(&s->free_ops);
     QSIMPLEQ_INIT(&s->labels);
+
+    s->tb_cache_skip = false;
+    s->nb_tb_cache_relocs = 0;
+}
+
+/*
+ * Persistent TB cache support. The backend reports every host address it
+ * embeds in the code of a TB. Addresses into the QEMU image, the prologue
+ * and the TB itself can be relocated on a later run, anything else (heap
+ * pointers, other TBs, shared libraries) makes the TB uncacheable.
+ */
+bool tcg_tb_cache_enabled;
+
+#ifdef CONFIG_LINUX
+extern const char __executable_start[], _end[];
+#define TB_CACHE_IMAGE_START ((uintptr_t)__executable_start)
+#define TB_CACHE_IMAGE_END   ((uintptr_t)_end)
+#else
+#define TB_CACHE_IMAGE_START 0
+#define TB_CACHE_IMAGE_END   0
+#endif
+
+static uintptr_t tb_cache_tb_start(TCGContext *s)
+{
+    return (uintptr_t)s->code_buf -
+        ROUND_UP(sizeof(TranslationBlock), qemu_icache_linesize);
+}
+
+void tcg_tb_cache_reloc(TCGContext *s, void *field, uintptr_t target,
+                        bool rel32)
+{
+    uintptr_t prologue = (uintptr_t)s->code_gen_prologue;
+    TCGTBCacheReloc *r;
+
+    if (!tcg_tb_cache_enabled || s->tb_cache_skip) {
+        return;
+    }
+
+    /* the TB struct and code move together */
+    if (target >= tb_cache_tb_start(s) && target <= (uintptr_t)s->code_ptr) {
+        if (rel32) {
+            return;
+        }
+        if (s->nb_tb_cache_relocs == TCG_MAX_TB_CACHE_RELOCS) {
+            s->tb_cache_skip = true;
+            return;
+        }
+        r = &s->tb_cache_relocs[s->nb_tb_cache_relocs++];
+        r->type = TCG_TB_CACHE_TB_ABS64;
+        r->addend = target - (uintptr_t)s->code_buf;
+    } else if (s->nb_tb_cache_relocs == TCG_MAX_TB_CACHE_RELOCS) {
+        s->tb_cache_skip = true;
+        return;
+    } else if (target >= TB_CACHE_IMAGE_START &&
+               target < TB_CACHE_IMAGE_END) {
+        r = &s->tb_cache_relocs[s->nb_tb_cache_relocs++];
+        r->type = rel32 ? TCG_TB_CACHE_IMAGE_REL32 : TCG_TB_CACHE_IMAGE_ABS64;
+        r->addend = target - TB_CACHE_IMAGE_START;
+    } else if (rel32 && target - prologue < tcg_prologue_size) {
+        r = &s->tb_cache_relocs[s->nb_tb_cache_relocs++];
+        r->type = TCG_TB_CACHE_PROLOGUE_REL32;
+        r->addend = target - prologue;
+    } else {
+        s->tb_cache_skip = true;
+        return;
+    }
+
+    r->offset = (uintptr_t)field - (uintptr_t)s->code_buf;
+}
+
+/*
+ * Host addresses below 4G can be emitted as plain 32 bit immediates that
+ * are not reported, so the image and the code buffer must be above it.
+ * Returns NULL or why code cannot be cached on this host.
+ */
+const char *tcg_tb_cache_enable(void)
+{
+    if (!TCG_TARGET_HAS_tb_cache || TB_CACHE_IMAGE_END == 0) {
+        return "host backend does not record relocations";
+    }
+    if (TB_CACHE_IMAGE_START <= UINT32_MAX ||
+        (uintptr_t)tcg_init_ctx.code_gen_prologue <= UINT32_MAX) {
+        return "QEMU and its code buffer must be mapped above 4G (PIE build)";
+    }
+
+    tcg_tb_cache_enabled = true;
+    return NULL;
+}
+
+/*
+ * Host instruction set extensions the backend generates code for, cached
+ * code must not be run on a host without them.
+ */
+uint32_t tcg_tb_cache_host_features(void)
+{
+#if TCG_TARGET_HAS_tb_cache
+    return tcg_target_tb_cache_features();
+#else
+    return 0;
+#endif
+}
+
+/* false if @r does not patch a field within @code_size bytes of code */
+bool tcg_tb_cache_reloc_valid(const TCGTBCacheReloc *r, size_t code_size)
+{
+    size_t field_size;
+
+    switch (r->type) {
+    case TCG_TB_CACHE_IMAGE_REL32:
+    case TCG_TB_CACHE_PROLOGUE_REL32:
+        field_size = 4;
+        break;
+    case TCG_TB_CACHE_IMAGE_ABS64:
+    case TCG_TB_CACHE_TB_ABS64:
+        field_size = 8;
+        break;
+    default:
+        return false;
+    }
+    return code_size >= field_size && r->offset <= code_size - field_size;
+}
+
+/*
+ * Patch cached code copied to @code, false if a relocation is invalid or
+ * cannot reach its target.
+ */
+bool tcg_tb_cache_apply(TCGContext *s, void *code, size_t code_size,
+                        const TCGTBCacheReloc *reloc, int nb_relocs)
+{
+    uintptr_t target;
+    intptr_t disp;
+    void *field;
+    int i;
+
+    for (i = 0; i < nb_relocs; i++) {
+        if (!tcg_tb_cache_reloc_valid(&reloc[i], code_size)) {
+            return false;
+        }
+        field = code + reloc[i].offset;
+
+        switch (reloc[i].type) {
+        case TCG_TB_CACHE_IMAGE_REL32:
+        case TCG_TB_CACHE_IMAGE_ABS64:
+            target = TB_CACHE_IMAGE_START + reloc[i].addend;
+            break;
+        case TCG_TB_CACHE_PROLOGUE_REL32:
+            target = (uintptr_t)s->code_gen_prologue + reloc[i].addend;
+            break;
+        case TCG_TB_CACHE_TB_ABS64:
+            target = (uintptr_t)code + reloc[i].addend;
+            break;
+        default:
+            return false;
+        }
+
+        if (reloc[i].type == TCG_TB_CACHE_IMAGE_ABS64 ||
+            reloc[i].type == TCG_TB_CACHE_TB_ABS64) {
+            stq_he_p(field, target);
+            continue;
+        }
+
+        /* displacements are relative to the end of the field */
+        disp = target - ((uintptr_t)field + 4);
+        if (disp != (int32_t)disp) {
+            return false;
+        }
+        stl_he_p(field, disp);
+    }
+
+    return true;
 }
 
 static inline TCGTemp *tcg_temp_alloc(TCGContext *s)
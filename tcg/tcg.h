@@ -220,6 +220,10 @@ typedef enum TCGOpcode {
 #define tcg_regset_reset_reg(d, r) ((d) &= ~((TCGRegSet)1 << (r)))
 #define tcg_regset_test_reg(d, r)  (((d) >> (r)) & 1)
 
+#ifndef TCG_TARGET_HAS_tb_cache
+#define TCG_TARGET_HAS_tb_cache 0
+#endif
+
 #ifndef TCG_TARGET_INSN_UNIT_SIZE
 # error "Missing TCG_TARGET_INSN_UNIT_SIZE"
 #elif TCG_TARGET_INSN_UNIT_SIZE == 1
@@ -580,6 +584,25 @@ typedef struct TCGProfile {
     int64_t table_op_count[NB_OPS];
 } TCGProfile;
 
+/*
+ * Host address embedded in the code of a TB, recorded so the code can be
+ * saved to the persistent TB cache and relocated on a later run.
+ */
+typedef enum TCGTBCacheRelocType {
+    TCG_TB_CACHE_IMAGE_REL32,       /* pc relative into the QEMU image */
+    TCG_TB_CACHE_IMAGE_ABS64,       /* absolute into the QEMU image */
+    TCG_TB_CACHE_PROLOGUE_REL32,    /* pc relative into the prologue */
+    TCG_TB_CACHE_TB_ABS64,          /* absolute into the TB itself */
+} TCGTBCacheRelocType;
+
+typedef struct TCGTBCacheReloc {
+    uint32_t offset;                /* of the field from the code start */
+    uint32_t type;
+    int64_t addend;                 /* from the base of the type */
+} TCGTBCacheReloc;
+
+#define TCG_MAX_TB_CACHE_RELOCS 256
+
 struct TCGContext {
     uint8_t *pool_cur, *pool_end;
     TCGPool *pool_first, *pool_current, *pool_first_large;
@@ -670,6 +693,11 @@ struct TCGContext {
        It does not take into account fixed registers */
     TCGTemp *reg_to_temp[TCG_TARGET_NB_REGS];
 
+    /* persistent TB cache, relocations of the TB being generated */
+    bool tb_cache_skip;
+    int nb_tb_cache_relocs;
+    TCGTBCacheReloc tb_cache_relocs[TCG_MAX_TB_CACHE_RELOCS];
+
     uint16_t gen_insn_end_off[TCG_MAX_INSNS];
     target_ulong gen_insn_data[TCG_MAX_INSNS][TARGET_INSN_START_WORDS];
 };
@@ -817,6 +845,7 @@ TranslationBlock *tcg_tb_alloc(TCGContext *s);
 
 void tcg_region_init(void);
 void tcg_region_reset_all(void);
+bool tcg_region_evict(GTraverseFunc func, gpointer user_data);
 
 size_t tcg_code_size(void);
 size_t tcg_code_capacity(void);
@@ -852,6 +881,15 @@ void tcg_register_thread(void);
 void tcg_prologue_init(TCGContext *s);
 void tcg_func_start(TCGContext *s);
 
+extern bool tcg_tb_cache_enabled;
+const char *tcg_tb_cache_enable(void);
+uint32_t tcg_tb_cache_host_features(void);
+void tcg_tb_cache_reloc(TCGContext *s, void *field, uintptr_t target,
+                        bool rel32);
+bool tcg_tb_cache_reloc_valid(const TCGTBCacheReloc *r, size_t code_size);
+bool tcg_tb_cache_apply(TCGContext *s, void *code, size_t code_size,
+                        const TCGTBCacheReloc *reloc, int nb_relocs);
+
 int tcg_gen_code(TCGContext *s, TranslationBlock *tb);
 
 void tcg_set_frame(TCGContext *s, TCGReg reg, intptr_t start, intptr_t size);
@@ -0,0 +1,248 @@
+/*
+ * QEMU IO bridge transport microbenchmark
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This work is licensed under the terms of the GNU GPL, version 2 or later.
+ * See the COPYING file in the top-level directory.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Measures the parent -> child -> parent round trip of a bridge message
+ * through each transport. It does not cover the shim IPC registers, the
+ * DSP interrupt or the firmware doorbell handling that a host IPC goes
+ * through, only the messages carrying it. The child is a forked echo
+ * process so both ends run the real transport code. The echo
+ * processes are forked before this process creates any threads. Results
+ * are printed as one JSON line per transport, e.g. :-
+ *
+ * {"bench":"io-bridge-transport","transport":"ring","msgs":10000,"p50_ns":..,
+ *  "p99_ns":..,"msgs_per_sec":..}
+ *
+ * Message count can be changed with IO_BRIDGE_BENCH_MSGS.
+ */
+#include "qemu/osdep.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "qemu/io-bridge.h"
+
+/* messages in flight for the throughput pass */
+#define BENCH_WINDOW    32
+
+static QemuSemaphore reply_sem;
+
+/* forked echo process for a transport */
+struct bench_peer {
+    const char *transport;
+    pid_t pid;
+    int ready_fd;       /* child writes a byte once registered */
+    int done_fd;        /* closed to tell the child to exit */
+};
+
+static struct bench_peer peers[] = {
+    { .transport = "ring", .pid = -1 },
+    { .transport = "mq", .pid = -1 },
+};
+
+static pid_t bench_pid;
+
+static int echo_cb(void *data, struct qemu_io_msg *msg)
+{
+    struct io_bridge *io = data;
+
+    qemu_io_bridge_send_msg_reply(io, msg);
+    return 0;
+}
+
+static int reply_cb(void *data, struct qemu_io_msg *msg)
+{
+    qemu_sem_post(&reply_sem);
+    return 0;
+}
+
+static void bench_ns(char *ns, size_t size, const char *transport)
+{
+    snprintf(ns, size, "bench%d-%s", bench_pid, transport);
+}
+
+static void bench_child(const char *transport, int ready_fd, int done_fd)
+{
+    struct io_bridge *io;
+    char ns[32], c = 0;
+
+    setenv("QEMU_IO_TRANSPORT", transport, 1);
+    bench_ns(ns, sizeof(ns), transport);
+
+    io = qemu_io_bridge_new(ns);
+    if (qemu_io_bridge_register_child(io, "bench", echo_cb, io) < 0)
+        _exit(1);
+
+    /* tell parent we are ready and wait for it to close done pipe */
+    if (write(ready_fd, &c, 1) != 1)
+        _exit(1);
+    while (read(done_fd, &c, 1) < 0 && errno == EINTR)
+        ;
+
+    qemu_io_bridge_free(io);
+    g_free(io);
+    _exit(0);
+}
+
+static void peers_fork(void)
+{
+    int ready[2], done[2];
+    int i, j;
+
+    for (i = 0; i < ARRAY_SIZE(peers); i++) {
+        g_assert(pipe(ready) == 0);
+        g_assert(pipe(done) == 0);
+
+        peers[i].pid = fork();
+        g_assert(peers[i].pid >= 0);
+        if (peers[i].pid == 0) {
+            /* an inherited done_fd would keep an earlier peer alive */
+            for (j = 0; j < i; j++) {
+                close(peers[j].ready_fd);
+                close(peers[j].done_fd);
+            }
+            close(ready[0]);
+            close(done[1]);
+            bench_child(peers[i].transport, ready[1], done[0]);
+        }
+
+        close(ready[1]);
+        close(done[0]);
+        peers[i].ready_fd = ready[0];
+        peers[i].done_fd = done[1];
+    }
+}
+
+static void peer_release(struct bench_peer *peer)
+{
+    if (peer->pid < 0)
+        return;
+
+    close(peer->done_fd);
+    close(peer->ready_fd);
+    waitpid(peer->pid, NULL, 0);
+    peer->pid = -1;
+}
+
+static struct bench_peer *peer_find(const char *transport)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(peers); i++) {
+        if (!strcmp(peers[i].transport, transport))
+            return &peers[i];
+    }
+    return NULL;
+}
+
+static int cmp_ns(const void *a, const void *b)
+{
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void send_irq(struct io_bridge *io)
+{
+    struct qemu_io_msg_irq irq;
+
+    irq.hdr.type = QEMU_IO_TYPE_IRQ;
+    irq.hdr.msg = QEMU_IO_MSG_IRQ;
+    irq.hdr.size = sizeof(irq);
+    irq.irq = 0;
+
+    g_assert(qemu_io_bridge_send_msg(io, &irq.hdr) >= 0);
+}
+
+static void test_io_bridge_transport(const void *opaque)
+{
+    const char *transport = opaque;
+    const char *env = getenv("IO_BRIDGE_BENCH_MSGS");
+    int msgs = env ? atoi(env) : 10000;
+    struct bench_peer *peer = peer_find(transport);
+    struct io_bridge *io;
+    int64_t *lat, start, p50, p99;
+    double rate;
+    char ns[32], c;
+    int i;
+
+    g_assert(msgs > 0);
+
+    /* transport and debug are read when the bridge is created */
+    setenv("QEMU_IO_TRANSPORT", transport, 1);
+    setenv("QEMU_IO_DEBUG", "0", 1);
+    bench_ns(ns, sizeof(ns), transport);
+
+    g_assert(peer && peer->pid > 0);
+    g_assert(read(peer->ready_fd, &c, 1) == 1);
+
+    qemu_sem_init(&reply_sem, 0);
+    io = qemu_io_bridge_new(ns);
+    g_assert(qemu_io_bridge_register_parent(io, "bench", reply_cb, NULL) == 0);
+
+    /* latency - one message in flight */
+    lat = g_new(int64_t, msgs);
+    for (i = 0; i < msgs; i++) {
+        start = get_clock();
+        send_irq(io);
+        qemu_sem_wait(&reply_sem);
+        lat[i] = get_clock() - start;
+    }
+
+    qsort(lat, msgs, sizeof(*lat), cmp_ns);
+    p50 = lat[msgs / 2];
+    p99 = lat[(int64_t)msgs * 99 / 100];
+
+    /* throughput - keep the window full */
+    g_test_timer_start();
+    for (i = 0; i < msgs; i++) {
+        if (i >= BENCH_WINDOW)
+            qemu_sem_wait(&reply_sem);
+        send_irq(io);
+    }
+    for (i = 0; i < MIN(msgs, BENCH_WINDOW); i++)
+        qemu_sem_wait(&reply_sem);
+    rate = msgs / g_test_timer_elapsed();
+
+    g_print("{\"bench\":\"io-bridge-transport\",\"transport\":\"%s\","
+            "\"msgs\":%d,\"p50_ns\":%" PRId64 ",\"p99_ns\":%" PRId64
+            ",\"msgs_per_sec\":%.0f}\n", transport, msgs, p50, p99, rate);
+    g_test_minimized_result(p99, "%s p99 %" PRId64 " ns", transport, p99);
+    g_test_maximized_result(rate, "%s %.0f msgs/sec", transport, rate);
+
+    /* joins the reader threads and closes the queues */
+    qemu_io_bridge_free(io);
+    g_free(io);
+    peer_release(peer);
+
+    qemu_sem_destroy(&reply_sem);
+    g_free(lat);
+}
+
+int main(int argc, char **argv)
+{
+    int i, ret;
+
+    /* fork the echo processes while this process is still single threaded */
+    bench_pid = getpid();
+    peers_fork();
+
+    g_test_init(&argc, &argv, NULL);
+
+    g_test_add_data_func("/io-bridge/transport/ring", "ring",
+                         test_io_bridge_transport);
+    g_test_add_data_func("/io-bridge/transport/mq", "mq",
+                         test_io_bridge_transport);
+
+    ret = g_test_run();
+
+    /* peers of transports that were not run still need to exit */
+    for (i = 0; i < ARRAY_SIZE(peers); i++)
+        peer_release(&peers[i]);
+
+    return ret;
+}
@@ -0,0 +1,116 @@
+/*
+ * AdvSIMD ops that the TCG backend emits as single vector insns:
+ * BSL/BIT/BIF (bitsel), ORN (orc), NOT, 64 bit ABS, SSHR (sari) and
+ * CMHI/CMHS (unsigned compare). Each result is checked lane by lane
+ * against plain C, so a wrong host encoding fails here.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef uint64_t v2u64 __attribute__((vector_size(16)));
+
+static const uint64_t vals[] = {
+    0, 1, 0x7fffffffffffffffull, 0x8000000000000000ull,
+    0xffffffffffffffffull, 0x0123456789abcdefull, 0xfedcba9876543210ull,
+    0x00000000ffffffffull, 0xffffffff00000000ull, 0x5555aaaa5555aaaaull,
+};
+
+#define N (sizeof(vals) / sizeof(vals[0]))
+
+#define OP2(insn, a, b) ({                                          \
+    v2u64 r_;                                                       \
+    asm(insn " %0.16b, %1.16b, %2.16b" : "=w"(r_) : "w"(a), "w"(b)); \
+    r_; })
+
+#define OP2D(insn, a, b) ({                                         \
+    v2u64 r_;                                                       \
+    asm(insn " %0.2d, %1.2d, %2.2d" : "=w"(r_) : "w"(a), "w"(b));   \
+    r_; })
+
+/* the destination is also an input of the bit select insns */
+#define SEL(insn, d, a, b) ({                                       \
+    v2u64 r_ = d;                                                   \
+    asm(insn " %0.16b, %1.16b, %2.16b" : "+w"(r_) : "w"(a), "w"(b)); \
+    r_; })
+
+static int errors;
+
+static void check(const char *op, int i, uint64_t got, uint64_t exp)
+{
+    if (got != exp) {
+        printf("%s lane %d: 0x%016llx expected 0x%016llx\n", op, i,
+               (unsigned long long)got, (unsigned long long)exp);
+        errors++;
+    }
+}
+
+int main(void)
+{
+    unsigned i, j, k;
+
+    for (i = 0; i < N; i++) {
+        for (j = 0; j < N; j++) {
+            v2u64 a = { vals[i], vals[j] };
+            v2u64 b = { vals[j], vals[(i + j) % N] };
+            v2u64 c = { vals[(i * 3 + j) % N], vals[i] };
+            v2u64 r;
+
+            r = OP2("orn", a, b);
+            for (k = 0; k < 2; k++) {
+                check("orn", k, r[k], a[k] | ~b[k]);
+            }
+
+            r = SEL("bsl", c, a, b);
+            for (k = 0; k < 2; k++) {
+                check("bsl", k, r[k], (a[k] & c[k]) | (b[k] & ~c[k]));
+            }
+            r = SEL("bit", c, a, b);
+            for (k = 0; k < 2; k++) {
+                check("bit", k, r[k], (a[k] & b[k]) | (c[k] & ~b[k]));
+            }
+            r = SEL("bif", c, a, b);
+            for (k = 0; k < 2; k++) {
+                check("bif", k, r[k], (c[k] & b[k]) | (a[k] & ~b[k]));
+            }
+
+            r = OP2D("cmhi", a, b);
+            for (k = 0; k < 2; k++) {
+                check("cmhi", k, r[k], a[k] > b[k] ? -1ull : 0);
+            }
+            r = OP2D("cmhs", a, b);
+            for (k = 0; k < 2; k++) {
+                check("cmhs", k, r[k], a[k] >= b[k] ? -1ull : 0);
+            }
+        }
+
+        {
+            v2u64 a = { vals[i], vals[(i + 1) % N] };
+            v2u64 r;
+
+            asm("not %0.16b, %1.16b" : "=w"(r) : "w"(a));
+            for (k = 0; k < 2; k++) {
+                check("not", k, r[k], ~a[k]);
+            }
+
+            asm("abs %0.2d, %1.2d" : "=w"(r) : "w"(a));
+            for (k = 0; k < 2; k++) {
+                int64_t x = a[k];
+                check("abs", k, r[k], x < 0 ? -(uint64_t)x : x);
+            }
+
+            asm("sshr %0.2d, %1.2d, #7" : "=w"(r) : "w"(a));
+            for (k = 0; k < 2; k++) {
+                check("sshr", k, r[k], (int64_t)a[k] >> 7);
+            }
+            asm("sshr %0.2d, %1.2d, #63" : "=w"(r) : "w"(a));
+            for (k = 0; k < 2; k++) {
+                check("sshr", k, r[k], (int64_t)a[k] >> 63);
+            }
+        }
+    }
+
+    printf("%s: %d errors\n", __FILE__, errors);
+    assert(errors == 0);
+    return 0;
+}
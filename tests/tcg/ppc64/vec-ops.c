@@ -0,0 +1,73 @@
+/*
+ * VMX doubleword ops that the TCG backend emits as single vector insns:
+ * vminud/vmaxud (umin/umax), vsrad (sarv), vorc (orc) and vnor (not).
+ * Each result is checked lane by lane against plain C, so a wrong host
+ * encoding fails here.
+ */
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef uint64_t v2u64 __attribute__((vector_size(16)));
+
+static const uint64_t vals[] = {
+    0, 1, 63, 64, 0x7fffffffffffffffull, 0x8000000000000000ull,
+    0xffffffffffffffffull, 0x0123456789abcdefull, 0xfedcba9876543210ull,
+    0x00000000ffffffffull, 0xffffffff00000000ull, 0x5555aaaa5555aaaaull,
+};
+
+#define N (sizeof(vals) / sizeof(vals[0]))
+
+#define OP2(insn, a, b) ({                                  \
+    v2u64 r_;                                               \
+    asm(insn " %0,%1,%2" : "=v"(r_) : "v"(a), "v"(b));      \
+    r_; })
+
+static int errors;
+
+static void check(const char *op, int i, uint64_t got, uint64_t exp)
+{
+    if (got != exp) {
+        printf("%s lane %d: 0x%016llx expected 0x%016llx\n", op, i,
+               (unsigned long long)got, (unsigned long long)exp);
+        errors++;
+    }
+}
+
+int main(void)
+{
+    unsigned i, j, k;
+
+    for (i = 0; i < N; i++) {
+        for (j = 0; j < N; j++) {
+            v2u64 a = { vals[i], vals[j] };
+            v2u64 b = { vals[j], vals[(i + j) % N] };
+            v2u64 r;
+
+            r = OP2("vminud", a, b);
+            for (k = 0; k < 2; k++) {
+                check("vminud", k, r[k], a[k] < b[k] ? a[k] : b[k]);
+            }
+            r = OP2("vmaxud", a, b);
+            for (k = 0; k < 2; k++) {
+                check("vmaxud", k, r[k], a[k] > b[k] ? a[k] : b[k]);
+            }
+            r = OP2("vsrad", a, b);
+            for (k = 0; k < 2; k++) {
+                check("vsrad", k, r[k], (int64_t)a[k] >> (b[k] & 63));
+            }
+            r = OP2("vorc", a, b);
+            for (k = 0; k < 2; k++) {
+                check("vorc", k, r[k], a[k] | ~b[k]);
+            }
+            r = OP2("vnor", a, a);
+            for (k = 0; k < 2; k++) {
+                check("vnor", k, r[k], ~a[k]);
+            }
+        }
+    }
+
+    printf("%s: %d errors\n", __FILE__, errors);
+    assert(errors == 0);
+    return 0;
+}
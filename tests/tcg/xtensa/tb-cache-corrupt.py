@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+#
+# Corrupt the relocations and jump offsets of a -tb-cache file
+#
+# Copyright (c) 2026 agent <agent@local>
+#
+# This work is licensed under the terms of the GNU GPL, version 2 or later.
+# See the COPYING file in the top-level directory.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+# Usage: tb-cache-corrupt.py <in> <out>
+#
+# Every record gets either a relocation or a goto_tb jump offset pointing
+# past its code. QEMU must reject these records instead of patching memory
+# outside the TB. The layout follows accel/tcg/tb-cache.c, in host byte
+# order.
+
+from __future__ import print_function
+import os
+import struct
+import sys
+
+HEADER = struct.Struct('=8sII256s')
+RECORD = struct.Struct('=QQIIQIIIIIIHHI')
+RELOC = struct.Struct('=IIq')
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write('usage: %s <in> <out>\n' % sys.argv[0])
+        sys.exit(1)
+
+    # no cache is written where -tb-cache is not supported
+    if not os.path.exists(sys.argv[1]):
+        print('%s not found, nothing to corrupt' % sys.argv[1])
+        return
+
+    with open(sys.argv[1], 'rb') as fobj:
+        data = bytearray(fobj.read())
+
+    nb_records = HEADER.unpack_from(data, 0)[2]
+    offset = HEADER.size
+    corrupted = 0
+
+    for i in range(nb_records):
+        rec = list(RECORD.unpack_from(data, offset))
+        size, code_size, search_size, nb_relocs = rec[5], rec[7], rec[8], rec[13]
+        relocs = offset + RECORD.size + size + code_size + search_size
+
+        if nb_relocs and i % 2 == 0:
+            reloc = list(RELOC.unpack_from(data, relocs))
+            reloc[0] = 0xfffffff0
+            RELOC.pack_into(data, relocs, *reloc)
+            corrupted += 1
+        elif rec[11] != 0xffff:
+            # jmp_insn_offset[0] past the code
+            rec[9] = code_size
+            RECORD.pack_into(data, offset, *rec)
+            corrupted += 1
+
+        offset = relocs + nb_relocs * RELOC.size
+
+    with open(sys.argv[2], 'wb') as fobj:
+        fobj.write(data)
+    print('%d of %d records corrupted' % (corrupted, nb_records))
+
+if __name__ == '__main__':
+    main()
@@ -19,7 +19,8 @@
  * with this program; if not, see <http://www.gnu.org/licenses/>.
  *
  * Creates an IO bridge between two QEMU instances where messages can be passed
- * between the parent and child instances via messages queues and shared memory.
+ * between the parent and child instances via shared memory rings (or POSIX
+ * message queues) and shared memory.
  *
  * The parent is usually the QEMU instance that runs the operating system (like
  * Linux) on the application processor whilst the child is typically a smaller
@@ -27,17 +28,24 @@
  * be the same architecture but are expected to communicate over a local bus.
  */
 
+#include "qemu/osdep.h"
 #include <mqueue.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
+#ifdef CONFIG_FALLOCATE_PUNCH_HOLE
+#include <linux/falloc.h>
+#endif
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <glib.h>
 #include <errno.h>
+#include "qemu/atomic.h"
+#include "qemu/error-report.h"
+#include "qemu/futex.h"
 #include "qemu/io-bridge.h"
 
 /* set to 1 to enable debug */
@@ -48,13 +56,22 @@ static int io_bridge_debug = 1;//QEMU_IO_DEBUG;
 #define ROLE_PARENT    1
 #define ROLE_CHILD    2
 
-static int role = ROLE_NONE;
 
 #define QEMU_IO_MAX_MSGS    8
 #define QEMU_IO_MAX_MSG_SIZE    128
 #define QEMU_IO_MAX_SHM_REGIONS    32
+#define QEMU_IO_MAX_HOST_RAM    8
 
 #define NAME_SIZE       64
+#define NS_SIZE         32
+
+/* ring slots per direction - must be power of 2 */
+#define QEMU_IO_RING_SLOTS    256
+#define QEMU_IO_RING_MASK     (QEMU_IO_RING_SLOTS - 1)
+#define QEMU_IO_CACHELINE     64
+
+/* how long a sender waits for a full ring before giving up */
+#define QEMU_IO_RING_TIMEOUT_MS    1000
 
 struct io_shm {
     int fd;
@@ -70,20 +87,155 @@ struct io_mq {
     mqd_t mqdes;
 };
 
+/*
+ * Single producer/single consumer ring, one per direction. The producer owns
+ * head, the consumer owns tail. The consumer sets sleeping before it waits on
+ * the futex so the producer only rings the doorbell when the ring goes from
+ * empty to non empty with the consumer asleep. A producer finding the ring
+ * full sets waiting and sleeps on tail until the consumer has drained it.
+ */
+struct io_ring {
+    uint32_t head __attribute__((aligned(QEMU_IO_CACHELINE)));
+    uint32_t tail __attribute__((aligned(QEMU_IO_CACHELINE)));
+    uint32_t sleeping __attribute__((aligned(QEMU_IO_CACHELINE)));
+    uint32_t waiting __attribute__((aligned(QEMU_IO_CACHELINE)));
+    uint8_t slot[QEMU_IO_RING_SLOTS][QEMU_IO_MAX_MSG_SIZE]
+        __attribute__((aligned(QEMU_IO_CACHELINE)));
+};
+
+/* rings are shared in one SHM object, parent Rx first then child Rx */
+struct io_rings {
+    struct io_ring parent;
+    struct io_ring child;
+};
+
+struct io_ring_shm {
+    char name[NAME_SIZE];
+    char thread_name[NAME_SIZE];
+    int fd;
+    struct io_rings *rings;
+    struct io_ring *rx;
+    struct io_ring *tx;
+    GMutex tx_mutex;    /* many local senders, one ring producer */
+    int stop;           /* tells the reader thread to exit */
+};
+
+/* parent guest RAM mapped by child */
+struct io_host_ram {
+    uint64_t gpa;
+    uint64_t size;
+    void *addr;
+};
+
+/*
+ * A bridge instance. Every IPC object name carries the instance namespace
+ * so any number of parent/child pairs can run on one host.
+ */
 struct io_bridge {
+    char ns[NS_SIZE];
+    int role;
+    int transport;
+    int id;                 /* next message id */
     struct io_mq parent;
     struct io_mq child;
+    mqd_t mq_wake;          /* writes our own Rx queue to stop the reader */
+    int mq_stop;            /* tells the mq reader thread to exit */
+    struct io_ring_shm ring;
     GThread *io_thread;
     int (*cb)(void *data, struct qemu_io_msg *msg);
     struct io_shm shm[QEMU_IO_MAX_SHM_REGIONS];
+    struct io_host_ram host_ram[QEMU_IO_MAX_HOST_RAM];
+    int num_host_ram;
+    int dispatching;    /* messages handed to cb but not yet returned */
     void *data;
 };
 
-static struct io_bridge _iob;
-static int _id = 0;
+/* instance used by the qemu_io_*() API */
+static struct io_bridge *_default;
+
+/*
+ * build "<prefix>-<ns>-<name>" or "<prefix>-<name>" without a namespace,
+ * a truncated name could collide with another namespace so fail instead
+ */
+static int io_ns_name(struct io_bridge *io, char *buf, const char *prefix,
+    const char *name)
+{
+    int len;
+
+    if (io->ns[0])
+        len = snprintf(buf, NAME_SIZE, "%s-%s-%s", prefix, io->ns, name);
+    else
+        len = snprintf(buf, NAME_SIZE, "%s-%s", prefix, name);
+
+    if (len >= NAME_SIZE) {
+        fprintf(stderr, "bridge-io: name %s too long for namespace %s\n",
+                name, io->ns);
+        return -ENAMETOOLONG;
+    }
+
+    return 0;
+}
+
+static gpointer ring_reader_thread(struct io_bridge *io);
+
+/* map parent RAM region described by msg into child */
+static void io_map_host_ram(struct io_bridge *io, struct qemu_io_msg_mem *mem)
+{
+    struct io_host_ram *ram;
+    char name[NAME_SIZE];
+    void *a;
+    int fd;
+
+    if (io->num_host_ram >= QEMU_IO_MAX_HOST_RAM) {
+        fprintf(stderr, "bridge-io: too many host RAM regions\n");
+        return;
+    }
+
+    /* fd belongs to parent so open it via procfs */
+    sprintf(name, "/proc/%u/fd/%d", mem->pid, mem->fd);
+    fd = open(name, O_RDWR);
+    if (fd < 0) {
+        fprintf(stderr, "bridge-io: cant open host RAM %s %d\n", name, -errno);
+        return;
+    }
+
+    a = mmap(NULL, mem->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+        mem->offset);
+    close(fd);
+    if (a == MAP_FAILED) {
+        fprintf(stderr, "bridge-io: cant mmap host RAM %d\n", -errno);
+        return;
+    }
+
+    ram = &io->host_ram[io->num_host_ram];
+    ram->gpa = mem->gpa;
+    ram->size = mem->size;
+    ram->addr = a;
+
+    /* publish region after it is fully initialised */
+    atomic_store_release(&io->num_host_ram, io->num_host_ram + 1);
+
+    if (io_bridge_debug)
+        fprintf(stdout, "bridge-io: host RAM gpa 0x%" PRIx64 " size 0x%" PRIx64 " at %p\n",
+            mem->gpa, mem->size, a);
+}
+
+static void io_bridge_dispatch(struct io_bridge *io, struct qemu_io_msg *hdr)
+{
+    /* memory messages are handled by the bridge */
+    if (hdr->type == QEMU_IO_TYPE_MEM && hdr->msg == QEMU_IO_MEM_HOST_RAM) {
+        io_map_host_ram(io, (struct qemu_io_msg_mem *)hdr);
+        return;
+    }
+
+    atomic_inc(&io->dispatching);
+    if (io->cb)
+        io->cb(io->data, hdr);
+    atomic_dec(&io->dispatching);
+}
 
 /* parent reader Q */
-static gpointer parent_reader_thread(gpointer data)
+static gpointer parent_mq_reader(gpointer data)
 {
     struct io_bridge *io = data;
     char buf[QEMU_IO_MAX_MSG_SIZE];
@@ -107,19 +259,21 @@ static gpointer parent_reader_thread(gpointer data)
     while (mq_receive(io->parent.mqdes, buf, QEMU_IO_MAX_MSG_SIZE, NULL) != -1) {
         struct qemu_io_msg *hdr = (struct qemu_io_msg*)buf;
 
+        if (atomic_read(&io->mq_stop))
+            break;
+
         if (io_bridge_debug)
             fprintf(stdout, "bridge-io: msg recv %d type %d size %d msg %d\n",
                 hdr->id, hdr->type, hdr->size, hdr->msg);
 
-        if (io->cb)
-            io->cb(io->data, hdr);
+        io_bridge_dispatch(io, hdr);
     }
 
     return 0;
 }
 
 /* child reader Q */
-static gpointer child_reader_thread(gpointer data)
+static gpointer child_mq_reader(gpointer data)
 {
     struct io_bridge *io = data;
     char buf[QEMU_IO_MAX_MSG_SIZE];
@@ -143,17 +297,39 @@ static gpointer child_reader_thread(gpointer data)
     while (mq_receive(io->child.mqdes, buf, QEMU_IO_MAX_MSG_SIZE, NULL) != -1) {
         struct qemu_io_msg *hdr = (struct qemu_io_msg*)buf;
 
+        if (atomic_read(&io->mq_stop))
+            break;
+
         if (io_bridge_debug)
             fprintf(stdout, "bridge-io: msg recv %d type %d size %d msg %d\n",
                 hdr->id, hdr->type, hdr->size, hdr->msg);
 
-        if (io->cb)
-            io->cb(io->data, hdr);
+        io_bridge_dispatch(io, hdr);
     }
 
     return 0;
 }
 
+static gpointer parent_reader_thread(gpointer data)
+{
+    struct io_bridge *io = data;
+
+    if (io->transport == QEMU_IO_TRANSPORT_RING)
+        return ring_reader_thread(io);
+
+    return parent_mq_reader(data);
+}
+
+static gpointer child_reader_thread(gpointer data)
+{
+    struct io_bridge *io = data;
+
+    if (io->transport == QEMU_IO_TRANSPORT_RING)
+        return ring_reader_thread(io);
+
+    return child_mq_reader(data);
+}
+
 static int mq_init(const char *name, struct io_bridge *io)
 {
     int ret = 0;
@@ -168,16 +344,15 @@ static int mq_init(const char *name, struct io_bridge *io)
     io->child.mqattr.mq_flags = 0;
     io->child.mqattr.mq_curmsgs = 0;
 
-    if (role == ROLE_PARENT) {
+    if (io->role == ROLE_PARENT) {
 
         /* Host */
 
-        sprintf(io->parent.thread_name, "io-bridge-%s", name);
-        io->io_thread = g_thread_new(io->parent.thread_name,
-            parent_reader_thread, io);
+        if (io_ns_name(io, io->parent.mq_name, "/qemu-io-parent", name) ||
+            io_ns_name(io, io->child.mq_name, "/qemu-io-child", name))
+            return -ENAMETOOLONG;
 
         /* parent Rx Q */
-        sprintf(io->parent.mq_name, "/qemu-io-parent-%s", name);
         io->parent.mqdes = mq_open(io->parent.mq_name, O_RDONLY,
             0664, &io->parent.mqattr);
         if (io->parent.mqdes < 0) {
@@ -187,7 +362,6 @@ static int mq_init(const char *name, struct io_bridge *io)
         }
 
         /* parent Tx Q */
-        sprintf(io->child.mq_name, "/qemu-io-child-%s", name);
         io->child.mqdes = mq_open(io->child.mq_name, O_WRONLY,
             0664, &io->child.mqattr);
         if (io->child.mqdes < 0) {
@@ -196,16 +370,21 @@ static int mq_init(const char *name, struct io_bridge *io)
             ret = -errno;
         }
 
+        /* queues are open so reader can start now */
+        io->mq_wake = mq_open(io->parent.mq_name, O_WRONLY | O_NONBLOCK);
+        io_ns_name(io, io->parent.thread_name, "io-bridge", name);
+        io->io_thread = g_thread_new(io->parent.thread_name,
+            parent_reader_thread, io);
+
     } else {
 
         /* DSP */
 
-        sprintf(io->child.thread_name, "io-bridge-%s", name);
-        io->io_thread = g_thread_new(io->child.thread_name,
-            child_reader_thread, io);
+        if (io_ns_name(io, io->child.mq_name, "/qemu-io-child", name) ||
+            io_ns_name(io, io->parent.mq_name, "/qemu-io-parent", name))
+            return -ENAMETOOLONG;
 
         /* child Rx Q */
-        sprintf(io->child.mq_name, "/qemu-io-child-%s", name);
         mq_unlink(io->child.mq_name);
         io->child.mqdes = mq_open(io->child.mq_name, O_RDONLY | O_CREAT,
             0664, &io->child.mqattr);
@@ -215,7 +394,6 @@ static int mq_init(const char *name, struct io_bridge *io)
         }
 
         /* child Tx Q */
-        sprintf(io->parent.mq_name, "/qemu-io-parent-%s", name);
         mq_unlink(io->parent.mq_name);
         io->parent.mqdes = mq_open(io->parent.mq_name, O_WRONLY | O_CREAT,
             0664, &io->parent.mqattr);
@@ -224,6 +402,11 @@ static int mq_init(const char *name, struct io_bridge *io)
             ret = -errno;
         }
 
+        io->mq_wake = mq_open(io->child.mq_name, O_WRONLY | O_NONBLOCK);
+        io_ns_name(io, io->child.thread_name, "io-bridge", name);
+        io->io_thread = g_thread_new(io->child.thread_name,
+            child_reader_thread, io);
+
     }
 
     if (ret == 0 && io_bridge_debug) {
@@ -233,50 +416,377 @@ static int mq_init(const char *name, struct io_bridge *io)
     return ret;
 }
 
-int qemu_io_register_parent(const char *name,
+static void mq_free(struct io_bridge *io)
+{
+    if (io->role == ROLE_NONE)
+        return;
+
+    /* reader is blocked in mq_receive(), wake it with an empty message */
+    if (io->io_thread) {
+        atomic_mb_set(&io->mq_stop, 1);
+        if (io->mq_wake >= 0)
+            mq_send(io->mq_wake, "", 0, 0);
+        g_thread_join(io->io_thread);
+        io->io_thread = NULL;
+    }
+
+    if (io->mq_wake >= 0)
+        mq_close(io->mq_wake);
+    if (io->parent.mqdes >= 0)
+        mq_close(io->parent.mqdes);
+    if (io->child.mqdes >= 0)
+        mq_close(io->child.mqdes);
+    io->mq_wake = io->parent.mqdes = io->child.mqdes = -1;
+
+    mq_unlink(io->parent.mq_name);
+    mq_unlink(io->child.mq_name);
+}
+
+/* consume every message currently on the ring, return number consumed */
+static int ring_drain(struct io_bridge *io, struct io_ring *ring)
+{
+    uint32_t head, tail;
+    int count = 0;
+
+    tail = ring->tail;
+    head = atomic_load_acquire(&ring->head);
+
+    while (tail != head) {
+        struct qemu_io_msg *hdr =
+            (struct qemu_io_msg *)ring->slot[tail & QEMU_IO_RING_MASK];
+
+        if (io_bridge_debug)
+            fprintf(stdout, "bridge-io: msg recv %d type %d size %d msg %d\n",
+                hdr->id, hdr->type, hdr->size, hdr->msg);
+
+        io_bridge_dispatch(io, hdr);
+
+        /* release slot and pick up anything queued meanwhile */
+        atomic_store_release(&ring->tail, ++tail);
+        count++;
+        if (tail == head)
+            head = atomic_load_acquire(&ring->head);
+    }
+
+    /* order tail stores before waiting load, then wake a blocked producer */
+    if (count) {
+        smp_mb();
+        if (atomic_read(&ring->waiting) && atomic_xchg(&ring->waiting, 0))
+            qemu_futex_wake(&ring->tail, 1);
+    }
+
+    return count;
+}
+
+static gpointer ring_reader_thread(struct io_bridge *io)
+{
+    struct io_ring *ring = io->ring.rx;
+    uint32_t head;
+
+    /* flush old messages here */
+    head = atomic_load_acquire(&ring->head);
+    if (io_bridge_debug)
+        fprintf(stdout, "bridge-io: flushed %u messages from ring %s\n",
+            head - ring->tail, io->ring.name);
+    atomic_store_release(&ring->tail, head);
+
+    while (!atomic_read(&io->ring.stop)) {
+        ring_drain(io, ring);
+
+        /* advertise we are going to sleep then check again */
+        atomic_mb_set(&ring->sleeping, 1);
+        if (atomic_read(&ring->head) != ring->tail ||
+            atomic_read(&io->ring.stop)) {
+            atomic_set(&ring->sleeping, 0);
+            continue;
+        }
+
+        qemu_futex_wait(&ring->sleeping, 1);
+    }
+
+    return 0;
+}
+
+/* wait for the consumer to free a slot, -EAGAIN if it does not in time */
+static int ring_wait_space(struct io_ring *ring, uint32_t head)
+{
+    int64_t deadline = g_get_monotonic_time() +
+        QEMU_IO_RING_TIMEOUT_MS * G_TIME_SPAN_MILLISECOND;
+    struct timespec ts;
+    int64_t left;
+    uint32_t tail;
+
+    for (;;) {
+        tail = atomic_load_acquire(&ring->tail);
+        if (head - tail < QEMU_IO_RING_SLOTS)
+            return 0;
+
+        left = deadline - g_get_monotonic_time();
+        if (left <= 0)
+            return -EAGAIN;
+
+        /* advertise we are waiting then check again */
+        atomic_mb_set(&ring->waiting, 1);
+        if (atomic_read(&ring->tail) != tail)
+            continue;
+
+        ts.tv_sec = left / G_USEC_PER_SEC;
+        ts.tv_nsec = (left % G_USEC_PER_SEC) * 1000;
+        qemu_futex(&ring->tail, FUTEX_WAIT, (int)tail, &ts, NULL, 0);
+    }
+}
+
+static int ring_send(struct io_bridge *io, struct qemu_io_msg *msg)
+{
+    struct io_ring *ring = io->ring.tx;
+    uint32_t head;
+    int ret;
+
+    if (ring == NULL)
+        return -ENODEV;
+
+    if (msg->size > QEMU_IO_MAX_MSG_SIZE)
+        return -EMSGSIZE;
+
+    g_mutex_lock(&io->ring.tx_mutex);
+
+    /* wait for consumer to free a slot - ring is sized so this is rare */
+    head = ring->head;
+    ret = ring_wait_space(ring, head);
+    if (ret < 0) {
+        g_mutex_unlock(&io->ring.tx_mutex);
+        errno = -ret;
+        return ret;
+    }
+
+    memcpy(ring->slot[head & QEMU_IO_RING_MASK], msg, msg->size);
+    atomic_store_release(&ring->head, head + 1);
+
+    /* order head store before sleeping load, then ring doorbell if needed */
+    smp_mb();
+    if (atomic_read(&ring->sleeping) && atomic_xchg(&ring->sleeping, 0))
+        qemu_futex_wake(&ring->sleeping, 1);
+
+    g_mutex_unlock(&io->ring.tx_mutex);
+
+    return 0;
+}
+
+static int ring_init(const char *name, struct io_bridge *io)
+{
+    struct io_ring_shm *rs = &io->ring;
+    size_t size = sizeof(struct io_rings);
+    void *a;
+    int ret;
+
+    g_mutex_init(&rs->tx_mutex);
+    if (io_ns_name(io, rs->name, "qemu-bridge-ring", name))
+        return -ENAMETOOLONG;
+
+    if (io->role == ROLE_PARENT) {
+
+        /* Host - DSP creates the rings */
+        rs->fd = shm_open(rs->name, O_RDWR, 0664);
+        if (rs->fd < 0) {
+            fprintf(stderr, "failed to open ring %s %d, has DSP been started ?\n",
+                    rs->name, -errno);
+            return -errno;
+        }
+
+    } else {
+
+        /* DSP */
+        shm_unlink(rs->name);
+        rs->fd = shm_open(rs->name, O_RDWR | O_CREAT, 0664);
+        if (rs->fd < 0) {
+            fprintf(stderr, "failed to create ring %s %d\n", rs->name, -errno);
+            return -errno;
+        }
+
+        ret = ftruncate(rs->fd, size);
+        if (ret < 0) {
+            fprintf(stderr, "bridge-io: cant truncate ring %d\n", errno);
+            ret = -errno;
+            close(rs->fd);
+            shm_unlink(rs->name);
+            return ret;
+        }
+    }
+
+    a = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, rs->fd, 0);
+    if (a == MAP_FAILED) {
+        fprintf(stderr, "bridge-io: cant mmap ring %d\n", errno);
+        ret = -errno;
+        close(rs->fd);
+        return ret;
+    }
+
+    rs->rings = a;
+    if (io->role == ROLE_PARENT) {
+        rs->rx = &rs->rings->parent;
+        rs->tx = &rs->rings->child;
+    } else {
+        rs->rx = &rs->rings->child;
+        rs->tx = &rs->rings->parent;
+    }
+
+    /* rings are mapped so reader can start now */
+    io_ns_name(io, rs->thread_name, "io-bridge", name);
+    io->io_thread = g_thread_new(rs->thread_name,
+        io->role == ROLE_PARENT ? parent_reader_thread : child_reader_thread,
+        io);
+
+    if (io_bridge_debug)
+        fprintf(stdout, "bridge-io-ring: added %s %zu bytes\n", rs->name, size);
+
+    return 0;
+}
+
+static void ring_free(struct io_bridge *io)
+{
+    struct io_ring_shm *rs = &io->ring;
+
+    if (rs->rings == NULL)
+        return;
+
+    /* reader must be gone before the rings are unmapped */
+    if (io->io_thread) {
+        atomic_mb_set(&rs->stop, 1);
+        atomic_set(&rs->rx->sleeping, 0);
+        qemu_futex_wake(&rs->rx->sleeping, 1);
+        g_thread_join(io->io_thread);
+        io->io_thread = NULL;
+    }
+
+    munmap(rs->rings, sizeof(struct io_rings));
+    close(rs->fd);
+    shm_unlink(rs->name);
+    rs->rings = NULL;
+    rs->rx = rs->tx = NULL;
+    g_mutex_clear(&rs->tx_mutex);
+}
+
+static int transport_init(const char *name, struct io_bridge *io)
+{
+    const char *t = getenv("QEMU_IO_TRANSPORT");
+
+    io->transport = QEMU_IO_TRANSPORT;
+    if (t && !strcmp(t, "mq"))
+        io->transport = QEMU_IO_TRANSPORT_MQ;
+    else if (t && !strcmp(t, "ring"))
+        io->transport = QEMU_IO_TRANSPORT_RING;
+
+    if (io->transport == QEMU_IO_TRANSPORT_RING)
+        return ring_init(name, io);
+
+    return mq_init(name, io);
+}
+
+
+/* create a bridge instance, ns may be NULL or empty for the legacy names */
+struct io_bridge *qemu_io_bridge_new(const char *ns)
+{
+    const char *debug = getenv("QEMU_IO_DEBUG");
+    struct io_bridge *io;
+
+    /* message tracing is very verbose, allow benchmarks to turn it off */
+    if (debug)
+        io_bridge_debug = atoi(debug);
+
+    /* namespace ends up in SHM and mqueue names */
+    if (ns && (strlen(ns) >= NS_SIZE || strchr(ns, '/')))
+        return NULL;
+
+    io = g_malloc0(sizeof(*io));
+    io->role = ROLE_NONE;
+    io->transport = QEMU_IO_TRANSPORT;
+    io->parent.mqdes = io->child.mqdes = io->mq_wake = -1;
+    if (ns)
+        strcpy(io->ns, ns);
+
+    return io;
+}
+
+/* io may be NULL to drop the default before it is freed */
+void qemu_io_bridge_set_default(struct io_bridge *io)
+{
+    _default = io;
+}
+
+bool qemu_io_bridge_is_default(struct io_bridge *io)
+{
+    return io == _default;
+}
+
+/* default instance, namespace taken from QEMU_IO_NS if not set up */
+struct io_bridge *qemu_io_bridge_get_default(void)
+{
+    const char *ns;
+
+    if (_default == NULL) {
+        /* the qemu_io_*() API can't fail, so reject a bad namespace here */
+        ns = getenv("QEMU_IO_NS");
+        _default = qemu_io_bridge_new(ns);
+        if (_default == NULL) {
+            error_report("bridge-io: invalid QEMU_IO_NS '%s', it must be "
+                         "under %d characters without '/'", ns, NS_SIZE);
+            exit(1);
+        }
+    }
+
+    return _default;
+}
+
+const char *qemu_io_bridge_ns(struct io_bridge *io)
+{
+    return io->ns;
+}
+
+int qemu_io_bridge_register_parent(struct io_bridge *io, const char *name,
     int (*cb)(void *, struct qemu_io_msg *msg), void *data)
 {
-    if (role != ROLE_NONE)
+    if (io->role != ROLE_NONE)
         return -EINVAL;
 
-    role = ROLE_PARENT;
-    _iob.cb = cb;
-    _iob.data = data;
+    io->role = ROLE_PARENT;
+    io->cb = cb;
+    io->data = data;
 
-    mq_init(name, &_iob);
+    transport_init(name, io);
 
     return 0;
 }
 
-int qemu_io_register_child(const char *name,
+int qemu_io_bridge_register_child(struct io_bridge *io, const char *name,
     int (*cb)(void *, struct qemu_io_msg *msg), void *data)
 {
-    int ret = 0;
-
-    if (role != ROLE_NONE)
+    if (io->role != ROLE_NONE)
         return -EINVAL;
 
-    role = ROLE_CHILD;
-    _iob.cb = cb;
-    _iob.data = data;
+    io->role = ROLE_CHILD;
+    io->cb = cb;
+    io->data = data;
 
-    mq_init(name, &_iob);
-
-    return ret;
+    return transport_init(name, io);
 }
 
-int qemu_io_register_shm(const char *rname, int region, size_t size, void **addr)
+int qemu_io_bridge_register_shm(struct io_bridge *io, const char *rname,
+    int region, size_t size, void **addr)
 {
     char *name;
     int fd, ret;
     void *a;
 
+    if (region < 0 || region >= QEMU_IO_MAX_SHM_REGIONS)
+        return -EINVAL;
+
     /* check that region is not already in use */
-    if (_iob.shm[region].fd)
+    if (io->shm[region].fd)
         return -EBUSY;
 
-    name = _iob.shm[region].name;
-    sprintf(name, "qemu-bridge-%s", rname);
+    name = io->shm[region].name;
+    if (io_ns_name(io, name, "qemu-bridge", rname))
+        return -ENAMETOOLONG;
 
     fd = shm_open(name, O_RDWR | O_CREAT, 0664);
     if (fd < 0) {
@@ -301,9 +811,9 @@ int qemu_io_register_shm(const char *rname, int region, size_t size, void **addr
     if (io_bridge_debug)
         fprintf(stdout, "bridge-io: %s fd %d region %d at %p allocated %zu bytes\n",
             name, fd, region, a, size);
-    _iob.shm[region].fd = fd;
-    _iob.shm[region].addr = a;
-    _iob.shm[region].size = size;
+    io->shm[region].fd = fd;
+    io->shm[region].addr = a;
+    io->shm[region].size = size;
     *addr = a;
 
     return ret;
@@ -311,31 +821,88 @@ int qemu_io_register_shm(const char *rname, int region, size_t size, void **addr
 
 #define PAGE_SIZE 4096
 
-int qemu_io_sync(int region, unsigned int offset, size_t length)
+int qemu_io_bridge_sync(struct io_bridge *io, int region, unsigned int offset,
+    size_t length)
 {
-    if (region < 0 || region > QEMU_IO_MAX_SHM_REGIONS)
+    if (region < 0 || region >= QEMU_IO_MAX_SHM_REGIONS)
         return -EINVAL;
 
     /* check that region is in use */
-    if (_iob.shm[region].fd == 0)
+    if (io->shm[region].fd == 0)
         return -EINVAL;
 
     /* align offset to pagesize */
     offset -= (offset % PAGE_SIZE);
 
-    return msync(_iob.shm[region].addr + offset, length, MS_SYNC | MS_INVALIDATE);
+    return msync(io->shm[region].addr + offset, length, MS_SYNC | MS_INVALIDATE);
 }
 
-int qemu_io_send_msg(struct qemu_io_msg *msg)
+/* release backing pages, the range reads back as zero */
+int qemu_io_bridge_discard_shm(struct io_bridge *io, int region,
+    size_t offset, size_t length)
 {
-    int ret;
+    struct io_shm *shm;
+    int ret = -ENOTSUP;
+
+    if (region < 0 || region >= QEMU_IO_MAX_SHM_REGIONS)
+        return -EINVAL;
 
-    msg->id = _id++;
+    shm = &io->shm[region];
+    if (shm->fd == 0 || offset % PAGE_SIZE || length % PAGE_SIZE ||
+        offset + length > shm->size)
+        return -EINVAL;
+
+#ifdef CONFIG_FALLOCATE_PUNCH_HOLE
+    if (fallocate(shm->fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+        offset, length) == 0)
+        return 0;
+    ret = -errno;
+#endif
+#ifdef MADV_REMOVE
+    if (madvise(shm->addr + offset, length, MADV_REMOVE) == 0)
+        return 0;
+    ret = -errno;
+#endif
+
+    /* no way to give the pages back, at least keep the zero semantics */
+    memset(shm->addr + offset, 0, length);
+    return ret;
+}
+
+/* host memory currently backing a SHM region in bytes */
+ssize_t qemu_io_bridge_shm_resident(struct io_bridge *io, int region)
+{
+    struct stat st;
+
+    if (region < 0 || region >= QEMU_IO_MAX_SHM_REGIONS)
+        return -EINVAL;
+
+    if (io->shm[region].fd == 0)
+        return -EINVAL;
 
-    if (role == ROLE_PARENT)
-        ret = mq_send(_iob.child.mqdes, (const char*)msg, msg->size, 0);
+    if (fstat(io->shm[region].fd, &st) < 0)
+        return -errno;
+
+    return (ssize_t)st.st_blocks * 512;
+}
+
+static int io_send(struct io_bridge *io, struct qemu_io_msg *msg)
+{
+    if (io->transport == QEMU_IO_TRANSPORT_RING)
+        return ring_send(io, msg);
+    else if (io->role == ROLE_PARENT)
+        return mq_send(io->child.mqdes, (const char*)msg, msg->size, 0);
     else
-        ret = mq_send(_iob.parent.mqdes, (const char*)msg, msg->size, 0);
+        return mq_send(io->parent.mqdes, (const char*)msg, msg->size, 0);
+}
+
+int qemu_io_bridge_send_msg(struct io_bridge *io, struct qemu_io_msg *msg)
+{
+    int ret;
+
+    msg->id = atomic_fetch_inc(&io->id);
+
+    ret = io_send(io, msg);
 
     if (io_bridge_debug)
         fprintf(stdout, "bridge-io: msg send: %d type %d msg %d size %d ret %d\n",
@@ -346,14 +913,12 @@ int qemu_io_send_msg(struct qemu_io_msg *msg)
     return ret;
 }
 
-int qemu_io_send_msg_reply(struct qemu_io_msg *msg)
+int qemu_io_bridge_send_msg_reply(struct io_bridge *io,
+    struct qemu_io_msg *msg)
 {
     int ret;
 
-    if (role == ROLE_PARENT)
-        ret = mq_send(_iob.child.mqdes, (const char*)msg, msg->size, 0);
-    else
-        ret = mq_send(_iob.parent.mqdes, (const char*)msg, msg->size, 0);
+    ret = io_send(io, msg);
 
     if (io_bridge_debug)
         fprintf(stdout, "bridge-io: repmsg send: %d type %d msg %d size %d ret %d\n",
@@ -364,32 +929,188 @@ int qemu_io_send_msg_reply(struct qemu_io_msg *msg)
     return ret;
 }
 
-void qemu_io_free(void)
+/*
+ * Share a region of parent guest RAM with the child. The fd must be shared
+ * RAM (e.g. memory-backend-memfd,share=on) so the child sees guest writes.
+ */
+int qemu_io_bridge_register_host_ram(struct io_bridge *io, uint64_t gpa,
+    uint64_t size, int fd, uint64_t offset)
+{
+    struct qemu_io_msg_mem mem;
+
+    if (io->role != ROLE_PARENT || fd < 0)
+        return -EINVAL;
+
+    mem.hdr.type = QEMU_IO_TYPE_MEM;
+    mem.hdr.msg = QEMU_IO_MEM_HOST_RAM;
+    mem.hdr.size = sizeof(mem);
+    mem.pid = getpid();
+    mem.fd = fd;
+    mem.gpa = gpa;
+    mem.size = size;
+    mem.offset = offset;
+
+    return qemu_io_bridge_send_msg(io, &mem.hdr);
+}
+
+/* get child pointer to parent guest RAM or NULL if not shared */
+void *qemu_io_bridge_host_ram(struct io_bridge *io, uint64_t gpa,
+    uint64_t size)
+{
+    struct io_host_ram *ram;
+    int i, count;
+
+    count = atomic_load_acquire(&io->num_host_ram);
+
+    for (i = 0; i < count; i++) {
+        ram = &io->host_ram[i];
+
+        if (gpa >= ram->gpa && gpa + size <= ram->gpa + ram->size)
+            return ram->addr + (gpa - ram->gpa);
+    }
+
+    return NULL;
+}
+
+/* are any received messages queued or still being dispatched */
+int qemu_io_bridge_pending(struct io_bridge *io)
+{
+    struct mq_attr attr;
+    mqd_t mqdes;
+
+    if (atomic_read(&io->dispatching))
+        return 1;
+
+    if (io->role == ROLE_NONE)
+        return 0;
+
+    if (io->transport == QEMU_IO_TRANSPORT_RING) {
+        if (io->ring.rx == NULL)
+            return 0;
+        return atomic_read(&io->ring.rx->head) !=
+            atomic_read(&io->ring.rx->tail);
+    }
+
+    mqdes = io->role == ROLE_PARENT ? io->parent.mqdes : io->child.mqdes;
+    if (mq_getattr(mqdes, &attr) < 0)
+        return 0;
+
+    return attr.mq_curmsgs > 0;
+}
+
+void qemu_io_bridge_free(struct io_bridge *io)
 {
     int i;
 
+    for (i = 0; i < io->num_host_ram; i++)
+        munmap(io->host_ram[i].addr, io->host_ram[i].size);
+    io->num_host_ram = 0;
+
     for (i = 0; i < QEMU_IO_MAX_SHM_REGIONS; i++) {
-        if (_iob.shm[i].fd) {
-            munmap(_iob.shm[i].addr, _iob.shm[i].size);
-            shm_unlink(_iob.shm[i].name);
-            close(_iob.shm[i].fd);
+        if (io->shm[i].fd) {
+            munmap(io->shm[i].addr, io->shm[i].size);
+            shm_unlink(io->shm[i].name);
+            close(io->shm[i].fd);
+            io->shm[i].fd = 0;
         }
     }
-    mq_unlink(_iob.parent.mq_name);
-    mq_unlink(_iob.child.mq_name);
+    if (io->transport == QEMU_IO_TRANSPORT_RING) {
+        ring_free(io);
+    } else {
+        mq_free(io);
+    }
 }
 
-void qemu_io_free_shm(int region)
+void qemu_io_bridge_free_shm(struct io_bridge *io, int region)
 {
     int err;
 
-    if ((region < QEMU_IO_MAX_SHM_REGIONS) && _iob.shm[region].fd) {
-        err = munmap(_iob.shm[region].addr, _iob.shm[region].size);
+    if (region >= 0 && region < QEMU_IO_MAX_SHM_REGIONS && io->shm[region].fd) {
+        err = munmap(io->shm[region].addr, io->shm[region].size);
         if (err < 0)
             fprintf(stderr, "bridge-io: munmap failed %d\n", errno);
 
         /* client or host can unlink this, so it gets done twice */
-        shm_unlink(_iob.shm[region].name);
-        close(_iob.shm[region].fd);
+        shm_unlink(io->shm[region].name);
+        close(io->shm[region].fd);
+        io->shm[region].fd = 0;
     }
 }
+
+/*
+ * Default instance API.
+ */
+
+int qemu_io_register_parent(const char *name,
+    int (*cb)(void *, struct qemu_io_msg *msg), void *data)
+{
+    return qemu_io_bridge_register_parent(qemu_io_bridge_get_default(),
+        name, cb, data);
+}
+
+int qemu_io_register_child(const char *name,
+    int (*cb)(void *, struct qemu_io_msg *msg), void *data)
+{
+    return qemu_io_bridge_register_child(qemu_io_bridge_get_default(),
+        name, cb, data);
+}
+
+int qemu_io_register_shm(const char *rname, int region, size_t size, void **addr)
+{
+    return qemu_io_bridge_register_shm(qemu_io_bridge_get_default(),
+        rname, region, size, addr);
+}
+
+int qemu_io_sync(int region, unsigned int offset, size_t length)
+{
+    return qemu_io_bridge_sync(qemu_io_bridge_get_default(),
+        region, offset, length);
+}
+
+int qemu_io_send_msg(struct qemu_io_msg *msg)
+{
+    return qemu_io_bridge_send_msg(qemu_io_bridge_get_default(), msg);
+}
+
+int qemu_io_send_msg_reply(struct qemu_io_msg *msg)
+{
+    return qemu_io_bridge_send_msg_reply(qemu_io_bridge_get_default(), msg);
+}
+
+int qemu_io_register_host_ram(uint64_t gpa, uint64_t size, int fd,
+    uint64_t offset)
+{
+    return qemu_io_bridge_register_host_ram(qemu_io_bridge_get_default(),
+        gpa, size, fd, offset);
+}
+
+void *qemu_io_host_ram(uint64_t gpa, uint64_t size)
+{
+    return qemu_io_bridge_host_ram(qemu_io_bridge_get_default(), gpa, size);
+}
+
+int qemu_io_pending(void)
+{
+    return qemu_io_bridge_pending(qemu_io_bridge_get_default());
+}
+
+void qemu_io_free(void)
+{
+    qemu_io_bridge_free(qemu_io_bridge_get_default());
+}
+
+void qemu_io_free_shm(int region)
+{
+    qemu_io_bridge_free_shm(qemu_io_bridge_get_default(), region);
+}
+
+int qemu_io_discard_shm(int region, size_t offset, size_t length)
+{
+    return qemu_io_bridge_discard_shm(qemu_io_bridge_get_default(),
+        region, offset, length);
+}
+
+ssize_t qemu_io_shm_resident(int region)
+{
+    return qemu_io_bridge_shm_resident(qemu_io_bridge_get_default(), region);
+}
@@ -24,6 +24,9 @@
 #include "qapi/error.h"
 #include "qemu-common.h"
 #include "sysemu/sysemu.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "qemu/error-report.h"
 
 #include "qemu/io-bridge.h"
 #include "hw/adsp/shim.h"
@@ -167,12 +170,251 @@ const struct adsp_reg_desc adsp_imx8_mu_map[] = {
     {.name = "cr", .enable = LOG_MU_CR, .offset = 0x24},
 };
 
+/*
+ * Binary register trace. Producers are the threads doing MMIO, each has its
+ * own single producer/single consumer ring so recording is lock free.
+ */
+
+#define LOG_RING_RECS   8192    /* 256kB per thread */
+#define LOG_FLUSH_US    2000
+
+struct log_ring {
+    struct log_trace_rec rec[LOG_RING_RECS];
+    uint32_t head;      /* written by producer */
+    uint32_t tail;      /* written by flush thread */
+    uint32_t dropped;
+    struct log_ring *next;
+};
+
+static struct {
+    GMutex mutex;       /* ring list and start up */
+    struct log_ring *rings;
+    FILE *file;
+    QemuThread thread;
+    int running;
+    uint16_t next_id;
+} log_bin;
+
+static __thread struct log_ring *log_ring;
+
+static struct log_ring *log_ring_new(void)
+{
+    struct log_ring *ring = g_malloc0(sizeof(*ring));
+
+    g_mutex_lock(&log_bin.mutex);
+    ring->next = log_bin.rings;
+    atomic_store_release(&log_bin.rings, ring);
+    g_mutex_unlock(&log_bin.mutex);
+
+    log_ring = ring;
+    return ring;
+}
+
+void log_trace(const struct log_space *ls, int type, hwaddr addr,
+    unsigned size, uint64_t value, uint64_t old)
+{
+    struct log_ring *ring = log_ring ? log_ring : log_ring_new();
+    struct log_trace_rec *rec;
+    uint32_t head = ring->head;
+
+    /* never block the vCPU, count and drop if the flush thread is behind */
+    if (head - atomic_load_acquire(&ring->tail) == LOG_RING_RECS) {
+        ring->dropped++;
+        return;
+    }
+
+    rec = &ring->rec[head % LOG_RING_RECS];
+    rec->ns = get_clock();
+    rec->value = value;
+    rec->old = old;
+    rec->offset = addr;
+    rec->dev = ls->id;
+    rec->type = type;
+    rec->size = size;
+
+    atomic_store_release(&ring->head, head + 1);
+}
+
+/* write out everything recorded so far, returns records written */
+static uint32_t log_flush(void)
+{
+    struct log_ring *ring;
+    uint32_t head, tail, count, total = 0;
+
+    for (ring = atomic_load_acquire(&log_bin.rings); ring; ring = ring->next) {
+
+        head = atomic_load_acquire(&ring->head);
+        tail = ring->tail;
+
+        while (head != tail) {
+            /* contiguous records up to end of ring */
+            count = MIN(head - tail, LOG_RING_RECS - tail % LOG_RING_RECS);
+            if (fwrite(&ring->rec[tail % LOG_RING_RECS], sizeof(ring->rec[0]),
+                count, log_bin.file) != count)
+                fprintf(stderr, "log: trace write failed %d\n", -errno);
+
+            tail += count;
+            total += count;
+        }
+
+        atomic_store_release(&ring->tail, tail);
+    }
+
+    return total;
+}
+
+static void *log_flush_thread(void *data)
+{
+    while (atomic_read(&log_bin.running)) {
+        if (!log_flush())
+            g_usleep(LOG_FLUSH_US);
+    }
+
+    return NULL;
+}
+
+static void log_trace_stop(void)
+{
+    struct log_ring *ring;
+    uint32_t dropped = 0;
+
+    atomic_set(&log_bin.running, 0);
+    qemu_thread_join(&log_bin.thread);
+
+    log_flush();
+    fclose(log_bin.file);
+
+    for (ring = log_bin.rings; ring; ring = ring->next)
+        dropped += ring->dropped;
+    if (dropped)
+        fprintf(stderr, "log: dropped %u trace records\n", dropped);
+}
+
+static void log_trace_start(const char *file_name)
+{
+    char name[64];
+    uint32_t hdr[2] = {LOG_TRACE_VERSION, sizeof(struct log_trace_rec)};
+
+    g_mutex_lock(&log_bin.mutex);
+
+    if (log_bin.file)
+        goto out;
+
+    if (file_name == NULL) {
+        sprintf(name, "/tmp/adsp-trace-%d.bin", getpid());
+        file_name = name;
+    }
+
+    log_bin.file = fopen(file_name, "w");
+    if (log_bin.file == NULL) {
+        fprintf(stderr, "error: can't open %s err %d\n", file_name, -errno);
+        exit(0);
+    }
+
+    fwrite(LOG_TRACE_MAGIC, 1, 8, log_bin.file);
+    fwrite(hdr, sizeof(hdr), 1, log_bin.file);
+    printf("log: binary register trace to %s\n", file_name);
+
+    log_bin.running = 1;
+    qemu_thread_create(&log_bin.thread, "adsp-log", log_flush_thread, NULL,
+        QEMU_THREAD_JOINABLE);
+    atexit(log_trace_stop);
+
+out:
+    g_mutex_unlock(&log_bin.mutex);
+}
+
+/* build the offset map so lookups no longer scan the descriptors */
+static void log_space_map(struct log_space *ls)
+{
+    const struct adsp_reg_space *space = ls->space;
+    const struct adsp_reg_desc *reg = space->reg;
+    uint32_t i, word, end;
+
+    for (i = 0; i < space->reg_count; i++) {
+        end = reg[i].offset + MAX(reg[i].size, 4);
+        ls->words = MAX(ls->words, DIV_ROUND_UP(end, 4));
+    }
+
+    ls->map = g_malloc0(ls->words);
+
+    for (i = 0; i < space->reg_count; i++) {
+
+        /* first descriptor at an offset wins, as it did for the scan */
+        word = reg[i].offset >> 2;
+        if (!(reg[i].offset & 3) && !(ls->map[word] & LOG_SPACE_SEEN)) {
+            ls->map[word] |= LOG_SPACE_SEEN;
+            if (reg[i].enable)
+                ls->map[word] |= LOG_SPACE_REG;
+        }
+
+        if (!reg[i].enable)
+            continue;
+
+        end = DIV_ROUND_UP(reg[i].offset + reg[i].size, 4);
+        for (word = reg[i].offset >> 2; word < end; word++)
+            ls->map[word] |= LOG_SPACE_AREA;
+    }
+}
+
+struct log_space *log_add_space(struct adsp_log *log,
+    const struct adsp_reg_space *space)
+{
+    static struct log_space log_space_full = {
+        .id = LOG_TRACE_DEV_UNMAPPED,
+    };
+    unsigned int i, slot, hash = ((uintptr_t)space >> 4) % LOG_SPACES;
+    struct log_space *ls = NULL;
+    char name[16] = {0};
+    uint64_t val[2];
+
+    g_mutex_lock(&log->mutex);
+
+    for (i = 0; i < LOG_SPACES; i++) {
+        slot = (hash + i) % LOG_SPACES;
+        ls = log->spaces[slot];
+        if (ls == NULL || ls->space == space)
+            break;
+    }
+
+    /* added by another thread or out of slots */
+    if (ls != NULL) {
+        if (ls->space != space) {
+            fprintf(stderr, "log: too many devices, %s not mapped\n",
+                space->name);
+            ls = &log_space_full;
+        }
+        goto out;
+    }
+
+    ls = g_malloc0(sizeof(*ls));
+    ls->space = space;
+    log_space_map(ls);
+
+    g_mutex_lock(&log_bin.mutex);
+    ls->id = log_bin.next_id++;
+    g_mutex_unlock(&log_bin.mutex);
+
+    /* tell the decoder the device name */
+    if (log->level == LOG_LEVEL_BIN) {
+        strncpy(name, space->name, sizeof(name));
+        memcpy(val, name, sizeof(val));
+        log_trace(ls, LOG_TRACE_DEV, 0, 0, val[0], val[1]);
+    }
+
+    atomic_store_release(&log->spaces[slot], ls);
+
+out:
+    g_mutex_unlock(&log->mutex);
+    return ls;
+}
+
 struct adsp_log *log_init(const char *log_name, const char *args)
 {
     struct adsp_log *log;
     struct timeval tv;
 
-    log = g_malloc(sizeof(*log));
+    log = g_malloc0(sizeof(*log));
     g_mutex_init(&log->mutex);
 
     if (log_name == NULL)
@@ -188,10 +430,18 @@ struct adsp_log *log_init(const char *log_name, const char *args)
     gettimeofday(&tv, NULL);
     log->tv_sec_start = tv.tv_sec;
 
-    /* TODO: parse level string later */
-    if (!args)
-        log->level = 0;
-
+    if (args == NULL)
+        log->level = LOG_LEVEL_OFF;
+    else if (!strcmp(args, "text"))
+        log->level = LOG_LEVEL_TEXT;
+    else if (!strcmp(args, "bin") || !strncmp(args, "bin:", 4)) {
+        log->level = LOG_LEVEL_BIN;
+        log_trace_start(args[3] ? args + 4 : NULL);
+    } else {
+        error_report("log: unknown trace_regs mode '%s', "
+            "use text, bin or bin:<file>", args);
+        exit(1);
+    }
 
     return log;
 }
@@ -306,6 +306,21 @@ static QemuOptsList qemu_accel_opts = {
             .type = QEMU_OPT_STRING,
             .help = "Enable/disable multi-threaded TCG",
         },
+        {
+            .name = "hot-trace",
+            .type = QEMU_OPT_NUMBER,
+            .help = "Retranslate TBs entered this often as hot traces",
+        },
+        {
+            .name = "hot-trace-jumps",
+            .type = QEMU_OPT_NUMBER,
+            .help = "Maximum direct jumps followed in a hot trace",
+        },
+        {
+            .name = "tb-evict",
+            .type = QEMU_OPT_BOOL,
+            .help = "Evict the oldest TCG code region instead of flushing",
+        },
         { /* end of list */ }
     },
 };
@@ -500,6 +515,23 @@ static QemuOptsList qemu_icount_opts = {
     },
 };
 
+static QemuOptsList qemu_perf_opts = {
+    .name = "perf",
+    .implied_opt_name = "mode",
+    .merge_lists = true,
+    .head = QTAILQ_HEAD_INITIALIZER(qemu_perf_opts.head),
+    .desc = {
+        {
+            .name = "mode",
+            .type = QEMU_OPT_STRING,
+        }, {
+            .name = "elf",
+            .type = QEMU_OPT_STRING,
+        },
+        { /* end of list */ }
+    },
+};
+
 static QemuOptsList qemu_fw_cfg_opts = {
     .name = "fw_cfg",
     .implied_opt_name = "name",
@@ -2907,6 +2939,7 @@ int main(int argc, char **argv, char **envp)
     qemu_add_opts(&qemu_name_opts);
     qemu_add_opts(&qemu_numa_opts);
     qemu_add_opts(&qemu_icount_opts);
+    qemu_add_opts(&qemu_perf_opts);
     qemu_add_opts(&qemu_semihosting_config_opts);
     qemu_add_opts(&qemu_fw_cfg_opts);
     module_call_init(MODULE_INIT_OPTS);
@@ -3647,6 +3680,31 @@ int main(int argc, char **argv, char **envp)
                     exit(1);
                 }
                 break;
+            case QEMU_OPTION_tb_cache:
+#ifndef CONFIG_TCG
+                error_report("TCG is disabled");
+                exit(1);
+#endif
+                tcg_tb_cache_path = optarg;
+                break;
+            case QEMU_OPTION_perf:
+#ifndef CONFIG_TCG
+                error_report("TCG is disabled");
+                exit(1);
+#endif
+                opts = qemu_opts_parse_noisily(qemu_find_opts("perf"),
+                                               optarg, true);
+                if (!opts) {
+                    exit(1);
+                }
+                tcg_perf_mode = qemu_opt_get(opts, "mode");
+                tcg_perf_elf = qemu_opt_get(opts, "elf");
+                if (!tcg_perf_mode || (strcmp(tcg_perf_mode, "map") &&
+                                       strcmp(tcg_perf_mode, "jitdump"))) {
+                    error_report("-perf: mode must be map or jitdump");
+                    exit(1);
+                }
+                break;
             case QEMU_OPTION_icount:
                 icount_opts = qemu_opts_parse_noisily(qemu_find_opts("icount"),
                                                       optarg, true);
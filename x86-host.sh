@@ -74,7 +74,7 @@ case $1 in
   ;;
 esac
 
-# Launch Qemu
+# Launch Qemu, guest RAM is shared memfd so the DSP DMA can map it directly
 ./x86_64-softmmu/qemu-system-x86_64 \
 	-enable-kvm -machine pc,accel=kvm -smp 2,sockets=2,cores=1,threads=1 \
 	-device virtio-net-pci,netdev=net0,mac=52:54:00:12:34:02 \
@@ -84,6 +84,8 @@ esac
 	-object rng-random,filename=/dev/urandom,id=rng0 \
 	-device virtio-rng-pci,rng=rng0 \
 	-cpu core2duo -m 256 \
+	-object memory-backend-memfd,id=mem0,size=256M,share=on \
+	-numa node,memdev=mem0 \
 	$HDA $ADSP \
 	-serial mon:vc -serial null \
 	-kernel $KERNEL -append 'root=/dev/vda rw highres=off  mem=256M ip=192.168.7.2::192.168.7.1:255.255.255.0 uvesafb.mode_option=640x480-32 oprofile.timer=1 uvesafb.task_timeout=-1 '
@@ -14,7 +14,7 @@ die()
 
 if [ $# -lt 1 ]
 then
-  echo "usage: $0 device [-k kernel] [-t] [-d] [-i] [-r rom] [-c] [-g] [-o time log]"
+  echo "usage: $0 device [-k kernel] [-t] [-d] [-i] [-r rom] [-c] [-g] [-o time log] [-w] [-p cpi] [-m]"
   echo "supported devices: byt, cht, hsw, bdw, bxt, sue, cnl, icl, skl, kbl, hky, tgl, imx8, imx8x"
   echo "[-k] | [--kernel]: load firmware kernel image"
   echo "[-r] | [--rom]: load firmware ROM image"
@@ -24,6 +24,9 @@ then
   echo "[-c] | [--console]: Stall DSP and enter console before executing"
   echo "[-g] | [--guest]: Display guest errors"
   echo "[-o] | [--timeout]: Kill after timeout seconds"
+  echo "[-w] | [--warp]: Skip virtual time while the DSP is idle"
+  echo "[-p] | [--cpi]: Deterministic CCOUNT, advancing cpi cycles per instruction"
+  echo "[-m] | [--mttcg]: Run each DSP core in its own host thread"
   exit
 fi
 
@@ -139,6 +142,19 @@ case $key in
     -c|--console)
     CARGS="-S"
     shift # past argument
+    ;;
+    -w|--warp)
+    MARGS=",time-warp=on"
+    shift # past argument
+    ;;
+    -m|--mttcg)
+    AARGS="-accel tcg,thread=multi"
+    shift # past argument
+    ;;
+    -p|--cpi)
+    PARGS=",ccount-cpi=$3,ccount-deterministic=on"
+    shift # past argument
+    shift # past value
     ;;
      -o|--timeout)
     TIMEOUT="$3"
@@ -160,9 +176,15 @@ if [ -z "$KERNEL" ]; then
     CARGS="-S"
 fi
 
-# clear old queues and memory
-rm -fr /dev/shm/qemu-bridge*
-rm -fr /dev/mqueue/qemu-io-*
+# clear old queues and memory, only our own if running in a namespace
+if [ -n "$QEMU_IO_NS" ]; then
+    rm -fr /dev/shm/qemu-bridge-${QEMU_IO_NS}-*
+    rm -fr /dev/shm/qemu-bridge-ring-${QEMU_IO_NS}-*
+    rm -fr /dev/mqueue/qemu-io-*-${QEMU_IO_NS}-*
+else
+    rm -fr /dev/shm/qemu-bridge*
+    rm -fr /dev/mqueue/qemu-io-*
+fi
 
 #
 # Using GDB
@@ -199,8 +221,8 @@ rm -fr /dev/mqueue/qemu-io-*
 
 set -x
 if [ -z ${TIMEOUT} ]; then
-	"${MY_DIR}"/xtensa-softmmu/qemu-system-xtensa -cpu $CPU -M $ADSP $TARGS $DARGS $IARGS -nographic $KERNEL $ROM $CARGS $GARGS -semihosting;
+	"${MY_DIR}"/xtensa-softmmu/qemu-system-xtensa -cpu $CPU$PARGS -M $ADSP$MARGS $AARGS $TARGS $DARGS $IARGS -nographic $KERNEL $ROM $CARGS $GARGS -semihosting;
 else
-	timeout --foreground $TIMEOUT "${MY_DIR}"/xtensa-softmmu/qemu-system-xtensa -cpu $CPU -M $ADSP $TARGS $DARGS $IARGS -nographic $KERNEL $ROM $CARGS $GARGS > $LOG;
+	timeout --foreground $TIMEOUT "${MY_DIR}"/xtensa-softmmu/qemu-system-xtensa -cpu $CPU$PARGS -M $ADSP$MARGS $AARGS $TARGS $DARGS $IARGS -nographic $KERNEL $ROM $CARGS $GARGS > $LOG;
 fi
 